@@ -0,0 +1,153 @@
+#include "physics/bench/Benchmark.h"
+#include "physics/collision/AABB.h"
+#include "physics/collision/CollisionDetection.h"
+#include "physics/dynamics/RigidBody.h"
+#include "physics/math/Vec3.h"
+#include "physics/world/Fluid.h"
+#include "physics/world/ParticleSystem.h"
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace physics::bench;
+using namespace physics::collision;
+using namespace physics::dynamics;
+using namespace physics::math;
+
+namespace {
+// Working sets stay small enough for L1 so the numbers reflect the kernels,
+// not memory; scene benchmarks cover the memory side.
+const size_t kSetSize = 1024;
+const size_t kSetMask = kSetSize - 1;
+
+std::vector<Vec3> randomVectors(std::mt19937& rng, float range) {
+    std::uniform_real_distribution<float> coordinate(-range, range);
+    std::vector<Vec3> vectors(kSetSize);
+    for (Vec3& v : vectors) {
+        v = Vec3(coordinate(rng), coordinate(rng), coordinate(rng));
+    }
+    return vectors;
+}
+
+std::vector<AABB> randomBoxes(std::mt19937& rng) {
+    std::uniform_real_distribution<float> coordinate(-10.0f, 10.0f);
+    std::uniform_real_distribution<float> extent(0.5f, 3.0f);
+    std::vector<AABB> boxes(kSetSize);
+    for (AABB& box : boxes) {
+        Vec3 center(coordinate(rng), coordinate(rng), coordinate(rng));
+        box = AABB(center, extent(rng), extent(rng), extent(rng));
+    }
+    return boxes;
+}
+}
+
+int main() {
+    std::mt19937 rng(1234);
+    std::vector<Vec3> a = randomVectors(rng, 10.0f);
+    std::vector<Vec3> b = randomVectors(rng, 10.0f);
+    std::vector<AABB> boxesA = randomBoxes(rng);
+    std::vector<AABB> boxesB = randomBoxes(rng);
+    std::vector<RigidBody> bodies;
+    for (size_t i = 0; i < kSetSize; i++) {
+        bodies.emplace_back(a[i], Vec3(1, 1, 1), 1.0f);
+        bodies.back().velocity = b[i];
+        bodies.back().applyForce(Vec3(0, -9.81f, 0));
+    }
+
+    PerfCounters probe;
+    std::cout << "Hardware counters: " << (probe.isAvailable() ? "available" : "unavailable") << "\n";
+
+    Benchmark::printHeader(std::cout);
+    auto report = [](const BenchmarkResult& result) { Benchmark::print(std::cout, result); };
+
+    report(Benchmark::run("Vec3::operator+", [&](size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            doNotOptimize(a[i & kSetMask] + b[i & kSetMask]);
+        }
+    }));
+    report(Benchmark::run("Vec3::dot", [&](size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            doNotOptimize(a[i & kSetMask].dot(b[i & kSetMask]));
+        }
+    }));
+    report(Benchmark::run("Vec3::cross", [&](size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            doNotOptimize(a[i & kSetMask].cross(b[i & kSetMask]));
+        }
+    }));
+    report(Benchmark::run("Vec3::normalized", [&](size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            doNotOptimize(a[i & kSetMask].normalized());
+        }
+    }));
+    report(Benchmark::run("AABB::intersects", [&](size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            // Offset the second index so the hit rate is data dependent.
+            doNotOptimize(boxesA[i & kSetMask].intersects(boxesB[(i * 7) & kSetMask]));
+        }
+    }));
+    report(Benchmark::run("AABB::expandToInclude(Vec3)", [&](size_t n) {
+        AABB bounds(a[0], a[0]);
+        for (size_t i = 0; i < n; i++) {
+            bounds.expandToInclude(b[i & kSetMask]);
+        }
+        doNotOptimize(bounds);
+    }));
+    report(Benchmark::run("AABB::expandToInclude(AABB)", [&](size_t n) {
+        AABB bounds = boxesA[0];
+        for (size_t i = 0; i < n; i++) {
+            bounds.expandToInclude(boxesB[i & kSetMask]);
+        }
+        doNotOptimize(bounds);
+    }));
+    report(Benchmark::run("RigidBody::integrate", [&](size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            bodies[i & kSetMask].integrate(1.0f / 600000.0f);
+        }
+        doNotOptimize(bodies[0].position);
+    }));
+    report(Benchmark::run("calculateSeparationVector", [&](size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            doNotOptimize(CollisionDetection::calculateSeparationVector(boxesA[i & kSetMask], boxesB[i & kSetMask]));
+        }
+    }));
+
+    // Whole particle steps; ns/op is per step of a million particles.
+    physics::world::ParticleSystem particles;
+    std::uniform_real_distribution<float> spread(-50.0f, 50.0f);
+    for (size_t i = 0; i < 1000000; i++) {
+        particles.spawn(Vec3(spread(rng), 10.0f + spread(rng), spread(rng)), Vec3(spread(rng), 0, spread(rng)), 1e9f);
+    }
+    BenchmarkOptions stepOptions;
+    stepOptions.samples = 10;
+    report(Benchmark::run("ParticleSystem::step 1M", [&](size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            particles.step(1.0f / 60.0f);
+        }
+    }, stepOptions));
+    physics::parallel::ThreadPool pool;
+    particles.threadPool = &pool;
+    report(Benchmark::run("ParticleSystem::step 1M pool", [&](size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            particles.step(1.0f / 60.0f);
+        }
+    }, stepOptions));
+
+    // A settling dam break; ns/op is per 60 Hz step of 25.6k fluid particles,
+    // five substeps at the default settings.
+    physics::world::FluidSystem fluid;
+    fluid.settings.bounds = AABB(Vec3(0, 0, 0), Vec3(4, 3, 2));
+    fluid.spawnBlock(AABB(Vec3(0, 0, 0), Vec3(2, 1, 1.6f)), 0.05f);
+    report(Benchmark::run("FluidSystem::step 25.6k", [&](size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            fluid.step(1.0f / 60.0f);
+        }
+    }, stepOptions));
+    fluid.threadPool = &pool;
+    report(Benchmark::run("FluidSystem::step 25.6k pool", [&](size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            fluid.step(1.0f / 60.0f);
+        }
+    }, stepOptions));
+    return 0;
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include "physics/bench/PerfCounters.h"
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace physics::bench {
+
+// Keeps value (and whatever produced it) from being optimized away.
+template <typename T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct BenchmarkOptions {
+    // Untimed runs before sampling, to warm caches and branch predictors.
+    uint32_t warmupRuns = 3;
+    uint32_t samples = 30;
+    // Kernel iterations per sample; 0 calibrates until one sample takes at
+    // least minSampleNanos, so timer resolution does not matter.
+    size_t iterations = 0;
+    uint64_t minSampleNanos = 200000;
+    // Samples whose modified z-score (distance from the median in units of
+    // the median absolute deviation) exceeds this are rejected.
+    double outlierThreshold = 3.5;
+};
+
+// Summary of a set of per-operation samples after outlier rejection.
+struct SampleStats {
+    double median = 0.0;
+    double mean = 0.0;
+    double stddev = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+    size_t kept = 0;
+    size_t rejected = 0;
+};
+
+struct BenchmarkResult {
+    std::string name;
+    size_t iterations = 0;
+    // Nanoseconds per kernel iteration.
+    SampleStats nanos;
+    // Mean counts per kernel iteration over the kept samples; only
+    // meaningful where hasCounter is set.
+    bool hasCounter[PerfCounters::CounterCount] = {};
+    double counters[PerfCounters::CounterCount] = {};
+};
+
+// In-tree micro-benchmark harness for small kernels. The kernel is called
+// as fn(iterations) and must run its body that many times, so the loop
+// overhead and the timer calls are amortized over a whole sample. Each
+// sample is timed with steady_clock and, when available, counted with
+// PerfCounters; the counter window covers exactly the timed region.
+class Benchmark {
+public:
+    template <typename Fn>
+    static BenchmarkResult run(const std::string& name, Fn&& fn, const BenchmarkOptions& options = BenchmarkOptions());
+
+    // Drops outliers by modified z-score and summarizes the rest. The MAD is
+    // floored at 0.1% of the median so jitter below about half a percent is
+    // never rejected; with a zero median anything off it is an outlier.
+    static SampleStats summarize(std::vector<double> samples, double outlierThreshold, std::vector<bool>* keptMask = nullptr);
+
+    static void printHeader(std::ostream& out);
+    static void print(std::ostream& out, const BenchmarkResult& result);
+
+private:
+    using KernelFn = void (*)(void* context, size_t iterations);
+
+    template <typename Fn>
+    static void invokeKernel(void* context, size_t iterations) {
+        (*static_cast<Fn*>(context))(iterations);
+    }
+
+    static BenchmarkResult runKernel(const std::string& name, KernelFn fn, void* context, const BenchmarkOptions& options);
+};
+
+template <typename Fn>
+BenchmarkResult Benchmark::run(const std::string& name, Fn&& fn, const BenchmarkOptions& options) {
+    using Kernel = std::remove_reference_t<Fn>;
+    return runKernel(name, &invokeKernel<Kernel>, const_cast<void*>(static_cast<const void*>(&fn)), options);
+}
+
+}
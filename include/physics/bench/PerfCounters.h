@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace physics::bench {
+
+// Hardware counters for the calling thread through Linux perf_event_open,
+// opened as one group so every counter covers the same window. Counters the
+// kernel or CPU refuses (containers, perf_event_paranoid, VMs without a PMU)
+// are simply missing; on other platforms none are available. Values are
+// scaled up when the kernel had to multiplex the group.
+class PerfCounters {
+public:
+    enum Counter : uint32_t { Cycles = 0, Instructions = 1, CacheMisses = 2, BranchMisses = 3 };
+    static const size_t CounterCount = 4;
+
+    PerfCounters();
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool isAvailable() const;
+    bool hasCounter(Counter counter) const;
+
+    void start();
+    void stop();
+    // Count over the last start/stop window; 0 for missing counters.
+    uint64_t get(Counter counter) const;
+
+    static const char* getName(Counter counter);
+
+private:
+    int fds[CounterCount];
+    int leader;
+    uint64_t values[CounterCount];
+};
+
+}
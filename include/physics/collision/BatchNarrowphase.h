@@ -0,0 +1,37 @@
+#pragma once
+#include "physics/collision/AABB.h"
+#include "physics/collision/Broadphase.h"
+#include "physics/collision/CollisionDetection.h"
+#include "physics/collision/Shape.h"
+#include "physics/math/Vec3.h"
+#include <span>
+
+namespace physics::collision {
+
+// AABB narrowphase over a batch of candidate pairs. Bounds and positions are
+// indexed by the pair's body indices. Writes a Contact for every pair with
+// positive penetration depth, in pair order, and returns how many were
+// written; contacts must have room for pairs.size() records. Each record is
+// bit-identical to CollisionDetection::getAABBCollisionInfo for that pair.
+//
+// On x86-64 CPUs with AVX2 eight pairs are processed per instruction (the
+// kernel is compiled for AVX2 separately and picked at runtime), with the
+// scalar path handling the tail and other CPUs.
+class BatchNarrowphase {
+public:
+  static size_t findContacts(const AABB* bounds, const physics::math::Vec3* positions,
+                             std::span<const BodyPair> pairs, Contact* contacts);
+  static size_t findContactsScalar(const AABB* bounds, const physics::math::Vec3* positions,
+                                   std::span<const BodyPair> pairs, Contact* contacts);
+
+  // Same for pairs of spheres, with radii read from shapes. Matches
+  // CollisionDetection::getSphereCollisionInfo bit for bit.
+  static size_t findSphereContacts(const physics::math::Vec3* positions, const Shape* shapes,
+                                   std::span<const BodyPair> pairs, Contact* contacts);
+  static size_t findSphereContactsScalar(const physics::math::Vec3* positions, const Shape* shapes,
+                                         std::span<const BodyPair> pairs, Contact* contacts);
+
+  static bool hasAvx2();
+};
+
+}
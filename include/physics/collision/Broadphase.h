@@ -0,0 +1,79 @@
+#pragma once
+#include "physics/collision/AABB.h"
+#include "physics/collision/CollisionFilter.h"
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+namespace physics::collision {
+
+struct BodyPair {
+  uint32_t a;
+  uint32_t b;
+};
+
+struct SweepEntry {
+  float minX;
+  uint32_t index;
+};
+
+// Sort-and-sweep broadphase along the x axis. Emits every pair of
+// overlapping bounds once with a < b. Temporary sort keys come from the
+// scratch resource so a frame arena makes the pass allocation-free. With
+// per-body filters (indexed like bounds), pairs that may not collide are
+// rejected before the overlap test and never emitted.
+//
+// findPairs is sortEntries followed by sweepRange over every entry. The
+// sweep can be split into disjoint entry ranges and run in parallel;
+// concatenating the range outputs in order gives the same pairs in the same
+// order as findPairs.
+class SweepAndPrune {
+public:
+  static void findPairs(const AABB* bounds, size_t count, std::pmr::vector<BodyPair>& pairs,
+                        std::pmr::memory_resource* scratch, const CollisionFilter* filters = nullptr);
+
+  // Sorts the entries of bounds[first, count); entry indices stay absolute.
+  static void sortEntries(const AABB* bounds, size_t count, std::pmr::vector<SweepEntry>& entries, size_t first = 0);
+
+  template <typename PairVector>
+  static void sweepRange(const AABB* bounds, std::span<const SweepEntry> entries, size_t begin, size_t end,
+                         PairVector& pairs, const CollisionFilter* filters = nullptr);
+
+private:
+  template <bool Filtered, typename PairVector>
+  static void sweep(const AABB* bounds, const CollisionFilter* filters, std::span<const SweepEntry> entries,
+                    size_t begin, size_t end, PairVector& pairs);
+};
+
+template <typename PairVector>
+void SweepAndPrune::sweepRange(const AABB* bounds, std::span<const SweepEntry> entries, size_t begin, size_t end,
+                               PairVector& pairs, const CollisionFilter* filters) {
+  if (filters) {
+    sweep<true>(bounds, filters, entries, begin, end, pairs);
+  } else {
+    sweep<false>(bounds, filters, entries, begin, end, pairs);
+  }
+}
+
+template <bool Filtered, typename PairVector>
+void SweepAndPrune::sweep(const AABB* bounds, const CollisionFilter* filters, std::span<const SweepEntry> entries,
+                          size_t begin, size_t end, PairVector& pairs) {
+  size_t count = entries.size();
+  for (size_t i = begin; i < end; i++) {
+    const AABB& current = bounds[entries[i].index];
+    for (size_t j = i + 1; j < count && entries[j].minX <= current.max.x; j++) {
+      if constexpr (Filtered) {
+        if (!CollisionFilter::shouldCollide(filters[entries[i].index], filters[entries[j].index])) continue;
+      }
+      const AABB& other = bounds[entries[j].index];
+      if (current.intersects(other)) {
+        uint32_t a = entries[i].index;
+        uint32_t b = entries[j].index;
+        pairs.push_back(a < b ? BodyPair{a, b} : BodyPair{b, a});
+      }
+    }
+  }
+}
+
+}
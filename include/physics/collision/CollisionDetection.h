@@ -1,6 +1,7 @@
 #pragma once 
 #include "physics/dynamics/RigidBody.h"
 #include "physics/math/Vec3.h"
+#include <cstdint>
 
 namespace physics::collision {
 
@@ -14,15 +15,32 @@ struct CollisionInfo {
   CollisionInfo(const physics::math::Vec3& point, const physics::math::Vec3& normal, float depth);
 };
 
+// Narrowphase result for one overlapping pair, by storage index.
+struct Contact {
+  uint32_t indexA;
+  uint32_t indexB;
+  CollisionInfo info;
+};
+
 class CollisionDetection {
 public:
   static CollisionInfo checkGroundCollision(const physics::dynamics::RigidBody& body, float groundY = 0.0f);
   static void resolveGroundCollision(physics::dynamics::RigidBody& body, const CollisionInfo& collision);
   static bool checkAABBCollision(const physics::dynamics::RigidBody& bodyA, const physics::dynamics::RigidBody& bodyB);
   static CollisionInfo getAABBCollisionInfo(const physics::dynamics::RigidBody& bodyA, const physics::dynamics::RigidBody& bodyB);
-  static void resolveAABBCollision(physics::dynamics::RigidBody& bodyA, physics::dynamics::RigidBody& bodyB, const CollisionInfo& collision);
-
-private:
+  // Same test on precomputed bounds; positionA/B give the contact point.
+  static CollisionInfo getAABBCollisionInfo(const AABB& aabbA, const AABB& aabbB,
+                                            const physics::math::Vec3& positionA, const physics::math::Vec3& positionB);
+  // Sphere-sphere test. The normal points from B towards A; the contact
+  // point is the middle of the overlap along it. Coincident centres
+  // separate along +y.
+  static CollisionInfo getSphereCollisionInfo(const physics::math::Vec3& centerA, float radiusA,
+                                              const physics::math::Vec3& centerB, float radiusB);
+  // Separates the bodies and applies a normal impulse; returns its
+  // magnitude (0 if they were already separating).
+  static float resolveAABBCollision(physics::dynamics::RigidBody& bodyA, physics::dynamics::RigidBody& bodyB, const CollisionInfo& collision);
+  // Minimum translation of A out of B along one axis; public so the kernel
+  // benchmarks can time it on its own.
   static physics::math::Vec3 calculateSeparationVector(const AABB& aabbA, const AABB& aabbB);
 };
 
@@ -0,0 +1,23 @@
+#pragma once
+#include <cstdint>
+
+namespace physics::collision {
+
+// Which bodies may collide. Two bodies collide when each one's category
+// has a bit in the other's mask. A non-zero group overrides that for bodies
+// sharing it: a positive group always collides, a negative group never
+// does (a projectile and its owner, the parts of a ragdoll).
+struct CollisionFilter {
+  uint32_t category = 1;
+  uint32_t mask = 0xFFFFFFFFu;
+  int32_t group = 0;
+
+  bool operator==(const CollisionFilter& other) const = default;
+
+  static bool shouldCollide(const CollisionFilter& a, const CollisionFilter& b) {
+    if (a.group != 0 && a.group == b.group) return a.group > 0;
+    return (a.category & b.mask) != 0 && (b.category & a.mask) != 0;
+  }
+};
+
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include "physics/math/Vec3.h"
+#include <vector>
+
+namespace physics::collision {
+
+// Convex point cloud in body space (relative to the body position). Only the
+// support function is used by the narrowphase, so the points need not be
+// pruned to the actual hull. Hulls are shared by reference from Shape and
+// must outlive every body that uses them.
+class ConvexHull {
+public:
+  explicit ConvexHull(std::vector<physics::math::Vec3> points);
+
+  // Point of the hull furthest along direction, in body space.
+  const physics::math::Vec3& support(const physics::math::Vec3& direction) const;
+
+  const std::vector<physics::math::Vec3>& getPoints() const;
+  const physics::math::Vec3& getLocalMin() const;
+  const physics::math::Vec3& getLocalMax() const;
+
+private:
+  std::vector<physics::math::Vec3> points;
+  physics::math::Vec3 localMin;
+  physics::math::Vec3 localMax;
+};
+
+}
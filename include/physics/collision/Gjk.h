@@ -0,0 +1,101 @@
+#pragma once
+#include "physics/collision/CollisionDetection.h"
+#include "physics/math/Vec3.h"
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace physics::collision {
+
+// Support mapping of a convex shape: the point of the shape furthest along a
+// direction, in world space. fn receives context unchanged, so one function
+// can serve every shape of a kind.
+struct SupportMapping {
+  physics::math::Vec3 (*fn)(const void* context, const physics::math::Vec3& direction);
+  const void* context;
+
+  physics::math::Vec3 support(const physics::math::Vec3& direction) const {
+    return fn(context, direction);
+  }
+};
+
+// Warm-start state for one pair: the search directions that produced the
+// last terminating simplex. Re-evaluating the supports along them rebuilds a
+// simplex close to the answer, so coherent frames finish in an iteration
+// or two.
+struct GjkCache {
+  physics::math::Vec3 directions[4];
+  uint32_t count = 0;
+  uint32_t lastFrame = 0;
+};
+
+struct GjkResult {
+  bool overlapping;
+  // Separated pairs: distance between the shapes, unit axis from B towards
+  // A and the closest points on each shape.
+  float distance;
+  physics::math::Vec3 axis;
+  physics::math::Vec3 pointA;
+  physics::math::Vec3 pointB;
+  uint32_t iterations;
+};
+
+// GJK distance/overlap query and EPA penetration depth over the Minkowski
+// difference A - B. Fixed-size working sets, no allocation.
+class Gjk {
+public:
+  static GjkResult query(const SupportMapping& a, const SupportMapping& b, GjkCache* cache = nullptr);
+
+  // Overlap test with penetration: the normal points from B towards A like
+  // the other narrowphase routines. Separated or touching pairs return no
+  // collision.
+  static CollisionInfo collide(const SupportMapping& a, const SupportMapping& b, GjkCache* cache = nullptr,
+                               uint32_t* iterations = nullptr);
+};
+
+// GjkCache per body pair, safe to use from several narrowphase tasks at once.
+// Keys are split over independently locked shards; each pair only ever
+// touches its own entry, so results do not depend on scheduling. Entries not
+// used for a while are dropped by beginFrame. Each shard is an open
+// addressing table that only allocates when it grows, so once the pair
+// count levels off, storing new pairs does not allocate.
+class GjkPairCache {
+public:
+  explicit GjkPairCache(uint32_t maxIdleFrames = 8);
+
+  // Copies the cached state for the pair into cache (count 0 if none).
+  void load(uint32_t idA, uint32_t idB, GjkCache& cache);
+  void store(uint32_t idA, uint32_t idB, const GjkCache& cache);
+
+  void beginFrame();
+  void clear();
+  size_t size();
+
+private:
+  static const size_t kShardCount = 16;
+
+  struct Entry {
+    uint64_t key;
+    GjkCache cache;
+  };
+
+  // Linear probing over a power-of-two slot count, at most half full.
+  // scratch keeps the survivors while beginFrame rebuilds the slots.
+  struct Shard {
+    std::mutex mutex;
+    std::vector<Entry> slots;
+    std::vector<Entry> scratch;
+    size_t count = 0;
+  };
+
+  Shard& shardFor(uint64_t key);
+  static GjkCache* find(Shard& shard, uint64_t key);
+  static GjkCache& insert(Shard& shard, uint64_t key);
+  static void rehash(Shard& shard, size_t slotCount);
+
+  Shard shards[kShardCount];
+  uint32_t frame;
+  uint32_t maxIdleFrames;
+};
+
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include "physics/math/Vec3.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace physics::collision {
+
+// Order matters: narrowphase pair tables are indexed with the lower type
+// first.
+enum class ShapeType : uint8_t {
+  Box = 0,
+  Sphere = 1,
+  Capsule = 2,
+  OrientedBox = 3,
+  ConvexHull = 4
+};
+
+inline constexpr size_t ShapeTypeCount = 5;
+
+class ConvexHull;
+
+// Collision geometry of a body, centred on its position. Box is the
+// axis-aligned box given by RigidBody::size. A capsule is a segment of
+// length 2 * halfHeight along axes[1], swept by radius. An oriented box
+// has halfExtents along its world-space unit axes. A convex hull points at
+// shared body-space geometry. Bodies have no angular state, so orientations
+// stay fixed unless changed by hand.
+struct Shape {
+  ShapeType type;
+  float radius;
+  float halfHeight;
+  physics::math::Vec3 halfExtents;
+  physics::math::Vec3 axes[3];
+  const ConvexHull* hull;
+
+  Shape();
+
+  static Shape box();
+  static Shape sphere(float radius);
+  static Shape capsule(float radius, float halfHeight,
+                       const physics::math::Vec3& axis = physics::math::Vec3(0, 1, 0));
+  // axisX and axisY must be orthonormal; the third axis is their cross product.
+  static Shape orientedBox(const physics::math::Vec3& halfExtents, const physics::math::Vec3& axisX,
+                           const physics::math::Vec3& axisY);
+  static Shape convexHull(const ConvexHull& hull);
+};
+
+}
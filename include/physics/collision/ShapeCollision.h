@@ -0,0 +1,51 @@
+#pragma once
+#include "physics/collision/AABB.h"
+#include "physics/collision/Broadphase.h"
+#include "physics/collision/CollisionDetection.h"
+#include "physics/collision/Gjk.h"
+#include "physics/collision/Shape.h"
+#include "physics/math/Vec3.h"
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace physics::collision {
+
+// Per-body collision inputs indexed by storage slot: world bounds, the
+// position each bound was built from, and the body's shape. Pairs involving
+// a convex hull warm-start GJK from gjkCache, keyed by the stable ids; both
+// may be null to run without a cache.
+struct ShapeView {
+  const AABB* bounds;
+  const physics::math::Vec3* positions;
+  const Shape* shapes;
+  const uint32_t* ids;
+  GjkPairCache* gjkCache;
+};
+
+// Narrowphase over a batch of pairs whose bodies all have the same two
+// shape types. Writes a Contact (normal from B towards A) for each pair
+// with positive penetration and returns the count.
+using PairBatchFn = size_t (*)(const ShapeView& view, std::span<const BodyPair> pairs, Contact* contacts);
+
+// Narrowphase for mixed shapes. Pairs are bucketed by their (typeA, typeB)
+// combination and every bucket runs through one entry of a function table,
+// so dispatch costs one indirect call per batch rather than per pair.
+// Box-box and sphere-sphere buckets use the SIMD kernels in
+// BatchNarrowphase; convex hulls go through GJK/EPA against any shape; the
+// rest are scalar loops over inlined pair tests.
+class ShapeCollision {
+public:
+  // contacts must have room for pairs.size() records. Contacts come out
+  // grouped by bucket and in pair order within a bucket. scratch holds the
+  // bucketed pairs and keeps its capacity between calls.
+  static size_t findContacts(const ShapeView& view, std::span<const BodyPair> pairs,
+                             std::vector<BodyPair>& scratch, Contact* contacts);
+
+  static PairBatchFn getPairFunction(ShapeType typeA, ShapeType typeB);
+
+  // Single pair of any shape types.
+  static CollisionInfo collide(const ShapeView& view, uint32_t indexA, uint32_t indexB);
+};
+
+}
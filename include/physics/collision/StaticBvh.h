@@ -0,0 +1,94 @@
+#pragma once
+#include "physics/collision/AABB.h"
+#include "physics/parallel/ThreadPool.h"
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace physics::collision {
+
+// One cache line holding the bounds of both children, quantized to 16 bits
+// per axis over the tree's bounds (rounded outwards, so they only ever grow).
+// A child with a non-zero count is a leaf covering primitives
+// [child, child + count); otherwise child is the index of an inner node.
+// An unused child has count 0 and child UINT32_MAX.
+struct alignas(64) BvhNode {
+  uint16_t childMin[2][3];
+  uint16_t childMax[2][3];
+  uint32_t child[2];
+  uint32_t count[2];
+};
+
+static_assert(sizeof(BvhNode) == 64, "BvhNode should fill exactly one cache line");
+
+// Bounding volume hierarchy over geometry that never moves. It is built once
+// with the binned surface area heuristic and stored as a flat node array, and
+// is never refit. Primitives are renumbered in leaf order: query() reports
+// primitive k, and getPrimitiveOrder()[k] is its index in the build input.
+//
+// The top of the tree is split serially until the pending subtrees are
+// small. Those subtrees are then built in parallel and spliced in order, so
+// the tree does not depend on the thread count.
+class StaticBvh {
+public:
+  StaticBvh();
+
+  void build(std::span<const AABB> bounds, physics::parallel::ThreadPool* pool = nullptr);
+  void clear();
+
+  // Calls visit(k) for every primitive whose bounds overlap box.
+  template <typename Visitor>
+  void query(const AABB& box, Visitor&& visit) const;
+
+  size_t getPrimitiveCount() const;
+  size_t getNodeCount() const;
+  size_t getDepth() const;
+  const AABB& getBounds() const;
+  std::span<const BvhNode> getNodes() const;
+  std::span<const uint32_t> getPrimitiveOrder() const;
+  std::span<const AABB> getPrimitiveBounds() const;
+
+private:
+  struct Builder;
+
+  void quantize(const AABB& box, uint16_t outMin[3], uint16_t outMax[3]) const;
+
+  std::vector<BvhNode> nodes;
+  std::vector<uint32_t> primitiveOrder;
+  std::vector<AABB> primitiveBounds;
+  AABB bounds;
+  float quantizeScale[3];
+  size_t depth;
+};
+
+template <typename Visitor>
+void StaticBvh::query(const AABB& box, Visitor&& visit) const {
+  if (nodes.empty() || !bounds.intersects(box)) return;
+  uint16_t queryMin[3];
+  uint16_t queryMax[3];
+  quantize(box, queryMin, queryMax);
+
+  // The builder caps the depth well below the stack size.
+  uint32_t stack[64];
+  size_t top = 0;
+  stack[top++] = 0;
+  while (top > 0) {
+    const BvhNode& node = nodes[stack[--top]];
+    for (int c = 1; c >= 0; c--) {
+      if (node.childMin[c][0] > queryMax[0] || node.childMax[c][0] < queryMin[0] ||
+          node.childMin[c][1] > queryMax[1] || node.childMax[c][1] < queryMin[1] ||
+          node.childMin[c][2] > queryMax[2] || node.childMax[c][2] < queryMin[2]) {
+        continue;
+      }
+      if (node.count[c] == 0) {
+        if (node.child[c] != UINT32_MAX) stack[top++] = node.child[c];
+        continue;
+      }
+      for (uint32_t k = node.child[c]; k < node.child[c] + node.count[c]; k++) {
+        if (primitiveBounds[k].intersects(box)) visit(k);
+      }
+    }
+  }
+}
+
+}
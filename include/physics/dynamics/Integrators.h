@@ -0,0 +1,97 @@
+#pragma once
+#include "physics/dynamics/RigidBody.h"
+#include "physics/math/Vec3.h"
+
+namespace physics::dynamics {
+
+// Integrator policies. Each policy advances one body by deltaTime given an
+// acceleration function accel(position, velocity) -> Vec3. Policies are plain
+// structs with static members so the choice is resolved at compile time and
+// the per-body loop in World stays inlined.
+
+struct SemiImplicitEuler {
+    template <typename AccelFn>
+    static void integrate(RigidBody& body, float deltaTime, AccelFn&& accel) {
+        body.velocity += accel(body.position, body.velocity) * deltaTime;
+        body.position += body.velocity * deltaTime;
+    }
+};
+
+// Drift-kick-drift leapfrog. Symplectic, second order, one force evaluation.
+struct PositionVerlet {
+    template <typename AccelFn>
+    static void integrate(RigidBody& body, float deltaTime, AccelFn&& accel) {
+        float halfDt = deltaTime * 0.5f;
+        body.position += body.velocity * halfDt;
+        body.velocity += accel(body.position, body.velocity) * deltaTime;
+        body.position += body.velocity * halfDt;
+    }
+};
+
+// Kick-drift-kick form. Symplectic, second order, two force evaluations.
+struct VelocityVerlet {
+    template <typename AccelFn>
+    static void integrate(RigidBody& body, float deltaTime, AccelFn&& accel) {
+        physics::math::Vec3 a0 = accel(body.position, body.velocity);
+        body.position += body.velocity * deltaTime + a0 * (0.5f * deltaTime * deltaTime);
+        physics::math::Vec3 a1 = accel(body.position, body.velocity + a0 * deltaTime);
+        body.velocity += (a0 + a1) * (0.5f * deltaTime);
+    }
+};
+
+// Classic fourth order Runge-Kutta. Not symplectic, but very accurate per step.
+struct RK4 {
+    template <typename AccelFn>
+    static void integrate(RigidBody& body, float deltaTime, AccelFn&& accel) {
+        using Vec3 = physics::math::Vec3;
+        float halfDt = deltaTime * 0.5f;
+        Vec3 x0 = body.position;
+        Vec3 v0 = body.velocity;
+
+        Vec3 k1x = v0;
+        Vec3 k1v = accel(x0, v0);
+
+        Vec3 k2x = v0 + k1v * halfDt;
+        Vec3 k2v = accel(x0 + k1x * halfDt, k2x);
+
+        Vec3 k3x = v0 + k2v * halfDt;
+        Vec3 k3v = accel(x0 + k2x * halfDt, k3x);
+
+        Vec3 k4x = v0 + k3v * deltaTime;
+        Vec3 k4v = accel(x0 + k3x * deltaTime, k4x);
+
+        float sixthDt = deltaTime / 6.0f;
+        body.position = x0 + (k1x + (k2x + k3x) * 2.0f + k4x) * sixthDt;
+        body.velocity = v0 + (k1v + (k2v + k3v) * 2.0f + k4v) * sixthDt;
+    }
+};
+
+// Integrates a body with the given policy using its accumulated acceleration
+// plus an optional position/velocity dependent field (springs, drag, ...).
+// Static bodies are skipped and accumulated forces are cleared afterwards,
+// matching RigidBody::integrate.
+template <typename Integrator, typename ForceField>
+inline void integrateBody(RigidBody& body, float deltaTime, ForceField&& field) {
+    if (body.isStatic) return;
+
+    physics::math::Vec3 accumulated = body.acceleration;
+    Integrator::integrate(body, deltaTime,
+        [&](const physics::math::Vec3& position, const physics::math::Vec3& velocity) {
+            return accumulated + field(body, position, velocity);
+        });
+    body.clearForces();
+}
+
+template <typename Integrator>
+inline void integrateBody(RigidBody& body, float deltaTime) {
+    if (body.isStatic) return;
+
+    physics::math::Vec3 accumulated = body.acceleration;
+    Integrator::integrate(body, deltaTime,
+        [&](const physics::math::Vec3&, const physics::math::Vec3&) {
+            return accumulated;
+        });
+    body.clearForces();
+}
+
+}
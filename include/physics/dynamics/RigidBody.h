@@ -1,6 +1,8 @@
 #pragma once
 #include "physics/math/Vec3.h"
 #include "physics/collision/AABB.h"
+#include "physics/collision/CollisionFilter.h"
+#include "physics/collision/Shape.h"
 
 namespace physics::dynamics {
 
@@ -16,6 +18,10 @@ public:
     float restitution;
     bool isStatic;
     bool onGround;
+    // Defaults to the axis-aligned box given by size.
+    physics::collision::Shape shape;
+    // Collision layers; the default collides with everything.
+    physics::collision::CollisionFilter filter;
     
     RigidBody();
     RigidBody(const physics::math::Vec3& position, const physics::math::Vec3& size, float mass = 1.0f);
@@ -23,6 +29,10 @@ public:
     void setMass(float mass);
     void makeStatic();
     void makeDynamic(float mass);
+    // Also sets size to the shape's extents in its own frame, so code that
+    // only understands boxes (region files, domain messages) keeps a
+    // conservative approximation.
+    void setShape(const physics::collision::Shape& shape);
     
     void applyForce(const physics::math::Vec3& force);
     void applyImpulse(const physics::math::Vec3& impulse);
@@ -0,0 +1,18 @@
+#pragma once
+#include "physics/math/Vec3.h"
+#include <cstdint>
+
+namespace physics::math {
+
+// 3D Morton (Z-order) codes with 10 bits per axis packed into 30 bits.
+// Points close in space map to codes close in value, so sorting by code
+// places spatial neighbours next to each other in memory.
+
+uint32_t expandBits10(uint32_t value);
+uint32_t mortonEncode(uint32_t x, uint32_t y, uint32_t z);
+
+// Quantizes point into the [boundsMin, boundsMax] box before encoding.
+// Points outside the box are clamped to its faces.
+uint32_t mortonEncode(const Vec3& point, const Vec3& boundsMin, const Vec3& boundsMax);
+
+}
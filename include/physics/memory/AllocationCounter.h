@@ -0,0 +1,20 @@
+#pragma once
+#include <cstdint>
+
+namespace physics::memory {
+
+// Debug counters of global operator new calls made on the current thread.
+// Counting is only live in builds compiled with PHYSICS_COUNT_ALLOCATIONS,
+// which replaces the global allocation functions (the test build does this).
+// Otherwise the counts stay at zero.
+//
+// The attributed count adds the allocations that pool workers made while
+// running chunks this thread handed out (ThreadPool credits them when the
+// parallelFor returns), so it covers a thread's own work wherever it ran and
+// nothing that other threads did meanwhile.
+bool allocationCountingEnabled();
+uint64_t threadAllocationCount();
+uint64_t attributedAllocationCount();
+void attributeAllocations(uint64_t count);
+
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+
+namespace physics::memory {
+
+// Linear allocator for per-step scratch data. Allocation bumps a pointer,
+// deallocation is a no-op and reset() rewinds everything at once. Memory is
+// kept across resets; if a frame overflowed into extra blocks they are
+// merged into a single block on the next reset, so a steady-state frame
+// never reaches the upstream resource.
+class FrameArena : public std::pmr::memory_resource {
+public:
+    explicit FrameArena(size_t initialCapacity = 64 * 1024,
+                        std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+    ~FrameArena() override;
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void reset();
+
+    size_t getBytesUsed() const;
+    size_t getCapacity() const;
+    size_t getPeakBytesUsed() const;
+    uint64_t getUpstreamAllocationCount() const;
+
+private:
+    struct Block {
+        Block* next;
+        size_t size;
+        size_t used;
+    };
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    Block* allocateBlock(size_t size);
+    void releaseBlocks();
+
+    std::pmr::memory_resource* upstream;
+    Block* head;
+    size_t bytesUsed;
+    size_t peakBytesUsed;
+    uint64_t upstreamAllocations;
+};
+
+}
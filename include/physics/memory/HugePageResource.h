@@ -0,0 +1,81 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+namespace physics::memory {
+
+enum class HugePageMode {
+    // Plain 4 KB pages; the mapping is still 2 MB aligned.
+    None,
+    // Transparent huge pages requested with madvise(MADV_HUGEPAGE).
+    Transparent,
+    // hugetlbfs pages (MAP_HUGETLB). Falls back to Transparent when the
+    // system has no free huge pages reserved.
+    Explicit
+};
+
+enum class NumaPolicy {
+    // Pages land on the node of the thread that first writes them.
+    FirstTouch,
+    // Pages prefer settings.numaNode and spill elsewhere when it is full.
+    Preferred,
+    // Pages alternate between all nodes.
+    Interleave
+};
+
+struct HugePageSettings {
+    HugePageMode mode = HugePageMode::Transparent;
+    NumaPolicy numaPolicy = NumaPolicy::FirstTouch;
+    unsigned numaNode = 0;
+    // Smaller requests go to the upstream resource.
+    size_t minMappingBytes = 256 * 1024;
+};
+
+// Memory resource for bulk arrays. Each large request gets its own anonymous
+// mapping, rounded up to and aligned on 2 MB so it can be backed by huge
+// pages, with an optional NUMA placement policy applied before any page is
+// touched. Containers growing geometrically only make a handful of such
+// requests. Placement and huge page requests are hints: when the kernel
+// refuses one the memory is still usable and the failure is counted.
+class HugePageResource : public std::pmr::memory_resource {
+public:
+    static constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+
+    explicit HugePageResource(const HugePageSettings& settings = HugePageSettings(),
+                              std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+
+    HugePageResource(const HugePageResource&) = delete;
+    HugePageResource& operator=(const HugePageResource&) = delete;
+
+    const HugePageSettings& getSettings() const;
+    size_t getMappedBytes() const;
+    size_t getMappingCount() const;
+    uint64_t getExplicitFallbackCount() const;
+    uint64_t getPlacementFailureCount() const;
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    bool isMapped(size_t bytes, size_t alignment) const;
+    void* mapAligned(size_t size);
+    void applyPlacement(void* p, size_t size);
+
+    HugePageSettings settings;
+    std::pmr::memory_resource* upstream;
+    std::atomic<size_t> mappedBytes;
+    std::atomic<size_t> mappingCount;
+    std::atomic<uint64_t> explicitFallbacks;
+    std::atomic<uint64_t> placementFailures;
+};
+
+// NUMA topology from sysfs. Without it the machine counts as a single node
+// holding every CPU.
+size_t numaNodeCount();
+std::vector<unsigned> numaNodeCpus(unsigned node);
+
+}
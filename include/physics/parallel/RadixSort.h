@@ -0,0 +1,22 @@
+#pragma once
+#include "physics/parallel/ThreadPool.h"
+#include <cstdint>
+#include <vector>
+
+namespace physics::parallel {
+
+// Buffers reused between sorts so repeated sorts of similar size do not allocate.
+struct RadixSortScratch {
+    std::vector<uint32_t> keys;
+    std::vector<uint32_t> values;
+    std::vector<uint32_t> histograms;
+};
+
+// Stable LSD radix sort of (key, value) pairs by key, 8 bits per pass.
+// Only the low keyBits of each key take part, so 30-bit Morton codes need
+// four passes. Each pass builds per-chunk histograms in parallel, prefix
+// sums them serially and scatters in parallel.
+void radixSortPairs(std::vector<uint32_t>& keys, std::vector<uint32_t>& values, RadixSortScratch& scratch,
+                    unsigned keyBits = 32, ThreadPool* pool = nullptr);
+
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace physics::parallel {
+
+// Single-producer single-consumer ring of fixed-size slots in POSIX shared
+// memory, usable between processes on one machine. One process creates the
+// segment (and unlinks it when done), the peers open it by name. push/pop
+// never block; they return false when the ring is full or empty.
+class SharedRingBuffer {
+public:
+    static SharedRingBuffer create(const std::string& name, size_t slotSize, size_t slotCount);
+    static SharedRingBuffer open(const std::string& name);
+    static void unlink(const std::string& name);
+
+    SharedRingBuffer();
+    ~SharedRingBuffer();
+    SharedRingBuffer(SharedRingBuffer&& other) noexcept;
+    SharedRingBuffer& operator=(SharedRingBuffer&& other) noexcept;
+    SharedRingBuffer(const SharedRingBuffer&) = delete;
+    SharedRingBuffer& operator=(const SharedRingBuffer&) = delete;
+
+    bool isValid() const;
+    size_t getSlotSize() const;
+    size_t getSlotCount() const;
+    size_t size() const;
+
+    bool push(const void* slot);
+    bool pop(void* slot);
+
+private:
+    struct Header;
+
+    SharedRingBuffer(void* mapping, size_t mappingSize);
+    char* slotData() const;
+
+    void* mapping;
+    size_t mappingSize;
+};
+
+}
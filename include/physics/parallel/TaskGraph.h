@@ -0,0 +1,76 @@
+#pragma once
+#include "physics/parallel/ThreadPool.h"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace physics::parallel {
+
+using TaskId = uint32_t;
+using TaskFn = void (*)(void* context, size_t arg);
+
+// Dependency graph of small tasks. Each task is a function pointer, a
+// context pointer and an integer argument, so building and running a graph
+// does not allocate once its vectors have grown to the frame's size; clear()
+// keeps the capacity for the next frame.
+//
+// run() starts every task as soon as all of its predecessors have finished
+// instead of waiting on whole-stage barriers. With a pool the work is spread
+// over its threads; without one tasks execute in a deterministic
+// topological order on the calling thread. A graph whose dependencies form
+// a cycle is never started: run() throws std::logic_error.
+class TaskGraph {
+public:
+    TaskGraph();
+
+    TaskId addTask(TaskFn fn, void* context, size_t arg = 0, const char* name = nullptr);
+    // No-op node used to join a group of tasks into one dependency.
+    TaskId addJoin(const char* name = nullptr);
+    void addDependency(TaskId before, TaskId after);
+
+    void clear();
+    void run(ThreadPool* pool = nullptr);
+
+    size_t getTaskCount() const;
+    const char* getTaskName(TaskId id) const;
+    // Completion order of the last run, for tests and profiling.
+    const std::vector<TaskId>& getLastRunOrder() const;
+
+private:
+    struct Task {
+        TaskFn fn;
+        void* context;
+        size_t arg;
+        const char* name;
+    };
+
+    void buildSuccessors();
+    bool isAcyclic();
+    void runSerial();
+    void runParallel(ThreadPool& pool);
+    void workerLoop();
+    void completeTask(TaskId id);
+
+    std::vector<Task> tasks;
+    std::vector<std::pair<TaskId, TaskId>> edges;
+
+    std::vector<uint32_t> successorOffsets;
+    std::vector<TaskId> successors;
+    std::vector<uint32_t> pendingPredecessors;
+    std::vector<TaskId> readyQueue;
+    size_t readyHead;
+    size_t readyTail;
+    size_t completedCount;
+    std::vector<TaskId> runOrder;
+    // Scratch for isAcyclic, kept so the check does not allocate either.
+    std::vector<uint32_t> checkPredecessors;
+    std::vector<TaskId> checkQueue;
+
+    std::mutex mutex;
+    std::condition_variable readyCondition;
+};
+
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace physics::parallel {
+
+// Fixed set of worker threads that execute parallelFor ranges. The calling
+// thread always participates, so a pool with zero workers runs serially.
+// parallelFor does not allocate: the range callback is passed by pointer.
+// Calls from inside a running range fall back to serial execution. What the
+// workers allocate during a parallelFor is credited to the calling thread's
+// attributed allocation count (AllocationCounter.h).
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t workerCount = defaultWorkerCount());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t getWorkerCount() const;
+    size_t getConcurrency() const;
+
+    // Pins worker i to cpus[i % cpus.size()], for example the CPUs of one
+    // NUMA node (see HugePageResource.h) so workers stay next to memory
+    // placed there. Returns false if any worker could not be pinned.
+    bool pinWorkers(std::span<const unsigned> cpus);
+    // Restricts the calling thread, which also runs chunks, to the CPU set.
+    static bool pinCallingThread(std::span<const unsigned> cpus);
+
+    // Calls fn(begin, end) over [0, count) in chunks of at least grain items.
+    template <typename Fn>
+    void parallelFor(size_t count, size_t grain, Fn&& fn);
+
+    static size_t defaultWorkerCount();
+    static ThreadPool& shared();
+    static bool inParallelRegion();
+
+private:
+    using RangeFn = void (*)(void* context, size_t begin, size_t end);
+
+    void run(size_t count, size_t grain, RangeFn fn, void* context);
+    void workerLoop();
+    void executeChunks();
+
+    std::vector<std::thread> workers;
+
+    std::mutex runMutex;
+    std::mutex mutex;
+    std::condition_variable wakeCondition;
+    std::condition_variable doneCondition;
+
+    RangeFn jobFn;
+    void* jobContext;
+    size_t jobCount;
+    size_t jobGrain;
+    std::atomic<size_t> nextChunk;
+    size_t busyWorkers;
+    uint64_t jobAllocations;
+    uint64_t generation;
+    bool stopping;
+};
+
+template <typename Fn>
+void ThreadPool::parallelFor(size_t count, size_t grain, Fn&& fn) {
+    if (count == 0) return;
+    if (grain == 0) grain = 1;
+    if (workers.empty() || count <= grain || inParallelRegion()) {
+        fn(size_t(0), count);
+        return;
+    }
+    using FnType = std::remove_reference_t<Fn>;
+    run(count, grain, [](void* context, size_t begin, size_t end) {
+        (*static_cast<FnType*>(context))(begin, end);
+    }, const_cast<void*>(static_cast<const void*>(&fn)));
+}
+
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace physics::world {
+
+// Stable handle to a body. Indices change when bodies are removed or the
+// storage is reordered; ids stay valid until the body is removed, after
+// which the id may be reused by a later addBody.
+using BodyId = uint32_t;
+inline constexpr BodyId InvalidBodyId = UINT32_MAX;
+inline constexpr size_t InvalidBodyIndex = SIZE_MAX;
+
+}
@@ -0,0 +1,143 @@
+#pragma once
+#include "physics/collision/AABB.h"
+#include "physics/collision/CollisionFilter.h"
+#include "physics/collision/StaticBvh.h"
+#include "physics/math/Vec3.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace physics::world {
+
+using CharacterId = uint32_t;
+inline constexpr CharacterId InvalidCharacterId = UINT32_MAX;
+
+// Movement tuning shared by every controller, in meters and seconds. The
+// defaults follow Source engine movement scaled to meters.
+struct CharacterSettings {
+    float maxSpeed = 6.1f;
+    float groundAcceleration = 10.0f;
+    float airAcceleration = 10.0f;
+    // Wish speed used for air acceleration. A small cap is what lets players
+    // gain speed by strafing and turning in the air.
+    float airSpeedCap = 0.57f;
+    float friction = 4.0f;
+    // Friction treats slower speeds as this one, so characters stop quickly.
+    float stopSpeed = 1.9f;
+    float jumpSpeed = 5.1f;
+    // Obstacles up to this height are climbed without jumping.
+    float stepHeight = 0.35f;
+    // Grounded characters follow the ground down slopes and steps up to this
+    // far instead of launching off them.
+    float snapDistance = 0.25f;
+    // Gap kept between a character and the geometry it touches.
+    float skinWidth = 0.01f;
+    // Surfaces whose normal has at least this up component count as ground.
+    float minGroundNormalY = 0.7f;
+};
+
+// Static geometry the controllers collide with: the world's baked static
+// bodies, found through its BVH, with their bounds and filters indexed by
+// slot.
+struct CharacterGeometry {
+    const physics::collision::StaticBvh* bvh = nullptr;
+    const physics::collision::AABB* bounds = nullptr;
+    const physics::collision::CollisionFilter* filters = nullptr;
+    physics::math::Vec3 gravity;
+};
+
+// Kinematic character controllers. A character is an axis-aligned box that
+// is not a body: the solver never pushes it, and it moves by collide and
+// slide, sweeping its box along the desired motion and sliding along
+// whatever it hits. Grounded characters climb steps and snap down to the
+// ground; airborne ones get Quake-style air acceleration.
+//
+// Characters only see baked static geometry (World::bakeStaticGeometry), so
+// each one reads shared immutable data and writes only its own state. All
+// characters are updated together in independent chunks, in parallel within
+// a world step, with the same result as a serial update. Characters do not
+// collide with each other or with dynamic bodies.
+//
+// State is kept as structure of arrays indexed by a dense slot; ids stay
+// valid until removed.
+class CharacterSystem {
+public:
+    CharacterSettings settings;
+
+    CharacterSystem();
+
+    // halfExtents is half the size of the character's box, which is centered
+    // on position.
+    CharacterId add(const physics::math::Vec3& position, const physics::math::Vec3& halfExtents,
+                    const physics::collision::CollisionFilter& filter = physics::collision::CollisionFilter());
+    void remove(CharacterId id);
+    void clear();
+
+    bool isValid(CharacterId id) const;
+    size_t getCount() const;
+
+    // Movement input for the following updates. wishDirection is projected
+    // onto the horizontal plane; wishSpeed is capped at settings.maxSpeed. A
+    // jump is consumed by the next update that finds the character grounded.
+    void setInput(CharacterId id, const physics::math::Vec3& wishDirection, float wishSpeed, bool jump = false);
+    // Moves the character without sweeping.
+    void teleport(CharacterId id, const physics::math::Vec3& position);
+    void setVelocity(CharacterId id, const physics::math::Vec3& velocity);
+
+    physics::math::Vec3 getPosition(CharacterId id) const;
+    physics::math::Vec3 getVelocity(CharacterId id) const;
+    bool isGrounded(CharacterId id) const;
+    physics::collision::AABB getBounds(CharacterId id) const;
+
+    // Updates the characters in slots [begin, end). Disjoint ranges may run
+    // concurrently.
+    void update(const CharacterGeometry& geometry, float deltaTime, size_t begin, size_t end);
+    void update(const CharacterGeometry& geometry, float deltaTime);
+
+private:
+    struct Hit {
+        float time;
+        physics::math::Vec3 normal;
+    };
+
+    struct Body {
+        physics::math::Vec3 position;
+        physics::math::Vec3 velocity;
+        physics::math::Vec3 halfExtents;
+        physics::collision::CollisionFilter filter;
+    };
+
+    void updateOne(const CharacterGeometry& geometry, float deltaTime, size_t slot);
+    bool sweep(const CharacterGeometry& geometry, const Body& body, const physics::math::Vec3& delta, Hit& hit) const;
+    void depenetrate(const CharacterGeometry& geometry, Body& body) const;
+    // Moves by delta, sliding along hits. Returns true if it hit ground.
+    bool slide(const CharacterGeometry& geometry, Body& body, physics::math::Vec3 delta) const;
+    bool stepUp(const CharacterGeometry& geometry, Body& body, const physics::math::Vec3& delta) const;
+    bool snapToGround(const CharacterGeometry& geometry, Body& body) const;
+    void accelerate(physics::math::Vec3& velocity, const physics::math::Vec3& wishDirection, float wishSpeed,
+                    float acceleration, float deltaTime) const;
+    void applyFriction(physics::math::Vec3& velocity, float deltaTime) const;
+    size_t slotOf(CharacterId id) const;
+
+    std::vector<CharacterId> ids;
+    std::vector<float> positionX;
+    std::vector<float> positionY;
+    std::vector<float> positionZ;
+    std::vector<float> velocityX;
+    std::vector<float> velocityY;
+    std::vector<float> velocityZ;
+    std::vector<float> halfExtentX;
+    std::vector<float> halfExtentY;
+    std::vector<float> halfExtentZ;
+    std::vector<float> wishX;
+    std::vector<float> wishZ;
+    std::vector<float> wishSpeed;
+    std::vector<uint8_t> jumpRequested;
+    std::vector<uint8_t> grounded;
+    std::vector<physics::collision::CollisionFilter> filters;
+
+    std::vector<uint32_t> idToSlot;
+    std::vector<CharacterId> freeIds;
+};
+
+}
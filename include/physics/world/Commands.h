@@ -0,0 +1,112 @@
+#pragma once
+#include "physics/dynamics/RigidBody.h"
+#include "physics/math/Vec3.h"
+#include "physics/world/BodyId.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace physics::world {
+
+enum class CommandType : uint8_t {
+    Spawn,
+    Despawn,
+    ApplyImpulse,
+    ApplyForce,
+    Teleport,
+    SetMass
+};
+
+// One deferred mutation. order is the writer's key in the high 32 bits and
+// its own sequence number in the low ones.
+struct Command {
+    uint64_t order;
+    CommandType type;
+    BodyId body;
+    physics::math::Vec3 value;
+    float mass;
+    // Spawn only: the body, owned by the command until it is applied, and
+    // where to store its id.
+    physics::dynamics::RigidBody* spawn;
+    BodyId* spawnedId;
+};
+
+// Commands published together by one writer.
+struct CommandBatch {
+    std::vector<Command> commands;
+    CommandBatch* next = nullptr;
+
+    ~CommandBatch();
+};
+
+class CommandBuffer;
+
+// Records commands for one producer, typically one per job or thread. A
+// writer is not itself thread safe; writers are. Commands become visible
+// to the world in batches: when flush() is called, when the batch reaches
+// kBatchSize commands, and when the writer is destroyed. Keys order the
+// writers' commands when they are applied, so give concurrent writers
+// different keys that do not depend on scheduling (a job index, not a
+// thread id).
+class CommandWriter {
+public:
+    static constexpr size_t kBatchSize = 256;
+
+    CommandWriter(CommandBuffer& buffer, uint32_t key);
+    CommandWriter(CommandWriter&& other) noexcept;
+    CommandWriter& operator=(CommandWriter&&) = delete;
+    CommandWriter(const CommandWriter&) = delete;
+    CommandWriter& operator=(const CommandWriter&) = delete;
+    ~CommandWriter();
+
+    // Adds the body when the commands are applied. If spawnedId is given,
+    // the new id is written to it then, so it must stay valid until then.
+    void spawn(std::unique_ptr<physics::dynamics::RigidBody> body, BodyId* spawnedId = nullptr);
+    void despawn(BodyId id);
+    void applyImpulse(BodyId id, const physics::math::Vec3& impulse);
+    // Acts during the step that applies it.
+    void applyForce(BodyId id, const physics::math::Vec3& force);
+    // Moves the body without changing its velocity.
+    void teleport(BodyId id, const physics::math::Vec3& position);
+    // A mass of zero or less makes the body static.
+    void setMass(BodyId id, float mass);
+
+    void flush();
+
+private:
+    void record(CommandType type, BodyId id, const physics::math::Vec3& value, float mass,
+                physics::dynamics::RigidBody* spawn, BodyId* spawnedId);
+
+    CommandBuffer* buffer;
+    uint64_t key;
+    uint32_t sequence;
+    std::unique_ptr<CommandBatch> batch;
+};
+
+// Lock-free multi-producer queue of command batches. Writers push finished
+// batches onto a single atomic list; the world takes the whole list at the
+// start of a step, so recording never waits on the step or on other
+// writers. Commands that are still in a writer's open batch at that point
+// wait for the next step.
+class CommandBuffer {
+public:
+    CommandBuffer();
+    CommandBuffer(const CommandBuffer&) = delete;
+    CommandBuffer& operator=(const CommandBuffer&) = delete;
+    ~CommandBuffer();
+
+    CommandWriter writer(uint32_t key);
+
+    void publish(std::unique_ptr<CommandBatch> batch);
+    // Moves every published command into out, sorted by order, and frees
+    // the batches. Must not run concurrently with itself.
+    void take(std::vector<Command>& out);
+    bool empty() const;
+
+private:
+    std::atomic<CommandBatch*> head;
+};
+
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include "physics/collision/CollisionDetection.h"
+#include "physics/world/BodyId.h"
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace physics::world {
+
+enum class ContactEventType : uint8_t {
+    Began,
+    Persisted,
+    Ended
+};
+
+struct ContactEvent {
+    ContactEventType type;
+    BodyId bodyA;
+    BodyId bodyB;
+    // Ended events repeat the last contact seen for the pair, with zero
+    // impulse.
+    physics::collision::CollisionInfo info;
+    // Normal impulse the solver applied to the pair this step.
+    float impulse;
+};
+
+struct ContactEventSettings {
+    bool enabled = false;
+    // Only report pairs where at least one body is subscribed.
+    bool subscribedOnly = false;
+};
+
+// Turns each step's contact list into began/persisted/ended events by
+// diffing it against the previous step's pairs. Both lists are kept sorted
+// by pair key and merged in one pass, so an update costs a sort of the
+// reported contacts and no allocation once the buffers have grown. Events
+// come out in pair-key order, which does not depend on thread scheduling.
+class ContactEventStream {
+public:
+    void update(std::span<const physics::collision::Contact> contacts, std::span<const float> impulses,
+                const BodyId* bodyIds, bool subscribedOnly);
+
+    // Subscriptions are by id, so they survive storage reordering.
+    void subscribe(BodyId id, bool subscribed = true);
+    bool isSubscribed(BodyId id) const;
+
+    // Ends every tracked pair for which removed(id) holds on either body.
+    // The ended events are reported by the next update, before a reused id
+    // can be mistaken for the old body.
+    template <typename IsRemoved>
+    void markRemoved(IsRemoved&& removed);
+    void markAllRemoved();
+    // Forgets tracked pairs and events without reporting them, for when
+    // event reporting is switched off.
+    void reset();
+
+    std::span<const ContactEvent> getEvents() const;
+    size_t getTrackedPairCount() const;
+
+private:
+    struct TrackedPair {
+        uint64_t key;
+        BodyId bodyA;
+        BodyId bodyB;
+        physics::collision::CollisionInfo info;
+        bool removed;
+    };
+
+    struct CurrentContact {
+        uint64_t key;
+        uint32_t contact;
+    };
+
+    std::vector<TrackedPair> tracked;
+    std::vector<TrackedPair> nextTracked;
+    std::vector<CurrentContact> current;
+    std::vector<ContactEvent> events;
+    std::vector<uint8_t> subscriptions;
+};
+
+template <typename IsRemoved>
+void ContactEventStream::markRemoved(IsRemoved&& removed) {
+    for (TrackedPair& pair : tracked) {
+        if (removed(pair.bodyA) || removed(pair.bodyB)) {
+            pair.removed = true;
+        }
+    }
+}
+
+}
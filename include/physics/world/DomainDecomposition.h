@@ -0,0 +1,137 @@
+#pragma once
+#include "physics/parallel/SharedRingBuffer.h"
+#include "physics/world/World.h"
+#include <chrono>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace physics::world {
+
+// Splits space into equal slabs along one axis; slab i is owned by domain i.
+// Positions beyond the outer slabs belong to the first or last domain.
+struct SlabLayout {
+    int axis;
+    float origin;
+    float slabWidth;
+    uint32_t domainCount;
+    float haloWidth;
+
+    uint32_t domainOf(const physics::math::Vec3& position) const;
+    float lowerBound(uint32_t domain) const;
+    float upperBound(uint32_t domain) const;
+    float coordinate(const physics::math::Vec3& position) const;
+};
+
+// Fixed-size record exchanged between neighbouring domains. A convex hull
+// travels as its index in the nodes' hull tables; hullIndex is ~0 for every
+// other shape.
+struct DomainMessage {
+    enum Kind : uint32_t { Ghost = 0, Migrate = 1, EndOfFrame = 2 };
+
+    uint32_t kind;
+    uint32_t frame;
+    float position[3];
+    float velocity[3];
+    float size[3];
+    float mass;
+    float friction;
+    float restitution;
+    uint32_t flags;
+    uint32_t shapeType;
+    uint32_t hullIndex;
+    float shapeRadius;
+    float shapeHalfHeight;
+    float shapeHalfExtents[3];
+    float shapeAxes[9];
+    uint32_t filterCategory;
+    uint32_t filterMask;
+    int32_t filterGroup;
+};
+
+// Ordered, non-blocking message channel to each neighbouring domain.
+// Neighbour 0 is the lower slab, neighbour 1 the upper slab. Shared memory is
+// the local implementation; a socket transport only has to provide the same
+// per-neighbour FIFO semantics.
+class DomainTransport {
+public:
+    virtual ~DomainTransport() = default;
+    virtual bool hasNeighbor(uint32_t neighbor) const = 0;
+    virtual bool trySend(uint32_t neighbor, const DomainMessage& message) = 0;
+    virtual bool tryReceive(uint32_t neighbor, DomainMessage& message) = 0;
+};
+
+class SharedMemoryTransport : public DomainTransport {
+public:
+    // Creates one ring per direction between each pair of neighbouring
+    // domains. Run once before the domain processes attach.
+    static void createRings(const std::string& prefix, uint32_t domainCount, size_t slotCount = 4096);
+    static void unlinkRings(const std::string& prefix, uint32_t domainCount);
+    static std::string ringName(const std::string& prefix, uint32_t from, uint32_t to);
+
+    SharedMemoryTransport(const std::string& prefix, uint32_t domain, uint32_t domainCount);
+
+    bool hasNeighbor(uint32_t neighbor) const override;
+    bool trySend(uint32_t neighbor, const DomainMessage& message) override;
+    bool tryReceive(uint32_t neighbor, DomainMessage& message) override;
+
+private:
+    physics::parallel::SharedRingBuffer outgoing[2];
+    physics::parallel::SharedRingBuffer incoming[2];
+};
+
+// Runs one slab of a decomposed world. Each step the node sends copies of
+// owned bodies within haloWidth of a border to that neighbour as ghosts,
+// hands over bodies that have left its slab, and waits for the neighbours'
+// messages for the same frame. Ghosts take part in the local World::step so
+// contacts across the border are seen on both sides, and are dropped again
+// afterwards; their owner integrates the authoritative copy.
+//
+// Bodies keep their shape and collision filter across the border. Every
+// node must register the same convex hulls in the same order; a hull that
+// is not registered arrives as the box given by the body's size.
+class DomainNode {
+public:
+    // How long step() waits without any message moving before it gives up
+    // on a neighbour and throws std::runtime_error. The node's bodies are in
+    // an undefined state afterwards. Zero waits forever.
+    std::chrono::milliseconds exchangeTimeout;
+
+    DomainNode(World& world, const SlabLayout& layout, uint32_t domain, DomainTransport& transport);
+
+    void step(float deltaTime);
+
+    uint32_t getDomain() const;
+    uint64_t getFrame() const;
+    size_t getOwnedBodyCount() const;
+    size_t getLastGhostCount() const;
+    size_t getLastMigratedInCount() const;
+    size_t getLastMigratedOutCount() const;
+    // The hull must outlive the node.
+    void registerHull(const physics::collision::ConvexHull& hull);
+
+    static DomainMessage packBody(const physics::dynamics::RigidBody& body, DomainMessage::Kind kind, uint32_t frame,
+                                  std::span<const physics::collision::ConvexHull* const> hulls = {});
+    static physics::dynamics::RigidBody unpackBody(const DomainMessage& message,
+                                                   std::span<const physics::collision::ConvexHull* const> hulls = {});
+
+private:
+    void exchange();
+
+    World& world;
+    SlabLayout layout;
+    uint32_t domain;
+    DomainTransport& transport;
+    uint64_t frame;
+    std::vector<const physics::collision::ConvexHull*> hulls;
+
+    std::vector<DomainMessage> outbox[2];
+    std::vector<BodyId> ghostIds;
+    std::vector<BodyId> leavingIds;
+    size_t lastGhostCount;
+    size_t lastMigratedIn;
+    size_t lastMigratedOut;
+};
+
+}
@@ -0,0 +1,141 @@
+#pragma once
+#include "physics/collision/AABB.h"
+#include "physics/dynamics/RigidBody.h"
+#include "physics/math/Vec3.h"
+#include "physics/parallel/ThreadPool.h"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace physics::world {
+
+struct FluidSettings {
+    physics::math::Vec3 gravity = physics::math::Vec3(0, -9.81f, 0);
+    // Kernel radius h. Particles further apart than this do not interact,
+    // and it is also the size of a grid cell.
+    float smoothingRadius = 0.1f;
+    float restDensity = 1000.0f;
+    // The default fills restDensity at a spacing of half the smoothing
+    // radius; change both together.
+    float particleMass = 0.125f;
+    // Pressure per kg/m^3 above rest density. Its square root is the speed
+    // of sound, which bounds the time step: stiffer fluids compress less
+    // but need smaller steps.
+    float stiffness = 200.0f;
+    // Dynamic viscosity. Large values give mud or a slurry rather than water.
+    float viscosity = 3.0f;
+    // step() splits its time step into substeps no longer than this.
+    float maxTimeStep = 1.0f / 300.0f;
+    // Container the particles cannot leave.
+    physics::collision::AABB bounds = physics::collision::AABB(physics::math::Vec3(-10, 0, -10),
+                                                               physics::math::Vec3(10, 20, 10));
+    // Normal velocity kept (reversed) on hitting the container or a coupled
+    // body, and the share of tangential velocity removed.
+    float restitution = 0.0f;
+    float friction = 0.05f;
+};
+
+// Smoothed particle hydrodynamics (weakly compressible, with the kernels
+// of Mueller et al. 2003), kept apart from World like ParticleSystem.
+// Every substep sorts the particles into a uniform grid of smoothingRadius
+// cells with a counting sort on hashed cell coordinates, so each cell's
+// particles are contiguous and a particle's neighbours are a few runs
+// covering its 27 surrounding cells. The density and force passes walk
+// those runs eight particles at a time with AVX2 when available.
+//
+// The container and coupled rigid bodies (boxes, by their AABB) act as
+// half spaces of fluid at rest: near a face a particle gets the density it
+// is missing and a pressure push, and particles that end up inside a body
+// leave through the nearest face. The body takes the opposite of both with
+// applyImpulse, so floating and pushing come out of the same exchange.
+// Static bodies are obstacles. Buoyancy is underestimated; a floating box
+// sits about twice as deep as its density says.
+//
+// Particles have no identity; the sort reorders them every substep.
+class FluidSystem {
+public:
+    FluidSettings settings;
+    // Pool for the per-particle passes. Chunking is fixed and each particle
+    // is computed on its own, so the result is the same with or without one.
+    physics::parallel::ThreadPool* threadPool;
+
+    FluidSystem();
+
+    size_t spawn(const physics::math::Vec3& position, const physics::math::Vec3& velocity);
+    // Fills region with particles on a grid of the given spacing (half the
+    // smoothing radius matches the default particle mass). Returns how many
+    // were added.
+    size_t spawnBlock(const physics::collision::AABB& region, float spacing,
+                      const physics::math::Vec3& velocity = physics::math::Vec3());
+    void reserve(size_t capacity);
+    void clear();
+
+    // The body must outlive the coupling; remove it before destroying it.
+    void couple(physics::dynamics::RigidBody* body);
+    void decouple(physics::dynamics::RigidBody* body);
+    void clearCoupled();
+
+    void step(float deltaTime);
+    // Same step with the AVX2 kernels disabled, for comparison and testing.
+    void stepScalar(float deltaTime);
+
+    size_t size() const;
+    physics::math::Vec3 getPosition(size_t index) const;
+    physics::math::Vec3 getVelocity(size_t index) const;
+    // As of the last substep's density pass.
+    float getDensity(size_t index) const;
+    std::span<const float> getPositionsX() const;
+    std::span<const float> getPositionsY() const;
+    std::span<const float> getPositionsZ() const;
+
+    static bool hasAvx2Kernel();
+
+private:
+    struct KernelParams {
+        float radius;
+        float radiusSquared;
+        float inverseCellSize;
+        float densityScale;
+        float pressureScale;
+        float viscosityScale;
+        float stiffness;
+        float restDensity;
+        float wallOffset;
+        float low[3];
+        float high[3];
+        uint32_t tableMask;
+    };
+
+    void run(float deltaTime, bool allowSimd);
+    void substep(float deltaTime, const KernelParams& params, bool allowSimd);
+    void buildGrid(const KernelParams& params);
+    void densityChunk(size_t chunk, const KernelParams& params, bool allowSimd);
+    void forceChunk(size_t chunk, const KernelParams& params, bool allowSimd);
+    void integrateChunk(size_t chunk, float deltaTime);
+    void setDensity(size_t index, float value, const KernelParams& params);
+    void bodyDensity(const KernelParams& params);
+    void bodyForces(const KernelParams& params, float deltaTime);
+    void pushOutOfBodies(const KernelParams& params);
+    void pushOut(size_t index, physics::dynamics::RigidBody& body, const physics::collision::AABB& box,
+                 physics::math::Vec3& impulse);
+    template <typename Fn>
+    void forEachChunk(Fn&& fn);
+    template <typename Fn>
+    void forEachNear(const physics::collision::AABB& box, const KernelParams& params, Fn&& fn);
+
+    std::vector<float> positionX, positionY, positionZ;
+    std::vector<float> velocityX, velocityY, velocityZ;
+    std::vector<float> density, inverseDensity, pressure;
+    std::vector<float> accelerationX, accelerationY, accelerationZ;
+    // Grid: cellKeys per particle, then cellStarts[key]..cellStarts[key + 1]
+    // is the sorted run of that key, with the order the sort produced.
+    std::vector<uint32_t> cellKeys;
+    std::vector<uint32_t> cellStarts;
+    std::vector<uint32_t> order;
+    std::vector<float> scratch;
+    std::vector<uint32_t> bodyKeys;
+    std::vector<physics::dynamics::RigidBody*> coupled;
+};
+
+}
@@ -0,0 +1,243 @@
+#pragma once
+#include "physics/dynamics/RigidBody.h"
+#include "physics/math/Vec3.h"
+#include "physics/world/BodyId.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace physics::world {
+
+using JointId = uint32_t;
+inline constexpr JointId InvalidJointId = UINT32_MAX;
+
+enum class JointType : uint8_t {
+    // Keeps the bodies at a fixed distance.
+    Distance,
+    // Pulls the bodies towards a rest length like a damped spring.
+    Spring,
+    // Lets body B swing around an axis through body A: its offset along the
+    // axis and its distance from the axis are held. Bodies carry no
+    // orientation, so this is the translational part of a hinge.
+    Hinge,
+    // Holds body B at a fixed offset from body A.
+    Fixed
+};
+
+inline constexpr size_t kJointTypeCount = 4;
+
+// Stiffness of a soft constraint, given as the natural frequency and damping
+// ratio of the spring-damper it behaves like. The solver derives its
+// per-step coefficients from these and the time step, so a joint responds
+// the same at 60 Hz as at 240 Hz. The spring constant scales with the
+// bodies' masses; a joint carrying a heavy load stretches by about
+// load / (mass * (2 pi hertz)^2). Frequencies above half the step rate are
+// clamped to it.
+struct JointSoftness {
+    float hertz = 30.0f;
+    float dampingRatio = 2.0f;
+};
+
+struct JointSettings {
+    // Gauss-Seidel passes over every joint per step.
+    uint32_t iterations = 4;
+    // Extra passes without the position feedback. They change velocities
+    // only, so the error correction moves bodies without leaving them with
+    // the speed it took. Springs are not relaxed.
+    uint32_t relaxIterations = 1;
+    // Softness of the distance, hinge and fixed joints. Half the step rate
+    // keeps them stiff without the jitter of hard constraints.
+    JointSoftness rigidSoftness;
+    // Starts each step from the previous step's impulses.
+    bool warmStarting = true;
+};
+
+// Joints between pairs of bodies, stored by type in structure-of-arrays
+// batches and solved with sequential impulses after the contact solve.
+//
+// Each step's solve is split into passes that must run in order. A pass
+// holds work items that touch disjoint bodies, so they can run on any
+// thread: the first pass prepares every joint, the following ones apply the
+// warm-start impulses and run the iterations one type and one color at a
+// time. Joints of a type are greedily colored so that joints sharing a body
+// get different colors. The coloring is redone after joints are added or
+// removed; joints past the last color share a pass that runs as one item.
+// solve() runs the same passes serially, so the result does not depend on
+// the thread count.
+//
+// Impulses move positions as well as velocities (by the time step times the
+// velocity change), which makes the solve equivalent to correcting the
+// velocities before integration.
+class JointSystem {
+public:
+    JointSettings settings;
+
+    JointSystem();
+
+    JointId addDistance(BodyId a, BodyId b, float length);
+    JointId addSpring(BodyId a, BodyId b, float restLength, const JointSoftness& softness);
+    // axis must be unit length.
+    JointId addHinge(BodyId a, BodyId b, const physics::math::Vec3& axis, float axialOffset, float radius);
+    JointId addFixed(BodyId a, BodyId b, const physics::math::Vec3& offset);
+    void remove(JointId id);
+    void clear();
+    // Removes every joint attached to a body for which isRemoved(id) holds.
+    template <typename Pred>
+    void removeBodyJoints(Pred isRemoved);
+
+    bool isValid(JointId id) const;
+    size_t getCount() const;
+    size_t getCount(JointType type) const;
+    JointType getType(JointId id) const;
+    BodyId getBodyA(JointId id) const;
+    BodyId getBodyB(JointId id) const;
+    // Magnitude of the impulse the joint applied in the last solve, e.g. to
+    // break joints under load.
+    float getImpulse(JointId id) const;
+
+    // Serial solve. bodies and idToIndex are the world's slot array and id
+    // table; ids missing from the table leave their joints inactive.
+    void solve(const std::unique_ptr<physics::dynamics::RigidBody>* bodies, const uint32_t* idToIndex,
+               size_t idCount, float deltaTime);
+
+    // Parallel solve: beginSolve() binds the bodies and lays out the passes,
+    // then every item of each pass runs through runItem() before the next
+    // pass starts.
+    void beginSolve(const std::unique_ptr<physics::dynamics::RigidBody>* bodies, const uint32_t* idToIndex,
+                    size_t idCount, float deltaTime);
+    size_t getPassCount() const;
+    size_t getPassBegin(size_t pass) const;
+    size_t getPassEnd(size_t pass) const;
+    void runItem(size_t item);
+
+private:
+    enum class Stage : uint8_t {
+        Prepare,
+        WarmStart,
+        Iterate,
+        Relax
+    };
+
+    struct WorkItem {
+        JointType type;
+        Stage stage;
+        // Joint indices for Prepare, colorOrder positions otherwise.
+        uint32_t begin;
+        uint32_t end;
+    };
+
+    struct JointRef {
+        JointType type;
+        uint32_t index;
+    };
+
+    // Storage shared by every joint type. Definition arrays hold one entry
+    // per joint; row arrays hold rowsPerJoint entries per joint and are
+    // rebuilt by each prepare, except the accumulated impulses.
+    struct JointBatch {
+        uint32_t rowsPerJoint;
+        std::vector<JointId> ids;
+        std::vector<BodyId> bodyA;
+        std::vector<BodyId> bodyB;
+        std::vector<float> impulse;
+
+        std::vector<uint32_t> slotA;
+        std::vector<uint32_t> slotB;
+        std::vector<float> normalX;
+        std::vector<float> normalY;
+        std::vector<float> normalZ;
+        std::vector<float> bias;
+        std::vector<float> mass;
+        std::vector<float> impulseScale;
+
+        bool colorsDirty;
+        std::vector<uint32_t> colorOrder;
+        std::vector<uint32_t> colorOffsets;
+
+        size_t size() const;
+    };
+
+    // Type-specific definitions, same order as the batch.
+    struct DistanceJoints {
+        std::vector<float> length;
+    };
+    struct SpringJoints {
+        std::vector<float> restLength;
+        std::vector<float> hertz;
+        std::vector<float> dampingRatio;
+    };
+    struct HingeJoints {
+        std::vector<float> axisX;
+        std::vector<float> axisY;
+        std::vector<float> axisZ;
+        std::vector<float> axialOffset;
+        std::vector<float> radius;
+    };
+    struct FixedJoints {
+        std::vector<float> offsetX;
+        std::vector<float> offsetY;
+        std::vector<float> offsetZ;
+    };
+
+    JointId addJoint(JointType type, BodyId a, BodyId b);
+    void removeAt(JointType type, uint32_t index);
+    void updateColors(JointBatch& batch);
+    void buildWorkItems();
+
+    // Resolves the joint's bodies and the offset from A to B at the start of
+    // the step. Returns false, leaving the joint inactive, if either body is
+    // missing.
+    bool bindBodies(JointBatch& batch, uint32_t joint, physics::math::Vec3& delta, float& inverseMassSum) const;
+    static void setRow(JointBatch& batch, size_t row, const physics::math::Vec3& normal, float error,
+                       float inverseMassSum, float biasRate, float massScale, float impulseScale);
+
+    void prepare(JointType type, uint32_t begin, uint32_t end);
+    void prepareDistance(uint32_t begin, uint32_t end);
+    void prepareSpring(uint32_t begin, uint32_t end);
+    void prepareHinge(uint32_t begin, uint32_t end);
+    void prepareFixed(uint32_t begin, uint32_t end);
+    void warmStart(JointBatch& batch, uint32_t begin, uint32_t end);
+    void iterate(JointBatch& batch, uint32_t begin, uint32_t end);
+    void relax(JointBatch& batch, uint32_t begin, uint32_t end);
+
+    JointBatch batches[kJointTypeCount];
+    DistanceJoints distance;
+    SpringJoints spring;
+    HingeJoints hinge;
+    FixedJoints fixed;
+
+    std::vector<JointRef> idToJoint;
+    std::vector<JointId> freeIds;
+    size_t jointCount;
+
+    // Scratch for updateColors().
+    std::vector<uint64_t> bodyColors;
+    std::vector<uint8_t> jointColors;
+    std::vector<WorkItem> items;
+    std::vector<uint32_t> passOffsets;
+
+    // Bound by beginSolve() for the current step.
+    const std::unique_ptr<physics::dynamics::RigidBody>* solveBodies;
+    const uint32_t* solveIdToIndex;
+    size_t solveIdCount;
+    float solveDeltaTime;
+    float rigidBiasRate;
+    float rigidMassScale;
+    float rigidImpulseScale;
+    float rigidRelaxScale;
+};
+
+template <typename Pred>
+void JointSystem::removeBodyJoints(Pred isRemoved) {
+    for (size_t t = 0; t < kJointTypeCount; t++) {
+        JointBatch& batch = batches[t];
+        for (size_t i = batch.size(); i-- > 0;) {
+            if (isRemoved(batch.bodyA[i]) || isRemoved(batch.bodyB[i])) {
+                removeAt(static_cast<JointType>(t), static_cast<uint32_t>(i));
+            }
+        }
+    }
+}
+
+}
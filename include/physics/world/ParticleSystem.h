@@ -0,0 +1,95 @@
+#pragma once
+#include "physics/collision/AABB.h"
+#include "physics/math/Vec3.h"
+#include "physics/parallel/ThreadPool.h"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace physics::world {
+
+struct ParticleSettings {
+    physics::math::Vec3 gravity = physics::math::Vec3(0, -9.81f, 0);
+    // Linear drag: velocity is scaled by 1 / (1 + drag * deltaTime) per step.
+    float drag = 0.1f;
+    float groundY = 0.0f;
+    // Normal velocity kept (reversed) on impact, and tangential velocity
+    // removed while touching the ground or a collider.
+    float restitution = 0.3f;
+    float friction = 0.2f;
+};
+
+// Point masses for debris, sparks and spray, kept apart from World. State
+// is stored as separate float arrays per component (structure of arrays),
+// so the integrator streams through memory and processes eight particles
+// per AVX2 instruction. Particles feel gravity and drag and collide only
+// with the ground plane and a short list of static boxes; they never
+// interact with each other or with World bodies.
+//
+// Particles have no identity. Each one has a remaining lifetime and is
+// removed by the step in which it runs out (or after kill()); removal swaps
+// the last particle into the hole, so indices are only stable between steps.
+class ParticleSystem {
+public:
+    ParticleSettings settings;
+    // Pool for the integrate pass. Chunking is fixed, so the result is the
+    // same with or without one.
+    physics::parallel::ThreadPool* threadPool;
+
+    ParticleSystem();
+
+    size_t spawn(const physics::math::Vec3& position, const physics::math::Vec3& velocity, float lifetime);
+    void kill(size_t index);
+    void reserve(size_t capacity);
+    void clear();
+
+    // Static boxes particles are pushed out of, through the nearest face.
+    // Every particle is tested against every collider, so keep the list short.
+    void addCollider(const physics::collision::AABB& bounds);
+    void clearColliders();
+
+    void step(float deltaTime);
+    // Same step with the AVX2 kernel disabled, for comparison and testing.
+    void stepScalar(float deltaTime);
+
+    size_t size() const;
+    physics::math::Vec3 getPosition(size_t index) const;
+    physics::math::Vec3 getVelocity(size_t index) const;
+    float getLifetime(size_t index) const;
+    std::span<const float> getPositionsX() const;
+    std::span<const float> getPositionsY() const;
+    std::span<const float> getPositionsZ() const;
+
+    static bool hasAvx2Kernel();
+
+private:
+    struct KernelParams {
+        float deltaTime;
+        float gravityStep[3];
+        float dragFactor;
+        float groundY;
+        float restitution;
+        float tangentKeep;
+        const physics::collision::AABB* colliders;
+        size_t colliderCount;
+    };
+
+    struct ChunkState {
+        std::vector<uint32_t> expired;
+    };
+
+    void run(float deltaTime, bool allowSimd);
+    void integrateChunk(size_t chunk, const KernelParams& params, bool allowSimd);
+    void removeExpired();
+    void swapRemove(size_t index);
+
+    std::vector<float> positionX, positionY, positionZ;
+    std::vector<float> velocityX, velocityY, velocityZ;
+    std::vector<float> lifetime;
+    std::vector<physics::collision::AABB> colliders;
+    std::vector<ChunkState> chunks;
+    size_t chunkCount;
+};
+
+}
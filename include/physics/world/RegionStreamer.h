@@ -0,0 +1,138 @@
+#pragma once
+#include "physics/world/World.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace physics::world {
+
+// Integer grid cell over body positions.
+struct RegionKey {
+    int32_t x;
+    int32_t y;
+    int32_t z;
+
+    bool operator==(const RegionKey& other) const = default;
+};
+
+struct RegionKeyHash {
+    size_t operator()(const RegionKey& key) const;
+};
+
+using ObserverId = uint32_t;
+
+// Pages regions of a World in and out of memory around a set of observers.
+// The world is partitioned into cubic cells of cellSize. A cell is active
+// when it lies within an observer's radius; update() serializes the bodies
+// of inactive cells to one file per cell and removes them from the world,
+// and queues active cells that have data on disk for loading. All file I/O
+// runs on a background thread; loaded bodies are added back to the world on
+// the next update() at the position and velocity they were saved with.
+// Ids of paged out bodies are released, reloaded bodies get new ids.
+//
+// I/O failures never drop bodies. A region whose write fails gets its
+// bodies back on the next update() and is retried when it is paged out
+// again; the file keeps what it held before. A region whose file cannot be
+// read or is malformed keeps its file, stays paged out and is listed by
+// getFailedLoads() until retryFailedLoads().
+//
+// Records keep each body's shape and collision filter. Convex hulls are
+// stored as their index in registerHull() order, so every run that reads
+// the files must register the same hulls in the same order; a hull that
+// was not registered is saved as the box given by the body's size.
+class RegionStreamer {
+public:
+    RegionStreamer(World& world, float cellSize, const std::filesystem::path& directory);
+    ~RegionStreamer();
+
+    RegionStreamer(const RegionStreamer&) = delete;
+    RegionStreamer& operator=(const RegionStreamer&) = delete;
+
+    ObserverId addObserver(const physics::math::Vec3& position, float radius);
+    void setObserverPosition(ObserverId id, const physics::math::Vec3& position);
+    void removeObserver(ObserverId id);
+
+    // Call once per frame (before or after World::step).
+    void update();
+    // Blocks until every queued read and write has finished.
+    void waitForPendingIO();
+
+    RegionKey getRegionKey(const physics::math::Vec3& position) const;
+    bool isRegionActive(const RegionKey& key) const;
+    bool isRegionOnDisk(const RegionKey& key) const;
+    size_t getPagedOutRegionCount() const;
+    size_t getPendingLoadCount() const;
+    const std::vector<RegionKey>& getFailedLoads() const;
+    size_t getFailedWriteCount() const;
+    // Lets the regions in getFailedLoads() be requested again.
+    void retryFailedLoads();
+    std::filesystem::path getRegionPath(const RegionKey& key) const;
+    // The hull must outlive the streamer.
+    void registerHull(const physics::collision::ConvexHull& hull);
+
+    static std::vector<char> serializeBodies(const std::vector<const physics::dynamics::RigidBody*>& bodies,
+                                             std::span<const physics::collision::ConvexHull* const> hulls = {});
+    static std::vector<physics::dynamics::RigidBody> deserializeBodies(
+        const std::vector<char>& data, std::span<const physics::collision::ConvexHull* const> hulls = {});
+
+private:
+    struct Observer {
+        physics::math::Vec3 position;
+        float radius;
+        bool active;
+    };
+
+    enum class RegionState { OnDisk, Loading };
+
+    struct IORequest {
+        RegionKey key;
+        bool write;
+        std::vector<char> data;
+    };
+
+    enum class IOStatus { Written, Loaded, LoadFailed, WriteFailed };
+
+    struct IOResult {
+        RegionKey key;
+        IOStatus status;
+        // Records of a load, or of a failed write. They are turned back
+        // into bodies on the main thread, which owns the hull table.
+        std::vector<char> records;
+        // WriteFailed only: the file still holds earlier records.
+        bool fileKept;
+    };
+
+    void pageOutInactiveRegions();
+    void requestActiveRegions();
+    void integrateLoadedRegions();
+    void ioLoop();
+    IOResult writeRegion(const IORequest& request);
+    IOResult readRegion(const IORequest& request);
+
+    World& world;
+    float cellSize;
+    std::filesystem::path directory;
+
+    std::vector<Observer> observers;
+    std::vector<const physics::collision::ConvexHull*> hulls;
+    std::unordered_map<RegionKey, RegionState, RegionKeyHash> regions;
+    std::vector<RegionKey> failedLoads;
+    size_t failedWrites;
+
+    std::thread ioThread;
+    mutable std::mutex ioMutex;
+    std::condition_variable ioWake;
+    std::condition_variable ioIdle;
+    std::deque<IORequest> ioRequests;
+    std::vector<IOResult> completedIO;
+    bool ioBusy;
+    bool stopping;
+};
+
+}
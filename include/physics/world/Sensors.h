@@ -0,0 +1,100 @@
+#pragma once
+#include "physics/collision/AABB.h"
+#include "physics/world/BodyId.h"
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace physics::world {
+
+using SensorId = uint32_t;
+inline constexpr SensorId InvalidSensorId = UINT32_MAX;
+
+enum class SensorEventType : uint8_t {
+    Enter,
+    Exit
+};
+
+struct SensorEvent {
+    SensorEventType type;
+    SensorId sensor;
+    BodyId body;
+};
+
+// Trigger volumes that only report overlaps. A sensor is an axis-aligned
+// box in a hash grid; it is never integrated, never enters the narrowphase
+// and never pushes bodies. Each update only looks at the bodies whose cached
+// bounds changed this step (World::getChangedBodies), queries the grid cells
+// they cover and diffs the result against the sensors they overlapped
+// before. Resting bodies and idle sensors cost nothing, so the work follows
+// the number of moving bodies, not the number of sensors.
+//
+// Adding, moving or removing a sensor is checked against every body on the
+// next update. That is meant for occasional edits; a volume that moves every
+// frame is cheaper as a body.
+class SensorSystem {
+public:
+    // cellSize should be around the size of a typical sensor.
+    explicit SensorSystem(float cellSize = 4.0f);
+
+    SensorId add(const physics::collision::AABB& bounds);
+    void remove(SensorId id);
+    void move(SensorId id, const physics::collision::AABB& bounds);
+    void clear();
+
+    bool isValid(SensorId id) const;
+    size_t getCount() const;
+    const physics::collision::AABB& getBounds(SensorId id) const;
+    // Sensors the body currently overlaps, ascending.
+    std::span<const SensorId> getOverlaps(BodyId body) const;
+    size_t getOverlapCount() const;
+
+    // bounds and ids are indexed by storage slot; changed lists the slots
+    // whose bounds changed since the last update.
+    void update(std::span<const physics::collision::AABB> bounds, const BodyId* ids, std::span<const uint32_t> changed);
+    // Reports exits for every sensor the body overlapped; the events are
+    // emitted by the next update.
+    void bodyRemoved(BodyId body);
+    void allBodiesRemoved();
+    bool hasPendingWork() const;
+
+    // Events of the last update: edited sensors first, then bodies in
+    // storage order. Valid until the next update.
+    std::span<const SensorEvent> getEvents() const;
+
+private:
+    struct CellRange {
+        int32_t min[3];
+        int32_t max[3];
+    };
+
+    CellRange cellRange(const physics::collision::AABB& bounds) const;
+    static uint64_t cellKey(int32_t x, int32_t y, int32_t z);
+    void insertIntoGrid(SensorId id);
+    void removeFromGrid(SensorId id);
+    std::vector<SensorId>& overlapsOf(BodyId body);
+    void refreshEditedSensor(SensorId id, std::span<const physics::collision::AABB> bounds, const BodyId* ids);
+    void refreshBody(BodyId body, const physics::collision::AABB& bounds);
+
+    float cellSize;
+    float inverseCellSize;
+    std::vector<physics::collision::AABB> sensorBounds;
+    std::vector<uint8_t> sensorAlive;
+    std::vector<uint8_t> sensorEdited;
+    std::vector<SensorId> freeSensorIds;
+    std::vector<SensorId> editedSensors;
+    size_t sensorCount;
+    size_t overlapCount;
+
+    std::unordered_map<uint64_t, std::vector<SensorId>> grid;
+    std::vector<uint32_t> queryStamps;
+    uint32_t queryStamp;
+
+    std::vector<std::vector<SensorId>> bodyOverlaps;
+    std::vector<SensorId> scratch;
+    std::vector<SensorEvent> pendingEvents;
+    std::vector<SensorEvent> events;
+};
+
+}
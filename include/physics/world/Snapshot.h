@@ -0,0 +1,32 @@
+#pragma once
+#include "physics/collision/AABB.h"
+#include "physics/math/Vec3.h"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace physics::world {
+
+struct SnapshotSettings {
+    bool enabled = false;
+};
+
+// Position stored as 16 bits per axis across a range box, for network
+// snapshots. The step is the range size / 65535 per axis, so a 1 km range
+// resolves to about 1.5 cm.
+struct QuantizedPosition {
+    uint16_t x;
+    uint16_t y;
+    uint16_t z;
+};
+
+// Positions outside the range are clamped to it.
+QuantizedPosition quantizePosition(const physics::math::Vec3& position, const physics::collision::AABB& range);
+physics::math::Vec3 dequantizePosition(const QuantizedPosition& position, const physics::collision::AABB& range);
+
+// Quantizes positions[slots[i]] into out[i], e.g. the snapshot positions of
+// the bodies returned by World::getChangedSince().
+void quantizePositions(std::span<const physics::math::Vec3> positions, std::span<const uint32_t> slots,
+                       const physics::collision::AABB& range, QuantizedPosition* out);
+
+}
@@ -1,34 +1,446 @@
 #pragma once
 #include "physics/dynamics/RigidBody.h"
+#include "physics/dynamics/Integrators.h"
+#include "physics/collision/BatchNarrowphase.h"
+#include "physics/collision/Broadphase.h"
+#include "physics/collision/CollisionDetection.h"
+#include "physics/collision/ShapeCollision.h"
+#include "physics/collision/StaticBvh.h"
+#include "physics/memory/FrameArena.h"
+#include "physics/parallel/RadixSort.h"
+#include "physics/parallel/TaskGraph.h"
+#include "physics/parallel/ThreadPool.h"
+#include "physics/world/BodyId.h"
+#include "physics/world/Characters.h"
+#include "physics/world/Commands.h"
+#include "physics/world/ContactEvents.h"
+#include "physics/world/Joints.h"
+#include "physics/world/Sensors.h"
+#include "physics/world/Snapshot.h"
+#include "physics/world/WorldPolicies.h"
+#include <cstdint>
+#include <memory_resource>
+#include <span>
 #include <vector>
 #include <memory>
 
 namespace physics::world {
 
-class World {
+// Periodic Morton (Z-order) reordering of body storage. A pass runs every
+// frameInterval steps, or earlier when more than disorderThreshold of the
+// sampled storage neighbours are out of Morton order.
+struct SpatialReorderSettings {
+    bool enabled = false;
+    uint32_t frameInterval = 64;
+    float disorderThreshold = 0.5f;
+    size_t disorderSampleCount = 256;
+};
+
+// Multi-rate stepping. A dynamic body is split into substeps when it would
+// move more than maxTravel times its smallest extent in one step, or when
+// one of its contacts in the previous step was deeper than maxPenetration
+// times that extent. Substep counts are powers of two up to maxSubsteps
+// (at most 64); 1 turns substepping off.
+struct SubstepSettings {
+    uint32_t maxSubsteps = 1;
+    float maxTravel = 0.5f;
+    float maxPenetration = 0.25f;
+};
+
+using Contact = physics::collision::Contact;
+
+// Stages of the step pipeline, in dependency order. A stage is complete
+// once all of its tasks have finished: Integrate when every body has moved,
+// Broadphase when the candidate pairs are merged, Narrowphase when contacts
+// and islands are built, Solve when every contact and joint has been resolved
+// and the contact events and snapshot are written.
+enum class StepStage {
+    Integrate,
+    Broadphase,
+    Narrowphase,
+    Solve
+};
+
+// Rigid body world whose pipeline stages are compile-time policies:
+// IntegratorT is the default integrator of step() (see Integrators.h),
+// BroadphaseT finds candidate pairs or, with NoBroadphase, removes the
+// collision pipeline entirely, SolverT resolves contacts, StorageT
+// provides the memory behind the per-body arrays and StagesT picks the
+// optional stages compiled in (see WorldPolicies.h). World is the default
+// configuration.
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT,
+          typename StagesT = AllStages>
+class BasicWorld {
+    using Vec3 = physics::math::Vec3;
+    using RigidBody = physics::dynamics::RigidBody;
+    using ThreadPool = physics::parallel::ThreadPool;
+    using TaskId = physics::parallel::TaskId;
+    using AABB = physics::collision::AABB;
+    using BodyPair = physics::collision::BodyPair;
+    using CollisionFilter = physics::collision::CollisionFilter;
+
 public:
     physics::math::Vec3 gravity;
     float timeStep;
+    SpatialReorderSettings reorderSettings;
+    // Skips the collision stages at runtime. A NoBroadphase world has none
+    // to skip.
+    bool collisionsEnabled;
+    // Debug builds assert that step() made no heap allocations, on the
+    // calling thread or on pool workers running its work. Other worlds and
+    // threads allocating meanwhile do not count. Only meaningful once the
+    // world has warmed up (see AllocationCounter.h).
+    bool debugAssertNoStepAllocations;
+    // Pool that runs the step's task graph. Null runs it on the calling
+    // thread; results are identical either way.
+    physics::parallel::ThreadPool* threadPool;
+    // Began/persisted/ended contact notifications, built once per step from
+    // the solved contacts. Off by default, and ignored unless
+    // StagesT::contactEvents.
+    ContactEventSettings contactEvents;
+    // Extra substeps for fast and deeply penetrating bodies. Off by default,
+    // and ignored unless StagesT::substeps.
+    SubstepSettings substeps;
+    // Contiguous copies of every body's final state, written at the end of
+    // each step for renderers and replication. Off by default, and ignored
+    // unless StagesT::snapshots.
+    SnapshotSettings snapshots;
     
-    World();
-    World(const physics::math::Vec3& gravity, float timeStep = 1.0f / 60.0f);
+    BasicWorld();
+    // storage constructs the StorageT policy. With DefaultStorage the
+    // per-body arrays and the frame arena draw from it (the default
+    // resource if null), e.g. a HugePageResource on large worlds; it must
+    // outlive the world.
+    BasicWorld(const physics::math::Vec3& gravity, float timeStep = 1.0f / 60.0f,
+          std::pmr::memory_resource* storage = nullptr);
     
-    void addBody(std::unique_ptr<physics::dynamics::RigidBody> body);
+    BodyId addBody(std::unique_ptr<physics::dynamics::RigidBody> body);
     void removeBody(size_t index);
+    // Removes every listed body in a single compaction pass. Unknown ids are
+    // ignored. Returns the number of bodies removed.
+    size_t removeBodies(std::span<const BodyId> ids);
     void clearBodies();
+    // Grows the per-body arrays to hold count bodies without reallocating.
+    void reserveBodies(size_t count);
+
+    // Deferred mutations that any thread may record, even while a step
+    // runs. Each step starts by applying the published commands in order of
+    // writer key and sequence: spawns first, added in one batch, then
+    // impulses, forces, teleports and mass changes, then despawns in one
+    // compaction pass. Commands naming unknown ids are ignored.
+    CommandBuffer& getCommands();
+    // Applies the published commands now, for worlds stepped by hand. Not
+    // thread safe with respect to the world.
+    void applyCommands();
     
     void step();
     void step(float deltaTime);
+
+    // Steps with a compile-time integrator policy (see Integrators.h).
+    // step(deltaTime) is equivalent to step<IntegratorT>(deltaTime).
+    // With a threadPool the force field is called from several threads.
+    template <typename Integrator>
+    void step(float deltaTime);
+    template <typename Integrator, typename ForceField>
+    void step(float deltaTime, ForceField&& field);
+
+    // Adds a task to every following step's graph. It starts as soon as the
+    // given stage completes and runs alongside the later stages, so it may
+    // read that stage's results (contacts after Narrowphase, for example) but
+    // must not write body state or use the frame arena.
+    void addStepTask(physics::parallel::TaskFn fn, void* context, StepStage after, const char* name = nullptr);
+    void clearStepTasks();
+    // Graph run by the last step, for inspection and profiling.
+    const physics::parallel::TaskGraph& getStepGraph() const;
     
     size_t getBodyCount() const;
     physics::dynamics::RigidBody* getBody(size_t index);
     const physics::dynamics::RigidBody* getBody(size_t index) const;
+
+    physics::dynamics::RigidBody* getBodyById(BodyId id);
+    const physics::dynamics::RigidBody* getBodyById(BodyId id) const;
+    BodyId getBodyId(size_t index) const;
+    size_t getBodyIndex(BodyId id) const;
+
+    // Sorts body storage by the Morton code of body positions. Ids are
+    // preserved; indices are not. Baked bodies keep their slots.
+    void reorderBodies();
+    // Fraction of sampled adjacent storage slots whose Morton codes are out
+    // of order. 0 right after reorderBodies().
+    float measureDisorder() const;
+
+    // Moves every static body to the front of storage and builds a BVH over
+    // them (with threadPool, or the shared pool). Steps then skip the baked
+    // block entirely: it is not integrated, its bounds are not refreshed and
+    // it stays out of the sweep; dynamic bodies find it by querying the BVH.
+    // Baked bodies must not move or change shape or filter. Removing one (or
+    // a Despawn, Teleport or SetMass command on one) drops the bake, and the
+    // next step bakes the remaining static bodies again before it runs.
+    // Clearing the world drops it for good; bake again after loading a
+    // level. Returns the number of baked bodies.
+    size_t bakeStaticGeometry();
+    size_t getBakedBodyCount() const;
+    const physics::collision::StaticBvh& getStaticBvh() const;
     
     void applyGravity();
     void integrateBodies(float deltaTime);
+    void detectCollisions();
+    void resolveCollisions();
+    void solveJoints(float deltaTime);
+    // Serial character update for worlds stepped by hand.
+    void updateCharacters(float deltaTime);
+
+    // Cached world-space bounds of every body, by storage index. Refreshed
+    // once per body at the end of integration, so they do not include the
+    // position corrections of the last contact solve; those are picked up at
+    // the start of the next step's refresh.
+    std::span<const physics::collision::AABB> getBodyBounds() const;
+    const physics::collision::AABB& getBodyBounds(size_t index) const;
+    // Storage indices whose cached bounds changed in the last step (including
+    // newly added bodies), in ascending order. Valid until the next step or
+    // until bodies are removed or reordered.
+    std::span<const uint32_t> getChangedBodies() const;
+
+    // Contacts found by the last step. Backed by the frame arena, valid until
+    // the next step begins.
+    std::span<const Contact> getContacts() const;
+    std::span<const physics::collision::BodyPair> getCandidatePairs() const;
+    // Normal impulse applied to each contact of getContacts(), same order.
+    std::span<const float> getContactImpulses() const;
+
+    // Contact events of the last step, in pair order. Bodies are reported by
+    // id; an ended event may name a body removed since the previous step.
+    // Valid until the next step.
+    std::span<const ContactEvent> getContactEvents() const;
+    // With contactEvents.subscribedOnly, only pairs involving a subscribed
+    // body are reported. Removing a body drops its subscription.
+    void subscribeContactEvents(BodyId id, bool subscribed = true);
+
+    // Trigger volumes. They are updated from the changed-body list right
+    // after integration, alongside the broadphase, and never reach the
+    // solver; read their events after step().
+    SensorSystem& getSensors();
+    const SensorSystem& getSensors() const;
+
+    // Joints between bodies, solved after the contacts of every step.
+    // Removing a body removes its joints.
+    JointSystem& getJoints();
+    const JointSystem& getJoints() const;
+
+    // Kinematic character controllers, moved against the baked static
+    // geometry during the integrate stage of every step. They are not bodies:
+    // clearing the bodies keeps them, and they do not push or get pushed.
+    CharacterSystem& getCharacters();
+    const CharacterSystem& getCharacters() const;
+
+    physics::memory::FrameArena& getFrameArena();
+    std::pmr::memory_resource* getStorageResource() const;
+    BroadphaseT& getBroadphase();
+    StorageT& getStorage();
+    uint64_t getLastStepAllocationCount() const;
+    // Bodies that took more than one substep in the last step.
+    size_t getLastSubstepBodyCount() const;
+
+    // Number of steps taken so far; the last step was frame getFrame().
+    uint32_t getFrame() const;
+    // Snapshot of the last step, by storage index, when snapshots are
+    // enabled: ids, positions, velocities and bounds after the contact and
+    // joint solve. The arrays are plain contiguous data for copying straight
+    // into upload buffers or packets, and stay valid until the next step.
+    std::span<const BodyId> getSnapshotIds() const;
+    std::span<const physics::math::Vec3> getSnapshotPositions() const;
+    std::span<const physics::math::Vec3> getSnapshotVelocities() const;
+    std::span<const physics::collision::AABB> getSnapshotBounds() const;
+    // Appends, in ascending order, the snapshot indices whose position or
+    // velocity changed after the given frame. New bodies count as changed,
+    // and so do bodies moved to another index by removals or reordering.
+    void getChangedSince(uint32_t frame, std::vector<uint32_t>& indices) const;
+
+    template <typename Integrator>
+    void integrateBodies(float deltaTime);
+    template <typename Integrator, typename ForceField>
+    void integrateBodies(float deltaTime, ForceField&& field);
     
 private:
-    std::vector<std::unique_ptr<physics::dynamics::RigidBody>> bodies;
+    using BodyRangeFn = void (*)(void* context, size_t begin, size_t end);
+    using BodyListFn = void (*)(void* context, const uint32_t* slots, size_t count, float deltaTime);
+
+    // Substep counts are 1 << level.
+    static constexpr uint32_t kSubstepLevelCount = 7;
+
+    struct StepTask {
+        physics::parallel::TaskFn fn;
+        void* context;
+        StepStage after;
+        const char* name;
+    };
+
+    // Per-chunk outputs of the parallel broadphase and narrowphase, merged
+    // in chunk order so the result does not depend on scheduling.
+    struct StepChunk {
+        std::vector<physics::collision::BodyPair> pairs;
+        std::vector<Contact> contacts;
+        std::vector<uint32_t> changedBodies;
+        std::vector<physics::collision::BodyPair> typedPairs;
+        // Substepped slots grouped by level, and their accumulated
+        // accelerations while they are stepped.
+        std::vector<uint32_t> substepGroups[kSubstepLevelCount];
+        std::vector<physics::math::Vec3> substepAccelerations;
+        size_t substepBodyCount = 0;
+    };
+
+    template <typename Fn>
+    static void invokeRange(void* context, size_t begin, size_t end);
+    template <typename Fn>
+    static void invokeList(void* context, const uint32_t* slots, size_t count, float deltaTime);
+
+    void runStep(BodyRangeFn integrate, void* context, BodyListFn substep, void* substepContext, float deltaTime);
+    void applyGravity(size_t begin, size_t end);
+    size_t computeContacts(std::span<const physics::collision::BodyPair> pairs,
+                           std::vector<physics::collision::BodyPair>& scratch, Contact* out) const;
+    void stepChunkRange(size_t chunk, size_t& begin, size_t& end) const;
+
+    void refreshBounds(size_t begin, size_t end, std::vector<uint32_t>& changed);
+    uint32_t substepLevel(size_t slot, float deltaTime) const;
+    void integrateMultiRate(size_t begin, size_t end, StepChunk& chunk);
+    void integrateSubstepGroup(StepChunk& chunk, uint32_t level);
+    void collideBaked(size_t slot);
+    void recordDeepContacts();
+    template <typename PairVector>
+    void findChunkPairs(size_t chunk, PairVector& pairs) const;
+    void dropStaticBake();
+
+    static void integrateTask(void* context, size_t chunk);
+    static void mergeChangedTask(void* context, size_t arg);
+    static void sortTask(void* context, size_t arg);
+    static void sweepTask(void* context, size_t chunk);
+    static void mergePairsTask(void* context, size_t arg);
+    static void narrowphaseTask(void* context, size_t chunk);
+    static void buildIslandsTask(void* context, size_t arg);
+    static void solveTask(void* context, size_t bucket);
+    static void contactEventsTask(void* context, size_t arg);
+    static void sensorTask(void* context, size_t arg);
+    static void jointTask(void* context, size_t item);
+    static void characterTask(void* context, size_t chunk);
+    static void snapshotTask(void* context, size_t chunk);
+
+    void beginStep();
+    void endStep();
+    CharacterGeometry getCharacterGeometry() const;
+    void maybeReorderBodies();
+    void computePositionBounds(physics::math::Vec3& boundsMin, physics::math::Vec3& boundsMax) const;
+    void computeMortonCodes(std::vector<uint32_t>& codes) const;
+    void applyBodyPermutation(const std::vector<uint32_t>& newToOld);
+    void releaseFrameData();
+
+    StorageT storagePolicy;
+    std::pmr::memory_resource* storageResource;
+    std::pmr::vector<std::unique_ptr<physics::dynamics::RigidBody>> bodies;
+    std::pmr::vector<BodyId> bodyIds;
+    std::vector<uint32_t> idToIndex;
+    std::vector<BodyId> freeIds;
+
+    // Slot-indexed bounds cache. bodyPositions and bodyShapes hold the
+    // position and shape each cached box was built from; boundsDirty forces
+    // a refresh of new bodies. bodyFilters sits next to the bounds so the
+    // sweep rejects filtered pairs without touching the bodies.
+    std::pmr::vector<physics::collision::AABB> bodyBounds;
+    std::pmr::vector<physics::math::Vec3> bodyPositions;
+    std::pmr::vector<physics::collision::Shape> bodyShapes;
+    std::pmr::vector<physics::collision::CollisionFilter> bodyFilters;
+    std::pmr::vector<uint8_t> boundsDirty;
+    std::vector<uint32_t> changedBodies;
+
+    // Slots [0, bakedBodyCount) are baked static bodies in BVH primitive
+    // order, so primitive k of staticBvh is slot k. bakedChanged lists baked
+    // slots whose bounds changed while baking; the next step reports them.
+    // rebakePending is set when an edit dropped the bake.
+    size_t bakedBodyCount;
+    physics::collision::StaticBvh staticBvh;
+    std::vector<uint32_t> bakedChanged;
+    bool rebakePending;
+
+    uint32_t framesSinceReorder;
+    bool hasMortonBounds;
+    physics::math::Vec3 mortonBoundsMin;
+    physics::math::Vec3 mortonBoundsMax;
+    std::vector<uint32_t> reorderKeys;
+    std::vector<uint32_t> reorderValues;
+    physics::parallel::RadixSortScratch reorderScratch;
+    std::pmr::vector<std::unique_ptr<physics::dynamics::RigidBody>> permutedBodies;
+    std::pmr::vector<BodyId> permutedIds;
+    std::pmr::vector<physics::collision::AABB> permutedBounds;
+    std::pmr::vector<physics::math::Vec3> permutedPositions;
+    std::pmr::vector<physics::collision::Shape> permutedShapes;
+    std::pmr::vector<physics::collision::CollisionFilter> permutedFilters;
+    std::vector<physics::collision::BodyPair> narrowphaseScratch;
+    std::pmr::vector<uint8_t> permutedDirty;
+    // Warm-start simplices for convex hull pairs, keyed by body id. Written
+    // from narrowphase tasks, hence mutable.
+    mutable physics::collision::GjkPairCache gjkCache;
+    std::vector<float> contactImpulses;
+    ContactEventStream contactEventStream;
+    SensorSystem sensors;
+    JointSystem joints;
+    CharacterSystem characters;
+    CommandBuffer commands;
+    std::vector<Command> pendingCommands;
+    std::vector<BodyId> despawnedIds;
+    // Bound by runStep() for the character and substep tasks.
+    CharacterGeometry stepCharacterGeometry;
+    float stepDeltaTime;
+    // Substep level each body's contacts asked for in the last step, by id,
+    // and the ids that have one, so the next step can reset them.
+    std::vector<uint8_t> contactSubstepLevels;
+    std::vector<BodyId> deepContactIds;
+    // Snapshot arrays, by storage index, and the frame each entry last
+    // changed in.
+    uint32_t frame;
+    std::pmr::vector<BodyId> snapshotIds;
+    std::pmr::vector<physics::math::Vec3> snapshotPositions;
+    std::pmr::vector<physics::math::Vec3> snapshotVelocities;
+    std::pmr::vector<physics::collision::AABB> snapshotBounds;
+    std::pmr::vector<uint32_t> snapshotChanged;
+
+    // Per-step scratch. Containers below draw from frameArena and are
+    // released before it is rewound, so keep them declared after it.
+    physics::memory::FrameArena frameArena;
+    std::pmr::vector<physics::collision::BodyPair> candidatePairs;
+    std::pmr::vector<Contact> contacts;
+    BroadphaseT broadphase;
+    size_t lastCandidatePairCount;
+
+    physics::parallel::TaskGraph stepGraph;
+    std::vector<StepTask> stepTasks;
+    std::vector<StepChunk> stepChunks;
+    BodyRangeFn stepIntegrateFn;
+    void* stepIntegrateContext;
+    BodyListFn stepSubstepFn;
+    void* stepSubstepContext;
+    size_t stepChunkCount;
+    size_t solveBucketCount;
+    std::vector<uint32_t> islandParent;
+    std::vector<uint32_t> islandBucket;
+    std::vector<uint32_t> contactBucket;
+    std::vector<uint32_t> solveBucketOffsets;
+    std::vector<uint32_t> solveBucketCursor;
+    std::vector<uint32_t> solveOrder;
+
+    uint64_t stepAllocationStart;
+    uint64_t lastStepAllocations;
+    size_t lastSubstepBodyCount;
 };
 
 }
+
+#include "physics/world/WorldImpl.h"
+
+namespace physics::world {
+
+using World = BasicWorld<physics::dynamics::SemiImplicitEuler, SweepAndPruneBroadphase, ImpulseSolver, DefaultStorage>;
+
+// Instantiated once in World.cpp.
+extern template class BasicWorld<physics::dynamics::SemiImplicitEuler, SweepAndPruneBroadphase, ImpulseSolver,
+                                 DefaultStorage>;
+
+}
@@ -0,0 +1,1387 @@
+#pragma once
+// Member definitions of BasicWorld, included at the end of World.h. The
+// default configuration is instantiated once in World.cpp.
+#include "physics/math/Morton.h"
+#include "physics/memory/AllocationCounter.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace physics::world {
+
+namespace detail {
+// Bodies (and sorted broadphase entries) per integrate, sweep and narrowphase
+// task. Fixed so the graph, and with it the result, does not depend on the
+// thread count.
+inline constexpr size_t kStepChunkSize = 512;
+// Characters per update task. A character costs a few BVH sweeps, far more
+// than integrating a body.
+inline constexpr size_t kCharacterChunkSize = 128;
+
+// Smallest substep level whose 1 << level substeps bring ratio down to 1,
+// capped at maxSubsteps and 64 substeps.
+inline uint32_t substepLevelFor(float ratio, uint32_t maxSubsteps) {
+    uint32_t limit = std::min<uint32_t>(maxSubsteps, 64);
+    uint32_t level = 0;
+    while ((2u << level) <= limit && static_cast<float>(1u << level) < ratio) {
+        level++;
+    }
+    return level;
+}
+
+inline float smallestExtent(const physics::math::Vec3& size) {
+    return std::min(size.x, std::min(size.y, size.z));
+}
+
+inline bool sameBounds(const physics::collision::AABB& lhs, const physics::collision::AABB& rhs) {
+    return lhs.min.x == rhs.min.x && lhs.min.y == rhs.min.y && lhs.min.z == rhs.min.z &&
+           lhs.max.x == rhs.max.x && lhs.max.y == rhs.max.y && lhs.max.z == rhs.max.z;
+}
+
+template <typename Vector>
+void permuteSlots(Vector& values, Vector& scratch, const std::vector<uint32_t>& newToOld) {
+    scratch.resize(values.size());
+    for (size_t i = 0; i < values.size(); i++) {
+        scratch[i] = std::move(values[newToOld[i]]);
+    }
+    values.swap(scratch);
+}
+
+inline uint32_t findIslandRoot(std::vector<uint32_t>& parent, uint32_t index) {
+    while (parent[index] != index) {
+        parent[index] = parent[parent[index]];
+        index = parent[index];
+    }
+    return index;
+}
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::BasicWorld() : BasicWorld(Vec3(0, -9.81f, 0), 1.0f / 60.0f) {}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::BasicWorld(const Vec3& gravity, float timeStep, std::pmr::memory_resource* storage)
+    : gravity(gravity), timeStep(timeStep), collisionsEnabled(true), debugAssertNoStepAllocations(false),
+      threadPool(nullptr), storagePolicy(storage), storageResource(storagePolicy.resource()),
+      bodies(storageResource), bodyIds(storageResource), bodyBounds(storageResource), bodyPositions(storageResource),
+      bodyShapes(storageResource), bodyFilters(storageResource), boundsDirty(storageResource), bakedBodyCount(0),
+      rebakePending(false), framesSinceReorder(0), hasMortonBounds(false), permutedBodies(storageResource), permutedIds(storageResource),
+      permutedBounds(storageResource), permutedPositions(storageResource), permutedShapes(storageResource),
+      permutedFilters(storageResource), permutedDirty(storageResource), stepDeltaTime(0.0f),
+      frame(0), snapshotIds(storageResource), snapshotPositions(storageResource), snapshotVelocities(storageResource),
+      snapshotBounds(storageResource), snapshotChanged(storageResource),
+      frameArena(64 * 1024, storageResource),
+      candidatePairs(&frameArena), contacts(&frameArena), broadphase(&frameArena),
+      lastCandidatePairCount(0), stepIntegrateFn(nullptr), stepIntegrateContext(nullptr), stepSubstepFn(nullptr),
+      stepSubstepContext(nullptr), stepChunkCount(0), solveBucketCount(1), stepAllocationStart(0), lastStepAllocations(0),
+      lastSubstepBodyCount(0) {}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+BodyId BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::addBody(std::unique_ptr<RigidBody> body) {
+    BodyId id;
+    if (!freeIds.empty()) {
+        id = freeIds.back();
+        freeIds.pop_back();
+    } else {
+        id = static_cast<BodyId>(idToIndex.size());
+        idToIndex.push_back(0);
+    }
+    idToIndex[id] = static_cast<uint32_t>(bodies.size());
+    bodyIds.push_back(id);
+    bodyBounds.push_back(body->getAABB());
+    bodyPositions.push_back(body->position);
+    bodyShapes.push_back(body->shape);
+    bodyFilters.push_back(body->filter);
+    boundsDirty.push_back(1);
+    bodies.push_back(std::move(body));
+    return id;
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::reserveBodies(size_t count) {
+    bodies.reserve(count);
+    bodyIds.reserve(count);
+    bodyBounds.reserve(count);
+    bodyPositions.reserve(count);
+    bodyShapes.reserve(count);
+    bodyFilters.reserve(count);
+    boundsDirty.reserve(count);
+    idToIndex.reserve(count);
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+CommandBuffer& BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::getCommands() {
+    static_assert(StagesT::commands, "stage compiled out by StagesT");
+    return commands;
+}
+
+// Commands arrive sorted by order; each kind is applied in that order, so
+// the outcome depends only on the writers' keys and what they recorded.
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::applyCommands() {
+    static_assert(StagesT::commands, "stage compiled out by StagesT");
+    if (commands.empty()) return;
+    commands.take(pendingCommands);
+
+    size_t spawnCount = 0;
+    for (const Command& command : pendingCommands) {
+        spawnCount += command.type == CommandType::Spawn ? 1 : 0;
+    }
+    if (spawnCount > 0) {
+        reserveBodies(bodies.size() + spawnCount);
+        for (Command& command : pendingCommands) {
+            if (command.type != CommandType::Spawn) continue;
+            BodyId id = addBody(std::unique_ptr<RigidBody>(command.spawn));
+            command.spawn = nullptr;
+            if (command.spawnedId) {
+                *command.spawnedId = id;
+            }
+        }
+    }
+
+    despawnedIds.clear();
+    for (const Command& command : pendingCommands) {
+        if (command.type == CommandType::Spawn) continue;
+        if (command.type == CommandType::Despawn) {
+            despawnedIds.push_back(command.body);
+            continue;
+        }
+        size_t index = getBodyIndex(command.body);
+        if (index == InvalidBodyIndex) continue;
+        RigidBody& body = *bodies[index];
+        switch (command.type) {
+            case CommandType::ApplyImpulse:
+                body.applyImpulse(command.value);
+                break;
+            case CommandType::ApplyForce:
+                body.applyForce(command.value);
+                break;
+            case CommandType::Teleport:
+            case CommandType::SetMass:
+                if (index < bakedBodyCount) {
+                    dropStaticBake();
+                }
+                if (command.type == CommandType::Teleport) {
+                    body.position = command.value;
+                } else {
+                    body.setMass(command.mass);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    if (!despawnedIds.empty()) {
+        removeBodies(despawnedIds);
+    }
+    pendingCommands.clear();
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::removeBody(size_t index) {
+    if (index < bodies.size()) {
+        releaseFrameData();
+        if (index < bakedBodyCount) {
+            dropStaticBake();
+        }
+        BodyId removedId = bodyIds[index];
+        bodies.erase(bodies.begin() + index);
+        bodyIds.erase(bodyIds.begin() + index);
+        bodyBounds.erase(bodyBounds.begin() + index);
+        bodyPositions.erase(bodyPositions.begin() + index);
+        bodyShapes.erase(bodyShapes.begin() + index);
+        bodyFilters.erase(bodyFilters.begin() + index);
+        boundsDirty.erase(boundsDirty.begin() + index);
+        for (size_t i = index; i < bodyIds.size(); i++) {
+            idToIndex[bodyIds[i]] = static_cast<uint32_t>(i);
+        }
+        idToIndex[removedId] = UINT32_MAX;
+        freeIds.push_back(removedId);
+        if constexpr (StagesT::contactEvents) {
+            contactEventStream.subscribe(removedId, false);
+            contactEventStream.markRemoved([removedId](BodyId id) { return id == removedId; });
+        }
+        if constexpr (StagesT::sensors) {
+            sensors.bodyRemoved(removedId);
+        }
+        if constexpr (StagesT::joints) {
+            joints.removeBodyJoints([removedId](BodyId id) { return id == removedId; });
+        }
+    }
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+size_t BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::removeBodies(std::span<const BodyId> ids) {
+    size_t removed = 0;
+    for (BodyId id : ids) {
+        size_t index = getBodyIndex(id);
+        if (index == InvalidBodyIndex || !bodies[index]) continue;
+        if (index < bakedBodyCount) {
+            dropStaticBake();
+        }
+        bodies[index].reset();
+        idToIndex[id] = UINT32_MAX;
+        freeIds.push_back(id);
+        if constexpr (StagesT::contactEvents) {
+            contactEventStream.subscribe(id, false);
+        }
+        if constexpr (StagesT::sensors) {
+            sensors.bodyRemoved(id);
+        }
+        removed++;
+    }
+    if (removed == 0) return 0;
+    if constexpr (StagesT::contactEvents) {
+        contactEventStream.markRemoved([this](BodyId id) { return idToIndex[id] == UINT32_MAX; });
+    }
+    if constexpr (StagesT::joints) {
+        joints.removeBodyJoints([this](BodyId id) { return id >= idToIndex.size() || idToIndex[id] == UINT32_MAX; });
+    }
+
+    releaseFrameData();
+    size_t write = 0;
+    for (size_t read = 0; read < bodies.size(); read++) {
+        if (!bodies[read]) continue;
+        bodies[write] = std::move(bodies[read]);
+        bodyIds[write] = bodyIds[read];
+        bodyBounds[write] = bodyBounds[read];
+        bodyPositions[write] = bodyPositions[read];
+        bodyShapes[write] = bodyShapes[read];
+        bodyFilters[write] = bodyFilters[read];
+        boundsDirty[write] = boundsDirty[read];
+        idToIndex[bodyIds[write]] = static_cast<uint32_t>(write);
+        write++;
+    }
+    bodies.resize(write);
+    bodyIds.resize(write);
+    bodyBounds.resize(write);
+    bodyPositions.resize(write);
+    bodyShapes.resize(write);
+    bodyFilters.resize(write);
+    boundsDirty.resize(write);
+    return removed;
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::clearBodies() {
+    releaseFrameData();
+    dropStaticBake();
+    rebakePending = false;
+    bodies.clear();
+    bodyIds.clear();
+    bodyBounds.clear();
+    bodyPositions.clear();
+    bodyShapes.clear();
+    bodyFilters.clear();
+    boundsDirty.clear();
+    idToIndex.clear();
+    freeIds.clear();
+    gjkCache.clear();
+    if constexpr (StagesT::contactEvents) {
+        contactEventStream.markAllRemoved();
+    }
+    if constexpr (StagesT::sensors) {
+        sensors.allBodiesRemoved();
+    }
+    if constexpr (StagesT::joints) {
+        joints.clear();
+    }
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::step() {
+    step(timeStep);
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::step(float deltaTime) {
+    step<IntegratorT>(deltaTime);
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+size_t BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::getBodyCount() const {
+    return bodies.size();
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+physics::dynamics::RigidBody* BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::getBody(size_t index) {
+    if (index < bodies.size()) {
+        return bodies[index].get();
+    }
+    return nullptr;
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+const physics::dynamics::RigidBody* BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::getBody(size_t index) const {
+    if (index < bodies.size()) {
+        return bodies[index].get();
+    }
+    return nullptr;
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::applyGravity() {
+    applyGravity(bakedBodyCount, bodies.size());
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::applyGravity(size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+        RigidBody& body = *bodies[i];
+        if (!body.isStatic) {
+            Vec3 gravityForce = gravity * body.mass;
+            body.applyForce(gravityForce);
+        }
+    }
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::integrateBodies(float deltaTime) {
+    integrateBodies<IntegratorT>(deltaTime);
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+physics::dynamics::RigidBody* BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::getBodyById(BodyId id) {
+    size_t index = getBodyIndex(id);
+    return index != InvalidBodyIndex ? bodies[index].get() : nullptr;
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+const physics::dynamics::RigidBody* BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::getBodyById(BodyId id) const {
+    size_t index = getBodyIndex(id);
+    return index != InvalidBodyIndex ? bodies[index].get() : nullptr;
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+BodyId BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::getBodyId(size_t index) const {
+    if (index < bodyIds.size()) {
+        return bodyIds[index];
+    }
+    return InvalidBodyId;
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+size_t BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::getBodyIndex(BodyId id) const {
+    if (id < idToIndex.size() && idToIndex[id] != UINT32_MAX) {
+        return idToIndex[id];
+    }
+    return InvalidBodyIndex;
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::computePositionBounds(Vec3& boundsMin, Vec3& boundsMax) const {
+    boundsMin = bakedBodyCount < bodies.size() ? bodies[bakedBodyCount]->position : Vec3();
+    boundsMax = boundsMin;
+    for (size_t i = bakedBodyCount; i < bodies.size(); i++) {
+        const auto& body = bodies[i];
+        boundsMin.x = std::min(boundsMin.x, body->position.x);
+        boundsMin.y = std::min(boundsMin.y, body->position.y);
+        boundsMin.z = std::min(boundsMin.z, body->position.z);
+        boundsMax.x = std::max(boundsMax.x, body->position.x);
+        boundsMax.y = std::max(boundsMax.y, body->position.y);
+        boundsMax.z = std::max(boundsMax.z, body->position.z);
+    }
+}
+
+// Codes of the bodies after the baked block; codes[i] is slot
+// bakedBodyCount + i.
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::computeMortonCodes(std::vector<uint32_t>& codes) const {
+    size_t count = bodies.size() - bakedBodyCount;
+    codes.resize(count);
+    ThreadPool::shared().parallelFor(count, 4096, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            codes[i] = physics::math::mortonEncode(bodies[bakedBodyCount + i]->position, mortonBoundsMin, mortonBoundsMax);
+        }
+    });
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::reorderBodies() {
+    framesSinceReorder = 0;
+    size_t count = bodies.size();
+    size_t sorted = count - bakedBodyCount;
+    if (sorted < 2) return;
+
+    computePositionBounds(mortonBoundsMin, mortonBoundsMax);
+    hasMortonBounds = true;
+    computeMortonCodes(reorderKeys);
+    reorderValues.resize(sorted);
+    for (size_t i = 0; i < sorted; i++) {
+        reorderValues[i] = static_cast<uint32_t>(bakedBodyCount + i);
+    }
+
+    physics::parallel::radixSortPairs(reorderKeys, reorderValues, reorderScratch, 30, &ThreadPool::shared());
+    // Baked slots stay in place ahead of the sorted bodies.
+    reorderValues.resize(count);
+    std::move_backward(reorderValues.begin(), reorderValues.begin() + sorted, reorderValues.end());
+    for (size_t i = 0; i < bakedBodyCount; i++) {
+        reorderValues[i] = static_cast<uint32_t>(i);
+    }
+    applyBodyPermutation(reorderValues);
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+float BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::measureDisorder() const {
+    size_t count = bodies.size() - bakedBodyCount;
+    if (count < 2) return 0.0f;
+
+    size_t samples = std::min(reorderSettings.disorderSampleCount, count - 1);
+    if (samples == 0) return 0.0f;
+    size_t stride = (count - 1) / samples;
+
+    // Measure against the quantization grid of the last reorder so a freshly
+    // sorted storage reports zero disorder.
+    Vec3 boundsMin = mortonBoundsMin;
+    Vec3 boundsMax = mortonBoundsMax;
+    if (!hasMortonBounds) {
+        computePositionBounds(boundsMin, boundsMax);
+    }
+
+    size_t outOfOrder = 0;
+    for (size_t s = 0; s < samples; s++) {
+        size_t i = bakedBodyCount + s * stride;
+        uint32_t a = physics::math::mortonEncode(bodies[i]->position, boundsMin, boundsMax);
+        uint32_t b = physics::math::mortonEncode(bodies[i + 1]->position, boundsMin, boundsMax);
+        if (a > b) outOfOrder++;
+    }
+    return static_cast<float>(outOfOrder) / static_cast<float>(samples);
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::maybeReorderBodies() {
+    if (!reorderSettings.enabled) return;
+
+    framesSinceReorder++;
+    if (reorderSettings.frameInterval > 0 && framesSinceReorder >= reorderSettings.frameInterval) {
+        reorderBodies();
+    } else if (measureDisorder() > reorderSettings.disorderThreshold) {
+        reorderBodies();
+    }
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+size_t BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::bakeStaticGeometry() {
+    releaseFrameData();
+    dropStaticBake();
+    rebakePending = false;
+    size_t count = bodies.size();
+    std::vector<uint32_t> staticSlots;
+    std::vector<uint32_t> otherSlots;
+    for (size_t i = 0; i < count; i++) {
+        (bodies[i]->isStatic ? staticSlots : otherSlots).push_back(static_cast<uint32_t>(i));
+    }
+    if (staticSlots.empty()) return 0;
+
+    // Bring the baked bounds and filters up to date; they are never
+    // refreshed again.
+    std::vector<AABB> staticBounds(staticSlots.size());
+    std::vector<uint8_t> refreshed(staticSlots.size(), 0);
+    for (size_t k = 0; k < staticSlots.size(); k++) {
+        uint32_t slot = staticSlots[k];
+        size_t before = changedBodies.size();
+        refreshBounds(slot, slot + 1, changedBodies);
+        refreshed[k] = changedBodies.size() != before;
+        staticBounds[k] = bodyBounds[slot];
+    }
+    changedBodies.clear();
+
+    staticBvh.build(staticBounds, threadPool ? threadPool : &ThreadPool::shared());
+
+    std::vector<uint32_t> newToOld;
+    newToOld.reserve(count);
+    std::span<const uint32_t> order = staticBvh.getPrimitiveOrder();
+    for (size_t k = 0; k < order.size(); k++) {
+        newToOld.push_back(staticSlots[order[k]]);
+        if (refreshed[order[k]]) bakedChanged.push_back(static_cast<uint32_t>(k));
+    }
+    newToOld.insert(newToOld.end(), otherSlots.begin(), otherSlots.end());
+    applyBodyPermutation(newToOld);
+    bakedBodyCount = staticSlots.size();
+    return bakedBodyCount;
+}
+
+// The baked bodies become ordinary static bodies in place, and the next
+// step bakes again. Ones still waiting to report their bake-time change get
+// a normal refresh instead.
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::dropStaticBake() {
+    for (uint32_t slot : bakedChanged) {
+        boundsDirty[slot] = 1;
+    }
+    bakedChanged.clear();
+    if (bakedBodyCount > 0) {
+        rebakePending = true;
+    }
+    bakedBodyCount = 0;
+    staticBvh.clear();
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+size_t BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::getBakedBodyCount() const {
+    return bakedBodyCount;
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+const physics::collision::StaticBvh& BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::getStaticBvh() const {
+    return staticBvh;
+}
+
+// Every piece of per-body state indexed by storage slot goes through here so
+// reorders keep it consistent with the body order.
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::applyBodyPermutation(const std::vector<uint32_t>& newToOld) {
+    size_t count = bodies.size();
+    releaseFrameData();
+
+    detail::permuteSlots(bodies, permutedBodies, newToOld);
+    detail::permuteSlots(bodyIds, permutedIds, newToOld);
+    detail::permuteSlots(bodyBounds, permutedBounds, newToOld);
+    detail::permuteSlots(bodyPositions, permutedPositions, newToOld);
+    detail::permuteSlots(bodyShapes, permutedShapes, newToOld);
+    detail::permuteSlots(bodyFilters, permutedFilters, newToOld);
+    detail::permuteSlots(boundsDirty, permutedDirty, newToOld);
+
+    for (size_t i = 0; i < count; i++) {
+        idToIndex[bodyIds[i]] = static_cast<uint32_t>(i);
+    }
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::beginStep() {
+    stepAllocationStart = physics::memory::attributedAllocationCount();
+    frame++;
+    if constexpr (StagesT::substeps) {
+        recordDeepContacts();
+    }
+    releaseFrameData();
+    maybeReorderBodies();
+    gjkCache.beginFrame();
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::endStep() {
+    lastStepAllocations = physics::memory::attributedAllocationCount() - stepAllocationStart;
+    assert(!debugAssertNoStepAllocations || lastStepAllocations == 0);
+}
+
+// Drops the views into the frame arena and rewinds it. Contacts and the
+// changed list refer to storage indices, so anything that moves bodies calls
+// this first.
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::releaseFrameData() {
+    changedBodies.clear();
+    std::pmr::vector<BodyPair>(&frameArena).swap(candidatePairs);
+    std::pmr::vector<Contact>(&frameArena).swap(contacts);
+    broadphase.release();
+    frameArena.reset();
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::detectCollisions() {
+    size_t count = bodies.size();
+    candidatePairs.clear();
+    contacts.clear();
+    changedBodies.assign(bakedChanged.begin(), bakedChanged.end());
+    bakedChanged.clear();
+    refreshBounds(bakedBodyCount, count, changedBodies);
+
+    candidatePairs.reserve(lastCandidatePairCount + lastCandidatePairCount / 4 + 16);
+    broadphase.prepare(bodyBounds.data(), bakedBodyCount, count);
+    size_t chunkCount = (count - bakedBodyCount + detail::kStepChunkSize - 1) / detail::kStepChunkSize;
+    for (size_t c = 0; c < chunkCount; c++) {
+        findChunkPairs(c, candidatePairs);
+    }
+    lastCandidatePairCount = candidatePairs.size();
+
+    contacts.resize(candidatePairs.size());
+    contacts.resize(computeContacts(std::span<const BodyPair>(candidatePairs.data(), candidatePairs.size()),
+                                    narrowphaseScratch, contacts.data()));
+}
+
+// Rebuilds the cached bounds of [begin, end) and lists the bodies whose box
+// changed. Bodies at rest cost one comparison and no writes. Filters are
+// synced on their own since they do not move the box.
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::refreshBounds(size_t begin, size_t end, std::vector<uint32_t>& changed) {
+    for (size_t i = begin; i < end; i++) {
+        const RigidBody& body = *bodies[i];
+        AABB bounds = body.getAABB();
+        if (boundsDirty[i] || !detail::sameBounds(bounds, bodyBounds[i]) || body.shape.type != bodyShapes[i].type) {
+            bodyBounds[i] = bounds;
+            bodyPositions[i] = body.position;
+            bodyShapes[i] = body.shape;
+            boundsDirty[i] = 0;
+            changed.push_back(static_cast<uint32_t>(i));
+        }
+        if (body.filter != bodyFilters[i]) {
+            bodyFilters[i] = body.filter;
+        }
+    }
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+uint32_t BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::substepLevel(size_t slot, float deltaTime) const {
+    const RigidBody& body = *bodies[slot];
+    if (body.isStatic) return 0;
+    float limit = substeps.maxTravel * detail::smallestExtent(body.size);
+    float travelSq = body.velocity.lengthSq() * deltaTime * deltaTime;
+    uint32_t level = 0;
+    if (travelSq > limit * limit) {
+        level = detail::substepLevelFor(std::sqrt(travelSq) / limit, substeps.maxSubsteps);
+    }
+    if (!deepContactIds.empty()) {
+        level = std::max<uint32_t>(level, contactSubstepLevels[bodyIds[slot]]);
+    }
+    return level;
+}
+
+// Integrates [begin, end) with each body's own number of substeps. Runs of
+// single-step bodies go through the usual range loop; the others are
+// grouped by substep count so each group advances in lockstep, one tight
+// loop per substep. Between substeps a group collides with the baked static
+// geometry; the step's collision pass handles the last one, and other
+// dynamic bodies. Only the substepped bodies pay for the extra work.
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::integrateMultiRate(size_t begin, size_t end, StepChunk& chunk) {
+    for (std::vector<uint32_t>& group : chunk.substepGroups) {
+        group.clear();
+    }
+    chunk.substepBodyCount = 0;
+    size_t run = begin;
+    for (size_t i = begin; i < end; i++) {
+        uint32_t level = substepLevel(i, stepDeltaTime);
+        if (level == 0) continue;
+        if (run < i) {
+            stepIntegrateFn(stepIntegrateContext, run, i);
+        }
+        run = i + 1;
+        chunk.substepGroups[level].push_back(static_cast<uint32_t>(i));
+        chunk.substepBodyCount++;
+    }
+    if (run < end) {
+        stepIntegrateFn(stepIntegrateContext, run, end);
+    }
+    for (uint32_t level = 1; level < kSubstepLevelCount; level++) {
+        if (!chunk.substepGroups[level].empty()) {
+            integrateSubstepGroup(chunk, level);
+        }
+    }
+}
+
+// Forces accumulated before the step, gravity included, act on every
+// substep; the integrator clears them after each one.
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::integrateSubstepGroup(StepChunk& chunk, uint32_t level) {
+    const std::vector<uint32_t>& group = chunk.substepGroups[level];
+    std::vector<Vec3>& accelerations = chunk.substepAccelerations;
+    accelerations.resize(group.size());
+    for (size_t k = 0; k < group.size(); k++) {
+        applyGravity(group[k], group[k] + 1);
+        accelerations[k] = bodies[group[k]]->acceleration;
+    }
+    uint32_t count = 1u << level;
+    float deltaTime = stepDeltaTime / static_cast<float>(count);
+    bool collide = collisionsEnabled && bakedBodyCount > 0;
+    for (uint32_t s = 0; s < count; s++) {
+        for (size_t k = 0; k < group.size(); k++) {
+            bodies[group[k]]->acceleration = accelerations[k];
+        }
+        stepSubstepFn(stepSubstepContext, group.data(), group.size(), deltaTime);
+        if constexpr (BroadphaseT::enabled) {
+            if (collide && s + 1 < count) {
+                for (uint32_t slot : group) {
+                    collideBaked(slot);
+                }
+            }
+        }
+    }
+}
+
+// Resolves a dynamic body against the baked bodies it overlaps, between two
+// of its substeps. Its cache entries are updated as it moves and marked
+// dirty so the step's refresh still reports it.
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::collideBaked(size_t slot) {
+    RigidBody& body = *bodies[slot];
+    AABB box = body.getAABB();
+    bodyBounds[slot] = box;
+    bodyPositions[slot] = body.position;
+    bodyShapes[slot] = body.shape;
+    boundsDirty[slot] = 1;
+    physics::collision::ShapeView view{bodyBounds.data(), bodyPositions.data(), bodyShapes.data(), bodyIds.data(), &gjkCache};
+    staticBvh.query(box, [&](uint32_t baked) {
+        if (!CollisionFilter::shouldCollide(bodyFilters[baked], body.filter)) return;
+        physics::collision::CollisionInfo info =
+            physics::collision::ShapeCollision::collide(view, baked, static_cast<uint32_t>(slot));
+        if (!info.hasCollision) return;
+        SolverT::resolve(*bodies[baked], body, info);
+        bodyBounds[slot] = body.getAABB();
+        bodyPositions[slot] = body.position;
+    });
+}
+
+// Turns the last step's contacts, which are still valid here, into substep
+// levels for the bodies they penetrated too deeply.
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::recordDeepContacts() {
+    for (BodyId id : deepContactIds) {
+        contactSubstepLevels[id] = 0;
+    }
+    deepContactIds.clear();
+    if (substeps.maxSubsteps <= 1) return;
+    if (contactSubstepLevels.size() < idToIndex.size()) {
+        contactSubstepLevels.resize(idToIndex.size(), 0);
+    }
+    for (const Contact& contact : contacts) {
+        for (uint32_t slot : {contact.indexA, contact.indexB}) {
+            const RigidBody& body = *bodies[slot];
+            if (body.isStatic) continue;
+            float limit = substeps.maxPenetration * detail::smallestExtent(body.size);
+            if (!(contact.info.penetrationDepth > limit)) continue;
+            uint8_t level = static_cast<uint8_t>(
+                detail::substepLevelFor(contact.info.penetrationDepth / limit, substeps.maxSubsteps));
+            BodyId id = bodyIds[slot];
+            if (contactSubstepLevels[id] == 0 && level > 0) {
+                deepContactIds.push_back(id);
+            }
+            contactSubstepLevels[id] = std::max(contactSubstepLevels[id], level);
+        }
+    }
+}
+
+// Sweep pairs of one chunk of sorted entries, followed by the baked bodies
+// overlapping the chunk's dynamic bodies. Baked slots come first in storage,
+// so those pairs are already ordered a < b.
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+template <typename PairVector>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::findChunkPairs(size_t chunk, PairVector& pairs) const {
+    size_t begin, end;
+    stepChunkRange(chunk, begin, end);
+    begin -= bakedBodyCount;
+    end -= bakedBodyCount;
+    broadphase.findPairs(bodyBounds.data(), bodyFilters.data(), begin, end, pairs);
+    if (bakedBodyCount == 0) return;
+
+    for (size_t slot = bakedBodyCount + begin; slot < bakedBodyCount + end; slot++) {
+        if (bodies[slot]->isStatic) continue;
+        const CollisionFilter& filter = bodyFilters[slot];
+        staticBvh.query(bodyBounds[slot], [&](uint32_t baked) {
+            if (CollisionFilter::shouldCollide(bodyFilters[baked], filter)) {
+                pairs.push_back({baked, static_cast<uint32_t>(slot)});
+            }
+        });
+    }
+}
+
+// Shape-dispatched narrowphase over the cached bounds and shapes, then drops
+// contacts between two static bodies in place.
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+size_t BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::computeContacts(std::span<const BodyPair> pairs, std::vector<BodyPair>& scratch, Contact* out) const {
+    physics::collision::ShapeView view{bodyBounds.data(), bodyPositions.data(), bodyShapes.data(), bodyIds.data(), &gjkCache};
+    size_t found = physics::collision::ShapeCollision::findContacts(view, pairs, scratch, out);
+    size_t kept = 0;
+    for (size_t i = 0; i < found; i++) {
+        if (bodies[out[i].indexA]->isStatic && bodies[out[i].indexB]->isStatic) continue;
+        out[kept++] = out[i];
+    }
+    return kept;
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::resolveCollisions() {
+    contactImpulses.resize(contacts.size());
+    for (size_t k = 0; k < contacts.size(); k++) {
+        const Contact& contact = contacts[k];
+        contactImpulses[k] = SolverT::resolve(*bodies[contact.indexA], *bodies[contact.indexB], contact.info);
+    }
+}
+
+// Serial joint solve for worlds stepped by hand; call after
+// resolveCollisions() with the step's time.
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::solveJoints(float deltaTime) {
+    static_assert(StagesT::joints, "stage compiled out by StagesT");
+    joints.solve(bodies.data(), idToIndex.data(), idToIndex.size(), deltaTime);
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::updateCharacters(float deltaTime) {
+    static_assert(StagesT::characters, "stage compiled out by StagesT");
+    characters.update(getCharacterGeometry(), deltaTime);
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+CharacterGeometry BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::getCharacterGeometry() const {
+    return CharacterGeometry{&staticBvh, bodyBounds.data(), bodyFilters.data(), gravity};
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::addStepTask(physics::parallel::TaskFn fn, void* context, StepStage after, const char* name) {
+    stepTasks.push_back({fn, context, after, name});
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::clearStepTasks() {
+    stepTasks.clear();
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+const physics::parallel::TaskGraph& BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::getStepGraph() const {
+    return stepGraph;
+}
+
+// Builds and runs the step as a task graph. Integration, the broadphase
+// sweep and the narrowphase are split into fixed body chunks; each
+// narrowphase chunk starts as soon as its own sweep chunk is done rather than
+// waiting for the whole broadphase. Contacts are grouped into islands of
+// touching dynamic bodies, and islands are solved in parallel buckets. Each
+// island keeps the serial contact order, and islands share no dynamic bodies,
+// so the result matches detectCollisions() + resolveCollisions(), followed
+// by solveJoints() when there are joints (and substepping is off).
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::runStep(BodyRangeFn integrate, void* context, BodyListFn substep, void* substepContext, float deltaTime) {
+    if constexpr (StagesT::commands) {
+        applyCommands();
+    }
+    // Ahead of beginStep, so an edit frame's rebake is not counted against
+    // debugAssertNoStepAllocations.
+    if (rebakePending) {
+        bakeStaticGeometry();
+    }
+    beginStep();
+
+    size_t count = bodies.size() - bakedBodyCount;
+    stepIntegrateFn = integrate;
+    stepIntegrateContext = context;
+    stepSubstepFn = substep;
+    stepSubstepContext = substepContext;
+    stepDeltaTime = deltaTime;
+    stepChunkCount = (count + detail::kStepChunkSize - 1) / detail::kStepChunkSize;
+    if (stepChunks.size() < stepChunkCount) {
+        stepChunks.resize(stepChunkCount);
+    }
+    size_t concurrency = threadPool ? threadPool->getConcurrency() : 1;
+    solveBucketCount = std::max<size_t>(1, std::min(concurrency, stepChunkCount));
+
+    stepGraph.clear();
+    TaskId integrated = stepGraph.addTask(&BasicWorld::mergeChangedTask, this, 0, "merge changed bodies");
+    for (size_t c = 0; c < stepChunkCount; c++) {
+        TaskId task = stepGraph.addTask(&BasicWorld::integrateTask, this, c, "integrate chunk");
+        stepGraph.addDependency(task, integrated);
+    }
+
+    // Characters only read the baked bodies, which integration never
+    // touches, so they move alongside it and finish with the stage.
+    if constexpr (StagesT::characters) {
+        size_t characterChunks =
+            (characters.getCount() + detail::kCharacterChunkSize - 1) / detail::kCharacterChunkSize;
+        if (characterChunks > 0) {
+            stepCharacterGeometry = getCharacterGeometry();
+            for (size_t c = 0; c < characterChunks; c++) {
+                TaskId task = stepGraph.addTask(&BasicWorld::characterTask, this, c, "move characters");
+                stepGraph.addDependency(task, integrated);
+            }
+        }
+    }
+
+    if constexpr (StagesT::sensors) {
+        if (sensors.hasPendingWork()) {
+            TaskId sensorUpdate = stepGraph.addTask(&BasicWorld::sensorTask, this, 0, "sensors");
+            stepGraph.addDependency(integrated, sensorUpdate);
+        }
+    }
+
+    TaskId stageDone[4] = {integrated, integrated, integrated, integrated};
+    // The collision stages exist only with a broadphase; collisionsEnabled
+    // skips them at runtime.
+    if constexpr (BroadphaseT::enabled) {
+        if (collisionsEnabled) {
+            TaskId sorted = stepGraph.addTask(&BasicWorld::sortTask, this, 0, "broadphase sort");
+            TaskId paired = stepGraph.addTask(&BasicWorld::mergePairsTask, this, 0, "broadphase merge");
+            TaskId islands = stepGraph.addTask(&BasicWorld::buildIslandsTask, this, 0, "build islands");
+            TaskId solved = stepGraph.addJoin("solve");
+            stepGraph.addDependency(integrated, sorted);
+            stepGraph.addDependency(paired, islands);
+
+            for (size_t c = 0; c < stepChunkCount; c++) {
+                TaskId sweep = stepGraph.addTask(&BasicWorld::sweepTask, this, c, "broadphase sweep");
+                TaskId narrow = stepGraph.addTask(&BasicWorld::narrowphaseTask, this, c, "narrowphase");
+                stepGraph.addDependency(sorted, sweep);
+                stepGraph.addDependency(sweep, paired);
+                stepGraph.addDependency(sweep, narrow);
+                stepGraph.addDependency(narrow, islands);
+            }
+            for (size_t b = 0; b < solveBucketCount; b++) {
+                TaskId solve = stepGraph.addTask(&BasicWorld::solveTask, this, b, "solve islands");
+                stepGraph.addDependency(islands, solve);
+                stepGraph.addDependency(solve, solved);
+            }
+            stageDone[static_cast<int>(StepStage::Broadphase)] = paired;
+            stageDone[static_cast<int>(StepStage::Narrowphase)] = islands;
+            stageDone[static_cast<int>(StepStage::Solve)] = solved;
+        }
+    }
+
+    // Joint passes run one after another once the contacts are solved, each
+    // pass spreading its independent items over the pool.
+    if constexpr (StagesT::joints) {
+        if (joints.getCount() > 0) {
+            joints.beginSolve(bodies.data(), idToIndex.data(), idToIndex.size(), deltaTime);
+            TaskId previous = stageDone[static_cast<int>(StepStage::Solve)];
+            for (size_t pass = 0; pass < joints.getPassCount(); pass++) {
+                TaskId passDone = stepGraph.addJoin("joint pass");
+                for (size_t item = joints.getPassBegin(pass); item < joints.getPassEnd(pass); item++) {
+                    TaskId task = stepGraph.addTask(&BasicWorld::jointTask, this, item, "solve joints");
+                    stepGraph.addDependency(previous, task);
+                    stepGraph.addDependency(task, passDone);
+                }
+                previous = passDone;
+            }
+            stageDone[static_cast<int>(StepStage::Solve)] = previous;
+        }
+    }
+
+    if constexpr (BroadphaseT::enabled && StagesT::contactEvents) {
+        if (collisionsEnabled && contactEvents.enabled) {
+            TaskId events = stepGraph.addTask(&BasicWorld::contactEventsTask, this, 0, "contact events");
+            stepGraph.addDependency(stageDone[static_cast<int>(StepStage::Solve)], events);
+            stageDone[static_cast<int>(StepStage::Solve)] = events;
+        } else {
+            contactEventStream.reset();
+        }
+    }
+
+    // The snapshot copies every body once the solve is done, in the same
+    // fixed chunks as integration, baked bodies included.
+    if constexpr (StagesT::snapshots) {
+        if (snapshots.enabled) {
+            size_t total = bodies.size();
+            snapshotIds.resize(total, InvalidBodyId);
+            snapshotPositions.resize(total);
+            snapshotVelocities.resize(total);
+            snapshotBounds.resize(total);
+            snapshotChanged.resize(total);
+            TaskId snapshotDone = stepGraph.addJoin("snapshot");
+            for (size_t c = 0; c * detail::kStepChunkSize < total; c++) {
+                TaskId task = stepGraph.addTask(&BasicWorld::snapshotTask, this, c, "write snapshot");
+                stepGraph.addDependency(stageDone[static_cast<int>(StepStage::Solve)], task);
+                stepGraph.addDependency(task, snapshotDone);
+            }
+            stageDone[static_cast<int>(StepStage::Solve)] = snapshotDone;
+        }
+    }
+
+    for (const StepTask& userTask : stepTasks) {
+        TaskId task = stepGraph.addTask(userTask.fn, userTask.context, 0, userTask.name);
+        stepGraph.addDependency(stageDone[static_cast<int>(userTask.after)], task);
+    }
+
+    stepGraph.run(threadPool);
+    endStep();
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::stepChunkRange(size_t chunk, size_t& begin, size_t& end) const {
+    begin = bakedBodyCount + chunk * detail::kStepChunkSize;
+    end = std::min(begin + detail::kStepChunkSize, bodies.size());
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::integrateTask(void* context, size_t chunk) {
+    BasicWorld& world = *static_cast<BasicWorld*>(context);
+    size_t begin, end;
+    world.stepChunkRange(chunk, begin, end);
+    if constexpr (StagesT::substeps) {
+        if (world.substeps.maxSubsteps > 1) {
+            world.integrateMultiRate(begin, end, world.stepChunks[chunk]);
+        } else {
+            world.stepChunks[chunk].substepBodyCount = 0;
+            world.stepIntegrateFn(world.stepIntegrateContext, begin, end);
+        }
+    } else {
+        world.stepIntegrateFn(world.stepIntegrateContext, begin, end);
+    }
+    std::vector<uint32_t>& changed = world.stepChunks[chunk].changedBodies;
+    changed.clear();
+    world.refreshBounds(begin, end, changed);
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::mergeChangedTask(void* context, size_t) {
+    BasicWorld& world = *static_cast<BasicWorld*>(context);
+    world.changedBodies.assign(world.bakedChanged.begin(), world.bakedChanged.end());
+    world.bakedChanged.clear();
+    world.lastSubstepBodyCount = 0;
+    for (size_t c = 0; c < world.stepChunkCount; c++) {
+        const std::vector<uint32_t>& changed = world.stepChunks[c].changedBodies;
+        world.changedBodies.insert(world.changedBodies.end(), changed.begin(), changed.end());
+        world.lastSubstepBodyCount += world.stepChunks[c].substepBodyCount;
+    }
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::sortTask(void* context, size_t) {
+    BasicWorld& world = *static_cast<BasicWorld*>(context);
+    world.broadphase.prepare(world.bodyBounds.data(), world.bakedBodyCount, world.bodyBounds.size());
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::sweepTask(void* context, size_t chunk) {
+    BasicWorld& world = *static_cast<BasicWorld*>(context);
+    std::vector<BodyPair>& pairs = world.stepChunks[chunk].pairs;
+    pairs.clear();
+    world.findChunkPairs(chunk, pairs);
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::mergePairsTask(void* context, size_t) {
+    BasicWorld& world = *static_cast<BasicWorld*>(context);
+    size_t total = 0;
+    for (size_t c = 0; c < world.stepChunkCount; c++) {
+        total += world.stepChunks[c].pairs.size();
+    }
+    world.candidatePairs.reserve(total);
+    for (size_t c = 0; c < world.stepChunkCount; c++) {
+        const std::vector<BodyPair>& pairs = world.stepChunks[c].pairs;
+        world.candidatePairs.insert(world.candidatePairs.end(), pairs.begin(), pairs.end());
+    }
+    world.lastCandidatePairCount = total;
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::narrowphaseTask(void* context, size_t chunk) {
+    BasicWorld& world = *static_cast<BasicWorld*>(context);
+    StepChunk& stepChunk = world.stepChunks[chunk];
+    stepChunk.contacts.resize(stepChunk.pairs.size());
+    stepChunk.contacts.resize(world.computeContacts(stepChunk.pairs, stepChunk.typedPairs, stepChunk.contacts.data()));
+}
+
+// Merges the chunk contacts and buckets them by island. Static bodies never
+// join islands: the solver only reads them, so two islands resting on the
+// same floor can still be solved concurrently.
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::buildIslandsTask(void* context, size_t) {
+    BasicWorld& world = *static_cast<BasicWorld*>(context);
+    size_t total = 0;
+    for (size_t c = 0; c < world.stepChunkCount; c++) {
+        total += world.stepChunks[c].contacts.size();
+    }
+    world.contacts.reserve(total);
+    world.contactImpulses.resize(total);
+    for (size_t c = 0; c < world.stepChunkCount; c++) {
+        const std::vector<Contact>& chunkContacts = world.stepChunks[c].contacts;
+        world.contacts.insert(world.contacts.end(), chunkContacts.begin(), chunkContacts.end());
+    }
+
+    size_t count = world.bodies.size();
+    std::vector<uint32_t>& parent = world.islandParent;
+    parent.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        parent[i] = static_cast<uint32_t>(i);
+    }
+    for (const Contact& contact : world.contacts) {
+        if (world.bodies[contact.indexA]->isStatic || world.bodies[contact.indexB]->isStatic) continue;
+        uint32_t rootA = detail::findIslandRoot(parent, contact.indexA);
+        uint32_t rootB = detail::findIslandRoot(parent, contact.indexB);
+        if (rootA != rootB) {
+            parent[std::max(rootA, rootB)] = std::min(rootA, rootB);
+        }
+    }
+
+    // Islands are dealt to buckets round-robin in order of first contact.
+    world.islandBucket.assign(count, UINT32_MAX);
+    world.contactBucket.resize(total);
+    world.solveBucketOffsets.assign(world.solveBucketCount + 1, 0);
+    uint32_t nextBucket = 0;
+    for (size_t k = 0; k < total; k++) {
+        const Contact& contact = world.contacts[k];
+        uint32_t body = world.bodies[contact.indexA]->isStatic ? contact.indexB : contact.indexA;
+        uint32_t root = detail::findIslandRoot(parent, body);
+        if (world.islandBucket[root] == UINT32_MAX) {
+            world.islandBucket[root] = nextBucket;
+            nextBucket = (nextBucket + 1) % static_cast<uint32_t>(world.solveBucketCount);
+        }
+        world.contactBucket[k] = world.islandBucket[root];
+        world.solveBucketOffsets[world.contactBucket[k] + 1]++;
+    }
+    for (size_t b = 0; b < world.solveBucketCount; b++) {
+        world.solveBucketOffsets[b + 1] += world.solveBucketOffsets[b];
+    }
+
+    // Stable counting sort keeps each island's contacts in serial order.
+    world.solveOrder.resize(total);
+    world.solveBucketCursor.assign(world.solveBucketOffsets.begin(), world.solveBucketOffsets.end() - 1);
+    for (size_t k = 0; k < total; k++) {
+        world.solveOrder[world.solveBucketCursor[world.contactBucket[k]]++] = static_cast<uint32_t>(k);
+    }
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::solveTask(void* context, size_t bucket) {
+    BasicWorld& world = *static_cast<BasicWorld*>(context);
+    for (uint32_t k = world.solveBucketOffsets[bucket]; k < world.solveBucketOffsets[bucket + 1]; k++) {
+        uint32_t index = world.solveOrder[k];
+        const Contact& contact = world.contacts[index];
+        world.contactImpulses[index] =
+            SolverT::resolve(*world.bodies[contact.indexA], *world.bodies[contact.indexB], contact.info);
+    }
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::contactEventsTask(void* context, size_t) {
+    BasicWorld& world = *static_cast<BasicWorld*>(context);
+    world.contactEventStream.update(world.getContacts(), world.getContactImpulses(), world.bodyIds.data(),
+                                    world.contactEvents.subscribedOnly);
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::jointTask(void* context, size_t item) {
+    static_cast<BasicWorld*>(context)->joints.runItem(item);
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::characterTask(void* context, size_t chunk) {
+    BasicWorld& world = *static_cast<BasicWorld*>(context);
+    size_t begin = chunk * detail::kCharacterChunkSize;
+    size_t end = std::min(begin + detail::kCharacterChunkSize, world.characters.getCount());
+    world.characters.update(world.stepCharacterGeometry, world.stepDeltaTime, begin, end);
+}
+
+// An entry keeps its change frame while the same body stays at its index
+// with the same position, velocity and bounds; the bounds catch setShape and
+// size changes of a body that does not move.
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::snapshotTask(void* context, size_t chunk) {
+    BasicWorld& world = *static_cast<BasicWorld*>(context);
+    size_t begin = chunk * detail::kStepChunkSize;
+    size_t end = std::min(begin + detail::kStepChunkSize, world.bodies.size());
+    for (size_t i = begin; i < end; i++) {
+        const RigidBody& body = *world.bodies[i];
+        BodyId id = world.bodyIds[i];
+        const Vec3& position = world.snapshotPositions[i];
+        const Vec3& velocity = world.snapshotVelocities[i];
+        AABB bounds = body.getAABB();
+        if (world.snapshotIds[i] == id && position.x == body.position.x && position.y == body.position.y &&
+            position.z == body.position.z && velocity.x == body.velocity.x && velocity.y == body.velocity.y &&
+            velocity.z == body.velocity.z && detail::sameBounds(bounds, world.snapshotBounds[i])) {
+            continue;
+        }
+        world.snapshotIds[i] = id;
+        world.snapshotPositions[i] = body.position;
+        world.snapshotVelocities[i] = body.velocity;
+        world.snapshotBounds[i] = bounds;
+        world.snapshotChanged[i] = world.frame;
+    }
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::sensorTask(void* context, size_t) {
+    BasicWorld& world = *static_cast<BasicWorld*>(context);
+    world.sensors.update(world.getBodyBounds(), world.bodyIds.data(), world.getChangedBodies());
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+std::span<const physics::collision::AABB> BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::getBodyBounds() const {
+    return std::span<const AABB>(bodyBounds.data(), bodyBounds.size());
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+const physics::collision::AABB& BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::getBodyBounds(size_t index) const {
+    return bodyBounds[index];
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+std::span<const uint32_t> BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::getChangedBodies() const {
+    return std::span<const uint32_t>(changedBodies.data(), changedBodies.size());
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+std::span<const Contact> BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::getContacts() const {
+    return std::span<const Contact>(contacts.data(), contacts.size());
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+std::span<const physics::collision::BodyPair> BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::getCandidatePairs() const {
+    return std::span<const BodyPair>(candidatePairs.data(), candidatePairs.size());
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+std::span<const float> BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::getContactImpulses() const {
+    return std::span<const float>(contactImpulses.data(), std::min(contactImpulses.size(), contacts.size()));
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+std::span<const ContactEvent> BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::getContactEvents() const {
+    return contactEventStream.getEvents();
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::subscribeContactEvents(BodyId id, bool subscribed) {
+    static_assert(StagesT::contactEvents, "stage compiled out by StagesT");
+    contactEventStream.subscribe(id, subscribed);
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+SensorSystem& BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::getSensors() {
+    static_assert(StagesT::sensors, "stage compiled out by StagesT");
+    return sensors;
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+const SensorSystem& BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::getSensors() const {
+    static_assert(StagesT::sensors, "stage compiled out by StagesT");
+    return sensors;
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+JointSystem& BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::getJoints() {
+    static_assert(StagesT::joints, "stage compiled out by StagesT");
+    return joints;
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+const JointSystem& BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::getJoints() const {
+    static_assert(StagesT::joints, "stage compiled out by StagesT");
+    return joints;
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+CharacterSystem& BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::getCharacters() {
+    static_assert(StagesT::characters, "stage compiled out by StagesT");
+    return characters;
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+const CharacterSystem& BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::getCharacters() const {
+    static_assert(StagesT::characters, "stage compiled out by StagesT");
+    return characters;
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+physics::memory::FrameArena& BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::getFrameArena() {
+    return frameArena;
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+std::pmr::memory_resource* BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::getStorageResource() const {
+    return storageResource;
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+uint64_t BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::getLastStepAllocationCount() const {
+    return lastStepAllocations;
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+size_t BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::getLastSubstepBodyCount() const {
+    return lastSubstepBodyCount;
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+uint32_t BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::getFrame() const {
+    return frame;
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+std::span<const BodyId> BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::getSnapshotIds() const {
+    return std::span<const BodyId>(snapshotIds.data(), snapshotIds.size());
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+std::span<const physics::math::Vec3> BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::getSnapshotPositions() const {
+    return std::span<const Vec3>(snapshotPositions.data(), snapshotPositions.size());
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+std::span<const physics::math::Vec3> BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::getSnapshotVelocities() const {
+    return std::span<const Vec3>(snapshotVelocities.data(), snapshotVelocities.size());
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+std::span<const physics::collision::AABB> BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::getSnapshotBounds() const {
+    return std::span<const AABB>(snapshotBounds.data(), snapshotBounds.size());
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::getChangedSince(uint32_t since, std::vector<uint32_t>& indices) const {
+    for (size_t i = 0; i < snapshotChanged.size(); i++) {
+        if (snapshotChanged[i] > since) {
+            indices.push_back(static_cast<uint32_t>(i));
+        }
+    }
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+BroadphaseT& BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::getBroadphase() {
+    return broadphase;
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+StorageT& BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::getStorage() {
+    return storagePolicy;
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+template <typename Fn>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::invokeRange(void* context, size_t begin, size_t end) {
+    (*static_cast<Fn*>(context))(begin, end);
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+template <typename Fn>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::invokeList(void* context, const uint32_t* slots, size_t count, float deltaTime) {
+    (*static_cast<Fn*>(context))(slots, count, deltaTime);
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+template <typename Integrator>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::step(float deltaTime) {
+    auto integrate = [this, deltaTime](size_t begin, size_t end) {
+        applyGravity(begin, end);
+        for (size_t i = begin; i < end; i++) {
+            physics::dynamics::integrateBody<Integrator>(*bodies[i], deltaTime);
+        }
+    };
+    auto substep = [this](const uint32_t* slots, size_t count, float substepTime) {
+        for (size_t k = 0; k < count; k++) {
+            physics::dynamics::integrateBody<Integrator>(*bodies[slots[k]], substepTime);
+        }
+    };
+    runStep(&invokeRange<decltype(integrate)>, &integrate, &invokeList<decltype(substep)>, &substep, deltaTime);
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+template <typename Integrator, typename ForceField>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::step(float deltaTime, ForceField&& field) {
+    auto integrate = [this, deltaTime, &field](size_t begin, size_t end) {
+        applyGravity(begin, end);
+        for (size_t i = begin; i < end; i++) {
+            physics::dynamics::integrateBody<Integrator>(*bodies[i], deltaTime, field);
+        }
+    };
+    auto substep = [this, &field](const uint32_t* slots, size_t count, float substepTime) {
+        for (size_t k = 0; k < count; k++) {
+            physics::dynamics::integrateBody<Integrator>(*bodies[slots[k]], substepTime, field);
+        }
+    };
+    runStep(&invokeRange<decltype(integrate)>, &integrate, &invokeList<decltype(substep)>, &substep, deltaTime);
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+template <typename Integrator>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::integrateBodies(float deltaTime) {
+    for (size_t i = bakedBodyCount; i < bodies.size(); i++) {
+        physics::dynamics::integrateBody<Integrator>(*bodies[i], deltaTime);
+    }
+}
+
+template <typename IntegratorT, typename BroadphaseT, typename SolverT, typename StorageT, typename StagesT>
+template <typename Integrator, typename ForceField>
+void BasicWorld<IntegratorT, BroadphaseT, SolverT, StorageT, StagesT>::integrateBodies(float deltaTime, ForceField&& field) {
+    for (size_t i = bakedBodyCount; i < bodies.size(); i++) {
+        physics::dynamics::integrateBody<Integrator>(*bodies[i], deltaTime, field);
+    }
+}
+
+}
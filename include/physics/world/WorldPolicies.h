@@ -0,0 +1,203 @@
+#pragma once
+#include "physics/collision/Broadphase.h"
+#include "physics/collision/CollisionDetection.h"
+#include "physics/collision/CollisionFilter.h"
+#include "physics/dynamics/RigidBody.h"
+#include "physics/memory/HugePageResource.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+namespace physics::world {
+
+// Policies plugged into BasicWorld (see World.h). Each is a plain type
+// resolved at compile time, so a world built without a stage has no code
+// for it and no runtime switch.
+
+// Broadphase policies. prepare() runs once per step after the bounds
+// refresh and covers the bodies in slots [first, count). findPairs() then
+// runs on disjoint chunks [begin, end) of those count - first items,
+// possibly in parallel; concatenating the chunk outputs in order yields
+// every overlapping pair once with a < b. Data kept by prepare() comes from
+// the scratch resource (the world's frame arena) and is dropped by
+// release() before the arena rewinds. With enabled false the world compiles
+// out the whole collision pipeline.
+class SweepAndPruneBroadphase {
+public:
+    static constexpr bool enabled = true;
+
+    explicit SweepAndPruneBroadphase(std::pmr::memory_resource* scratch);
+
+    void prepare(const physics::collision::AABB* bounds, size_t first, size_t count);
+    template <typename PairVector>
+    void findPairs(const physics::collision::AABB* bounds, const physics::collision::CollisionFilter* filters,
+                   size_t begin, size_t end, PairVector& pairs) const;
+    void release();
+
+private:
+    std::pmr::memory_resource* scratch;
+    std::pmr::vector<physics::collision::SweepEntry> entries;
+};
+
+// Hashes every body into the cells of a uniform grid its bounds cover.
+// Suits crowds of similarly sized bodies; set cellSize to about their
+// size. A body spanning many cells (a large floor) costs one entry per
+// cell, so bake such geometry instead.
+class UniformGridBroadphase {
+public:
+    static constexpr bool enabled = true;
+    float cellSize = 2.0f;
+
+    explicit UniformGridBroadphase(std::pmr::memory_resource* scratch);
+
+    void prepare(const physics::collision::AABB* bounds, size_t first, size_t count);
+    template <typename PairVector>
+    void findPairs(const physics::collision::AABB* bounds, const physics::collision::CollisionFilter* filters,
+                   size_t begin, size_t end, PairVector& pairs) const;
+    void release();
+
+private:
+    struct CellEntry {
+        uint32_t hash;
+        uint32_t index;
+    };
+
+    int32_t cellOf(float coordinate) const;
+    static uint32_t hashCell(int32_t x, int32_t y, int32_t z);
+
+    std::pmr::memory_resource* scratch;
+    std::pmr::vector<CellEntry> entries;
+    size_t first;
+};
+
+// No collision detection at all: bodies only integrate.
+class NoBroadphase {
+public:
+    static constexpr bool enabled = false;
+
+    explicit NoBroadphase(std::pmr::memory_resource*) {}
+
+    void prepare(const physics::collision::AABB*, size_t, size_t) {}
+    template <typename PairVector>
+    void findPairs(const physics::collision::AABB*, const physics::collision::CollisionFilter*, size_t, size_t,
+                   PairVector&) const {}
+    void release() {}
+};
+
+// Stage policies choose the optional stages of the step. A stage that is
+// off has no task, no per-step check and no code in the world, and its
+// accessors do not compile. Within a stage that is on, the world's settings
+// (contactEvents.enabled, snapshots.enabled, substeps.maxSubsteps) still
+// switch it at runtime.
+struct AllStages {
+    static constexpr bool commands = true;
+    static constexpr bool characters = true;
+    static constexpr bool sensors = true;
+    static constexpr bool joints = true;
+    static constexpr bool contactEvents = true;
+    static constexpr bool snapshots = true;
+    static constexpr bool substeps = true;
+};
+
+// Only integration and, with a broadphase, the contact pipeline.
+struct NoOptionalStages {
+    static constexpr bool commands = false;
+    static constexpr bool characters = false;
+    static constexpr bool sensors = false;
+    static constexpr bool joints = false;
+    static constexpr bool contactEvents = false;
+    static constexpr bool snapshots = false;
+    static constexpr bool substeps = false;
+};
+
+// Solver policies resolve one contact and return the normal impulse.
+struct ImpulseSolver {
+    static float resolve(physics::dynamics::RigidBody& a, physics::dynamics::RigidBody& b,
+                         const physics::collision::CollisionInfo& info) {
+        return physics::collision::CollisionDetection::resolveAABBCollision(a, b, info);
+    }
+};
+
+// Storage policies provide the memory resource behind the per-body arrays
+// and the frame arena. They are constructed from the world's storage
+// argument and outlive every container that uses them.
+class DefaultStorage {
+public:
+    // Uses the given resource, or the default resource if null.
+    explicit DefaultStorage(std::pmr::memory_resource* resource = nullptr);
+
+    std::pmr::memory_resource* resource() const;
+
+private:
+    std::pmr::memory_resource* storageResource;
+};
+
+// Owns a HugePageResource with default settings; the argument is its
+// upstream for small requests.
+class HugePageStorage {
+public:
+    explicit HugePageStorage(std::pmr::memory_resource* upstream = nullptr);
+
+    std::pmr::memory_resource* resource();
+    physics::memory::HugePageResource& pages();
+
+private:
+    physics::memory::HugePageResource hugePages;
+};
+
+template <typename PairVector>
+void SweepAndPruneBroadphase::findPairs(const physics::collision::AABB* bounds,
+                                        const physics::collision::CollisionFilter* filters, size_t begin,
+                                        size_t end, PairVector& pairs) const {
+    physics::collision::SweepAndPrune::sweepRange(
+        bounds, std::span<const physics::collision::SweepEntry>(entries.data(), entries.size()), begin, end, pairs,
+        filters);
+}
+
+// A pair is reported only from the cell holding the low corner of the two
+// boxes' overlap. That cell is covered by both bodies, so each pair comes out
+// exactly once, and hash collisions between distinct cells drop out too.
+// prepare() keeps one entry per body and hash, so a body covering two
+// colliding cells is not seen twice in a run.
+template <typename PairVector>
+void UniformGridBroadphase::findPairs(const physics::collision::AABB* bounds,
+                                      const physics::collision::CollisionFilter* filters, size_t begin, size_t end,
+                                      PairVector& pairs) const {
+    for (size_t k = begin; k < end; k++) {
+        uint32_t i = static_cast<uint32_t>(first + k);
+        const physics::collision::AABB& box = bounds[i];
+        int32_t minCell[3] = {cellOf(box.min.x), cellOf(box.min.y), cellOf(box.min.z)};
+        int32_t maxCell[3] = {cellOf(box.max.x), cellOf(box.max.y), cellOf(box.max.z)};
+        for (int32_t x = minCell[0]; x <= maxCell[0]; x++) {
+            for (int32_t y = minCell[1]; y <= maxCell[1]; y++) {
+                for (int32_t z = minCell[2]; z <= maxCell[2]; z++) {
+                    uint32_t hash = hashCell(x, y, z);
+                    auto it = std::lower_bound(entries.begin(), entries.end(), CellEntry{hash, i + 1},
+                                               [](const CellEntry& lhs, const CellEntry& rhs) {
+                                                   return lhs.hash < rhs.hash ||
+                                                          (lhs.hash == rhs.hash && lhs.index < rhs.index);
+                                               });
+                    for (; it != entries.end() && it->hash == hash; ++it) {
+                        uint32_t j = it->index;
+                        const physics::collision::AABB& other = bounds[j];
+                        if (!box.intersects(other)) continue;
+                        if (cellOf(std::max(box.min.x, other.min.x)) != x ||
+                            cellOf(std::max(box.min.y, other.min.y)) != y ||
+                            cellOf(std::max(box.min.z, other.min.z)) != z) {
+                            continue;
+                        }
+                        if (filters && !physics::collision::CollisionFilter::shouldCollide(filters[i], filters[j])) {
+                            continue;
+                        }
+                        pairs.push_back({i, j});
+                    }
+                }
+            }
+        }
+    }
+}
+
+}
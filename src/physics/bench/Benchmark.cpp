@@ -0,0 +1,158 @@
+#include "physics/bench/Benchmark.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <ostream>
+
+namespace physics::bench {
+
+namespace {
+// Scales the MAD to a standard deviation for normally distributed samples.
+const double kMadScale = 0.6745;
+// Floor on the MAD relative to the median. Very stable kernels can have a
+// near-zero MAD, which would otherwise flag sub-percent jitter as outliers.
+const double kMinRelativeMad = 1e-3;
+
+double median(std::vector<double>& values) {
+    size_t middle = values.size() / 2;
+    std::nth_element(values.begin(), values.begin() + middle, values.end());
+    double upper = values[middle];
+    if (values.size() % 2 == 1) return upper;
+    double lower = *std::max_element(values.begin(), values.begin() + middle);
+    return (lower + upper) * 0.5;
+}
+
+uint64_t nowNanos() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+}
+
+SampleStats Benchmark::summarize(std::vector<double> samples, double outlierThreshold, std::vector<bool>* keptMask) {
+    SampleStats stats;
+    if (keptMask) keptMask->assign(samples.size(), true);
+    if (samples.empty()) return stats;
+
+    std::vector<double> scratch = samples;
+    double center = median(scratch);
+    for (double& value : scratch) {
+        value = std::abs(value - center);
+    }
+    double mad = std::max(median(scratch), std::abs(center) * kMinRelativeMad);
+
+    double sum = 0.0;
+    double sumSq = 0.0;
+    bool first = true;
+    for (size_t i = 0; i < samples.size(); i++) {
+        double deviation = std::abs(samples[i] - center);
+        bool outlier = mad > 0.0 ? kMadScale * deviation / mad > outlierThreshold : deviation > 0.0;
+        if (outlier) {
+            stats.rejected++;
+            if (keptMask) (*keptMask)[i] = false;
+            continue;
+        }
+        stats.kept++;
+        sum += samples[i];
+        sumSq += samples[i] * samples[i];
+        stats.min = first ? samples[i] : std::min(stats.min, samples[i]);
+        stats.max = first ? samples[i] : std::max(stats.max, samples[i]);
+        first = false;
+    }
+    stats.median = center;
+    stats.mean = sum / static_cast<double>(stats.kept);
+    double variance = stats.kept > 1 ? (sumSq - sum * stats.mean) / static_cast<double>(stats.kept - 1) : 0.0;
+    stats.stddev = std::sqrt(std::max(variance, 0.0));
+    return stats;
+}
+
+BenchmarkResult Benchmark::runKernel(const std::string& name, KernelFn fn, void* context, const BenchmarkOptions& options) {
+    BenchmarkResult result;
+    result.name = name;
+
+    size_t iterations = options.iterations;
+    if (iterations == 0) {
+        iterations = 1;
+        for (;;) {
+            uint64_t begin = nowNanos();
+            fn(context, iterations);
+            if (nowNanos() - begin >= options.minSampleNanos || iterations >= (size_t(1) << 40)) break;
+            iterations *= 2;
+        }
+    }
+    result.iterations = iterations;
+
+    for (uint32_t i = 0; i < options.warmupRuns; i++) {
+        fn(context, iterations);
+    }
+
+    PerfCounters counters;
+    std::vector<double> nanos(options.samples);
+    std::vector<double> counts[PerfCounters::CounterCount];
+    for (auto& values : counts) {
+        values.resize(options.samples);
+    }
+    double perIteration = 1.0 / static_cast<double>(iterations);
+    for (uint32_t s = 0; s < options.samples; s++) {
+        counters.start();
+        uint64_t begin = nowNanos();
+        fn(context, iterations);
+        uint64_t end = nowNanos();
+        counters.stop();
+        nanos[s] = static_cast<double>(end - begin) * perIteration;
+        for (uint32_t c = 0; c < PerfCounters::CounterCount; c++) {
+            counts[c][s] = static_cast<double>(counters.get(static_cast<PerfCounters::Counter>(c))) * perIteration;
+        }
+    }
+
+    // Counters are averaged over the samples the timing kept, so a sample
+    // disturbed by a context switch is dropped from both.
+    std::vector<bool> kept;
+    result.nanos = summarize(nanos, options.outlierThreshold, &kept);
+    for (uint32_t c = 0; c < PerfCounters::CounterCount; c++) {
+        result.hasCounter[c] = counters.hasCounter(static_cast<PerfCounters::Counter>(c));
+        double sum = 0.0;
+        for (size_t s = 0; s < kept.size(); s++) {
+            if (kept[s]) sum += counts[c][s];
+        }
+        result.counters[c] = result.nanos.kept > 0 ? sum / static_cast<double>(result.nanos.kept) : 0.0;
+    }
+    return result;
+}
+
+void Benchmark::printHeader(std::ostream& out) {
+    char line[160];
+    std::snprintf(line, sizeof(line), "%-28s %10s %8s %5s %9s %9s %6s %9s %9s\n", "benchmark", "ns/op", "+-%", "rej",
+                  "cycles", "instr", "IPC", "cache-mis", "br-miss");
+    out << line;
+}
+
+void Benchmark::print(std::ostream& out, const BenchmarkResult& result) {
+    auto counter = [&](PerfCounters::Counter c, char* buffer, size_t size) {
+        if (result.hasCounter[c]) {
+            std::snprintf(buffer, size, "%.3f", result.counters[c]);
+        } else {
+            std::snprintf(buffer, size, "-");
+        }
+    };
+    char cycles[32], instructions[32], cacheMisses[32], branchMisses[32], ipc[32];
+    counter(PerfCounters::Cycles, cycles, sizeof(cycles));
+    counter(PerfCounters::Instructions, instructions, sizeof(instructions));
+    counter(PerfCounters::CacheMisses, cacheMisses, sizeof(cacheMisses));
+    counter(PerfCounters::BranchMisses, branchMisses, sizeof(branchMisses));
+    bool hasIpc = result.hasCounter[PerfCounters::Cycles] && result.hasCounter[PerfCounters::Instructions] &&
+                  result.counters[PerfCounters::Cycles] > 0.0;
+    if (hasIpc) {
+        std::snprintf(ipc, sizeof(ipc), "%.2f", result.counters[PerfCounters::Instructions] / result.counters[PerfCounters::Cycles]);
+    } else {
+        std::snprintf(ipc, sizeof(ipc), "-");
+    }
+    double spread = result.nanos.mean > 0.0 ? 100.0 * result.nanos.stddev / result.nanos.mean : 0.0;
+
+    char line[256];
+    std::snprintf(line, sizeof(line), "%-28s %10.3f %8.1f %5zu %9s %9s %6s %9s %9s\n", result.name.c_str(),
+                  result.nanos.median, spread, result.nanos.rejected, cycles, instructions, ipc, cacheMisses, branchMisses);
+    out << line;
+}
+
+}
@@ -0,0 +1,104 @@
+#include "physics/bench/PerfCounters.h"
+
+#if defined(__linux__)
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace physics::bench {
+
+#if defined(__linux__)
+namespace {
+const uint64_t kCounterConfigs[PerfCounters::CounterCount] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES,
+};
+
+int openCounter(uint64_t config, int groupFd) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = groupFd < 0 ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0));
+}
+}
+
+PerfCounters::PerfCounters() : leader(-1) {
+    for (size_t i = 0; i < CounterCount; i++) {
+        values[i] = 0;
+        fds[i] = openCounter(kCounterConfigs[i], leader);
+        if (fds[i] >= 0 && leader < 0) {
+            leader = fds[i];
+        }
+    }
+}
+
+PerfCounters::~PerfCounters() {
+    for (int fd : fds) {
+        if (fd >= 0) close(fd);
+    }
+}
+
+void PerfCounters::start() {
+    if (leader < 0) return;
+    ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+void PerfCounters::stop() {
+    if (leader < 0) return;
+    ioctl(leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    for (size_t i = 0; i < CounterCount; i++) {
+        values[i] = 0;
+        if (fds[i] < 0) continue;
+        // value, time enabled, time running
+        uint64_t data[3];
+        if (read(fds[i], data, sizeof(data)) != static_cast<ssize_t>(sizeof(data)) || data[2] == 0) continue;
+        values[i] = data[2] < data[1]
+            ? static_cast<uint64_t>(static_cast<double>(data[0]) * static_cast<double>(data[1]) / static_cast<double>(data[2]))
+            : data[0];
+    }
+}
+#else
+PerfCounters::PerfCounters() : leader(-1) {
+    for (size_t i = 0; i < CounterCount; i++) {
+        fds[i] = -1;
+        values[i] = 0;
+    }
+}
+
+PerfCounters::~PerfCounters() {}
+
+void PerfCounters::start() {}
+
+void PerfCounters::stop() {}
+#endif
+
+bool PerfCounters::isAvailable() const {
+    return leader >= 0;
+}
+
+bool PerfCounters::hasCounter(Counter counter) const {
+    return fds[counter] >= 0;
+}
+
+uint64_t PerfCounters::get(Counter counter) const {
+    return values[counter];
+}
+
+const char* PerfCounters::getName(Counter counter) {
+    static const char* const kNames[CounterCount] = {"cycles", "instructions", "cache-misses", "branch-misses"};
+    return kNames[counter];
+}
+
+}
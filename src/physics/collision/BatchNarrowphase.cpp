@@ -0,0 +1,248 @@
+#include "physics/collision/BatchNarrowphase.h"
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PHYSICS_HAS_AVX2_KERNEL 1
+#endif
+
+namespace physics::collision {
+
+using Vec3 = physics::math::Vec3;
+
+static_assert(sizeof(Vec3) == 3 * sizeof(float), "batch gathers assume packed Vec3");
+static_assert(sizeof(AABB) == 6 * sizeof(float), "batch gathers assume packed AABB");
+static_assert(sizeof(Shape) % sizeof(float) == 0 && offsetof(Shape, radius) % sizeof(float) == 0,
+              "sphere gathers index shapes in floats");
+
+size_t BatchNarrowphase::findContactsScalar(const AABB* bounds, const Vec3* positions,
+                                            std::span<const BodyPair> pairs, Contact* contacts) {
+  size_t written = 0;
+  for (const BodyPair& pair : pairs) {
+    CollisionInfo info = CollisionDetection::getAABBCollisionInfo(bounds[pair.a], bounds[pair.b],
+                                                                  positions[pair.a], positions[pair.b]);
+    if (info.hasCollision && info.penetrationDepth > 0.0f) {
+      contacts[written++] = {pair.a, pair.b, info};
+    }
+  }
+  return written;
+}
+
+size_t BatchNarrowphase::findSphereContactsScalar(const Vec3* positions, const Shape* shapes,
+                                                  std::span<const BodyPair> pairs, Contact* contacts) {
+  size_t written = 0;
+  for (const BodyPair& pair : pairs) {
+    CollisionInfo info = CollisionDetection::getSphereCollisionInfo(positions[pair.a], shapes[pair.a].radius,
+                                                                    positions[pair.b], shapes[pair.b].radius);
+    if (info.hasCollision) {
+      contacts[written++] = {pair.a, pair.b, info};
+    }
+  }
+  return written;
+}
+
+#ifdef PHYSICS_HAS_AVX2_KERNEL
+
+namespace {
+
+// Every operation mirrors the scalar path so the results match bit for bit:
+// std::min(a, b) is (b < a) ? b : a, which is _mm256_min_ps(b, a), and the
+// minimum-overlap axis uses the same <= comparisons in the same order.
+__attribute__((target("avx2"))) size_t findContactsAvx2(const AABB* bounds, const Vec3* positions,
+                                                        std::span<const BodyPair> pairs, Contact* contacts) {
+  const float* boundsBase = &bounds[0].min.x;
+  const float* positionBase = &positions[0].x;
+  const __m256 half = _mm256_set1_ps(0.5f);
+  const __m256 one = _mm256_set1_ps(1.0f);
+  const __m256 minusOne = _mm256_set1_ps(-1.0f);
+  const __m256 zero = _mm256_setzero_ps();
+
+  size_t written = 0;
+  size_t batchEnd = pairs.size() & ~size_t(7);
+  for (size_t base = 0; base < batchEnd; base += 8) {
+    alignas(32) int32_t indexA[8];
+    alignas(32) int32_t indexB[8];
+    for (int lane = 0; lane < 8; lane++) {
+      indexA[lane] = static_cast<int32_t>(pairs[base + lane].a);
+      indexB[lane] = static_cast<int32_t>(pairs[base + lane].b);
+    }
+    __m256i laneA = _mm256_load_si256(reinterpret_cast<const __m256i*>(indexA));
+    __m256i laneB = _mm256_load_si256(reinterpret_cast<const __m256i*>(indexB));
+    __m256i boundsA = _mm256_mullo_epi32(laneA, _mm256_set1_epi32(6));
+    __m256i boundsB = _mm256_mullo_epi32(laneB, _mm256_set1_epi32(6));
+
+    __m256 intersecting = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    __m256 overlap[3];
+    __m256 direction[3];
+    for (int axis = 0; axis < 3; axis++) {
+      __m256i minOffset = _mm256_set1_epi32(axis);
+      __m256i maxOffset = _mm256_set1_epi32(axis + 3);
+      __m256 minA = _mm256_i32gather_ps(boundsBase, _mm256_add_epi32(boundsA, minOffset), 4);
+      __m256 maxA = _mm256_i32gather_ps(boundsBase, _mm256_add_epi32(boundsA, maxOffset), 4);
+      __m256 minB = _mm256_i32gather_ps(boundsBase, _mm256_add_epi32(boundsB, minOffset), 4);
+      __m256 maxB = _mm256_i32gather_ps(boundsBase, _mm256_add_epi32(boundsB, maxOffset), 4);
+
+      intersecting = _mm256_and_ps(intersecting, _mm256_cmp_ps(minA, maxB, _CMP_LE_OQ));
+      intersecting = _mm256_and_ps(intersecting, _mm256_cmp_ps(maxA, minB, _CMP_GE_OQ));
+
+      overlap[axis] = _mm256_sub_ps(_mm256_min_ps(maxB, maxA), _mm256_max_ps(minB, minA));
+      __m256 centerA = _mm256_mul_ps(_mm256_add_ps(minA, maxA), half);
+      __m256 centerB = _mm256_mul_ps(_mm256_add_ps(minB, maxB), half);
+      direction[axis] = _mm256_blendv_ps(one, minusOne, _mm256_cmp_ps(centerA, centerB, _CMP_LT_OQ));
+    }
+
+    __m256 useX = _mm256_and_ps(_mm256_cmp_ps(overlap[0], overlap[1], _CMP_LE_OQ),
+                                _mm256_cmp_ps(overlap[0], overlap[2], _CMP_LE_OQ));
+    __m256 useY = _mm256_andnot_ps(useX, _mm256_cmp_ps(overlap[1], overlap[2], _CMP_LE_OQ));
+    __m256 useZ = _mm256_andnot_ps(_mm256_or_ps(useX, useY), intersecting);
+
+    __m256 separation[3] = {
+      _mm256_and_ps(useX, _mm256_mul_ps(overlap[0], direction[0])),
+      _mm256_and_ps(useY, _mm256_mul_ps(overlap[1], direction[1])),
+      _mm256_and_ps(useZ, _mm256_mul_ps(overlap[2], direction[2])),
+    };
+    __m256 lengthSq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(separation[0], separation[0]),
+                                                  _mm256_mul_ps(separation[1], separation[1])),
+                                    _mm256_mul_ps(separation[2], separation[2]));
+    __m256 depth = _mm256_sqrt_ps(lengthSq);
+    __m256 hit = _mm256_and_ps(intersecting, _mm256_cmp_ps(depth, zero, _CMP_GT_OQ));
+    int hitMask = _mm256_movemask_ps(hit);
+    if (hitMask == 0) continue;
+
+    alignas(32) float normal[3][8];
+    alignas(32) float depthLanes[8];
+    for (int axis = 0; axis < 3; axis++) {
+      _mm256_store_ps(normal[axis], _mm256_div_ps(separation[axis], depth));
+    }
+    _mm256_store_ps(depthLanes, depth);
+
+    while (hitMask) {
+      int lane = __builtin_ctz(static_cast<unsigned>(hitMask));
+      hitMask &= hitMask - 1;
+      const float* positionA = positionBase + 3 * static_cast<size_t>(indexA[lane]);
+      const float* positionB = positionBase + 3 * static_cast<size_t>(indexB[lane]);
+      Vec3 contactPoint((positionA[0] + positionB[0]) * 0.5f, (positionA[1] + positionB[1]) * 0.5f,
+                        (positionA[2] + positionB[2]) * 0.5f);
+      contacts[written++] = {static_cast<uint32_t>(indexA[lane]), static_cast<uint32_t>(indexB[lane]),
+                             CollisionInfo(contactPoint, Vec3(normal[0][lane], normal[1][lane], normal[2][lane]),
+                                           depthLanes[lane])};
+    }
+  }
+
+  written += BatchNarrowphase::findContactsScalar(bounds, positions, pairs.subspan(batchEnd), contacts + written);
+  return written;
+}
+
+__attribute__((target("avx2"))) size_t findSphereContactsAvx2(const Vec3* positions, const Shape* shapes,
+                                                              std::span<const BodyPair> pairs, Contact* contacts) {
+  const float* positionBase = &positions[0].x;
+  const float* shapeBase = reinterpret_cast<const float*>(shapes);
+  const __m256i shapeStride = _mm256_set1_epi32(static_cast<int>(sizeof(Shape) / sizeof(float)));
+  const __m256i radiusOffset = _mm256_set1_epi32(static_cast<int>(offsetof(Shape, radius) / sizeof(float)));
+  const __m256i three = _mm256_set1_epi32(3);
+  const __m256 half = _mm256_set1_ps(0.5f);
+  const __m256 zero = _mm256_setzero_ps();
+  const __m256 one = _mm256_set1_ps(1.0f);
+
+  size_t written = 0;
+  size_t batchEnd = pairs.size() & ~size_t(7);
+  for (size_t base = 0; base < batchEnd; base += 8) {
+    alignas(32) int32_t indexA[8];
+    alignas(32) int32_t indexB[8];
+    for (int lane = 0; lane < 8; lane++) {
+      indexA[lane] = static_cast<int32_t>(pairs[base + lane].a);
+      indexB[lane] = static_cast<int32_t>(pairs[base + lane].b);
+    }
+    __m256i laneA = _mm256_load_si256(reinterpret_cast<const __m256i*>(indexA));
+    __m256i laneB = _mm256_load_si256(reinterpret_cast<const __m256i*>(indexB));
+
+    __m256 radiusA = _mm256_i32gather_ps(shapeBase, _mm256_add_epi32(_mm256_mullo_epi32(laneA, shapeStride), radiusOffset), 4);
+    __m256 radiusB = _mm256_i32gather_ps(shapeBase, _mm256_add_epi32(_mm256_mullo_epi32(laneB, shapeStride), radiusOffset), 4);
+    __m256i positionA = _mm256_mullo_epi32(laneA, three);
+    __m256i positionB = _mm256_mullo_epi32(laneB, three);
+    __m256 centerB[3];
+    __m256 delta[3];
+    for (int axis = 0; axis < 3; axis++) {
+      __m256i offset = _mm256_set1_epi32(axis);
+      __m256 a = _mm256_i32gather_ps(positionBase, _mm256_add_epi32(positionA, offset), 4);
+      centerB[axis] = _mm256_i32gather_ps(positionBase, _mm256_add_epi32(positionB, offset), 4);
+      delta[axis] = _mm256_sub_ps(a, centerB[axis]);
+    }
+
+    __m256 distanceSq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(delta[0], delta[0]), _mm256_mul_ps(delta[1], delta[1])),
+                                      _mm256_mul_ps(delta[2], delta[2]));
+    __m256 radiusSum = _mm256_add_ps(radiusA, radiusB);
+    __m256 hit = _mm256_cmp_ps(distanceSq, _mm256_mul_ps(radiusSum, radiusSum), _CMP_LT_OQ);
+    if (_mm256_movemask_ps(hit) == 0) continue;
+
+    __m256 distance = _mm256_sqrt_ps(distanceSq);
+    __m256 depth = _mm256_sub_ps(radiusSum, distance);
+    hit = _mm256_and_ps(hit, _mm256_cmp_ps(depth, zero, _CMP_GT_OQ));
+    int hitMask = _mm256_movemask_ps(hit);
+    if (hitMask == 0) continue;
+
+    __m256 separated = _mm256_cmp_ps(distance, zero, _CMP_GT_OQ);
+    __m256 normal[3] = {
+      _mm256_and_ps(separated, _mm256_div_ps(delta[0], distance)),
+      _mm256_blendv_ps(one, _mm256_div_ps(delta[1], distance), separated),
+      _mm256_and_ps(separated, _mm256_div_ps(delta[2], distance)),
+    };
+    __m256 reach = _mm256_sub_ps(radiusB, _mm256_mul_ps(depth, half));
+
+    alignas(32) float normalLanes[3][8];
+    alignas(32) float pointLanes[3][8];
+    alignas(32) float depthLanes[8];
+    for (int axis = 0; axis < 3; axis++) {
+      _mm256_store_ps(normalLanes[axis], normal[axis]);
+      _mm256_store_ps(pointLanes[axis], _mm256_add_ps(centerB[axis], _mm256_mul_ps(normal[axis], reach)));
+    }
+    _mm256_store_ps(depthLanes, depth);
+
+    while (hitMask) {
+      int lane = __builtin_ctz(static_cast<unsigned>(hitMask));
+      hitMask &= hitMask - 1;
+      contacts[written++] = {static_cast<uint32_t>(indexA[lane]), static_cast<uint32_t>(indexB[lane]),
+                             CollisionInfo(Vec3(pointLanes[0][lane], pointLanes[1][lane], pointLanes[2][lane]),
+                                           Vec3(normalLanes[0][lane], normalLanes[1][lane], normalLanes[2][lane]),
+                                           depthLanes[lane])};
+    }
+  }
+
+  written += BatchNarrowphase::findSphereContactsScalar(positions, shapes, pairs.subspan(batchEnd), contacts + written);
+  return written;
+}
+
+}
+
+#endif
+
+bool BatchNarrowphase::hasAvx2() {
+#ifdef PHYSICS_HAS_AVX2_KERNEL
+  static const bool supported = __builtin_cpu_supports("avx2");
+  return supported;
+#else
+  return false;
+#endif
+}
+
+size_t BatchNarrowphase::findContacts(const AABB* bounds, const Vec3* positions,
+                                      std::span<const BodyPair> pairs, Contact* contacts) {
+#ifdef PHYSICS_HAS_AVX2_KERNEL
+  if (hasAvx2()) {
+    return findContactsAvx2(bounds, positions, pairs, contacts);
+  }
+#endif
+  return findContactsScalar(bounds, positions, pairs, contacts);
+}
+
+size_t BatchNarrowphase::findSphereContacts(const Vec3* positions, const Shape* shapes,
+                                            std::span<const BodyPair> pairs, Contact* contacts) {
+#ifdef PHYSICS_HAS_AVX2_KERNEL
+  if (hasAvx2()) {
+    return findSphereContactsAvx2(positions, shapes, pairs, contacts);
+  }
+#endif
+  return findSphereContactsScalar(positions, shapes, pairs, contacts);
+}
+
+}
@@ -0,0 +1,25 @@
+#include "physics/collision/Broadphase.h"
+#include <algorithm>
+
+namespace physics::collision {
+
+void SweepAndPrune::sortEntries(const AABB* bounds, size_t count, std::pmr::vector<SweepEntry>& entries,
+                                size_t first) {
+  entries.clear();
+  entries.reserve(count - first);
+  for (size_t i = first; i < count; i++) {
+    entries.push_back({bounds[i].min.x, static_cast<uint32_t>(i)});
+  }
+  std::sort(entries.begin(), entries.end(), [](const SweepEntry& lhs, const SweepEntry& rhs) {
+    return lhs.minX < rhs.minX || (lhs.minX == rhs.minX && lhs.index < rhs.index);
+  });
+}
+
+void SweepAndPrune::findPairs(const AABB* bounds, size_t count, std::pmr::vector<BodyPair>& pairs,
+                              std::pmr::memory_resource* scratch, const CollisionFilter* filters) {
+  std::pmr::vector<SweepEntry> entries(scratch);
+  sortEntries(bounds, count, entries);
+  sweepRange(bounds, std::span<const SweepEntry>(entries.data(), entries.size()), 0, count, pairs, filters);
+}
+
+}
@@ -1,7 +1,6 @@
 #include "physics/collision/CollisionDetection.h"
 #include <algorithm>
 #include <cmath>
-#include <iostream>
 namespace physics::collision {
 
 using Vec3 = physics::math::Vec3;
@@ -50,9 +49,11 @@ bool CollisionDetection::checkAABBCollision(const RigidBody& bodyA, const RigidB
 }
 
 CollisionInfo CollisionDetection::getAABBCollisionInfo(const RigidBody& bodyA, const RigidBody& bodyB) {
-    AABB aabbA = bodyA.getAABB();
-    AABB aabbB = bodyB.getAABB();
-    
+    return getAABBCollisionInfo(bodyA.getAABB(), bodyB.getAABB(), bodyA.position, bodyB.position);
+}
+
+CollisionInfo CollisionDetection::getAABBCollisionInfo(const AABB& aabbA, const AABB& aabbB,
+                                                       const Vec3& positionA, const Vec3& positionB) {
     if (!aabbA.intersects(aabbB)) {
         return CollisionInfo();
     }
@@ -61,36 +62,54 @@ CollisionInfo CollisionDetection::getAABBCollisionInfo(const RigidBody& bodyA, c
     float penetrationDepth = separation.length();
     Vec3 normal = separation.normalized();
     
-    Vec3 contactPoint = (bodyA.position + bodyB.position) * 0.5f;
+    Vec3 contactPoint = (positionA + positionB) * 0.5f;
     
     return CollisionInfo(contactPoint, normal, penetrationDepth);
 }
 
-void CollisionDetection::resolveAABBCollision(RigidBody& bodyA, RigidBody& bodyB, const CollisionInfo& collision) {
-    if (!collision.hasCollision) return;
+CollisionInfo CollisionDetection::getSphereCollisionInfo(const Vec3& centerA, float radiusA,
+                                                         const Vec3& centerB, float radiusB) {
+    Vec3 delta = centerA - centerB;
+    float distanceSq = delta.lengthSq();
+    float radiusSum = radiusA + radiusB;
+    if (!(distanceSq < radiusSum * radiusSum)) {
+        return CollisionInfo();
+    }
+
+    float distance = std::sqrt(distanceSq);
+    float penetrationDepth = radiusSum - distance;
+    if (!(penetrationDepth > 0.0f)) {
+        return CollisionInfo();
+    }
+    Vec3 normal = distance > 0.0f ? Vec3(delta.x / distance, delta.y / distance, delta.z / distance) : Vec3(0, 1, 0);
+    Vec3 contactPoint = centerB + normal * (radiusB - penetrationDepth * 0.5f);
+    return CollisionInfo(contactPoint, normal, penetrationDepth);
+}
+
+float CollisionDetection::resolveAABBCollision(RigidBody& bodyA, RigidBody& bodyB, const CollisionInfo& collision) {
+    if (!collision.hasCollision) return 0.0f;
     
-    if (bodyA.isStatic && bodyB.isStatic) return;
+    if (bodyA.isStatic && bodyB.isStatic) return 0.0f;
     
     Vec3 separation = collision.normal * collision.penetrationDepth;
     
+    // The normal points from B towards A, so A moves along it and B against it.
     if (bodyA.isStatic) {
-        bodyB.position = bodyB.position + separation;
+        bodyB.position = bodyB.position - separation;
     } else if (bodyB.isStatic) {
-        bodyA.position = bodyA.position - separation;
+        bodyA.position = bodyA.position + separation;
     } else {
         float totalInverseMass = bodyA.inverseMass + bodyB.inverseMass;
         float ratioA = bodyA.inverseMass / totalInverseMass;
         float ratioB = bodyB.inverseMass / totalInverseMass;
         bodyA.position = bodyA.position + separation * ratioA;
         bodyB.position = bodyB.position - separation * ratioB;
-        Vec3 separation = collision.normal * collision.penetrationDepth;
-        std::cout << "DEBUG: separation vector=(" << separation.x << ", " << separation.y << ", " << separation.z << ")\n";
-        std::cout << "DEBUG: ratioA=" << ratioA << " ratioB=" << ratioB << "\n";     }
+    }
     
     Vec3 relativeVelocity = bodyA.velocity - bodyB.velocity;
     float velocityAlongNormal = relativeVelocity.dot(collision.normal);
     
-    if (velocityAlongNormal > 0) return;
+    if (velocityAlongNormal > 0) return 0.0f;
     
     float restitution = std::min(bodyA.restitution, bodyB.restitution);
     float impulseScalar = -(1 + restitution) * velocityAlongNormal;
@@ -104,6 +123,7 @@ void CollisionDetection::resolveAABBCollision(RigidBody& bodyA, RigidBody& bodyB
     if (!bodyB.isStatic) {
         bodyB.velocity = bodyB.velocity - impulse * bodyB.inverseMass;
     }
+    return impulseScalar;
 }
 
 Vec3 CollisionDetection::calculateSeparationVector(const AABB& aabbA, const AABB& aabbB) {
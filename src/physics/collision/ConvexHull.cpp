@@ -0,0 +1,45 @@
+#include "physics/collision/ConvexHull.h"
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+namespace physics::collision {
+
+using Vec3 = physics::math::Vec3;
+
+ConvexHull::ConvexHull(std::vector<Vec3> hullPoints) : points(std::move(hullPoints)) {
+  assert(!points.empty());
+  localMin = points[0];
+  localMax = points[0];
+  for (const Vec3& point : points) {
+    localMin = Vec3(std::min(localMin.x, point.x), std::min(localMin.y, point.y), std::min(localMin.z, point.z));
+    localMax = Vec3(std::max(localMax.x, point.x), std::max(localMax.y, point.y), std::max(localMax.z, point.z));
+  }
+}
+
+const Vec3& ConvexHull::support(const Vec3& direction) const {
+  size_t best = 0;
+  float bestDistance = points[0].dot(direction);
+  for (size_t i = 1; i < points.size(); i++) {
+    float distance = points[i].dot(direction);
+    if (distance > bestDistance) {
+      bestDistance = distance;
+      best = i;
+    }
+  }
+  return points[best];
+}
+
+const std::vector<Vec3>& ConvexHull::getPoints() const {
+  return points;
+}
+
+const Vec3& ConvexHull::getLocalMin() const {
+  return localMin;
+}
+
+const Vec3& ConvexHull::getLocalMax() const {
+  return localMax;
+}
+
+}
@@ -0,0 +1,537 @@
+#include "physics/collision/Gjk.h"
+#include <algorithm>
+#include <cmath>
+
+namespace physics::collision {
+
+using Vec3 = physics::math::Vec3;
+
+namespace {
+
+const int kMaxIterations = 64;
+const float kRelativeTolerance = 1e-6f;
+const float kOverlapDistanceSq = 1e-12f;
+const int kMaxPolytopeVertices = 64;
+const int kMaxPolytopeFaces = 128;
+const int kMaxHorizonEdges = 192;
+const int kMaxEpaIterations = 48;
+const float kEpaTolerance = 1e-4f;
+
+struct SimplexVertex {
+  Vec3 point;
+  Vec3 onA;
+  Vec3 onB;
+  Vec3 direction;
+};
+
+struct Simplex {
+  SimplexVertex vertices[4];
+  float weights[4];
+  int count = 0;
+};
+
+SimplexVertex supportVertex(const SupportMapping& a, const SupportMapping& b, const Vec3& direction) {
+  Vec3 onA = a.support(direction);
+  Vec3 onB = b.support(direction * -1.0f);
+  return {onA - onB, onA, onB, direction};
+}
+
+void keep(Simplex& simplex, int i0, float w0) {
+  simplex.vertices[0] = simplex.vertices[i0];
+  simplex.weights[0] = w0;
+  simplex.count = 1;
+}
+
+void keep(Simplex& simplex, int i0, float w0, int i1, float w1) {
+  SimplexVertex v0 = simplex.vertices[i0];
+  SimplexVertex v1 = simplex.vertices[i1];
+  simplex.vertices[0] = v0;
+  simplex.vertices[1] = v1;
+  simplex.weights[0] = w0;
+  simplex.weights[1] = w1;
+  simplex.count = 2;
+}
+
+Vec3 weightedPoint(const Simplex& simplex) {
+  Vec3 result(0, 0, 0);
+  for (int i = 0; i < simplex.count; i++) {
+    result += simplex.vertices[i].point * simplex.weights[i];
+  }
+  return result;
+}
+
+void closestOnSegment(Simplex& simplex) {
+  const Vec3& a = simplex.vertices[0].point;
+  Vec3 ab = simplex.vertices[1].point - a;
+  float lengthSq = ab.lengthSq();
+  float t = lengthSq > 0.0f ? -a.dot(ab) / lengthSq : 0.0f;
+  if (t <= 0.0f) {
+    keep(simplex, 0, 1.0f);
+  } else if (t >= 1.0f) {
+    keep(simplex, 1, 1.0f);
+  } else {
+    simplex.weights[0] = 1.0f - t;
+    simplex.weights[1] = t;
+  }
+}
+
+// Closest point of triangle 0-1-2 to the origin (Ericson, Real-Time
+// Collision Detection, 5.1.5), reducing the simplex to the feature it lies on.
+void closestOnTriangle(Simplex& simplex) {
+  const Vec3 a = simplex.vertices[0].point;
+  const Vec3 b = simplex.vertices[1].point;
+  const Vec3 c = simplex.vertices[2].point;
+  Vec3 ab = b - a;
+  Vec3 ac = c - a;
+
+  float d1 = -ab.dot(a);
+  float d2 = -ac.dot(a);
+  if (d1 <= 0.0f && d2 <= 0.0f) return keep(simplex, 0, 1.0f);
+
+  float d3 = -ab.dot(b);
+  float d4 = -ac.dot(b);
+  if (d3 >= 0.0f && d4 <= d3) return keep(simplex, 1, 1.0f);
+
+  float vc = d1 * d4 - d3 * d2;
+  if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+    float v = d1 / (d1 - d3);
+    return keep(simplex, 0, 1.0f - v, 1, v);
+  }
+
+  float d5 = -ab.dot(c);
+  float d6 = -ac.dot(c);
+  if (d6 >= 0.0f && d5 <= d6) return keep(simplex, 2, 1.0f);
+
+  float vb = d5 * d2 - d1 * d6;
+  if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+    float w = d2 / (d2 - d6);
+    return keep(simplex, 0, 1.0f - w, 2, w);
+  }
+
+  float va = d3 * d6 - d5 * d4;
+  if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) {
+    float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+    return keep(simplex, 1, 1.0f - w, 2, w);
+  }
+
+  float denominator = va + vb + vc;
+  if (denominator <= 0.0f) {
+    // Degenerate triangle: fall back to its longest edge
+    keep(simplex, 0, 1.0f, 1, 0.0f);
+    return closestOnSegment(simplex);
+  }
+  float v = vb / denominator;
+  float w = vc / denominator;
+  simplex.weights[0] = 1.0f - v - w;
+  simplex.weights[1] = v;
+  simplex.weights[2] = w;
+}
+
+// Returns true when the origin lies inside tetrahedron 0-1-2-3. Otherwise
+// reduces the simplex to the closest face feature.
+bool closestOnTetrahedron(Simplex& simplex) {
+  static const int kFaces[4][4] = {{0, 1, 2, 3}, {0, 3, 1, 2}, {0, 2, 3, 1}, {1, 3, 2, 0}};
+  const SimplexVertex* v = simplex.vertices;
+  float volume = (v[1].point - v[0].point).cross(v[2].point - v[0].point).dot(v[3].point - v[0].point);
+  bool degenerate = std::abs(volume) < 1e-12f;
+
+  bool outsideAny = false;
+  float bestDistanceSq = 0.0f;
+  Simplex best;
+  for (const auto& face : kFaces) {
+    const Vec3& a = v[face[0]].point;
+    Vec3 normal = (v[face[1]].point - a).cross(v[face[2]].point - a);
+    float originSide = -normal.dot(a);
+    float oppositeSide = normal.dot(v[face[3]].point - a);
+    if (!degenerate && originSide * oppositeSide >= 0.0f) continue;
+
+    Simplex candidate;
+    candidate.vertices[0] = v[face[0]];
+    candidate.vertices[1] = v[face[1]];
+    candidate.vertices[2] = v[face[2]];
+    candidate.count = 3;
+    closestOnTriangle(candidate);
+    float distanceSq = weightedPoint(candidate).lengthSq();
+    if (!outsideAny || distanceSq < bestDistanceSq) {
+      outsideAny = true;
+      bestDistanceSq = distanceSq;
+      best = candidate;
+    }
+  }
+  if (!outsideAny) return true;
+  simplex = best;
+  return false;
+}
+
+// Updates the simplex to the feature closest to the origin. Returns true
+// if the origin is enclosed.
+bool reduce(Simplex& simplex) {
+  switch (simplex.count) {
+    case 1:
+      simplex.weights[0] = 1.0f;
+      return false;
+    case 2:
+      closestOnSegment(simplex);
+      return false;
+    case 3:
+      closestOnTriangle(simplex);
+      return false;
+    default:
+      return closestOnTetrahedron(simplex);
+  }
+}
+
+bool containsPoint(const Simplex& simplex, const Vec3& point) {
+  for (int i = 0; i < simplex.count; i++) {
+    if ((simplex.vertices[i].point - point).lengthSq() <= 1e-12f) return true;
+  }
+  return false;
+}
+
+GjkResult runGjk(const SupportMapping& a, const SupportMapping& b, GjkCache* cache, Simplex& simplex) {
+  GjkResult result{};
+  simplex.count = 0;
+  if (cache && cache->count > 0) {
+    for (uint32_t i = 0; i < cache->count && i < 4; i++) {
+      SimplexVertex vertex = supportVertex(a, b, cache->directions[i]);
+      if (!containsPoint(simplex, vertex.point)) {
+        simplex.vertices[simplex.count++] = vertex;
+      }
+    }
+  } else {
+    simplex.vertices[simplex.count++] = supportVertex(a, b, Vec3(1, 0, 0));
+  }
+
+  bool enclosed = reduce(simplex);
+  Vec3 closest = weightedPoint(simplex);
+  while (!enclosed && result.iterations < static_cast<uint32_t>(kMaxIterations)) {
+    result.iterations++;
+    float distanceSq = closest.lengthSq();
+    if (distanceSq <= kOverlapDistanceSq) {
+      enclosed = true;
+      break;
+    }
+
+    SimplexVertex vertex = supportVertex(a, b, closest * -1.0f);
+    if (distanceSq - closest.dot(vertex.point) <= kRelativeTolerance * distanceSq ||
+        containsPoint(simplex, vertex.point)) {
+      break;
+    }
+    simplex.vertices[simplex.count++] = vertex;
+    enclosed = reduce(simplex);
+    closest = weightedPoint(simplex);
+  }
+  if (result.iterations == 0) result.iterations = 1;
+
+  if (cache) {
+    cache->count = static_cast<uint32_t>(simplex.count);
+    for (int i = 0; i < simplex.count; i++) {
+      cache->directions[i] = simplex.vertices[i].direction;
+    }
+  }
+
+  result.overlapping = enclosed;
+  if (!enclosed) {
+    result.distance = closest.length();
+    result.axis = result.distance > 0.0f ? closest * (1.0f / result.distance) : Vec3(0, 1, 0);
+    result.pointA = Vec3(0, 0, 0);
+    result.pointB = Vec3(0, 0, 0);
+    for (int i = 0; i < simplex.count; i++) {
+      result.pointA += simplex.vertices[i].onA * simplex.weights[i];
+      result.pointB += simplex.vertices[i].onB * simplex.weights[i];
+    }
+  }
+  return result;
+}
+
+struct PolytopeFace {
+  int a, b, c;
+  Vec3 normal;
+  float distance;
+};
+
+bool makeFace(const SimplexVertex* vertices, int a, int b, int c, PolytopeFace& face) {
+  Vec3 normal = (vertices[b].point - vertices[a].point).cross(vertices[c].point - vertices[a].point);
+  float length = normal.length();
+  if (length < 1e-12f) return false;
+  face.a = a;
+  face.b = b;
+  face.c = c;
+  face.normal = normal * (1.0f / length);
+  face.distance = face.normal.dot(vertices[a].point);
+  return true;
+}
+
+// Grows a point, segment or triangle simplex into a tetrahedron that still
+// lies in the Minkowski difference. Fails for flat (touching) contacts.
+bool expandToTetrahedron(const SupportMapping& a, const SupportMapping& b, Simplex& simplex) {
+  static const Vec3 kAxes[6] = {Vec3(1, 0, 0), Vec3(-1, 0, 0), Vec3(0, 1, 0), Vec3(0, -1, 0), Vec3(0, 0, 1), Vec3(0, 0, -1)};
+  if (simplex.count == 1) {
+    for (const Vec3& axis : kAxes) {
+      SimplexVertex vertex = supportVertex(a, b, axis);
+      if ((vertex.point - simplex.vertices[0].point).lengthSq() > 1e-10f) {
+        simplex.vertices[simplex.count++] = vertex;
+        break;
+      }
+    }
+    if (simplex.count < 2) return false;
+  }
+  if (simplex.count == 2) {
+    Vec3 line = simplex.vertices[1].point - simplex.vertices[0].point;
+    for (const Vec3& axis : kAxes) {
+      Vec3 direction = line.cross(axis);
+      if (direction.lengthSq() < 1e-12f) continue;
+      SimplexVertex vertex = supportVertex(a, b, direction);
+      if (line.cross(vertex.point - simplex.vertices[0].point).lengthSq() > 1e-10f) {
+        simplex.vertices[simplex.count++] = vertex;
+        break;
+      }
+    }
+    if (simplex.count < 3) return false;
+  }
+  if (simplex.count == 3) {
+    const Vec3& origin = simplex.vertices[0].point;
+    Vec3 normal = (simplex.vertices[1].point - origin).cross(simplex.vertices[2].point - origin);
+    for (float side : {1.0f, -1.0f}) {
+      SimplexVertex vertex = supportVertex(a, b, normal * side);
+      if (std::abs(normal.dot(vertex.point - origin)) > 1e-10f) {
+        simplex.vertices[simplex.count++] = vertex;
+        break;
+      }
+    }
+    if (simplex.count < 4) return false;
+  }
+  return true;
+}
+
+CollisionInfo runEpa(const SupportMapping& a, const SupportMapping& b, Simplex& simplex) {
+  if (!expandToTetrahedron(a, b, simplex)) return CollisionInfo();
+
+  SimplexVertex vertices[kMaxPolytopeVertices];
+  PolytopeFace faces[kMaxPolytopeFaces];
+  int vertexCount = 4;
+  int faceCount = 0;
+  for (int i = 0; i < 4; i++) {
+    vertices[i] = simplex.vertices[i];
+  }
+
+  static const int kTetraFaces[4][4] = {{0, 1, 2, 3}, {0, 3, 1, 2}, {0, 2, 3, 1}, {1, 3, 2, 0}};
+  for (const auto& f : kTetraFaces) {
+    PolytopeFace face;
+    if (!makeFace(vertices, f[0], f[1], f[2], face)) return CollisionInfo();
+    // Orient outwards, away from the fourth vertex
+    if (face.normal.dot(vertices[f[3]].point - vertices[f[0]].point) > 0.0f) {
+      makeFace(vertices, f[0], f[2], f[1], face);
+    }
+    faces[faceCount++] = face;
+  }
+
+  int closest = 0;
+  for (int iteration = 0; iteration < kMaxEpaIterations; iteration++) {
+    closest = 0;
+    for (int i = 1; i < faceCount; i++) {
+      if (faces[i].distance < faces[closest].distance) closest = i;
+    }
+    const PolytopeFace& face = faces[closest];
+    SimplexVertex vertex = supportVertex(a, b, face.normal);
+    if (vertex.point.dot(face.normal) - face.distance < kEpaTolerance || vertexCount == kMaxPolytopeVertices) {
+      break;
+    }
+
+    int newIndex = vertexCount;
+    vertices[vertexCount++] = vertex;
+
+    // Remove every face the new vertex can see and stitch the horizon to it
+    int edges[kMaxHorizonEdges][2];
+    int edgeCount = 0;
+    for (int i = 0; i < faceCount;) {
+      const PolytopeFace& candidate = faces[i];
+      if (candidate.normal.dot(vertex.point - vertices[candidate.a].point) <= 0.0f) {
+        i++;
+        continue;
+      }
+      const int faceEdges[3][2] = {{candidate.a, candidate.b}, {candidate.b, candidate.c}, {candidate.c, candidate.a}};
+      for (const auto& edge : faceEdges) {
+        bool shared = false;
+        for (int e = 0; e < edgeCount; e++) {
+          if (edges[e][0] == edge[1] && edges[e][1] == edge[0]) {
+            edges[e][0] = edges[edgeCount - 1][0];
+            edges[e][1] = edges[edgeCount - 1][1];
+            edgeCount--;
+            shared = true;
+            break;
+          }
+        }
+        if (!shared && edgeCount < kMaxHorizonEdges) {
+          edges[edgeCount][0] = edge[0];
+          edges[edgeCount][1] = edge[1];
+          edgeCount++;
+        }
+      }
+      faces[i] = faces[--faceCount];
+    }
+
+    for (int e = 0; e < edgeCount && faceCount < kMaxPolytopeFaces; e++) {
+      PolytopeFace newFace;
+      if (makeFace(vertices, edges[e][0], edges[e][1], newIndex, newFace)) {
+        faces[faceCount++] = newFace;
+      }
+    }
+    if (faceCount == 0) return CollisionInfo();
+  }
+
+  const PolytopeFace& face = faces[closest];
+  if (face.distance <= 0.0f) return CollisionInfo();
+
+  // Barycentric coordinates of the origin's projection on the closest face
+  // give the witness points on each shape.
+  Vec3 projection = face.normal * face.distance;
+  const SimplexVertex& va = vertices[face.a];
+  const SimplexVertex& vb = vertices[face.b];
+  const SimplexVertex& vc = vertices[face.c];
+  Vec3 v0 = vb.point - va.point;
+  Vec3 v1 = vc.point - va.point;
+  Vec3 v2 = projection - va.point;
+  float d00 = v0.dot(v0);
+  float d01 = v0.dot(v1);
+  float d11 = v1.dot(v1);
+  float d20 = v2.dot(v0);
+  float d21 = v2.dot(v1);
+  float denominator = d00 * d11 - d01 * d01;
+  float v = denominator != 0.0f ? (d11 * d20 - d01 * d21) / denominator : 0.0f;
+  float w = denominator != 0.0f ? (d00 * d21 - d01 * d20) / denominator : 0.0f;
+  float u = 1.0f - v - w;
+  Vec3 pointA = va.onA * u + vb.onA * v + vc.onA * w;
+  Vec3 pointB = va.onB * u + vb.onB * v + vc.onB * w;
+
+  return CollisionInfo((pointA + pointB) * 0.5f, face.normal * -1.0f, face.distance);
+}
+
+}
+
+GjkResult Gjk::query(const SupportMapping& a, const SupportMapping& b, GjkCache* cache) {
+  Simplex simplex;
+  return runGjk(a, b, cache, simplex);
+}
+
+CollisionInfo Gjk::collide(const SupportMapping& a, const SupportMapping& b, GjkCache* cache, uint32_t* iterations) {
+  Simplex simplex;
+  GjkResult result = runGjk(a, b, cache, simplex);
+  if (iterations) *iterations = result.iterations;
+  if (!result.overlapping) return CollisionInfo();
+  return runEpa(a, b, simplex);
+}
+
+namespace {
+// Body ids are below UINT32_MAX, so no pair key has every bit set.
+const uint64_t kEmptyKey = ~0ull;
+const size_t kMinSlots = 16;
+
+size_t slotOf(uint64_t key, size_t mask) {
+  uint64_t h = key * 0xC2B2AE3D27D4EB4Full;
+  return static_cast<size_t>(h ^ (h >> 32)) & mask;
+}
+}
+
+GjkPairCache::GjkPairCache(uint32_t maxIdleFrames) : frame(0), maxIdleFrames(maxIdleFrames) {}
+
+GjkPairCache::Shard& GjkPairCache::shardFor(uint64_t key) {
+  return shards[(key * 0x9E3779B97F4A7C15ull) >> 60];
+}
+
+GjkCache* GjkPairCache::find(Shard& shard, uint64_t key) {
+  if (shard.slots.empty()) return nullptr;
+  size_t mask = shard.slots.size() - 1;
+  for (size_t i = slotOf(key, mask);; i = (i + 1) & mask) {
+    Entry& entry = shard.slots[i];
+    if (entry.key == key) return &entry.cache;
+    if (entry.key == kEmptyKey) return nullptr;
+  }
+}
+
+GjkCache& GjkPairCache::insert(Shard& shard, uint64_t key) {
+  if ((shard.count + 1) * 2 > shard.slots.size()) {
+    rehash(shard, std::max(kMinSlots, shard.slots.size() * 2));
+  }
+  size_t mask = shard.slots.size() - 1;
+  size_t i = slotOf(key, mask);
+  while (shard.slots[i].key != kEmptyKey) {
+    i = (i + 1) & mask;
+  }
+  shard.slots[i].key = key;
+  shard.count++;
+  return shard.slots[i].cache;
+}
+
+void GjkPairCache::rehash(Shard& shard, size_t slotCount) {
+  shard.scratch.clear();
+  for (const Entry& entry : shard.slots) {
+    if (entry.key != kEmptyKey) shard.scratch.push_back(entry);
+  }
+  shard.slots.assign(slotCount, Entry{kEmptyKey, GjkCache()});
+  shard.count = 0;
+  for (const Entry& entry : shard.scratch) {
+    insert(shard, entry.key) = entry.cache;
+  }
+}
+
+void GjkPairCache::load(uint32_t idA, uint32_t idB, GjkCache& cache) {
+  uint64_t key = (static_cast<uint64_t>(idA) << 32) | idB;
+  Shard& shard = shardFor(key);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  GjkCache* entry = find(shard, key);
+  if (!entry) {
+    cache.count = 0;
+    return;
+  }
+  cache = *entry;
+}
+
+void GjkPairCache::store(uint32_t idA, uint32_t idB, const GjkCache& cache) {
+  uint64_t key = (static_cast<uint64_t>(idA) << 32) | idB;
+  Shard& shard = shardFor(key);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  GjkCache* entry = find(shard, key);
+  if (!entry) entry = &insert(shard, key);
+  *entry = cache;
+  entry->lastFrame = frame;
+}
+
+// Idle entries are dropped by rebuilding the table at its current size from
+// the survivors; removing them in place would break probe chains.
+void GjkPairCache::beginFrame() {
+  frame++;
+  if (maxIdleFrames == 0 || frame % maxIdleFrames != 0) return;
+  for (Shard& shard : shards) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (shard.count == 0) continue;
+    shard.scratch.clear();
+    for (const Entry& entry : shard.slots) {
+      if (entry.key != kEmptyKey && frame - entry.cache.lastFrame <= maxIdleFrames) shard.scratch.push_back(entry);
+    }
+    std::fill(shard.slots.begin(), shard.slots.end(), Entry{kEmptyKey, GjkCache()});
+    shard.count = 0;
+    for (const Entry& entry : shard.scratch) {
+      insert(shard, entry.key) = entry.cache;
+    }
+  }
+}
+
+void GjkPairCache::clear() {
+  for (Shard& shard : shards) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    std::fill(shard.slots.begin(), shard.slots.end(), Entry{kEmptyKey, GjkCache()});
+    shard.count = 0;
+  }
+}
+
+size_t GjkPairCache::size() {
+  size_t total = 0;
+  for (Shard& shard : shards) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    total += shard.count;
+  }
+  return total;
+}
+
+}
@@ -0,0 +1,59 @@
+#include "physics/collision/Shape.h"
+#include <cmath>
+
+namespace physics::collision {
+
+using Vec3 = physics::math::Vec3;
+
+namespace {
+// Any unit vector not parallel to axis, crossed into a perpendicular one.
+Vec3 perpendicular(const Vec3& axis) {
+  Vec3 helper = std::abs(axis.x) < 0.9f ? Vec3(1, 0, 0) : Vec3(0, 0, 1);
+  return axis.cross(helper).normalized();
+}
+}
+
+Shape::Shape()
+  : type(ShapeType::Box), radius(0.0f), halfHeight(0.0f), halfExtents(0, 0, 0),
+    axes{Vec3(1, 0, 0), Vec3(0, 1, 0), Vec3(0, 0, 1)}, hull(nullptr) {}
+
+Shape Shape::box() {
+  return Shape();
+}
+
+Shape Shape::sphere(float radius) {
+  Shape shape;
+  shape.type = ShapeType::Sphere;
+  shape.radius = radius;
+  return shape;
+}
+
+Shape Shape::capsule(float radius, float halfHeight, const Vec3& axis) {
+  Shape shape;
+  shape.type = ShapeType::Capsule;
+  shape.radius = radius;
+  shape.halfHeight = halfHeight;
+  shape.axes[1] = axis.normalized();
+  shape.axes[0] = perpendicular(shape.axes[1]);
+  shape.axes[2] = shape.axes[0].cross(shape.axes[1]);
+  return shape;
+}
+
+Shape Shape::orientedBox(const Vec3& halfExtents, const Vec3& axisX, const Vec3& axisY) {
+  Shape shape;
+  shape.type = ShapeType::OrientedBox;
+  shape.halfExtents = halfExtents;
+  shape.axes[0] = axisX;
+  shape.axes[1] = axisY;
+  shape.axes[2] = axisX.cross(axisY);
+  return shape;
+}
+
+Shape Shape::convexHull(const ConvexHull& hull) {
+  Shape shape;
+  shape.type = ShapeType::ConvexHull;
+  shape.hull = &hull;
+  return shape;
+}
+
+}
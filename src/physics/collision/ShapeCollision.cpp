@@ -0,0 +1,404 @@
+#include "physics/collision/ShapeCollision.h"
+#include "physics/collision/BatchNarrowphase.h"
+#include "physics/collision/ConvexHull.h"
+#include <algorithm>
+#include <cmath>
+
+namespace physics::collision {
+
+using Vec3 = physics::math::Vec3;
+
+namespace {
+
+using PairTest = bool (*)(const ShapeView& view, uint32_t a, uint32_t b, CollisionInfo& info);
+
+const size_t kPairTypeCount = ShapeTypeCount * ShapeTypeCount;
+
+// Box and oriented box in one form: centre, unit axes and half extents.
+struct BoxFrame {
+  Vec3 center;
+  Vec3 axes[3];
+  float half[3];
+};
+
+BoxFrame boxFrame(const ShapeView& view, uint32_t index) {
+  BoxFrame frame;
+  const Shape& shape = view.shapes[index];
+  if (shape.type == ShapeType::OrientedBox) {
+    frame.center = view.positions[index];
+    frame.axes[0] = shape.axes[0];
+    frame.axes[1] = shape.axes[1];
+    frame.axes[2] = shape.axes[2];
+    frame.half[0] = shape.halfExtents.x;
+    frame.half[1] = shape.halfExtents.y;
+    frame.half[2] = shape.halfExtents.z;
+  } else {
+    const AABB& bounds = view.bounds[index];
+    Vec3 size = bounds.getSize();
+    frame.center = bounds.getCenter();
+    frame.axes[0] = Vec3(1, 0, 0);
+    frame.axes[1] = Vec3(0, 1, 0);
+    frame.axes[2] = Vec3(0, 0, 1);
+    frame.half[0] = size.x * 0.5f;
+    frame.half[1] = size.y * 0.5f;
+    frame.half[2] = size.z * 0.5f;
+  }
+  return frame;
+}
+
+Vec3 toLocal(const BoxFrame& frame, const Vec3& point) {
+  Vec3 offset = point - frame.center;
+  return Vec3(offset.dot(frame.axes[0]), offset.dot(frame.axes[1]), offset.dot(frame.axes[2]));
+}
+
+Vec3 rotateToWorld(const BoxFrame& frame, const Vec3& local) {
+  return frame.axes[0] * local.x + frame.axes[1] * local.y + frame.axes[2] * local.z;
+}
+
+Vec3 toWorld(const BoxFrame& frame, const Vec3& local) {
+  return frame.center + rotateToWorld(frame, local);
+}
+
+float component(const Vec3& v, int axis) {
+  return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+}
+
+Vec3 clampToBox(const BoxFrame& frame, const Vec3& local) {
+  return Vec3(std::clamp(local.x, -frame.half[0], frame.half[0]),
+              std::clamp(local.y, -frame.half[1], frame.half[1]),
+              std::clamp(local.z, -frame.half[2], frame.half[2]));
+}
+
+// Box A against sphere B.
+bool boxSphere(const BoxFrame& box, const Vec3& center, float radius, CollisionInfo& info) {
+  Vec3 local = toLocal(box, center);
+  Vec3 closest = clampToBox(box, local);
+  Vec3 toBox = closest - local;
+  float distanceSq = toBox.lengthSq();
+
+  if (distanceSq > 0.0f) {
+    if (distanceSq >= radius * radius) return false;
+    float distance = std::sqrt(distanceSq);
+    Vec3 localNormal(toBox.x / distance, toBox.y / distance, toBox.z / distance);
+    info = CollisionInfo(toWorld(box, closest), rotateToWorld(box, localNormal), radius - distance);
+    return true;
+  }
+
+  // Centre inside the box: push the sphere out through the nearest face.
+  int axis = 0;
+  float faceDistance = box.half[0] - std::abs(local.x);
+  for (int i = 1; i < 3; i++) {
+    float d = box.half[i] - std::abs(component(local, i));
+    if (d < faceDistance) {
+      faceDistance = d;
+      axis = i;
+    }
+  }
+  float side = component(local, axis) >= 0.0f ? 1.0f : -1.0f;
+  Vec3 facePoint = local;
+  if (axis == 0) facePoint.x = side * box.half[0];
+  if (axis == 1) facePoint.y = side * box.half[1];
+  if (axis == 2) facePoint.z = side * box.half[2];
+  info = CollisionInfo(toWorld(box, facePoint), box.axes[axis] * -side, radius + faceDistance);
+  return true;
+}
+
+void capsuleSegment(const ShapeView& view, uint32_t index, Vec3& start, Vec3& end) {
+  const Shape& shape = view.shapes[index];
+  Vec3 offset = shape.axes[1] * shape.halfHeight;
+  start = view.positions[index] - offset;
+  end = view.positions[index] + offset;
+}
+
+float closestSegmentParameter(const Vec3& start, const Vec3& end, const Vec3& point) {
+  Vec3 direction = end - start;
+  float lengthSq = direction.lengthSq();
+  if (lengthSq <= 0.0f) return 0.0f;
+  return std::clamp((point - start).dot(direction) / lengthSq, 0.0f, 1.0f);
+}
+
+Vec3 pointOnSegment(const Vec3& start, const Vec3& end, float t) {
+  return start + (end - start) * t;
+}
+
+// Closest points between segments p1-q1 and p2-q2 (Ericson, Real-Time
+// Collision Detection, 5.1.9).
+void closestSegmentPoints(const Vec3& p1, const Vec3& q1, const Vec3& p2, const Vec3& q2, Vec3& c1, Vec3& c2) {
+  Vec3 d1 = q1 - p1;
+  Vec3 d2 = q2 - p2;
+  Vec3 r = p1 - p2;
+  float a = d1.lengthSq();
+  float e = d2.lengthSq();
+  float f = d2.dot(r);
+  float s = 0.0f;
+  float t = 0.0f;
+
+  if (a <= 1e-12f && e <= 1e-12f) {
+    c1 = p1;
+    c2 = p2;
+    return;
+  }
+  if (a <= 1e-12f) {
+    t = std::clamp(f / e, 0.0f, 1.0f);
+  } else {
+    float c = d1.dot(r);
+    if (e <= 1e-12f) {
+      s = std::clamp(-c / a, 0.0f, 1.0f);
+    } else {
+      float b = d1.dot(d2);
+      float denominator = a * e - b * b;
+      s = denominator > 0.0f ? std::clamp((b * f - c * e) / denominator, 0.0f, 1.0f) : 0.0f;
+      t = (b * s + f) / e;
+      if (t < 0.0f) {
+        t = 0.0f;
+        s = std::clamp(-c / a, 0.0f, 1.0f);
+      } else if (t > 1.0f) {
+        t = 1.0f;
+        s = std::clamp((b - c) / a, 0.0f, 1.0f);
+      }
+    }
+  }
+  c1 = p1 + d1 * s;
+  c2 = p2 + d2 * t;
+}
+
+bool boxSpherePair(const ShapeView& view, uint32_t a, uint32_t b, CollisionInfo& info) {
+  return boxSphere(boxFrame(view, a), view.positions[b], view.shapes[b].radius, info);
+}
+
+bool sphereCapsulePair(const ShapeView& view, uint32_t a, uint32_t b, CollisionInfo& info) {
+  Vec3 start, end;
+  capsuleSegment(view, b, start, end);
+  Vec3 closest = pointOnSegment(start, end, closestSegmentParameter(start, end, view.positions[a]));
+  info = CollisionDetection::getSphereCollisionInfo(view.positions[a], view.shapes[a].radius, closest, view.shapes[b].radius);
+  return info.hasCollision;
+}
+
+bool capsuleCapsulePair(const ShapeView& view, uint32_t a, uint32_t b, CollisionInfo& info) {
+  Vec3 startA, endA, startB, endB, closestA, closestB;
+  capsuleSegment(view, a, startA, endA);
+  capsuleSegment(view, b, startB, endB);
+  closestSegmentPoints(startA, endA, startB, endB, closestA, closestB);
+  info = CollisionDetection::getSphereCollisionInfo(closestA, view.shapes[a].radius, closestB, view.shapes[b].radius);
+  return info.hasCollision;
+}
+
+// Finds the capsule point nearest the box by alternating closest-point
+// projections between the segment and the box, then tests a sphere there.
+// A few rounds converge for all but near-parallel edge cases.
+bool boxCapsulePair(const ShapeView& view, uint32_t a, uint32_t b, CollisionInfo& info) {
+  BoxFrame box = boxFrame(view, a);
+  Vec3 start, end;
+  capsuleSegment(view, b, start, end);
+  Vec3 localStart = toLocal(box, start);
+  Vec3 localEnd = toLocal(box, end);
+
+  float t = closestSegmentParameter(localStart, localEnd, Vec3(0, 0, 0));
+  for (int iteration = 0; iteration < 4; iteration++) {
+    Vec3 onBox = clampToBox(box, pointOnSegment(localStart, localEnd, t));
+    t = closestSegmentParameter(localStart, localEnd, onBox);
+  }
+  return boxSphere(box, pointOnSegment(start, end, t), view.shapes[b].radius, info);
+}
+
+// Separating-axis test between two boxes, any orientation: 3 + 3 face axes
+// and 9 edge-edge axes. The axis of least overlap becomes the normal.
+bool orientedBoxPair(const ShapeView& view, uint32_t a, uint32_t b, CollisionInfo& info) {
+  BoxFrame boxA = boxFrame(view, a);
+  BoxFrame boxB = boxFrame(view, b);
+  Vec3 offset = boxA.center - boxB.center;
+
+  float bestOverlap = 0.0f;
+  Vec3 bestAxis;
+  bool found = false;
+  auto testAxis = [&](Vec3 axis) {
+    float lengthSq = axis.lengthSq();
+    if (lengthSq < 1e-8f) return true;
+    axis = axis * (1.0f / std::sqrt(lengthSq));
+    float reachA = 0.0f;
+    float reachB = 0.0f;
+    for (int i = 0; i < 3; i++) {
+      reachA += std::abs(boxA.axes[i].dot(axis)) * boxA.half[i];
+      reachB += std::abs(boxB.axes[i].dot(axis)) * boxB.half[i];
+    }
+    float distance = offset.dot(axis);
+    float overlap = reachA + reachB - std::abs(distance);
+    if (overlap <= 0.0f) return false;
+    if (!found || overlap < bestOverlap) {
+      found = true;
+      bestOverlap = overlap;
+      bestAxis = distance >= 0.0f ? axis : axis * -1.0f;
+    }
+    return true;
+  };
+
+  for (int i = 0; i < 3; i++) {
+    if (!testAxis(boxA.axes[i]) || !testAxis(boxB.axes[i])) return false;
+  }
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 3; j++) {
+      if (!testAxis(boxA.axes[i].cross(boxB.axes[j]))) return false;
+    }
+  }
+  info = CollisionInfo((view.positions[a] + view.positions[b]) * 0.5f, bestAxis, bestOverlap);
+  return true;
+}
+
+struct SupportContext {
+  const ShapeView* view;
+  uint32_t index;
+};
+
+// Support mapping for every shape type, so any shape can meet a hull in GJK.
+Vec3 shapeSupport(const void* context, const Vec3& direction) {
+  const SupportContext& body = *static_cast<const SupportContext*>(context);
+  const ShapeView& view = *body.view;
+  const Shape& shape = view.shapes[body.index];
+  const Vec3& position = view.positions[body.index];
+  switch (shape.type) {
+    case ShapeType::Sphere:
+    case ShapeType::Capsule: {
+      Vec3 center = position;
+      if (shape.type == ShapeType::Capsule) {
+        center += shape.axes[1] * (direction.dot(shape.axes[1]) >= 0.0f ? shape.halfHeight : -shape.halfHeight);
+      }
+      float length = direction.length();
+      return length > 0.0f ? center + direction * (shape.radius / length) : center;
+    }
+    case ShapeType::ConvexHull:
+      return position + shape.hull->support(direction);
+    case ShapeType::Box:
+    case ShapeType::OrientedBox:
+      break;
+  }
+  BoxFrame box = boxFrame(view, body.index);
+  Vec3 corner = box.center;
+  for (int i = 0; i < 3; i++) {
+    corner += box.axes[i] * (direction.dot(box.axes[i]) >= 0.0f ? box.half[i] : -box.half[i]);
+  }
+  return corner;
+}
+
+bool convexPair(const ShapeView& view, uint32_t a, uint32_t b, CollisionInfo& info) {
+  SupportContext contextA{&view, a};
+  SupportContext contextB{&view, b};
+  SupportMapping supportA{&shapeSupport, &contextA};
+  SupportMapping supportB{&shapeSupport, &contextB};
+
+  if (!view.gjkCache || !view.ids) {
+    info = Gjk::collide(supportA, supportB);
+    return info.hasCollision;
+  }
+  GjkCache cache;
+  view.gjkCache->load(view.ids[a], view.ids[b], cache);
+  info = Gjk::collide(supportA, supportB, &cache);
+  view.gjkCache->store(view.ids[a], view.ids[b], cache);
+  return info.hasCollision;
+}
+
+// Runs Test with the bodies swapped, for the table entries whose natural
+// order is the other way round.
+template <PairTest Test>
+bool flipped(const ShapeView& view, uint32_t a, uint32_t b, CollisionInfo& info) {
+  if (!Test(view, b, a, info)) return false;
+  info.normal = info.normal * -1.0f;
+  return true;
+}
+
+template <PairTest Test>
+size_t testPairs(const ShapeView& view, std::span<const BodyPair> pairs, Contact* contacts) {
+  size_t written = 0;
+  CollisionInfo info;
+  for (const BodyPair& pair : pairs) {
+    if (Test(view, pair.a, pair.b, info)) {
+      contacts[written++] = {pair.a, pair.b, info};
+    }
+  }
+  return written;
+}
+
+size_t boxBoxBatch(const ShapeView& view, std::span<const BodyPair> pairs, Contact* contacts) {
+  return BatchNarrowphase::findContacts(view.bounds, view.positions, pairs, contacts);
+}
+
+size_t sphereSphereBatch(const ShapeView& view, std::span<const BodyPair> pairs, Contact* contacts) {
+  return BatchNarrowphase::findSphereContacts(view.positions, view.shapes, pairs, contacts);
+}
+
+// Indexed [typeA * ShapeTypeCount + typeB] in ShapeType order: Box, Sphere,
+// Capsule, OrientedBox, ConvexHull.
+const PairBatchFn kPairFunctions[kPairTypeCount] = {
+  &boxBoxBatch,                          &testPairs<boxSpherePair>,
+  &testPairs<boxCapsulePair>,            &testPairs<orientedBoxPair>,
+  &testPairs<convexPair>,
+
+  &testPairs<flipped<boxSpherePair>>,    &sphereSphereBatch,
+  &testPairs<sphereCapsulePair>,         &testPairs<flipped<boxSpherePair>>,
+  &testPairs<convexPair>,
+
+  &testPairs<flipped<boxCapsulePair>>,   &testPairs<flipped<sphereCapsulePair>>,
+  &testPairs<capsuleCapsulePair>,        &testPairs<flipped<boxCapsulePair>>,
+  &testPairs<convexPair>,
+
+  &testPairs<orientedBoxPair>,           &testPairs<boxSpherePair>,
+  &testPairs<boxCapsulePair>,            &testPairs<orientedBoxPair>,
+  &testPairs<convexPair>,
+
+  &testPairs<convexPair>,                &testPairs<convexPair>,
+  &testPairs<convexPair>,                &testPairs<convexPair>,
+  &testPairs<convexPair>,
+};
+
+size_t pairTypeIndex(const ShapeView& view, const BodyPair& pair) {
+  return static_cast<size_t>(view.shapes[pair.a].type) * ShapeTypeCount + static_cast<size_t>(view.shapes[pair.b].type);
+}
+
+}
+
+PairBatchFn ShapeCollision::getPairFunction(ShapeType typeA, ShapeType typeB) {
+  return kPairFunctions[static_cast<size_t>(typeA) * ShapeTypeCount + static_cast<size_t>(typeB)];
+}
+
+size_t ShapeCollision::findContacts(const ShapeView& view, std::span<const BodyPair> pairs,
+                                    std::vector<BodyPair>& scratch, Contact* contacts) {
+  if (pairs.empty()) return 0;
+
+  uint32_t offsets[kPairTypeCount + 1] = {};
+  for (const BodyPair& pair : pairs) {
+    offsets[pairTypeIndex(view, pair) + 1]++;
+  }
+  // Single-type batches, the common case, skip the scatter.
+  size_t firstType = pairTypeIndex(view, pairs[0]);
+  if (offsets[firstType + 1] == pairs.size()) {
+    return kPairFunctions[firstType](view, pairs, contacts);
+  }
+
+  for (size_t i = 0; i < kPairTypeCount; i++) {
+    offsets[i + 1] += offsets[i];
+  }
+  uint32_t cursor[kPairTypeCount];
+  std::copy(offsets, offsets + kPairTypeCount, cursor);
+  scratch.resize(pairs.size());
+  for (const BodyPair& pair : pairs) {
+    scratch[cursor[pairTypeIndex(view, pair)]++] = pair;
+  }
+
+  size_t written = 0;
+  for (size_t i = 0; i < kPairTypeCount; i++) {
+    if (offsets[i + 1] == offsets[i]) continue;
+    std::span<const BodyPair> batch(scratch.data() + offsets[i], offsets[i + 1] - offsets[i]);
+    written += kPairFunctions[i](view, batch, contacts + written);
+  }
+  return written;
+}
+
+CollisionInfo ShapeCollision::collide(const ShapeView& view, uint32_t indexA, uint32_t indexB) {
+  BodyPair pair{indexA, indexB};
+  Contact contact;
+  if (kPairFunctions[pairTypeIndex(view, pair)](view, std::span<const BodyPair>(&pair, 1), &contact) == 0) {
+    return CollisionInfo();
+  }
+  return contact.info;
+}
+
+}
@@ -0,0 +1,322 @@
+#include "physics/collision/StaticBvh.h"
+#include <algorithm>
+#include <cmath>
+
+namespace physics::collision {
+
+using Vec3 = physics::math::Vec3;
+using ThreadPool = physics::parallel::ThreadPool;
+
+namespace {
+const int kBinCount = 16;
+const uint32_t kMaxLeafSize = 4;
+// Subtrees at most this large are built by parallel tasks.
+const uint32_t kSubtreePrimitives = 4096;
+// Below this depth splits are forced to the median, which bounds the depth
+// by kMaxSahDepth + log2(count) and keeps the query stack small.
+const size_t kMaxSahDepth = 24;
+// Cost of visiting a node relative to testing one primitive.
+const float kTraversalCost = 1.0f;
+const uint16_t kQuantizedMax = 65535;
+
+float axisValue(const Vec3& v, int axis) {
+  return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+}
+
+float halfArea(const AABB& box) {
+  Vec3 d = box.max - box.min;
+  return d.x * d.y + d.y * d.z + d.z * d.x;
+}
+
+void setEmptyChild(BvhNode& node, int c) {
+  for (int a = 0; a < 3; a++) {
+    node.childMin[c][a] = kQuantizedMax;
+    node.childMax[c][a] = 0;
+  }
+  node.child[c] = UINT32_MAX;
+  node.count[c] = 0;
+}
+}
+
+struct StaticBvh::Builder {
+  struct Subtree {
+    uint32_t parent;
+    int slot;
+    uint32_t begin;
+    uint32_t mid;
+    uint32_t end;
+    size_t depth;
+  };
+
+  const StaticBvh& tree;
+  std::span<const AABB> input;
+  std::vector<Vec3> centroids;
+  uint32_t* order;
+
+  AABB rangeBounds(uint32_t begin, uint32_t end) const {
+    AABB box = input[order[begin]];
+    for (uint32_t i = begin + 1; i < end; i++) {
+      box.expandToInclude(input[order[i]]);
+    }
+    return box;
+  }
+
+  // Partitions [begin, end) and returns true with the split point, or false
+  // if the range is better off as a leaf.
+  bool chooseSplit(uint32_t begin, uint32_t end, size_t depth, const AABB& box, uint32_t& mid) {
+    uint32_t count = end - begin;
+    if (count <= 1) return false;
+
+    AABB centroidBox(centroids[order[begin]], centroids[order[begin]]);
+    for (uint32_t i = begin + 1; i < end; i++) {
+      centroidBox.expandToInclude(centroids[order[i]]);
+    }
+    Vec3 extent = centroidBox.max - centroidBox.min;
+    int longest = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+
+    if (depth >= kMaxSahDepth || axisValue(extent, longest) <= 0.0f) {
+      if (count <= kMaxLeafSize) return false;
+      return medianSplit(begin, end, longest, mid);
+    }
+
+    float bestCost = INFINITY;
+    int bestAxis = -1;
+    int bestBin = 0;
+    for (int axis = 0; axis < 3; axis++) {
+      float axisExtent = axisValue(extent, axis);
+      if (axisExtent <= 0.0f) continue;
+      float binScale = static_cast<float>(kBinCount) / axisExtent;
+      float axisMin = axisValue(centroidBox.min, axis);
+
+      AABB binBounds[kBinCount];
+      uint32_t binCounts[kBinCount] = {};
+      for (uint32_t i = begin; i < end; i++) {
+        int bin = std::min(kBinCount - 1, static_cast<int>((axisValue(centroids[order[i]], axis) - axisMin) * binScale));
+        if (binCounts[bin]++ == 0) {
+          binBounds[bin] = input[order[i]];
+        } else {
+          binBounds[bin].expandToInclude(input[order[i]]);
+        }
+      }
+
+      float leftCost[kBinCount - 1];
+      AABB sweep;
+      uint32_t sweepCount = 0;
+      for (int b = 0; b < kBinCount - 1; b++) {
+        if (binCounts[b] > 0) {
+          if (sweepCount == 0) sweep = binBounds[b];
+          else sweep.expandToInclude(binBounds[b]);
+          sweepCount += binCounts[b];
+        }
+        leftCost[b] = sweepCount > 0 ? halfArea(sweep) * static_cast<float>(sweepCount) : 0.0f;
+      }
+      sweepCount = 0;
+      for (int b = kBinCount - 1; b > 0; b--) {
+        if (binCounts[b] > 0) {
+          if (sweepCount == 0) sweep = binBounds[b];
+          else sweep.expandToInclude(binBounds[b]);
+          sweepCount += binCounts[b];
+        }
+        if (sweepCount == 0 || sweepCount == count) continue;
+        float cost = leftCost[b - 1] + halfArea(sweep) * static_cast<float>(sweepCount);
+        if (cost < bestCost) {
+          bestCost = cost;
+          bestAxis = axis;
+          bestBin = b;
+        }
+      }
+    }
+
+    float area = halfArea(box);
+    if (bestAxis < 0) {
+      if (count <= kMaxLeafSize) return false;
+      return medianSplit(begin, end, longest, mid);
+    }
+    if (count <= kMaxLeafSize && area * static_cast<float>(count) <= kTraversalCost * area + bestCost) {
+      return false;
+    }
+
+    float binScale = static_cast<float>(kBinCount) / axisValue(extent, bestAxis);
+    float axisMin = axisValue(centroidBox.min, bestAxis);
+    uint32_t* split = std::partition(order + begin, order + end, [&](uint32_t index) {
+      int bin = std::min(kBinCount - 1, static_cast<int>((axisValue(centroids[index], bestAxis) - axisMin) * binScale));
+      return bin < bestBin;
+    });
+    mid = static_cast<uint32_t>(split - order);
+    if (mid == begin || mid == end) {
+      return medianSplit(begin, end, longest, mid);
+    }
+    return true;
+  }
+
+  bool medianSplit(uint32_t begin, uint32_t end, int axis, uint32_t& mid) {
+    mid = begin + (end - begin) / 2;
+    std::nth_element(order + begin, order + mid, order + end, [&](uint32_t lhs, uint32_t rhs) {
+      float a = axisValue(centroids[lhs], axis);
+      float b = axisValue(centroids[rhs], axis);
+      return a < b || (a == b && lhs < rhs);
+    });
+    return true;
+  }
+
+  // Fills child slot c of out[nodeIndex] with [begin, end). With a pending
+  // list, small subtrees are queued there instead of being built.
+  void fillChild(std::vector<BvhNode>& out, uint32_t nodeIndex, int c, uint32_t begin, uint32_t end, size_t depth,
+                 std::vector<Subtree>* pending) {
+    AABB box = rangeBounds(begin, end);
+    tree.quantize(box, out[nodeIndex].childMin[c], out[nodeIndex].childMax[c]);
+
+    uint32_t mid;
+    if (!chooseSplit(begin, end, depth, box, mid)) {
+      out[nodeIndex].child[c] = begin;
+      out[nodeIndex].count[c] = end - begin;
+      return;
+    }
+    out[nodeIndex].count[c] = 0;
+    if (pending && end - begin <= kSubtreePrimitives) {
+      out[nodeIndex].child[c] = UINT32_MAX;
+      pending->push_back({nodeIndex, c, begin, mid, end, depth});
+      return;
+    }
+
+    uint32_t index = static_cast<uint32_t>(out.size());
+    out.push_back(BvhNode{});
+    out[nodeIndex].child[c] = index;
+    fillChild(out, index, 0, begin, mid, depth + 1, pending);
+    fillChild(out, index, 1, mid, end, depth + 1, pending);
+  }
+
+  void buildSubtree(const Subtree& subtree, std::vector<BvhNode>& out) {
+    out.clear();
+    out.push_back(BvhNode{});
+    fillChild(out, 0, 0, subtree.begin, subtree.mid, subtree.depth + 1, nullptr);
+    fillChild(out, 0, 1, subtree.mid, subtree.end, subtree.depth + 1, nullptr);
+  }
+};
+
+StaticBvh::StaticBvh() : quantizeScale{0.0f, 0.0f, 0.0f}, depth(0) {}
+
+void StaticBvh::build(std::span<const AABB> input, ThreadPool* pool) {
+  clear();
+  uint32_t count = static_cast<uint32_t>(input.size());
+  if (count == 0) return;
+
+  bounds = input[0];
+  for (const AABB& box : input) {
+    bounds.expandToInclude(box);
+  }
+  Vec3 extent = bounds.max - bounds.min;
+  for (int a = 0; a < 3; a++) {
+    float axisExtent = axisValue(extent, a);
+    quantizeScale[a] = axisExtent > 0.0f ? static_cast<float>(kQuantizedMax) / axisExtent : 0.0f;
+  }
+
+  primitiveOrder.resize(count);
+  for (uint32_t i = 0; i < count; i++) {
+    primitiveOrder[i] = i;
+  }
+  Builder builder{*this, input, std::vector<Vec3>(count), primitiveOrder.data()};
+  for (uint32_t i = 0; i < count; i++) {
+    builder.centroids[i] = input[i].getCenter();
+  }
+
+  // Top of the tree, serially.
+  std::vector<Builder::Subtree> pending;
+  nodes.push_back(BvhNode{});
+  uint32_t mid;
+  AABB all = builder.rangeBounds(0, count);
+  if (builder.chooseSplit(0, count, 0, all, mid)) {
+    builder.fillChild(nodes, 0, 0, 0, mid, 1, &pending);
+    builder.fillChild(nodes, 0, 1, mid, count, 1, &pending);
+  } else {
+    builder.fillChild(nodes, 0, 0, 0, count, 1, &pending);
+    setEmptyChild(nodes[0], 1);
+  }
+
+  // Subtrees touch disjoint ranges of the primitive order.
+  std::vector<std::vector<BvhNode>> subtreeNodes(pending.size());
+  auto buildRange = [&](size_t begin, size_t end) {
+    for (size_t t = begin; t < end; t++) {
+      builder.buildSubtree(pending[t], subtreeNodes[t]);
+    }
+  };
+  if (pool) {
+    pool->parallelFor(pending.size(), 1, buildRange);
+  } else {
+    buildRange(0, pending.size());
+  }
+
+  for (size_t t = 0; t < pending.size(); t++) {
+    uint32_t base = static_cast<uint32_t>(nodes.size());
+    for (BvhNode node : subtreeNodes[t]) {
+      for (int c = 0; c < 2; c++) {
+        if (node.count[c] == 0 && node.child[c] != UINT32_MAX) node.child[c] += base;
+      }
+      nodes.push_back(node);
+    }
+    nodes[pending[t].parent].child[pending[t].slot] = base;
+  }
+
+  // Children always follow their parent in the array.
+  std::vector<uint32_t> nodeDepth(nodes.size(), 1);
+  depth = 1;
+  for (size_t i = 0; i < nodes.size(); i++) {
+    depth = std::max<size_t>(depth, nodeDepth[i]);
+    for (int c = 0; c < 2; c++) {
+      if (nodes[i].count[c] == 0 && nodes[i].child[c] != UINT32_MAX) nodeDepth[nodes[i].child[c]] = nodeDepth[i] + 1;
+    }
+  }
+
+  primitiveBounds.resize(count);
+  for (uint32_t k = 0; k < count; k++) {
+    primitiveBounds[k] = input[primitiveOrder[k]];
+  }
+}
+
+void StaticBvh::clear() {
+  nodes.clear();
+  primitiveOrder.clear();
+  primitiveBounds.clear();
+  bounds = AABB();
+  depth = 0;
+}
+
+void StaticBvh::quantize(const AABB& box, uint16_t outMin[3], uint16_t outMax[3]) const {
+  for (int a = 0; a < 3; a++) {
+    float origin = axisValue(bounds.min, a);
+    float low = std::floor((axisValue(box.min, a) - origin) * quantizeScale[a]) - 1.0f;
+    float high = std::ceil((axisValue(box.max, a) - origin) * quantizeScale[a]) + 1.0f;
+    outMin[a] = static_cast<uint16_t>(std::clamp(low, 0.0f, static_cast<float>(kQuantizedMax)));
+    outMax[a] = static_cast<uint16_t>(std::clamp(high, 0.0f, static_cast<float>(kQuantizedMax)));
+  }
+}
+
+size_t StaticBvh::getPrimitiveCount() const {
+  return primitiveOrder.size();
+}
+
+size_t StaticBvh::getNodeCount() const {
+  return nodes.size();
+}
+
+size_t StaticBvh::getDepth() const {
+  return depth;
+}
+
+const AABB& StaticBvh::getBounds() const {
+  return bounds;
+}
+
+std::span<const BvhNode> StaticBvh::getNodes() const {
+  return std::span<const BvhNode>(nodes.data(), nodes.size());
+}
+
+std::span<const uint32_t> StaticBvh::getPrimitiveOrder() const {
+  return std::span<const uint32_t>(primitiveOrder.data(), primitiveOrder.size());
+}
+
+std::span<const AABB> StaticBvh::getPrimitiveBounds() const {
+  return std::span<const AABB>(primitiveBounds.data(), primitiveBounds.size());
+}
+
+}
@@ -1,9 +1,15 @@
 #include "physics/dynamics/RigidBody.h"
+#include "physics/collision/ConvexHull.h"
+#include "physics/dynamics/Integrators.h"
+#include <algorithm>
+#include <cmath>
 
 namespace physics::dynamics {
 
 using Vec3 = physics::math::Vec3;
 using AABB = physics::collision::AABB;
+using Shape = physics::collision::Shape;
+using ShapeType = physics::collision::ShapeType;
 
 RigidBody::RigidBody() 
     : position(0, 0, 0), velocity(0, 0, 0), acceleration(0, 0, 0), size(1, 1, 1),
@@ -37,6 +43,29 @@ void RigidBody::makeDynamic(float mass) {
     setMass(mass);
 }
 
+void RigidBody::setShape(const Shape& shape) {
+    this->shape = shape;
+    switch (shape.type) {
+        case ShapeType::Sphere:
+            size = Vec3(2.0f * shape.radius, 2.0f * shape.radius, 2.0f * shape.radius);
+            break;
+        case ShapeType::Capsule:
+            size = Vec3(2.0f * shape.radius, 2.0f * (shape.halfHeight + shape.radius), 2.0f * shape.radius);
+            break;
+        case ShapeType::OrientedBox:
+            size = shape.halfExtents * 2.0f;
+            break;
+        case ShapeType::ConvexHull: {
+            const Vec3& low = shape.hull->getLocalMin();
+            const Vec3& high = shape.hull->getLocalMax();
+            size = Vec3(2.0f * std::max(-low.x, high.x), 2.0f * std::max(-low.y, high.y), 2.0f * std::max(-low.z, high.z));
+            break;
+        }
+        case ShapeType::Box:
+            break;
+    }
+}
+
 void RigidBody::applyForce(const Vec3& force) {
     if (!isStatic && inverseMass > 0.0f) {
         acceleration += force * inverseMass;
@@ -54,14 +83,35 @@ void RigidBody::clearForces() {
 }
 
 void RigidBody::integrate(float deltaTime) {
-    if (isStatic) return;
-    
-    velocity += acceleration * deltaTime;
-    position += velocity * deltaTime;
-    clearForces();
+    integrateBody<SemiImplicitEuler>(*this, deltaTime);
 }
 
 AABB RigidBody::getAABB() const {
+    switch (shape.type) {
+        case ShapeType::Sphere: {
+            Vec3 radius(shape.radius, shape.radius, shape.radius);
+            return AABB(position - radius, position + radius);
+        }
+        case ShapeType::Capsule: {
+            const Vec3& axis = shape.axes[1];
+            Vec3 reach(std::abs(axis.x) * shape.halfHeight + shape.radius,
+                       std::abs(axis.y) * shape.halfHeight + shape.radius,
+                       std::abs(axis.z) * shape.halfHeight + shape.radius);
+            return AABB(position - reach, position + reach);
+        }
+        case ShapeType::OrientedBox: {
+            const Vec3* axes = shape.axes;
+            const Vec3& half = shape.halfExtents;
+            Vec3 reach(std::abs(axes[0].x) * half.x + std::abs(axes[1].x) * half.y + std::abs(axes[2].x) * half.z,
+                       std::abs(axes[0].y) * half.x + std::abs(axes[1].y) * half.y + std::abs(axes[2].y) * half.z,
+                       std::abs(axes[0].z) * half.x + std::abs(axes[1].z) * half.y + std::abs(axes[2].z) * half.z);
+            return AABB(position - reach, position + reach);
+        }
+        case ShapeType::ConvexHull:
+            return AABB(position + shape.hull->getLocalMin(), position + shape.hull->getLocalMax());
+        case ShapeType::Box:
+            break;
+    }
     Vec3 halfSize = size * 0.5f;
     return AABB(position - halfSize, position + halfSize);
 }
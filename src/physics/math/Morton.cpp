@@ -0,0 +1,35 @@
+#include "physics/math/Morton.h"
+#include <algorithm>
+
+namespace physics::math {
+
+uint32_t expandBits10(uint32_t value) {
+  value &= 0x3ff;
+  value = (value | (value << 16)) & 0x030000ff;
+  value = (value | (value << 8)) & 0x0300f00f;
+  value = (value | (value << 4)) & 0x030c30c3;
+  value = (value | (value << 2)) & 0x09249249;
+  return value;
+}
+
+uint32_t mortonEncode(uint32_t x, uint32_t y, uint32_t z) {
+  return (expandBits10(x) << 2) | (expandBits10(y) << 1) | expandBits10(z);
+}
+
+namespace {
+uint32_t quantize(float value, float min, float max) {
+  float extent = max - min;
+  if (extent <= 0.0f) return 0;
+  float t = (value - min) / extent;
+  t = std::clamp(t, 0.0f, 1.0f);
+  return static_cast<uint32_t>(t * 1023.0f);
+}
+}
+
+uint32_t mortonEncode(const Vec3& point, const Vec3& boundsMin, const Vec3& boundsMax) {
+  return mortonEncode(quantize(point.x, boundsMin.x, boundsMax.x),
+                      quantize(point.y, boundsMin.y, boundsMax.y),
+                      quantize(point.z, boundsMin.z, boundsMax.z));
+}
+
+}
@@ -0,0 +1,72 @@
+#include "physics/memory/AllocationCounter.h"
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace physics::memory {
+
+namespace {
+thread_local uint64_t allocationCount = 0;
+thread_local uint64_t attributedCount = 0;
+}
+
+bool allocationCountingEnabled() {
+#ifdef PHYSICS_COUNT_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+uint64_t threadAllocationCount() {
+    return allocationCount;
+}
+
+uint64_t attributedAllocationCount() {
+    return allocationCount + attributedCount;
+}
+
+void attributeAllocations(uint64_t count) {
+    attributedCount += count;
+}
+
+#ifdef PHYSICS_COUNT_ALLOCATIONS
+void* countedAllocate(std::size_t size, std::size_t alignment) {
+    allocationCount++;
+    if (size == 0) size = 1;
+    void* p = alignment > alignof(std::max_align_t)
+        ? std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)
+        : std::malloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+#endif
+
+}
+
+#ifdef PHYSICS_COUNT_ALLOCATIONS
+void* operator new(std::size_t size) {
+    return physics::memory::countedAllocate(size, alignof(std::max_align_t));
+}
+
+void* operator new[](std::size_t size) {
+    return physics::memory::countedAllocate(size, alignof(std::max_align_t));
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return physics::memory::countedAllocate(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return physics::memory::countedAllocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+#endif
@@ -0,0 +1,103 @@
+#include "physics/memory/FrameArena.h"
+#include <algorithm>
+#include <new>
+
+namespace physics::memory {
+
+namespace {
+const size_t kBlockHeaderSize = (sizeof(void*) * 3 + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+}
+
+FrameArena::FrameArena(size_t initialCapacity, std::pmr::memory_resource* upstream)
+    : upstream(upstream), head(nullptr), bytesUsed(0), peakBytesUsed(0), upstreamAllocations(0) {
+    if (initialCapacity > 0) {
+        head = allocateBlock(initialCapacity);
+    }
+}
+
+FrameArena::~FrameArena() {
+    releaseBlocks();
+}
+
+FrameArena::Block* FrameArena::allocateBlock(size_t size) {
+    void* memory = upstream->allocate(kBlockHeaderSize + size, alignof(std::max_align_t));
+    upstreamAllocations++;
+    Block* block = static_cast<Block*>(memory);
+    block->next = nullptr;
+    block->size = size;
+    block->used = 0;
+    return block;
+}
+
+void FrameArena::releaseBlocks() {
+    while (head) {
+        Block* next = head->next;
+        upstream->deallocate(head, kBlockHeaderSize + head->size, alignof(std::max_align_t));
+        head = next;
+    }
+}
+
+void FrameArena::reset() {
+    if (head && head->next) {
+        size_t total = 0;
+        for (Block* block = head; block; block = block->next) {
+            total += block->size;
+        }
+        releaseBlocks();
+        head = allocateBlock(total);
+    } else if (head) {
+        head->used = 0;
+    }
+    bytesUsed = 0;
+}
+
+void* FrameArena::do_allocate(size_t bytes, size_t alignment) {
+    if (head) {
+        uintptr_t base = reinterpret_cast<uintptr_t>(head) + kBlockHeaderSize;
+        uintptr_t current = base + head->used;
+        uintptr_t aligned = (current + alignment - 1) & ~(uintptr_t(alignment) - 1);
+        size_t needed = (aligned - current) + bytes;
+        if (head->used + needed <= head->size) {
+            head->used += needed;
+            bytesUsed += needed;
+            peakBytesUsed = std::max(peakBytesUsed, bytesUsed);
+            return reinterpret_cast<void*>(aligned);
+        }
+    }
+
+    // Overflow: chain a new block in front. Old blocks stay alive until reset.
+    size_t previousSize = head ? head->size : 0;
+    size_t size = std::max(bytes + alignment, previousSize * 2);
+    Block* block = allocateBlock(size);
+    block->next = head;
+    head = block;
+    return do_allocate(bytes, alignment);
+}
+
+void FrameArena::do_deallocate(void*, size_t, size_t) {}
+
+bool FrameArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+size_t FrameArena::getBytesUsed() const {
+    return bytesUsed;
+}
+
+size_t FrameArena::getCapacity() const {
+    size_t total = 0;
+    for (Block* block = head; block; block = block->next) {
+        total += block->size;
+    }
+    return total;
+}
+
+size_t FrameArena::getPeakBytesUsed() const {
+    return peakBytesUsed;
+}
+
+uint64_t FrameArena::getUpstreamAllocationCount() const {
+    return upstreamAllocations;
+}
+
+}
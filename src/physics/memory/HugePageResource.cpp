@@ -0,0 +1,185 @@
+#include "physics/memory/HugePageResource.h"
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace physics::memory {
+
+namespace {
+// Nodes beyond this are not addressable by the placement mask.
+const size_t kMaxNumaNodes = 256;
+// log2 of the huge page size, encoded into the mmap flags.
+const int kHugePageShift = 21;
+
+size_t roundUpToHugePage(size_t bytes) {
+    return (bytes + HugePageResource::kHugePageSize - 1) & ~(HugePageResource::kHugePageSize - 1);
+}
+
+// Parses sysfs lists such as "0-3,8,10-11".
+std::vector<unsigned> parseList(const std::string& text) {
+    std::vector<unsigned> values;
+    std::stringstream stream(text);
+    std::string range;
+    while (std::getline(stream, range, ',')) {
+        if (range.empty() || range == "\n") continue;
+        size_t dash = range.find('-');
+        unsigned first = static_cast<unsigned>(std::stoul(range.substr(0, dash)));
+        unsigned last = dash == std::string::npos ? first : static_cast<unsigned>(std::stoul(range.substr(dash + 1)));
+        for (unsigned v = first; v <= last; v++) {
+            values.push_back(v);
+        }
+    }
+    return values;
+}
+
+bool readSysfsList(const std::string& path, std::vector<unsigned>& values) {
+    std::ifstream file(path);
+    std::string text;
+    if (!file || !std::getline(file, text)) return false;
+    values = parseList(text);
+    return !values.empty();
+}
+}
+
+HugePageResource::HugePageResource(const HugePageSettings& settings, std::pmr::memory_resource* upstream)
+    : settings(settings), upstream(upstream), mappedBytes(0), mappingCount(0), explicitFallbacks(0),
+      placementFailures(0) {}
+
+const HugePageSettings& HugePageResource::getSettings() const {
+    return settings;
+}
+
+size_t HugePageResource::getMappedBytes() const {
+    return mappedBytes.load(std::memory_order_relaxed);
+}
+
+size_t HugePageResource::getMappingCount() const {
+    return mappingCount.load(std::memory_order_relaxed);
+}
+
+uint64_t HugePageResource::getExplicitFallbackCount() const {
+    return explicitFallbacks.load(std::memory_order_relaxed);
+}
+
+uint64_t HugePageResource::getPlacementFailureCount() const {
+    return placementFailures.load(std::memory_order_relaxed);
+}
+
+// Decided from the request alone so deallocate takes the same path.
+bool HugePageResource::isMapped(size_t bytes, size_t alignment) const {
+    return bytes >= settings.minMappingBytes && alignment <= kHugePageSize;
+}
+
+void* HugePageResource::do_allocate(size_t bytes, size_t alignment) {
+    if (!isMapped(bytes, alignment)) {
+        return upstream->allocate(bytes, alignment);
+    }
+    size_t size = roundUpToHugePage(bytes);
+    void* p = MAP_FAILED;
+    if (settings.mode == HugePageMode::Explicit) {
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (kHugePageShift << MAP_HUGE_SHIFT);
+        p = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (p == MAP_FAILED) {
+            explicitFallbacks.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    if (p == MAP_FAILED) {
+        p = mapAligned(size);
+        if (settings.mode != HugePageMode::None) {
+            madvise(p, size, MADV_HUGEPAGE);
+        }
+    }
+    applyPlacement(p, size);
+    mappedBytes.fetch_add(size, std::memory_order_relaxed);
+    mappingCount.fetch_add(1, std::memory_order_relaxed);
+    return p;
+}
+
+void HugePageResource::do_deallocate(void* p, size_t bytes, size_t alignment) {
+    if (!isMapped(bytes, alignment)) {
+        upstream->deallocate(p, bytes, alignment);
+        return;
+    }
+    size_t size = roundUpToHugePage(bytes);
+    munmap(p, size);
+    mappedBytes.fetch_sub(size, std::memory_order_relaxed);
+    mappingCount.fetch_sub(1, std::memory_order_relaxed);
+}
+
+bool HugePageResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+// Over-maps by one huge page and trims both ends so the kernel can back the
+// range with whole huge pages.
+void* HugePageResource::mapAligned(size_t size) {
+    size_t padded = size + kHugePageSize;
+    void* raw = mmap(nullptr, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    uintptr_t start = reinterpret_cast<uintptr_t>(raw);
+    uintptr_t aligned = (start + kHugePageSize - 1) & ~(uintptr_t(kHugePageSize) - 1);
+    size_t head = aligned - start;
+    size_t tail = padded - head - size;
+    if (head > 0) munmap(raw, head);
+    if (tail > 0) munmap(reinterpret_cast<void*>(aligned + size), tail);
+    return reinterpret_cast<void*>(aligned);
+}
+
+// mbind through the raw syscall so there is no libnuma dependency. The
+// policy only affects pages faulted in afterwards, which is all of them.
+void HugePageResource::applyPlacement(void* p, size_t size) {
+    if (settings.numaPolicy == NumaPolicy::FirstTouch) return;
+
+    unsigned long mask[kMaxNumaNodes / (8 * sizeof(unsigned long))] = {};
+    const size_t bitsPerWord = 8 * sizeof(unsigned long);
+    int mode = MPOL_PREFERRED;
+    if (settings.numaPolicy == NumaPolicy::Preferred) {
+        if (settings.numaNode >= kMaxNumaNodes) {
+            placementFailures.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        mask[settings.numaNode / bitsPerWord] |= 1UL << (settings.numaNode % bitsPerWord);
+    } else {
+        mode = MPOL_INTERLEAVE;
+        size_t nodes = std::min(numaNodeCount(), kMaxNumaNodes);
+        for (size_t n = 0; n < nodes; n++) {
+            mask[n / bitsPerWord] |= 1UL << (n % bitsPerWord);
+        }
+    }
+    if (syscall(SYS_mbind, p, size, mode, mask, kMaxNumaNodes, 0) != 0) {
+        placementFailures.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+size_t numaNodeCount() {
+    std::vector<unsigned> nodes;
+    if (!readSysfsList("/sys/devices/system/node/online", nodes)) return 1;
+    return nodes.back() + 1;
+}
+
+std::vector<unsigned> numaNodeCpus(unsigned node) {
+    std::vector<unsigned> cpus;
+    if (readSysfsList("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist", cpus)) {
+        return cpus;
+    }
+    cpus.clear();
+    if (node == 0) {
+        unsigned count = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned c = 0; c < count; c++) {
+            cpus.push_back(c);
+        }
+    }
+    return cpus;
+}
+
+}
@@ -0,0 +1,88 @@
+#include "physics/parallel/RadixSort.h"
+#include <algorithm>
+#include <utility>
+
+namespace physics::parallel {
+
+namespace {
+const size_t kRadix = 256;
+const size_t kMinChunkSize = 4096;
+}
+
+void radixSortPairs(std::vector<uint32_t>& keys, std::vector<uint32_t>& values, RadixSortScratch& scratch,
+                    unsigned keyBits, ThreadPool* pool) {
+    size_t count = keys.size();
+    if (count < 2) return;
+
+    std::vector<uint32_t>& scratchKeys = scratch.keys;
+    std::vector<uint32_t>& scratchValues = scratch.values;
+    scratchKeys.resize(count);
+    scratchValues.resize(count);
+
+    size_t concurrency = pool ? pool->getConcurrency() : 1;
+    size_t chunkCount = std::clamp(count / kMinChunkSize, size_t(1), concurrency * 4);
+    size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+    chunkCount = (count + chunkSize - 1) / chunkSize;
+
+    std::vector<uint32_t>& histograms = scratch.histograms;
+    histograms.resize(chunkCount * kRadix);
+
+    auto forEachChunk = [&](auto&& body) {
+        if (pool) {
+            pool->parallelFor(chunkCount, 1, [&](size_t begin, size_t end) {
+                for (size_t chunk = begin; chunk < end; chunk++) body(chunk);
+            });
+        } else {
+            for (size_t chunk = 0; chunk < chunkCount; chunk++) body(chunk);
+        }
+    };
+
+    std::vector<uint32_t>* srcKeys = &keys;
+    std::vector<uint32_t>* srcValues = &values;
+    std::vector<uint32_t>* dstKeys = &scratchKeys;
+    std::vector<uint32_t>* dstValues = &scratchValues;
+
+    for (unsigned shift = 0; shift < keyBits; shift += 8) {
+        forEachChunk([&](size_t chunk) {
+            uint32_t* histogram = &histograms[chunk * kRadix];
+            std::fill(histogram, histogram + kRadix, 0u);
+            size_t begin = chunk * chunkSize;
+            size_t end = std::min(count, begin + chunkSize);
+            for (size_t i = begin; i < end; i++) {
+                histogram[((*srcKeys)[i] >> shift) & 0xff]++;
+            }
+        });
+
+        // Turn counts into scatter offsets ordered by (digit, chunk) for stability.
+        uint32_t offset = 0;
+        for (size_t digit = 0; digit < kRadix; digit++) {
+            for (size_t chunk = 0; chunk < chunkCount; chunk++) {
+                uint32_t bucketCount = histograms[chunk * kRadix + digit];
+                histograms[chunk * kRadix + digit] = offset;
+                offset += bucketCount;
+            }
+        }
+
+        forEachChunk([&](size_t chunk) {
+            uint32_t* histogram = &histograms[chunk * kRadix];
+            size_t begin = chunk * chunkSize;
+            size_t end = std::min(count, begin + chunkSize);
+            for (size_t i = begin; i < end; i++) {
+                uint32_t key = (*srcKeys)[i];
+                uint32_t destination = histogram[(key >> shift) & 0xff]++;
+                (*dstKeys)[destination] = key;
+                (*dstValues)[destination] = (*srcValues)[i];
+            }
+        });
+
+        std::swap(srcKeys, dstKeys);
+        std::swap(srcValues, dstValues);
+    }
+
+    if (srcKeys != &keys) {
+        keys.swap(scratchKeys);
+        values.swap(scratchValues);
+    }
+}
+
+}
@@ -0,0 +1,149 @@
+#include "physics/parallel/SharedRingBuffer.h"
+#include <atomic>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace physics::parallel {
+
+// Lives at the start of the mapping. Head and tail sit on separate cache
+// lines so producer and consumer do not false-share.
+struct SharedRingBuffer::Header {
+    uint64_t slotSize;
+    uint64_t slotCount;
+    alignas(64) std::atomic<uint64_t> head;
+    alignas(64) std::atomic<uint64_t> tail;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared memory ring needs address-free atomics");
+
+namespace {
+const size_t kDataOffset = 192;
+
+size_t mappingSizeFor(size_t slotSize, size_t slotCount) {
+    return kDataOffset + slotSize * slotCount;
+}
+}
+
+SharedRingBuffer SharedRingBuffer::create(const std::string& name, size_t slotSize, size_t slotCount) {
+    int fd = shm_open(name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0600);
+    if (fd < 0) {
+        throw std::runtime_error("shm_open failed for " + name);
+    }
+    size_t size = mappingSizeFor(slotSize, slotCount);
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        close(fd);
+        throw std::runtime_error("ftruncate failed for " + name);
+    }
+    void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("mmap failed for " + name);
+    }
+
+    static_assert(sizeof(Header) <= kDataOffset, "ring header overlaps slot data");
+    Header* header = new (mapping) Header();
+    header->slotSize = slotSize;
+    header->slotCount = slotCount;
+    header->head.store(0, std::memory_order_relaxed);
+    header->tail.store(0, std::memory_order_release);
+    return SharedRingBuffer(mapping, size);
+}
+
+SharedRingBuffer SharedRingBuffer::open(const std::string& name) {
+    int fd = shm_open(name.c_str(), O_RDWR, 0600);
+    if (fd < 0) {
+        throw std::runtime_error("shm_open failed for " + name);
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < kDataOffset) {
+        close(fd);
+        throw std::runtime_error("shared ring " + name + " is not initialized");
+    }
+    size_t size = static_cast<size_t>(info.st_size);
+    void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("mmap failed for " + name);
+    }
+    return SharedRingBuffer(mapping, size);
+}
+
+void SharedRingBuffer::unlink(const std::string& name) {
+    shm_unlink(name.c_str());
+}
+
+SharedRingBuffer::SharedRingBuffer() : mapping(nullptr), mappingSize(0) {}
+
+SharedRingBuffer::SharedRingBuffer(void* mapping, size_t mappingSize)
+    : mapping(mapping), mappingSize(mappingSize) {}
+
+SharedRingBuffer::~SharedRingBuffer() {
+    if (mapping) {
+        munmap(mapping, mappingSize);
+    }
+}
+
+SharedRingBuffer::SharedRingBuffer(SharedRingBuffer&& other) noexcept
+    : mapping(std::exchange(other.mapping, nullptr)), mappingSize(std::exchange(other.mappingSize, 0)) {}
+
+SharedRingBuffer& SharedRingBuffer::operator=(SharedRingBuffer&& other) noexcept {
+    if (this != &other) {
+        if (mapping) {
+            munmap(mapping, mappingSize);
+        }
+        mapping = std::exchange(other.mapping, nullptr);
+        mappingSize = std::exchange(other.mappingSize, 0);
+    }
+    return *this;
+}
+
+bool SharedRingBuffer::isValid() const {
+    return mapping != nullptr;
+}
+
+size_t SharedRingBuffer::getSlotSize() const {
+    return static_cast<const Header*>(mapping)->slotSize;
+}
+
+size_t SharedRingBuffer::getSlotCount() const {
+    return static_cast<const Header*>(mapping)->slotCount;
+}
+
+size_t SharedRingBuffer::size() const {
+    const Header* header = static_cast<const Header*>(mapping);
+    return header->head.load(std::memory_order_acquire) - header->tail.load(std::memory_order_acquire);
+}
+
+char* SharedRingBuffer::slotData() const {
+    return static_cast<char*>(mapping) + kDataOffset;
+}
+
+bool SharedRingBuffer::push(const void* slot) {
+    Header* header = static_cast<Header*>(mapping);
+    uint64_t head = header->head.load(std::memory_order_relaxed);
+    uint64_t tail = header->tail.load(std::memory_order_acquire);
+    if (head - tail >= header->slotCount) return false;
+
+    std::memcpy(slotData() + (head % header->slotCount) * header->slotSize, slot, header->slotSize);
+    header->head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+bool SharedRingBuffer::pop(void* slot) {
+    Header* header = static_cast<Header*>(mapping);
+    uint64_t tail = header->tail.load(std::memory_order_relaxed);
+    uint64_t head = header->head.load(std::memory_order_acquire);
+    if (head == tail) return false;
+
+    std::memcpy(slot, slotData() + (tail % header->slotCount) * header->slotSize, header->slotSize);
+    header->tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+}
@@ -0,0 +1,152 @@
+#include "physics/parallel/TaskGraph.h"
+#include <cassert>
+#include <stdexcept>
+
+namespace physics::parallel {
+
+TaskGraph::TaskGraph() : readyHead(0), readyTail(0), completedCount(0) {}
+
+TaskId TaskGraph::addTask(TaskFn fn, void* context, size_t arg, const char* name) {
+    tasks.push_back({fn, context, arg, name});
+    return static_cast<TaskId>(tasks.size() - 1);
+}
+
+TaskId TaskGraph::addJoin(const char* name) {
+    return addTask(nullptr, nullptr, 0, name);
+}
+
+void TaskGraph::addDependency(TaskId before, TaskId after) {
+    assert(before < tasks.size() && after < tasks.size() && before != after);
+    edges.emplace_back(before, after);
+}
+
+void TaskGraph::clear() {
+    tasks.clear();
+    edges.clear();
+}
+
+size_t TaskGraph::getTaskCount() const {
+    return tasks.size();
+}
+
+const char* TaskGraph::getTaskName(TaskId id) const {
+    return id < tasks.size() && tasks[id].name ? tasks[id].name : "";
+}
+
+const std::vector<TaskId>& TaskGraph::getLastRunOrder() const {
+    return runOrder;
+}
+
+// Builds a CSR successor list and predecessor counts from the edge list.
+void TaskGraph::buildSuccessors() {
+    size_t count = tasks.size();
+    successorOffsets.assign(count + 1, 0);
+    pendingPredecessors.assign(count, 0);
+    for (const auto& [before, after] : edges) {
+        successorOffsets[before + 1]++;
+        pendingPredecessors[after]++;
+    }
+    for (size_t i = 0; i < count; i++) {
+        successorOffsets[i + 1] += successorOffsets[i];
+    }
+    successors.resize(edges.size());
+    // Fill using readyQueue as a temporary cursor per task
+    readyQueue.assign(successorOffsets.begin(), successorOffsets.end() - 1);
+    for (const auto& [before, after] : edges) {
+        successors[readyQueue[before]++] = after;
+    }
+
+    readyQueue.resize(count);
+    readyHead = 0;
+    readyTail = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (pendingPredecessors[i] == 0) {
+            readyQueue[readyTail++] = static_cast<TaskId>(i);
+        }
+    }
+    completedCount = 0;
+    runOrder.clear();
+    runOrder.reserve(count);
+}
+
+// Kahn's algorithm on a copy of the predecessor counts. Workers would wait
+// forever on a cycle, so it has to be caught before the run starts.
+bool TaskGraph::isAcyclic() {
+    checkPredecessors.assign(pendingPredecessors.begin(), pendingPredecessors.end());
+    checkQueue.reserve(tasks.size());
+    checkQueue.assign(readyQueue.begin(), readyQueue.begin() + readyTail);
+    for (size_t head = 0; head < checkQueue.size(); head++) {
+        TaskId id = checkQueue[head];
+        for (uint32_t s = successorOffsets[id]; s < successorOffsets[id + 1]; s++) {
+            if (--checkPredecessors[successors[s]] == 0) {
+                checkQueue.push_back(successors[s]);
+            }
+        }
+    }
+    return checkQueue.size() == tasks.size();
+}
+
+void TaskGraph::run(ThreadPool* pool) {
+    if (tasks.empty()) return;
+    buildSuccessors();
+    if (!isAcyclic()) {
+        throw std::logic_error("task graph has a cycle");
+    }
+    if (pool && pool->getWorkerCount() > 0 && !ThreadPool::inParallelRegion()) {
+        runParallel(*pool);
+    } else {
+        runSerial();
+    }
+}
+
+void TaskGraph::completeTask(TaskId id) {
+    runOrder.push_back(id);
+    completedCount++;
+    for (uint32_t s = successorOffsets[id]; s < successorOffsets[id + 1]; s++) {
+        TaskId next = successors[s];
+        if (--pendingPredecessors[next] == 0) {
+            readyQueue[readyTail++] = next;
+        }
+    }
+}
+
+void TaskGraph::runSerial() {
+    while (readyHead < readyTail) {
+        TaskId id = readyQueue[readyHead++];
+        const Task& task = tasks[id];
+        if (task.fn) task.fn(task.context, task.arg);
+        completeTask(id);
+    }
+}
+
+void TaskGraph::runParallel(ThreadPool& pool) {
+    pool.parallelFor(pool.getConcurrency(), 1, [this](size_t, size_t) { workerLoop(); });
+}
+
+void TaskGraph::workerLoop() {
+    size_t total = tasks.size();
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        readyCondition.wait(lock, [&]() { return readyHead < readyTail || completedCount == total; });
+        if (readyHead == readyTail) break;
+
+        TaskId id = readyQueue[readyHead++];
+        const Task task = tasks[id];
+        lock.unlock();
+        if (task.fn) task.fn(task.context, task.arg);
+        lock.lock();
+
+        size_t readyBefore = readyTail;
+        completeTask(id);
+        size_t released = readyTail - readyBefore;
+        if (completedCount == total) {
+            readyCondition.notify_all();
+        } else if (released > 1) {
+            readyCondition.notify_all();
+        } else if (released == 1) {
+            readyCondition.notify_one();
+        }
+    }
+}
+
+}
@@ -0,0 +1,138 @@
+#include "physics/parallel/ThreadPool.h"
+#include "physics/memory/AllocationCounter.h"
+#include <algorithm>
+#include <pthread.h>
+#include <sched.h>
+
+namespace physics::parallel {
+
+namespace {
+thread_local bool insideParallelRegion = false;
+}
+
+ThreadPool::ThreadPool(size_t workerCount)
+    : jobFn(nullptr), jobContext(nullptr), jobCount(0), jobGrain(1), nextChunk(0),
+      busyWorkers(0), jobAllocations(0), generation(0), stopping(false) {
+    workers.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; i++) {
+        workers.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeCondition.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+size_t ThreadPool::getWorkerCount() const {
+    return workers.size();
+}
+
+size_t ThreadPool::getConcurrency() const {
+    return workers.size() + 1;
+}
+
+bool ThreadPool::pinWorkers(std::span<const unsigned> cpus) {
+    if (cpus.empty()) return false;
+    bool pinned = true;
+    for (size_t i = 0; i < workers.size(); i++) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpus[i % cpus.size()], &set);
+        pinned &= pthread_setaffinity_np(workers[i].native_handle(), sizeof(set), &set) == 0;
+    }
+    return pinned;
+}
+
+bool ThreadPool::pinCallingThread(std::span<const unsigned> cpus) {
+    if (cpus.empty()) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (unsigned cpu : cpus) {
+        CPU_SET(cpu, &set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+size_t ThreadPool::defaultWorkerCount() {
+    unsigned int hardware = std::thread::hardware_concurrency();
+    return hardware > 1 ? hardware - 1 : 0;
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+bool ThreadPool::inParallelRegion() {
+    return insideParallelRegion;
+}
+
+void ThreadPool::run(size_t count, size_t grain, RangeFn fn, void* context) {
+    std::lock_guard<std::mutex> runLock(runMutex);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobFn = fn;
+        jobContext = context;
+        jobCount = count;
+        jobGrain = grain;
+        nextChunk.store(0, std::memory_order_relaxed);
+        busyWorkers = workers.size();
+        jobAllocations = 0;
+        generation++;
+    }
+    wakeCondition.notify_all();
+
+    insideParallelRegion = true;
+    executeChunks();
+    insideParallelRegion = false;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    doneCondition.wait(lock, [this]() { return busyWorkers == 0; });
+    jobFn = nullptr;
+    jobContext = nullptr;
+    physics::memory::attributeAllocations(jobAllocations);
+}
+
+void ThreadPool::executeChunks() {
+    size_t chunkCount = (jobCount + jobGrain - 1) / jobGrain;
+    for (;;) {
+        size_t chunk = nextChunk.fetch_add(1, std::memory_order_relaxed);
+        if (chunk >= chunkCount) break;
+        size_t begin = chunk * jobGrain;
+        size_t end = std::min(jobCount, begin + jobGrain);
+        jobFn(jobContext, begin, end);
+    }
+}
+
+void ThreadPool::workerLoop() {
+    insideParallelRegion = true;
+    uint64_t seenGeneration = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeCondition.wait(lock, [&]() { return stopping || generation != seenGeneration; });
+            if (stopping) return;
+            seenGeneration = generation;
+        }
+
+        uint64_t allocationsBefore = physics::memory::threadAllocationCount();
+        executeChunks();
+        uint64_t allocations = physics::memory::threadAllocationCount() - allocationsBefore;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobAllocations += allocations;
+            busyWorkers--;
+        }
+        doneCondition.notify_one();
+    }
+}
+
+}
@@ -0,0 +1,414 @@
+#include "physics/world/Characters.h"
+#include <algorithm>
+#include <cmath>
+
+namespace physics::world {
+
+using Vec3 = physics::math::Vec3;
+using AABB = physics::collision::AABB;
+using CollisionFilter = physics::collision::CollisionFilter;
+
+namespace {
+// Slide iterations per move; a corner takes two, a wedge three.
+const int kMaxSlideIterations = 4;
+const int kMaxDepenetrationPasses = 4;
+const float kMinMove = 1e-6f;
+
+void toArray(const Vec3& v, float out[3]) {
+    out[0] = v.x;
+    out[1] = v.y;
+    out[2] = v.z;
+}
+
+float horizontalDistance(const Vec3& from, const Vec3& to) {
+    float dx = to.x - from.x;
+    float dz = to.z - from.z;
+    return std::sqrt(dx * dx + dz * dz);
+}
+
+// Earliest time in [0, 1] at which a box with the given half extents moving
+// from position by delta touches target, from the ray against target grown
+// by the half extents. Boxes already overlapping at the start are ignored
+// (depenetration handles them), and so is touching contact that moves
+// parallel to the face.
+bool sweepBox(const Vec3& position, const Vec3& halfExtents, const Vec3& delta, const AABB& target, float& time,
+              Vec3& normal) {
+    float p[3], e[3], d[3], lo[3], hi[3];
+    toArray(position, p);
+    toArray(halfExtents, e);
+    toArray(delta, d);
+    toArray(target.min, lo);
+    toArray(target.max, hi);
+    float enter = -1e30f;
+    float exit = 1e30f;
+    int axis = -1;
+    for (int i = 0; i < 3; i++) {
+        float low = lo[i] - e[i];
+        float high = hi[i] + e[i];
+        if (std::fabs(d[i]) < 1e-12f) {
+            if (p[i] <= low || p[i] >= high) return false;
+            continue;
+        }
+        float t1 = (low - p[i]) / d[i];
+        float t2 = (high - p[i]) / d[i];
+        if (t1 > t2) std::swap(t1, t2);
+        if (t1 > enter) {
+            enter = t1;
+            axis = i;
+        }
+        exit = std::min(exit, t2);
+    }
+    if (axis < 0 || enter > exit || enter < 0.0f || enter > 1.0f || exit <= 0.0f) return false;
+    float n[3] = {0, 0, 0};
+    n[axis] = d[axis] > 0.0f ? -1.0f : 1.0f;
+    time = enter;
+    normal = Vec3(n[0], n[1], n[2]);
+    return true;
+}
+
+AABB boxAt(const Vec3& position, const Vec3& halfExtents) {
+    return AABB(position - halfExtents, position + halfExtents);
+}
+}
+
+CharacterSystem::CharacterSystem() {}
+
+CharacterId CharacterSystem::add(const Vec3& position, const Vec3& halfExtents, const CollisionFilter& filter) {
+    CharacterId id;
+    if (!freeIds.empty()) {
+        id = freeIds.back();
+        freeIds.pop_back();
+    } else {
+        id = static_cast<CharacterId>(idToSlot.size());
+        idToSlot.push_back(UINT32_MAX);
+    }
+    idToSlot[id] = static_cast<uint32_t>(ids.size());
+    ids.push_back(id);
+    positionX.push_back(position.x);
+    positionY.push_back(position.y);
+    positionZ.push_back(position.z);
+    velocityX.push_back(0.0f);
+    velocityY.push_back(0.0f);
+    velocityZ.push_back(0.0f);
+    halfExtentX.push_back(halfExtents.x);
+    halfExtentY.push_back(halfExtents.y);
+    halfExtentZ.push_back(halfExtents.z);
+    wishX.push_back(0.0f);
+    wishZ.push_back(0.0f);
+    wishSpeed.push_back(0.0f);
+    jumpRequested.push_back(0);
+    grounded.push_back(0);
+    filters.push_back(filter);
+    return id;
+}
+
+// Swap-removes the character's slot.
+void CharacterSystem::remove(CharacterId id) {
+    if (!isValid(id)) return;
+    size_t slot = idToSlot[id];
+    size_t last = ids.size() - 1;
+    auto moveLast = [slot](auto& values) {
+        values[slot] = values.back();
+        values.pop_back();
+    };
+    moveLast(ids);
+    moveLast(positionX);
+    moveLast(positionY);
+    moveLast(positionZ);
+    moveLast(velocityX);
+    moveLast(velocityY);
+    moveLast(velocityZ);
+    moveLast(halfExtentX);
+    moveLast(halfExtentY);
+    moveLast(halfExtentZ);
+    moveLast(wishX);
+    moveLast(wishZ);
+    moveLast(wishSpeed);
+    moveLast(jumpRequested);
+    moveLast(grounded);
+    moveLast(filters);
+    if (slot < last) {
+        idToSlot[ids[slot]] = static_cast<uint32_t>(slot);
+    }
+    idToSlot[id] = UINT32_MAX;
+    freeIds.push_back(id);
+}
+
+void CharacterSystem::clear() {
+    ids.clear();
+    positionX.clear();
+    positionY.clear();
+    positionZ.clear();
+    velocityX.clear();
+    velocityY.clear();
+    velocityZ.clear();
+    halfExtentX.clear();
+    halfExtentY.clear();
+    halfExtentZ.clear();
+    wishX.clear();
+    wishZ.clear();
+    wishSpeed.clear();
+    jumpRequested.clear();
+    grounded.clear();
+    filters.clear();
+    idToSlot.clear();
+    freeIds.clear();
+}
+
+bool CharacterSystem::isValid(CharacterId id) const {
+    return id < idToSlot.size() && idToSlot[id] != UINT32_MAX;
+}
+
+size_t CharacterSystem::getCount() const {
+    return ids.size();
+}
+
+size_t CharacterSystem::slotOf(CharacterId id) const {
+    return idToSlot[id];
+}
+
+void CharacterSystem::setInput(CharacterId id, const Vec3& wishDirection, float speed, bool jump) {
+    size_t slot = slotOf(id);
+    Vec3 flat(wishDirection.x, 0.0f, wishDirection.z);
+    float length = flat.length();
+    wishX[slot] = length > kMinMove ? flat.x / length : 0.0f;
+    wishZ[slot] = length > kMinMove ? flat.z / length : 0.0f;
+    wishSpeed[slot] = length > kMinMove ? std::min(speed, settings.maxSpeed) : 0.0f;
+    jumpRequested[slot] = jump ? 1 : 0;
+}
+
+void CharacterSystem::teleport(CharacterId id, const Vec3& position) {
+    size_t slot = slotOf(id);
+    positionX[slot] = position.x;
+    positionY[slot] = position.y;
+    positionZ[slot] = position.z;
+    grounded[slot] = 0;
+}
+
+void CharacterSystem::setVelocity(CharacterId id, const Vec3& velocity) {
+    size_t slot = slotOf(id);
+    velocityX[slot] = velocity.x;
+    velocityY[slot] = velocity.y;
+    velocityZ[slot] = velocity.z;
+}
+
+Vec3 CharacterSystem::getPosition(CharacterId id) const {
+    size_t slot = slotOf(id);
+    return Vec3(positionX[slot], positionY[slot], positionZ[slot]);
+}
+
+Vec3 CharacterSystem::getVelocity(CharacterId id) const {
+    size_t slot = slotOf(id);
+    return Vec3(velocityX[slot], velocityY[slot], velocityZ[slot]);
+}
+
+bool CharacterSystem::isGrounded(CharacterId id) const {
+    return grounded[slotOf(id)] != 0;
+}
+
+AABB CharacterSystem::getBounds(CharacterId id) const {
+    size_t slot = slotOf(id);
+    return boxAt(Vec3(positionX[slot], positionY[slot], positionZ[slot]),
+                 Vec3(halfExtentX[slot], halfExtentY[slot], halfExtentZ[slot]));
+}
+
+void CharacterSystem::update(const CharacterGeometry& geometry, float deltaTime) {
+    update(geometry, deltaTime, 0, ids.size());
+}
+
+void CharacterSystem::update(const CharacterGeometry& geometry, float deltaTime, size_t begin, size_t end) {
+    for (size_t slot = begin; slot < end; slot++) {
+        updateOne(geometry, deltaTime, slot);
+    }
+}
+
+// One Source-style movement tick: jump, friction and ground acceleration or
+// air acceleration and gravity, then collide and slide. A grounded move also
+// tries the same move lifted by stepHeight and keeps whichever gets further,
+// then snaps back down to the ground.
+void CharacterSystem::updateOne(const CharacterGeometry& geometry, float deltaTime, size_t slot) {
+    Body body{Vec3(positionX[slot], positionY[slot], positionZ[slot]),
+              Vec3(velocityX[slot], velocityY[slot], velocityZ[slot]),
+              Vec3(halfExtentX[slot], halfExtentY[slot], halfExtentZ[slot]), filters[slot]};
+    depenetrate(geometry, body);
+
+    Vec3 wish(wishX[slot], 0.0f, wishZ[slot]);
+    bool walking = grounded[slot] != 0;
+    if (walking && jumpRequested[slot]) {
+        body.velocity.y = settings.jumpSpeed;
+        jumpRequested[slot] = 0;
+        walking = false;
+    }
+    if (walking) {
+        body.velocity.y = 0.0f;
+        applyFriction(body.velocity, deltaTime);
+        accelerate(body.velocity, wish, wishSpeed[slot], settings.groundAcceleration, deltaTime);
+    } else {
+        accelerate(body.velocity, wish, std::min(wishSpeed[slot], settings.airSpeedCap), settings.airAcceleration,
+                   deltaTime);
+        body.velocity += geometry.gravity * deltaTime;
+    }
+
+    Vec3 delta = body.velocity * deltaTime;
+    bool onGround;
+    if (walking) {
+        Vec3 start = body.position;
+        Body flat = body;
+        onGround = slide(geometry, flat, delta);
+        float flatProgress = horizontalDistance(start, flat.position);
+        Body stepped = body;
+        if (flatProgress + kMinMove < horizontalDistance(Vec3(), delta) && stepUp(geometry, stepped, delta) &&
+            horizontalDistance(start, stepped.position) > flatProgress + kMinMove) {
+            body = stepped;
+            onGround = true;
+        } else {
+            body = flat;
+        }
+        if (!onGround) {
+            onGround = snapToGround(geometry, body);
+        }
+    } else {
+        onGround = slide(geometry, body, delta) && body.velocity.y <= 0.0f;
+    }
+    if (onGround) {
+        body.velocity.y = 0.0f;
+    }
+
+    positionX[slot] = body.position.x;
+    positionY[slot] = body.position.y;
+    positionZ[slot] = body.position.z;
+    velocityX[slot] = body.velocity.x;
+    velocityY[slot] = body.velocity.y;
+    velocityZ[slot] = body.velocity.z;
+    grounded[slot] = onGround ? 1 : 0;
+}
+
+// Nearest hit along delta among the baked bodies the swept box overlaps.
+bool CharacterSystem::sweep(const CharacterGeometry& geometry, const Body& body, const Vec3& delta, Hit& hit) const {
+    if (!geometry.bvh) return false;
+    AABB start = boxAt(body.position, body.halfExtents);
+    AABB end = boxAt(body.position + delta, body.halfExtents);
+    AABB swept(Vec3(std::min(start.min.x, end.min.x), std::min(start.min.y, end.min.y), std::min(start.min.z, end.min.z)),
+               Vec3(std::max(start.max.x, end.max.x), std::max(start.max.y, end.max.y), std::max(start.max.z, end.max.z)));
+    bool found = false;
+    hit.time = 2.0f;
+    geometry.bvh->query(swept, [&](uint32_t slot) {
+        if (!CollisionFilter::shouldCollide(body.filter, geometry.filters[slot])) return;
+        float time;
+        Vec3 normal;
+        if (sweepBox(body.position, body.halfExtents, delta, geometry.bounds[slot], time, normal) && time < hit.time) {
+            hit.time = time;
+            hit.normal = normal;
+            found = true;
+        }
+    });
+    return found;
+}
+
+// Pushes the box out of any geometry it starts inside (spawned in a wall,
+// or left there by a teleport) along the axis of least penetration.
+void CharacterSystem::depenetrate(const CharacterGeometry& geometry, Body& body) const {
+    if (!geometry.bvh) return;
+    for (int pass = 0; pass < kMaxDepenetrationPasses; pass++) {
+        bool moved = false;
+        geometry.bvh->query(boxAt(body.position, body.halfExtents), [&](uint32_t slot) {
+            if (moved || !CollisionFilter::shouldCollide(body.filter, geometry.filters[slot])) return;
+            AABB box = boxAt(body.position, body.halfExtents);
+            const AABB& other = geometry.bounds[slot];
+            float push[3] = {other.max.x - box.min.x, other.max.y - box.min.y, other.max.z - box.min.z};
+            float pull[3] = {box.max.x - other.min.x, box.max.y - other.min.y, box.max.z - other.min.z};
+            int axis = -1;
+            float depth = 0.0f;
+            float sign = 0.0f;
+            for (int i = 0; i < 3; i++) {
+                if (push[i] <= 0.0f || pull[i] <= 0.0f) return;
+                if (axis < 0 || push[i] < depth) {
+                    axis = i;
+                    depth = push[i];
+                    sign = 1.0f;
+                }
+                if (pull[i] < depth) {
+                    axis = i;
+                    depth = pull[i];
+                    sign = -1.0f;
+                }
+            }
+            float offset = sign * (depth + settings.skinWidth);
+            body.position += Vec3(axis == 0 ? offset : 0.0f, axis == 1 ? offset : 0.0f, axis == 2 ? offset : 0.0f);
+            moved = true;
+        });
+        if (!moved) return;
+    }
+}
+
+bool CharacterSystem::slide(const CharacterGeometry& geometry, Body& body, Vec3 delta) const {
+    bool hitGround = false;
+    for (int i = 0; i < kMaxSlideIterations; i++) {
+        float length = delta.length();
+        if (length < kMinMove) break;
+        Hit hit;
+        if (!sweep(geometry, body, delta, hit)) {
+            body.position += delta;
+            break;
+        }
+        // Stop skinWidth short of the hit, then slide the rest along it.
+        float time = std::max(0.0f, hit.time - settings.skinWidth / length);
+        body.position += delta * time;
+        Vec3 rest = delta * (1.0f - time);
+        float into = rest.dot(hit.normal);
+        if (into < 0.0f) rest += hit.normal * -into;
+        float speedInto = body.velocity.dot(hit.normal);
+        if (speedInto < 0.0f) body.velocity += hit.normal * -speedInto;
+        if (hit.normal.y >= settings.minGroundNormalY) hitGround = true;
+        delta = rest;
+    }
+    return hitGround;
+}
+
+// Up by stepHeight (or less under a ceiling), across, then down onto ground.
+// Fails if the box does not land on ground.
+bool CharacterSystem::stepUp(const CharacterGeometry& geometry, Body& body, const Vec3& delta) const {
+    Hit hit;
+    float up = settings.stepHeight;
+    if (sweep(geometry, body, Vec3(0, up, 0), hit)) {
+        up = std::max(0.0f, hit.time * up - settings.skinWidth);
+    }
+    if (up <= settings.skinWidth) return false;
+    body.position.y += up;
+    slide(geometry, body, Vec3(delta.x, 0.0f, delta.z));
+    float down = up + settings.skinWidth;
+    if (!sweep(geometry, body, Vec3(0, -down, 0), hit) || hit.normal.y < settings.minGroundNormalY) return false;
+    body.position.y -= std::max(0.0f, hit.time * down - settings.skinWidth);
+    return true;
+}
+
+bool CharacterSystem::snapToGround(const CharacterGeometry& geometry, Body& body) const {
+    Hit hit;
+    float down = settings.snapDistance;
+    if (!sweep(geometry, body, Vec3(0, -down, 0), hit) || hit.normal.y < settings.minGroundNormalY) return false;
+    body.position.y -= std::max(0.0f, hit.time * down - settings.skinWidth);
+    return true;
+}
+
+// Quake acceleration: only the speed along the wish direction is limited,
+// so turning while accelerating sideways keeps adding speed.
+void CharacterSystem::accelerate(Vec3& velocity, const Vec3& wishDirection, float speed, float acceleration,
+                                 float deltaTime) const {
+    float current = velocity.dot(wishDirection);
+    float add = speed - current;
+    if (add <= 0.0f) return;
+    float change = std::min(acceleration * deltaTime * speed, add);
+    velocity += wishDirection * change;
+}
+
+void CharacterSystem::applyFriction(Vec3& velocity, float deltaTime) const {
+    float speed = velocity.length();
+    if (speed < kMinMove) {
+        velocity = Vec3();
+        return;
+    }
+    float drop = std::max(speed, settings.stopSpeed) * settings.friction * deltaTime;
+    velocity *= std::max(0.0f, speed - drop) / speed;
+}
+
+}
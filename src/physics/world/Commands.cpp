@@ -0,0 +1,117 @@
+#include "physics/world/Commands.h"
+#include <algorithm>
+
+namespace physics::world {
+
+using Vec3 = physics::math::Vec3;
+using RigidBody = physics::dynamics::RigidBody;
+
+CommandBatch::~CommandBatch() {
+    for (const Command& command : commands) {
+        delete command.spawn;
+    }
+}
+
+CommandWriter::CommandWriter(CommandBuffer& buffer, uint32_t key)
+    : buffer(&buffer), key(static_cast<uint64_t>(key) << 32), sequence(0) {}
+
+CommandWriter::CommandWriter(CommandWriter&& other) noexcept
+    : buffer(other.buffer), key(other.key), sequence(other.sequence), batch(std::move(other.batch)) {}
+
+CommandWriter::~CommandWriter() {
+    flush();
+}
+
+void CommandWriter::record(CommandType type, BodyId id, const Vec3& value, float mass, RigidBody* spawn,
+                           BodyId* spawnedId) {
+    if (!batch) {
+        batch = std::make_unique<CommandBatch>();
+        batch->commands.reserve(kBatchSize);
+    }
+    batch->commands.push_back(Command{key | sequence++, type, id, value, mass, spawn, spawnedId});
+    if (batch->commands.size() >= kBatchSize) {
+        flush();
+    }
+}
+
+void CommandWriter::spawn(std::unique_ptr<RigidBody> body, BodyId* spawnedId) {
+    record(CommandType::Spawn, InvalidBodyId, Vec3(), 0.0f, body.release(), spawnedId);
+}
+
+void CommandWriter::despawn(BodyId id) {
+    record(CommandType::Despawn, id, Vec3(), 0.0f, nullptr, nullptr);
+}
+
+void CommandWriter::applyImpulse(BodyId id, const Vec3& impulse) {
+    record(CommandType::ApplyImpulse, id, impulse, 0.0f, nullptr, nullptr);
+}
+
+void CommandWriter::applyForce(BodyId id, const Vec3& force) {
+    record(CommandType::ApplyForce, id, force, 0.0f, nullptr, nullptr);
+}
+
+void CommandWriter::teleport(BodyId id, const Vec3& position) {
+    record(CommandType::Teleport, id, position, 0.0f, nullptr, nullptr);
+}
+
+void CommandWriter::setMass(BodyId id, float mass) {
+    record(CommandType::SetMass, id, Vec3(), mass, nullptr, nullptr);
+}
+
+void CommandWriter::flush() {
+    if (batch && !batch->commands.empty()) {
+        buffer->publish(std::move(batch));
+    }
+}
+
+CommandBuffer::CommandBuffer() : head(nullptr) {}
+
+CommandBuffer::~CommandBuffer() {
+    CommandBatch* batch = head.exchange(nullptr, std::memory_order_acquire);
+    while (batch) {
+        CommandBatch* next = batch->next;
+        delete batch;
+        batch = next;
+    }
+}
+
+CommandWriter CommandBuffer::writer(uint32_t key) {
+    return CommandWriter(*this, key);
+}
+
+// Treiber stack push. Batches are never popped one by one, only taken as a
+// whole, so there is no ABA problem.
+void CommandBuffer::publish(std::unique_ptr<CommandBatch> batch) {
+    CommandBatch* node = batch.release();
+    node->next = head.load(std::memory_order_relaxed);
+    while (!head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) {
+    }
+}
+
+void CommandBuffer::take(std::vector<Command>& out) {
+    out.clear();
+    CommandBatch* first = head.exchange(nullptr, std::memory_order_acquire);
+    size_t count = 0;
+    for (CommandBatch* batch = first; batch; batch = batch->next) {
+        count += batch->commands.size();
+    }
+    out.reserve(count);
+    CommandBatch* batch = first;
+    while (batch) {
+        out.insert(out.end(), batch->commands.begin(), batch->commands.end());
+        // The spawned bodies now belong to out.
+        for (Command& command : batch->commands) {
+            command.spawn = nullptr;
+        }
+        CommandBatch* next = batch->next;
+        delete batch;
+        batch = next;
+    }
+    std::sort(out.begin(), out.end(), [](const Command& a, const Command& b) { return a.order < b.order; });
+}
+
+bool CommandBuffer::empty() const {
+    return head.load(std::memory_order_relaxed) == nullptr;
+}
+
+}
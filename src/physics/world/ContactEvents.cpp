@@ -0,0 +1,92 @@
+#include "physics/world/ContactEvents.h"
+#include <algorithm>
+
+namespace physics::world {
+
+using Contact = physics::collision::Contact;
+using CollisionInfo = physics::collision::CollisionInfo;
+
+namespace {
+// Order-independent key, so a pair keeps its key when the broadphase lists
+// it the other way round.
+uint64_t pairKey(BodyId a, BodyId b) {
+    BodyId low = std::min(a, b);
+    BodyId high = std::max(a, b);
+    return (static_cast<uint64_t>(low) << 32) | high;
+}
+}
+
+void ContactEventStream::update(std::span<const Contact> contacts, std::span<const float> impulses,
+                                const BodyId* bodyIds, bool subscribedOnly) {
+    current.clear();
+    for (size_t k = 0; k < contacts.size(); k++) {
+        BodyId a = bodyIds[contacts[k].indexA];
+        BodyId b = bodyIds[contacts[k].indexB];
+        if (subscribedOnly && !isSubscribed(a) && !isSubscribed(b)) continue;
+        current.push_back({pairKey(a, b), static_cast<uint32_t>(k)});
+    }
+    std::sort(current.begin(), current.end(),
+              [](const CurrentContact& lhs, const CurrentContact& rhs) { return lhs.key < rhs.key; });
+
+    events.clear();
+    nextTracked.clear();
+    auto began = [&](const CurrentContact& entry, ContactEventType type) {
+        const Contact& contact = contacts[entry.contact];
+        BodyId a = bodyIds[contact.indexA];
+        BodyId b = bodyIds[contact.indexB];
+        float impulse = entry.contact < impulses.size() ? impulses[entry.contact] : 0.0f;
+        events.push_back({type, a, b, contact.info, impulse});
+        nextTracked.push_back({entry.key, a, b, contact.info, false});
+    };
+    auto ended = [&](const TrackedPair& pair) {
+        events.push_back({ContactEventType::Ended, pair.bodyA, pair.bodyB, pair.info, 0.0f});
+    };
+
+    size_t i = 0;
+    size_t j = 0;
+    while (i < tracked.size() || j < current.size()) {
+        if (j == current.size() || (i < tracked.size() && (tracked[i].removed || tracked[i].key < current[j].key))) {
+            ended(tracked[i++]);
+        } else if (i == tracked.size() || current[j].key < tracked[i].key) {
+            began(current[j++], ContactEventType::Began);
+        } else {
+            i++;
+            began(current[j++], ContactEventType::Persisted);
+        }
+    }
+    tracked.swap(nextTracked);
+}
+
+void ContactEventStream::subscribe(BodyId id, bool subscribed) {
+    if (id >= subscriptions.size()) {
+        if (!subscribed) return;
+        subscriptions.resize(id + 1, 0);
+    }
+    subscriptions[id] = subscribed ? 1 : 0;
+}
+
+bool ContactEventStream::isSubscribed(BodyId id) const {
+    return id < subscriptions.size() && subscriptions[id] != 0;
+}
+
+void ContactEventStream::markAllRemoved() {
+    for (TrackedPair& pair : tracked) {
+        pair.removed = true;
+    }
+    subscriptions.clear();
+}
+
+void ContactEventStream::reset() {
+    tracked.clear();
+    events.clear();
+}
+
+std::span<const ContactEvent> ContactEventStream::getEvents() const {
+    return std::span<const ContactEvent>(events.data(), events.size());
+}
+
+size_t ContactEventStream::getTrackedPairCount() const {
+    return tracked.size();
+}
+
+}
@@ -0,0 +1,300 @@
+#include "physics/world/DomainDecomposition.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+
+namespace physics::world {
+
+using Vec3 = physics::math::Vec3;
+using RigidBody = physics::dynamics::RigidBody;
+using SharedRingBuffer = physics::parallel::SharedRingBuffer;
+using ConvexHull = physics::collision::ConvexHull;
+using ShapeType = physics::collision::ShapeType;
+
+namespace {
+const uint32_t kLowerNeighbor = 0;
+const uint32_t kUpperNeighbor = 1;
+const uint32_t kFlagStatic = 1 << 0;
+const uint32_t kFlagOnGround = 1 << 1;
+const uint32_t kNoHull = 0xFFFFFFFFu;
+}
+
+float SlabLayout::coordinate(const Vec3& position) const {
+    return axis == 0 ? position.x : (axis == 1 ? position.y : position.z);
+}
+
+uint32_t SlabLayout::domainOf(const Vec3& position) const {
+    float slab = std::floor((coordinate(position) - origin) / slabWidth);
+    if (slab < 0.0f) return 0;
+    if (slab >= static_cast<float>(domainCount)) return domainCount - 1;
+    return static_cast<uint32_t>(slab);
+}
+
+float SlabLayout::lowerBound(uint32_t domain) const {
+    return origin + slabWidth * static_cast<float>(domain);
+}
+
+float SlabLayout::upperBound(uint32_t domain) const {
+    return origin + slabWidth * static_cast<float>(domain + 1);
+}
+
+std::string SharedMemoryTransport::ringName(const std::string& prefix, uint32_t from, uint32_t to) {
+    return prefix + "_" + std::to_string(from) + "_" + std::to_string(to);
+}
+
+void SharedMemoryTransport::createRings(const std::string& prefix, uint32_t domainCount, size_t slotCount) {
+    for (uint32_t d = 0; d + 1 < domainCount; d++) {
+        SharedRingBuffer::create(ringName(prefix, d, d + 1), sizeof(DomainMessage), slotCount);
+        SharedRingBuffer::create(ringName(prefix, d + 1, d), sizeof(DomainMessage), slotCount);
+    }
+}
+
+void SharedMemoryTransport::unlinkRings(const std::string& prefix, uint32_t domainCount) {
+    for (uint32_t d = 0; d + 1 < domainCount; d++) {
+        SharedRingBuffer::unlink(ringName(prefix, d, d + 1));
+        SharedRingBuffer::unlink(ringName(prefix, d + 1, d));
+    }
+}
+
+SharedMemoryTransport::SharedMemoryTransport(const std::string& prefix, uint32_t domain, uint32_t domainCount) {
+    if (domain > 0) {
+        outgoing[kLowerNeighbor] = SharedRingBuffer::open(ringName(prefix, domain, domain - 1));
+        incoming[kLowerNeighbor] = SharedRingBuffer::open(ringName(prefix, domain - 1, domain));
+    }
+    if (domain + 1 < domainCount) {
+        outgoing[kUpperNeighbor] = SharedRingBuffer::open(ringName(prefix, domain, domain + 1));
+        incoming[kUpperNeighbor] = SharedRingBuffer::open(ringName(prefix, domain + 1, domain));
+    }
+}
+
+bool SharedMemoryTransport::hasNeighbor(uint32_t neighbor) const {
+    return neighbor < 2 && outgoing[neighbor].isValid();
+}
+
+bool SharedMemoryTransport::trySend(uint32_t neighbor, const DomainMessage& message) {
+    return outgoing[neighbor].push(&message);
+}
+
+bool SharedMemoryTransport::tryReceive(uint32_t neighbor, DomainMessage& message) {
+    return incoming[neighbor].pop(&message);
+}
+
+DomainNode::DomainNode(World& world, const SlabLayout& layout, uint32_t domain, DomainTransport& transport)
+    : exchangeTimeout(10000), world(world), layout(layout), domain(domain), transport(transport), frame(0),
+      lastGhostCount(0), lastMigratedIn(0), lastMigratedOut(0) {}
+
+void DomainNode::registerHull(const ConvexHull& hull) {
+    hulls.push_back(&hull);
+}
+
+DomainMessage DomainNode::packBody(const RigidBody& body, DomainMessage::Kind kind, uint32_t frame,
+                                   std::span<const ConvexHull* const> hulls) {
+    DomainMessage message{};
+    message.kind = kind;
+    message.frame = frame;
+    message.position[0] = body.position.x;
+    message.position[1] = body.position.y;
+    message.position[2] = body.position.z;
+    message.velocity[0] = body.velocity.x;
+    message.velocity[1] = body.velocity.y;
+    message.velocity[2] = body.velocity.z;
+    message.size[0] = body.size.x;
+    message.size[1] = body.size.y;
+    message.size[2] = body.size.z;
+    message.mass = body.mass;
+    message.friction = body.friction;
+    message.restitution = body.restitution;
+    message.flags = (body.isStatic ? kFlagStatic : 0) | (body.onGround ? kFlagOnGround : 0);
+
+    const physics::collision::Shape& shape = body.shape;
+    ShapeType type = shape.type;
+    message.hullIndex = kNoHull;
+    if (type == ShapeType::ConvexHull) {
+        auto found = std::find(hulls.begin(), hulls.end(), shape.hull);
+        if (found == hulls.end()) {
+            // size covers the hull, so the receiver gets a conservative box.
+            type = ShapeType::Box;
+        } else {
+            message.hullIndex = static_cast<uint32_t>(found - hulls.begin());
+        }
+    }
+    message.shapeType = static_cast<uint32_t>(type);
+    message.shapeRadius = shape.radius;
+    message.shapeHalfHeight = shape.halfHeight;
+    message.shapeHalfExtents[0] = shape.halfExtents.x;
+    message.shapeHalfExtents[1] = shape.halfExtents.y;
+    message.shapeHalfExtents[2] = shape.halfExtents.z;
+    for (int axis = 0; axis < 3; axis++) {
+        message.shapeAxes[axis * 3 + 0] = shape.axes[axis].x;
+        message.shapeAxes[axis * 3 + 1] = shape.axes[axis].y;
+        message.shapeAxes[axis * 3 + 2] = shape.axes[axis].z;
+    }
+    message.filterCategory = body.filter.category;
+    message.filterMask = body.filter.mask;
+    message.filterGroup = body.filter.group;
+    return message;
+}
+
+RigidBody DomainNode::unpackBody(const DomainMessage& message, std::span<const ConvexHull* const> hulls) {
+    RigidBody body(Vec3(message.position[0], message.position[1], message.position[2]),
+                   Vec3(message.size[0], message.size[1], message.size[2]),
+                   (message.flags & kFlagStatic) ? 0.0f : message.mass);
+    body.velocity = Vec3(message.velocity[0], message.velocity[1], message.velocity[2]);
+    body.friction = message.friction;
+    body.restitution = message.restitution;
+    body.onGround = (message.flags & kFlagOnGround) != 0;
+
+    // size already matches the shape, so it is assigned rather than set.
+    physics::collision::Shape& shape = body.shape;
+    shape.type = message.shapeType < physics::collision::ShapeTypeCount ? static_cast<ShapeType>(message.shapeType)
+                                                                       : ShapeType::Box;
+    shape.radius = message.shapeRadius;
+    shape.halfHeight = message.shapeHalfHeight;
+    shape.halfExtents = Vec3(message.shapeHalfExtents[0], message.shapeHalfExtents[1], message.shapeHalfExtents[2]);
+    for (int axis = 0; axis < 3; axis++) {
+        shape.axes[axis] = Vec3(message.shapeAxes[axis * 3 + 0], message.shapeAxes[axis * 3 + 1],
+                                message.shapeAxes[axis * 3 + 2]);
+    }
+    if (shape.type == ShapeType::ConvexHull) {
+        if (message.hullIndex < hulls.size()) {
+            shape.hull = hulls[message.hullIndex];
+        } else {
+            shape.type = ShapeType::Box;
+        }
+    }
+    body.filter.category = message.filterCategory;
+    body.filter.mask = message.filterMask;
+    body.filter.group = message.filterGroup;
+    return body;
+}
+
+void DomainNode::step(float deltaTime) {
+    exchange();
+    world.step(deltaTime);
+    world.removeBodies(ghostIds);
+    lastGhostCount = ghostIds.size();
+    ghostIds.clear();
+    frame++;
+}
+
+void DomainNode::exchange() {
+    uint32_t frameTag = static_cast<uint32_t>(frame);
+    float lower = layout.lowerBound(domain);
+    float upper = layout.upperBound(domain);
+
+    outbox[kLowerNeighbor].clear();
+    outbox[kUpperNeighbor].clear();
+    leavingIds.clear();
+    ghostIds.clear();
+
+    for (size_t i = 0; i < world.getBodyCount(); i++) {
+        const RigidBody& body = *world.getBody(i);
+        uint32_t owner = layout.domainOf(body.position);
+        if (owner != domain) {
+            uint32_t neighbor = owner < domain ? kLowerNeighbor : kUpperNeighbor;
+            if (transport.hasNeighbor(neighbor)) {
+                outbox[neighbor].push_back(packBody(body, DomainMessage::Migrate, frameTag, hulls));
+                leavingIds.push_back(world.getBodyId(i));
+            }
+            continue;
+        }
+
+        float c = layout.coordinate(body.position);
+        if (c - lower < layout.haloWidth && transport.hasNeighbor(kLowerNeighbor)) {
+            outbox[kLowerNeighbor].push_back(packBody(body, DomainMessage::Ghost, frameTag, hulls));
+        }
+        if (upper - c < layout.haloWidth && transport.hasNeighbor(kUpperNeighbor)) {
+            outbox[kUpperNeighbor].push_back(packBody(body, DomainMessage::Ghost, frameTag, hulls));
+        }
+    }
+    lastMigratedOut = leavingIds.size();
+    world.removeBodies(leavingIds);
+
+    DomainMessage endOfFrame{};
+    endOfFrame.kind = DomainMessage::EndOfFrame;
+    endOfFrame.frame = frameTag;
+
+    size_t sent[2] = {0, 0};
+    bool finished[2] = {!transport.hasNeighbor(kLowerNeighbor), !transport.hasNeighbor(kUpperNeighbor)};
+    bool received[2] = {finished[0], finished[1]};
+    for (uint32_t n = 0; n < 2; n++) {
+        if (!finished[n]) outbox[n].push_back(endOfFrame);
+    }
+
+    lastMigratedIn = 0;
+    // Interleave sends and receives so a full ring in one direction can never
+    // stall both sides.
+    auto lastProgress = std::chrono::steady_clock::now();
+    while (!(finished[0] && finished[1] && received[0] && received[1])) {
+        bool progress = false;
+        for (uint32_t n = 0; n < 2; n++) {
+            while (!finished[n] && transport.trySend(n, outbox[n][sent[n]])) {
+                progress = true;
+                if (++sent[n] == outbox[n].size()) finished[n] = true;
+            }
+
+            DomainMessage message;
+            while (!received[n] && transport.tryReceive(n, message)) {
+                progress = true;
+                // Neighbours step in lock-step, so anything else means a
+                // lost or duplicated EndOfFrame.
+                if (message.frame != frameTag) {
+                    throw std::runtime_error("domain " + std::to_string(domain) + ": message from the " +
+                                             (n == kLowerNeighbor ? "lower" : "upper") + " neighbour for frame " +
+                                             std::to_string(message.frame) + " during frame " +
+                                             std::to_string(frameTag));
+                }
+                if (message.kind == DomainMessage::EndOfFrame) {
+                    received[n] = true;
+                    break;
+                }
+                BodyId id = world.addBody(std::make_unique<RigidBody>(unpackBody(message, hulls)));
+                if (message.kind == DomainMessage::Ghost) {
+                    ghostIds.push_back(id);
+                } else {
+                    lastMigratedIn++;
+                }
+            }
+        }
+        if (progress) {
+            lastProgress = std::chrono::steady_clock::now();
+            continue;
+        }
+        if (exchangeTimeout.count() > 0 && std::chrono::steady_clock::now() - lastProgress > exchangeTimeout) {
+            uint32_t neighbor = !(finished[0] && received[0]) ? kLowerNeighbor : kUpperNeighbor;
+            throw std::runtime_error("domain " + std::to_string(domain) + ": no message from or to the " +
+                                     (neighbor == kLowerNeighbor ? "lower" : "upper") + " neighbour for frame " +
+                                     std::to_string(frameTag));
+        }
+        std::this_thread::yield();
+    }
+}
+
+uint32_t DomainNode::getDomain() const {
+    return domain;
+}
+
+uint64_t DomainNode::getFrame() const {
+    return frame;
+}
+
+// Ghosts only exist inside step(), so between steps the world holds owned
+// bodies only.
+size_t DomainNode::getOwnedBodyCount() const {
+    return world.getBodyCount();
+}
+
+size_t DomainNode::getLastGhostCount() const {
+    return lastGhostCount;
+}
+
+size_t DomainNode::getLastMigratedInCount() const {
+    return lastMigratedIn;
+}
+
+size_t DomainNode::getLastMigratedOutCount() const {
+    return lastMigratedOut;
+}
+
+}
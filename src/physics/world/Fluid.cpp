@@ -0,0 +1,788 @@
+#include "physics/world/Fluid.h"
+#include "physics/collision/BatchNarrowphase.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <numbers>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PHYSICS_HAS_AVX2_KERNEL 1
+#endif
+
+namespace physics::world {
+
+using Vec3 = physics::math::Vec3;
+using AABB = physics::collision::AABB;
+using RigidBody = physics::dynamics::RigidBody;
+
+namespace {
+// Particles per task. Density and force passes cost a few hundred
+// neighbour tests per particle, so chunks are smaller than the particle
+// system's.
+const size_t kFluidChunkSize = 4096;
+const size_t kLaneCount = 8;
+// Pairs closer than this exert no pressure on each other; the direction
+// between them is undefined.
+const float kMinDistanceSquared = 1e-12f;
+const size_t kMinTableSize = 1024;
+
+struct FluidArrays {
+    const float* x;
+    const float* y;
+    const float* z;
+    const float* vx;
+    const float* vy;
+    const float* vz;
+    const float* inverseDensity;
+    const float* pressure;
+};
+
+struct CellRange {
+    uint32_t begin;
+    uint32_t end;
+};
+
+// The particles of the 27 neighbouring cells: one run per row of three
+// cells along x, split where a row wraps around the table and merged where
+// rows share keys, so at most 18.
+struct Neighbourhood {
+    int cell[3];
+    CellRange ranges[18];
+    size_t count;
+};
+
+int cellCoordinate(float value, float inverseCellSize) {
+    return static_cast<int>(std::floor(value * inverseCellSize));
+}
+
+// Rows along x are hashed and x is added, so neighbouring cells in a row
+// have consecutive keys and their particles are one contiguous run.
+uint32_t hashCell(int x, int y, int z, uint32_t mask) {
+    return (((static_cast<uint32_t>(y) * 19349663u) ^ (static_cast<uint32_t>(z) * 83492791u)) +
+            static_cast<uint32_t>(x)) & mask;
+}
+
+void gatherNeighbourhood(Neighbourhood& hood, const int cell[3], const uint32_t* cellStarts, uint32_t mask) {
+    for (int axis = 0; axis < 3; axis++) {
+        hood.cell[axis] = cell[axis];
+    }
+    // Key intervals of the nine rows, sorted by first key as they come.
+    CellRange keys[18];
+    size_t keyCount = 0;
+    auto insert = [&](uint32_t first, uint32_t last) {
+        size_t k = keyCount++;
+        while (k > 0 && keys[k - 1].begin > first) {
+            keys[k] = keys[k - 1];
+            k--;
+        }
+        keys[k] = CellRange{first, last};
+    };
+    for (int dz = -1; dz <= 1; dz++) {
+        for (int dy = -1; dy <= 1; dy++) {
+            uint32_t first = hashCell(cell[0] - 1, cell[1] + dy, cell[2] + dz, mask);
+            uint32_t last = first + 2;
+            if (last > mask) {
+                insert(first, mask);
+                insert(0, last & mask);
+            } else {
+                insert(first, last);
+            }
+        }
+    }
+    hood.count = 0;
+    uint32_t first = keys[0].begin;
+    uint32_t last = keys[0].end;
+    for (size_t k = 1; k <= keyCount; k++) {
+        if (k < keyCount && keys[k].begin <= last + 1) {
+            last = std::max(last, keys[k].end);
+            continue;
+        }
+        if (cellStarts[first] != cellStarts[last + 1]) {
+            hood.ranges[hood.count++] = CellRange{cellStarts[first], cellStarts[last + 1]};
+        }
+        if (k < keyCount) {
+            first = keys[k].begin;
+            last = keys[k].end;
+        }
+    }
+}
+
+// Both kernels keep one partial sum per SIMD lane and reduce them in this
+// order, so scalar and AVX2 results are identical.
+float sumLanes(const float* lanes) {
+    return ((lanes[0] + lanes[4]) + (lanes[2] + lanes[6])) + ((lanes[1] + lanes[5]) + (lanes[3] + lanes[7]));
+}
+
+// Scalar reference kernels. Neighbours are taken in groups of eight from
+// the start of each cell's run; lane l of a group always adds to partial
+// sum l, and lanes past the end of the run add zero.
+template <typename Params>
+float densityScalar(const FluidArrays& p, size_t i, const Neighbourhood& hood, const Params& params) {
+    float lanes[kLaneCount] = {};
+    float xi = p.x[i], yi = p.y[i], zi = p.z[i];
+    for (size_t c = 0; c < hood.count; c++) {
+        const CellRange& range = hood.ranges[c];
+        for (uint32_t base = range.begin; base < range.end; base += kLaneCount) {
+            for (size_t l = 0; l < kLaneCount; l++) {
+                uint32_t j = base + static_cast<uint32_t>(l);
+                float term = 0.0f;
+                if (j < range.end) {
+                    float dx = xi - p.x[j];
+                    float dy = yi - p.y[j];
+                    float dz = zi - p.z[j];
+                    float r2 = (dx * dx + dy * dy) + dz * dz;
+                    if (r2 < params.radiusSquared) {
+                        float d = params.radiusSquared - r2;
+                        term = (d * d) * d;
+                    }
+                }
+                lanes[l] += term;
+            }
+        }
+    }
+    return sumLanes(lanes) * params.densityScale;
+}
+
+template <typename Params>
+Vec3 accelerationScalar(const FluidArrays& p, size_t i, const Neighbourhood& hood, const Params& params) {
+    float lanesX[kLaneCount] = {};
+    float lanesY[kLaneCount] = {};
+    float lanesZ[kLaneCount] = {};
+    float xi = p.x[i], yi = p.y[i], zi = p.z[i];
+    float vxi = p.vx[i], vyi = p.vy[i], vzi = p.vz[i];
+    float pi = p.pressure[i];
+    for (size_t c = 0; c < hood.count; c++) {
+        const CellRange& range = hood.ranges[c];
+        for (uint32_t base = range.begin; base < range.end; base += kLaneCount) {
+            for (size_t l = 0; l < kLaneCount; l++) {
+                uint32_t j = base + static_cast<uint32_t>(l);
+                float ax = 0.0f, ay = 0.0f, az = 0.0f;
+                if (j < range.end) {
+                    float dx = xi - p.x[j];
+                    float dy = yi - p.y[j];
+                    float dz = zi - p.z[j];
+                    float r2 = (dx * dx + dy * dy) + dz * dz;
+                    if (r2 < params.radiusSquared && r2 > kMinDistanceSquared) {
+                        float r = std::sqrt(r2);
+                        float q = params.radius - r;
+                        float shared = (pi + p.pressure[j]) * p.inverseDensity[j];
+                        float pressureWeight = (((shared * q) * q) / r) * params.pressureScale;
+                        float viscosityWeight = (q * p.inverseDensity[j]) * params.viscosityScale;
+                        ax = pressureWeight * dx + viscosityWeight * (p.vx[j] - vxi);
+                        ay = pressureWeight * dy + viscosityWeight * (p.vy[j] - vyi);
+                        az = pressureWeight * dz + viscosityWeight * (p.vz[j] - vzi);
+                    }
+                }
+                lanesX[l] += ax;
+                lanesY[l] += ay;
+                lanesZ[l] += az;
+            }
+        }
+    }
+    float inverseDensity = p.inverseDensity[i];
+    return Vec3(sumLanes(lanesX) * inverseDensity, sumLanes(lanesY) * inverseDensity,
+                sumLanes(lanesZ) * inverseDensity);
+}
+
+#ifdef PHYSICS_HAS_AVX2_KERNEL
+// Lanes below count are set.
+__attribute__((target("avx2"))) __m256i laneMask(uint32_t count) {
+    return _mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int>(std::min<uint32_t>(count, kLaneCount))),
+                              _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+}
+
+template <typename Params>
+__attribute__((target("avx2"))) float densityAvx2(const FluidArrays& p, size_t i, const Neighbourhood& hood,
+                                                  const Params& params) {
+    const __m256 xi = _mm256_set1_ps(p.x[i]);
+    const __m256 yi = _mm256_set1_ps(p.y[i]);
+    const __m256 zi = _mm256_set1_ps(p.z[i]);
+    const __m256 radiusSquared = _mm256_set1_ps(params.radiusSquared);
+    __m256 sum = _mm256_setzero_ps();
+    for (size_t c = 0; c < hood.count; c++) {
+        const CellRange& range = hood.ranges[c];
+        for (uint32_t base = range.begin; base < range.end; base += kLaneCount) {
+            __m256i valid = laneMask(range.end - base);
+            __m256 dx = _mm256_sub_ps(xi, _mm256_maskload_ps(p.x + base, valid));
+            __m256 dy = _mm256_sub_ps(yi, _mm256_maskload_ps(p.y + base, valid));
+            __m256 dz = _mm256_sub_ps(zi, _mm256_maskload_ps(p.z + base, valid));
+            __m256 r2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+            __m256 inside = _mm256_and_ps(_mm256_castsi256_ps(valid), _mm256_cmp_ps(r2, radiusSquared, _CMP_LT_OQ));
+            __m256 d = _mm256_sub_ps(radiusSquared, r2);
+            sum = _mm256_add_ps(sum, _mm256_and_ps(inside, _mm256_mul_ps(_mm256_mul_ps(d, d), d)));
+        }
+    }
+    alignas(32) float lanes[kLaneCount];
+    _mm256_store_ps(lanes, sum);
+    return sumLanes(lanes) * params.densityScale;
+}
+
+template <typename Params>
+__attribute__((target("avx2"))) Vec3 accelerationAvx2(const FluidArrays& p, size_t i, const Neighbourhood& hood,
+                                                      const Params& params) {
+    const __m256 xi = _mm256_set1_ps(p.x[i]);
+    const __m256 yi = _mm256_set1_ps(p.y[i]);
+    const __m256 zi = _mm256_set1_ps(p.z[i]);
+    const __m256 vxi = _mm256_set1_ps(p.vx[i]);
+    const __m256 vyi = _mm256_set1_ps(p.vy[i]);
+    const __m256 vzi = _mm256_set1_ps(p.vz[i]);
+    const __m256 pi = _mm256_set1_ps(p.pressure[i]);
+    const __m256 radius = _mm256_set1_ps(params.radius);
+    const __m256 radiusSquared = _mm256_set1_ps(params.radiusSquared);
+    const __m256 minDistanceSquared = _mm256_set1_ps(kMinDistanceSquared);
+    const __m256 pressureScale = _mm256_set1_ps(params.pressureScale);
+    const __m256 viscosityScale = _mm256_set1_ps(params.viscosityScale);
+    __m256 sumX = _mm256_setzero_ps();
+    __m256 sumY = _mm256_setzero_ps();
+    __m256 sumZ = _mm256_setzero_ps();
+    for (size_t c = 0; c < hood.count; c++) {
+        const CellRange& range = hood.ranges[c];
+        for (uint32_t base = range.begin; base < range.end; base += kLaneCount) {
+            __m256i valid = laneMask(range.end - base);
+            __m256 dx = _mm256_sub_ps(xi, _mm256_maskload_ps(p.x + base, valid));
+            __m256 dy = _mm256_sub_ps(yi, _mm256_maskload_ps(p.y + base, valid));
+            __m256 dz = _mm256_sub_ps(zi, _mm256_maskload_ps(p.z + base, valid));
+            __m256 r2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+            __m256 inside = _mm256_and_ps(_mm256_castsi256_ps(valid),
+                                          _mm256_and_ps(_mm256_cmp_ps(r2, radiusSquared, _CMP_LT_OQ),
+                                                        _mm256_cmp_ps(r2, minDistanceSquared, _CMP_GT_OQ)));
+            if (_mm256_movemask_ps(inside) == 0) continue;
+
+            // Lanes outside compute garbage (possibly NaN) that the mask drops.
+            __m256 r = _mm256_sqrt_ps(r2);
+            __m256 q = _mm256_sub_ps(radius, r);
+            __m256 inverseDensity = _mm256_maskload_ps(p.inverseDensity + base, valid);
+            __m256 shared = _mm256_mul_ps(_mm256_add_ps(pi, _mm256_maskload_ps(p.pressure + base, valid)), inverseDensity);
+            __m256 pressureWeight = _mm256_mul_ps(_mm256_div_ps(_mm256_mul_ps(_mm256_mul_ps(shared, q), q), r), pressureScale);
+            __m256 viscosityWeight = _mm256_mul_ps(_mm256_mul_ps(q, inverseDensity), viscosityScale);
+            __m256 dvx = _mm256_sub_ps(_mm256_maskload_ps(p.vx + base, valid), vxi);
+            __m256 dvy = _mm256_sub_ps(_mm256_maskload_ps(p.vy + base, valid), vyi);
+            __m256 dvz = _mm256_sub_ps(_mm256_maskload_ps(p.vz + base, valid), vzi);
+            __m256 ax = _mm256_add_ps(_mm256_mul_ps(pressureWeight, dx), _mm256_mul_ps(viscosityWeight, dvx));
+            __m256 ay = _mm256_add_ps(_mm256_mul_ps(pressureWeight, dy), _mm256_mul_ps(viscosityWeight, dvy));
+            __m256 az = _mm256_add_ps(_mm256_mul_ps(pressureWeight, dz), _mm256_mul_ps(viscosityWeight, dvz));
+            sumX = _mm256_add_ps(sumX, _mm256_and_ps(inside, ax));
+            sumY = _mm256_add_ps(sumY, _mm256_and_ps(inside, ay));
+            sumZ = _mm256_add_ps(sumZ, _mm256_and_ps(inside, az));
+        }
+    }
+    alignas(32) float lanesX[kLaneCount];
+    alignas(32) float lanesY[kLaneCount];
+    alignas(32) float lanesZ[kLaneCount];
+    _mm256_store_ps(lanesX, sumX);
+    _mm256_store_ps(lanesY, sumY);
+    _mm256_store_ps(lanesZ, sumZ);
+    float inverseDensity = p.inverseDensity[i];
+    return Vec3(sumLanes(lanesX) * inverseDensity, sumLanes(lanesY) * inverseDensity,
+                sumLanes(lanesZ) * inverseDensity);
+}
+#endif
+
+// Walls and coupled bodies are modelled as half spaces of fluid at rest
+// density with the particle's own pressure (a mirror boundary), integrated
+// analytically instead of sampled with particles. The half space starts
+// half a particle spacing behind the wall, where the first mirrored layer
+// would be. wallDensity is the poly6 kernel integrated over the half space
+// beyond distance; it is half the rest density at distance zero and zero a
+// kernel radius away.
+float wallDensity(float distance, float radius, float restDensity) {
+    float t = distance / radius;
+    if (t >= 1.0f) return 0.0f;
+    float t2 = t * t;
+    float integral = t * (1.0f - t2 * (4.0f / 3.0f - t2 * (1.2f - t2 * (4.0f / 7.0f - t2 / 9.0f))));
+    return restDensity * (0.5f - (315.0f / 256.0f) * integral);
+}
+
+// The spiky gradient integrated over the same half space: the wall's
+// acceleration on a particle, away from the wall, per unit pressure /
+// density.
+float wallGradient(float distance, float radius) {
+    float t = distance / radius;
+    if (t >= 1.0f) return 0.0f;
+    float u = 1.0f - t;
+    float u4 = (u * u) * (u * u);
+    return (30.0f / radius) * u4 * (0.25f - 0.2f * u);
+}
+
+// Distance from outside a box to the face whose slab the point is in.
+// Points past an edge or a corner are not in any slab and get none; the
+// push out after integration still keeps them from entering.
+bool faceDistance(float x, float y, float z, const AABB& box, int& axis, float& sign, float& distance) {
+    const float below[3] = {box.min.x - x, box.min.y - y, box.min.z - z};
+    const float above[3] = {x - box.max.x, y - box.max.y, z - box.max.z};
+    int outside = 0;
+    for (int a = 0; a < 3; a++) {
+        if (below[a] > 0.0f || above[a] > 0.0f) {
+            outside++;
+            axis = a;
+        }
+    }
+    if (outside != 1) return false;
+    sign = below[axis] > 0.0f ? -1.0f : 1.0f;
+    distance = std::max(below[axis], above[axis]);
+    return true;
+}
+
+// Refreshes hood when particle i is in a different cell from the last one;
+// particles are sorted by cell, so that is rare.
+template <typename Params>
+void updateNeighbourhood(Neighbourhood& hood, bool& valid, float x, float y, float z, const uint32_t* cellStarts,
+                         const Params& params) {
+    int cell[3] = {cellCoordinate(x, params.inverseCellSize), cellCoordinate(y, params.inverseCellSize),
+                   cellCoordinate(z, params.inverseCellSize)};
+    if (valid && cell[0] == hood.cell[0] && cell[1] == hood.cell[1] && cell[2] == hood.cell[2]) return;
+    gatherNeighbourhood(hood, cell, cellStarts, params.tableMask);
+    valid = true;
+}
+}
+
+FluidSystem::FluidSystem() : threadPool(nullptr) {}
+
+size_t FluidSystem::spawn(const Vec3& position, const Vec3& velocity) {
+    positionX.push_back(position.x);
+    positionY.push_back(position.y);
+    positionZ.push_back(position.z);
+    velocityX.push_back(velocity.x);
+    velocityY.push_back(velocity.y);
+    velocityZ.push_back(velocity.z);
+    return positionX.size() - 1;
+}
+
+size_t FluidSystem::spawnBlock(const AABB& region, float spacing, const Vec3& velocity) {
+    if (!(spacing > 0.0f)) return 0;
+    size_t counts[3];
+    const float extents[3] = {region.max.x - region.min.x, region.max.y - region.min.y, region.max.z - region.min.z};
+    for (int axis = 0; axis < 3; axis++) {
+        counts[axis] = extents[axis] > 0.0f ? static_cast<size_t>(extents[axis] / spacing) : 0;
+    }
+    reserve(size() + counts[0] * counts[1] * counts[2]);
+    float half = spacing * 0.5f;
+    for (size_t z = 0; z < counts[2]; z++) {
+        for (size_t y = 0; y < counts[1]; y++) {
+            for (size_t x = 0; x < counts[0]; x++) {
+                spawn(Vec3(region.min.x + half + static_cast<float>(x) * spacing,
+                           region.min.y + half + static_cast<float>(y) * spacing,
+                           region.min.z + half + static_cast<float>(z) * spacing),
+                      velocity);
+            }
+        }
+    }
+    return counts[0] * counts[1] * counts[2];
+}
+
+void FluidSystem::reserve(size_t capacity) {
+    for (std::vector<float>* values : {&positionX, &positionY, &positionZ, &velocityX, &velocityY, &velocityZ}) {
+        values->reserve(capacity);
+    }
+}
+
+void FluidSystem::clear() {
+    for (std::vector<float>* values : {&positionX, &positionY, &positionZ, &velocityX, &velocityY, &velocityZ,
+                                       &density, &inverseDensity, &pressure}) {
+        values->clear();
+    }
+}
+
+void FluidSystem::couple(RigidBody* body) {
+    if (body && std::find(coupled.begin(), coupled.end(), body) == coupled.end()) {
+        coupled.push_back(body);
+    }
+}
+
+void FluidSystem::decouple(RigidBody* body) {
+    coupled.erase(std::remove(coupled.begin(), coupled.end(), body), coupled.end());
+}
+
+void FluidSystem::clearCoupled() {
+    coupled.clear();
+}
+
+void FluidSystem::step(float deltaTime) {
+    run(deltaTime, true);
+}
+
+void FluidSystem::stepScalar(float deltaTime) {
+    run(deltaTime, false);
+}
+
+template <typename Fn>
+void FluidSystem::forEachChunk(Fn&& fn) {
+    size_t chunkCount = (size() + kFluidChunkSize - 1) / kFluidChunkSize;
+    auto chunks = [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; c++) {
+            fn(c);
+        }
+    };
+    if (threadPool) {
+        threadPool->parallelFor(chunkCount, 1, chunks);
+    } else {
+        chunks(0, chunkCount);
+    }
+}
+
+void FluidSystem::run(float deltaTime, bool allowSimd) {
+    size_t count = size();
+    if (count == 0 || !(deltaTime > 0.0f)) return;
+
+    const float h = settings.smoothingRadius;
+    const float pi = std::numbers::pi_v<float>;
+    KernelParams params;
+    params.radius = h;
+    params.radiusSquared = h * h;
+    params.inverseCellSize = 1.0f / h;
+    // Poly6 for density, the spiky gradient for pressure (averaged over the
+    // pair so forces are symmetric) and the viscosity Laplacian.
+    params.densityScale = settings.particleMass * 315.0f / (64.0f * pi * std::pow(h, 9.0f));
+    params.pressureScale = 0.5f * settings.particleMass * 45.0f / (pi * std::pow(h, 6.0f));
+    params.viscosityScale = settings.viscosity * settings.particleMass * 45.0f / (pi * std::pow(h, 6.0f));
+    params.stiffness = settings.stiffness;
+    params.restDensity = settings.restDensity;
+    params.wallOffset = 0.5f * std::cbrt(settings.particleMass / settings.restDensity);
+    params.low[0] = settings.bounds.min.x;
+    params.low[1] = settings.bounds.min.y;
+    params.low[2] = settings.bounds.min.z;
+    params.high[0] = settings.bounds.max.x;
+    params.high[1] = settings.bounds.max.y;
+    params.high[2] = settings.bounds.max.z;
+    size_t tableSize = std::max(kMinTableSize, std::bit_ceil(2 * count));
+    params.tableMask = static_cast<uint32_t>(tableSize - 1);
+
+    cellKeys.resize(count);
+    cellStarts.resize(tableSize + 1);
+    order.resize(count);
+    scratch.resize(count);
+    for (std::vector<float>* values : {&density, &inverseDensity, &pressure, &accelerationX, &accelerationY,
+                                       &accelerationZ}) {
+        values->resize(count);
+    }
+
+    // The tolerance keeps 1/60 s at a 1/300 s limit from rounding up to six.
+    int substeps = static_cast<int>(std::ceil(deltaTime / settings.maxTimeStep - 1e-3f));
+    substeps = std::max(substeps, 1);
+    float substepTime = deltaTime / static_cast<float>(substeps);
+    for (int s = 0; s < substeps; s++) {
+        substep(substepTime, params, allowSimd);
+    }
+}
+
+void FluidSystem::substep(float deltaTime, const KernelParams& params, bool allowSimd) {
+    buildGrid(params);
+    forEachChunk([&](size_t chunk) { densityChunk(chunk, params, allowSimd); });
+    bodyDensity(params);
+    forEachChunk([&](size_t chunk) { forceChunk(chunk, params, allowSimd); });
+    bodyForces(params, deltaTime);
+    forEachChunk([&](size_t chunk) { integrateChunk(chunk, deltaTime); });
+    pushOutOfBodies(params);
+}
+
+// Counting sort by cell key: keys in parallel, then one serial pass to
+// count, one to turn counts into run ends, and one backwards to scatter,
+// which leaves cellStarts[key] at the start of its run and keeps the sort
+// stable. The particle arrays are then gathered into sorted order in
+// parallel.
+void FluidSystem::buildGrid(const KernelParams& params) {
+    size_t count = size();
+    forEachChunk([&](size_t chunk) {
+        size_t begin = chunk * kFluidChunkSize;
+        size_t end = std::min(begin + kFluidChunkSize, count);
+        for (size_t i = begin; i < end; i++) {
+            cellKeys[i] = hashCell(cellCoordinate(positionX[i], params.inverseCellSize),
+                                   cellCoordinate(positionY[i], params.inverseCellSize),
+                                   cellCoordinate(positionZ[i], params.inverseCellSize), params.tableMask);
+        }
+    });
+
+    std::fill(cellStarts.begin(), cellStarts.end(), 0u);
+    for (size_t i = 0; i < count; i++) {
+        cellStarts[cellKeys[i]]++;
+    }
+    uint32_t total = 0;
+    for (size_t key = 0; key + 1 < cellStarts.size(); key++) {
+        total += cellStarts[key];
+        cellStarts[key] = total;
+    }
+    cellStarts.back() = total;
+    for (size_t i = count; i-- > 0;) {
+        order[--cellStarts[cellKeys[i]]] = static_cast<uint32_t>(i);
+    }
+
+    for (std::vector<float>* values : {&positionX, &positionY, &positionZ, &velocityX, &velocityY, &velocityZ}) {
+        forEachChunk([&](size_t chunk) {
+            size_t begin = chunk * kFluidChunkSize;
+            size_t end = std::min(begin + kFluidChunkSize, count);
+            for (size_t i = begin; i < end; i++) {
+                scratch[i] = (*values)[order[i]];
+            }
+        });
+        values->swap(scratch);
+    }
+}
+
+void FluidSystem::densityChunk(size_t chunk, const KernelParams& params, bool allowSimd) {
+    size_t begin = chunk * kFluidChunkSize;
+    size_t end = std::min(begin + kFluidChunkSize, size());
+    FluidArrays arrays{positionX.data(), positionY.data(), positionZ.data(), velocityX.data(), velocityY.data(),
+                       velocityZ.data(), inverseDensity.data(), pressure.data()};
+#ifdef PHYSICS_HAS_AVX2_KERNEL
+    bool simd = allowSimd && hasAvx2Kernel();
+#else
+    (void)allowSimd;
+    bool simd = false;
+#endif
+    Neighbourhood hood;
+    bool hoodValid = false;
+    for (size_t i = begin; i < end; i++) {
+        updateNeighbourhood(hood, hoodValid, positionX[i], positionY[i], positionZ[i], cellStarts.data(), params);
+        float value;
+#ifdef PHYSICS_HAS_AVX2_KERNEL
+        if (simd) {
+            value = densityAvx2(arrays, i, hood, params);
+        } else
+#endif
+        {
+            value = densityScalar(arrays, i, hood, params);
+        }
+        (void)simd;
+        const float position[3] = {positionX[i], positionY[i], positionZ[i]};
+        for (int axis = 0; axis < 3; axis++) {
+            value += wallDensity(position[axis] - params.low[axis] + params.wallOffset, params.radius, params.restDensity);
+            value += wallDensity(params.high[axis] - position[axis] + params.wallOffset, params.radius, params.restDensity);
+        }
+        setDensity(i, value, params);
+    }
+}
+
+void FluidSystem::setDensity(size_t index, float value, const KernelParams& params) {
+    density[index] = value;
+    // A particle always counts itself, so the density is positive.
+    inverseDensity[index] = 1.0f / value;
+    // Negative pressure would pull particles into clumps at the surface.
+    pressure[index] = std::max(0.0f, params.stiffness * (value - params.restDensity));
+}
+
+void FluidSystem::forceChunk(size_t chunk, const KernelParams& params, bool allowSimd) {
+    size_t begin = chunk * kFluidChunkSize;
+    size_t end = std::min(begin + kFluidChunkSize, size());
+    FluidArrays arrays{positionX.data(), positionY.data(), positionZ.data(), velocityX.data(), velocityY.data(),
+                       velocityZ.data(), inverseDensity.data(), pressure.data()};
+#ifdef PHYSICS_HAS_AVX2_KERNEL
+    bool simd = allowSimd && hasAvx2Kernel();
+#else
+    (void)allowSimd;
+    bool simd = false;
+#endif
+    Neighbourhood hood;
+    bool hoodValid = false;
+    for (size_t i = begin; i < end; i++) {
+        updateNeighbourhood(hood, hoodValid, positionX[i], positionY[i], positionZ[i], cellStarts.data(), params);
+        Vec3 acceleration;
+#ifdef PHYSICS_HAS_AVX2_KERNEL
+        if (simd) {
+            acceleration = accelerationAvx2(arrays, i, hood, params);
+        } else
+#endif
+        {
+            acceleration = accelerationScalar(arrays, i, hood, params);
+        }
+        (void)simd;
+        float accelerations[3] = {acceleration.x, acceleration.y, acceleration.z};
+        const float position[3] = {positionX[i], positionY[i], positionZ[i]};
+        float pressurePerDensity = pressure[i] * inverseDensity[i];
+        for (int axis = 0; axis < 3; axis++) {
+            accelerations[axis] += pressurePerDensity * (wallGradient(position[axis] - params.low[axis] + params.wallOffset, params.radius) -
+                                                         wallGradient(params.high[axis] - position[axis] + params.wallOffset, params.radius));
+        }
+        accelerationX[i] = accelerations[0];
+        accelerationY[i] = accelerations[1];
+        accelerationZ[i] = accelerations[2];
+    }
+}
+
+void FluidSystem::integrateChunk(size_t chunk, float deltaTime) {
+    size_t begin = chunk * kFluidChunkSize;
+    size_t end = std::min(begin + kFluidChunkSize, size());
+    const AABB& box = settings.bounds;
+    const float low[3] = {box.min.x, box.min.y, box.min.z};
+    const float high[3] = {box.max.x, box.max.y, box.max.z};
+    const float gravity[3] = {settings.gravity.x, settings.gravity.y, settings.gravity.z};
+    const float tangentKeep = 1.0f - settings.friction;
+    for (size_t i = begin; i < end; i++) {
+        float* position[3] = {&positionX[i], &positionY[i], &positionZ[i]};
+        float* velocity[3] = {&velocityX[i], &velocityY[i], &velocityZ[i]};
+        const float acceleration[3] = {accelerationX[i], accelerationY[i], accelerationZ[i]};
+        for (int axis = 0; axis < 3; axis++) {
+            *velocity[axis] += (acceleration[axis] + gravity[axis]) * deltaTime;
+            *position[axis] += *velocity[axis] * deltaTime;
+        }
+        for (int axis = 0; axis < 3; axis++) {
+            bool below = *position[axis] < low[axis];
+            bool above = *position[axis] > high[axis];
+            if (!below && !above) continue;
+            *position[axis] = below ? low[axis] : high[axis];
+            float& normalVelocity = *velocity[axis];
+            if (below ? normalVelocity < 0.0f : normalVelocity > 0.0f) {
+                normalVelocity = -normalVelocity * settings.restitution;
+            }
+            for (int other = 0; other < 3; other++) {
+                if (other != axis) *velocity[other] *= tangentKeep;
+            }
+        }
+    }
+}
+
+// Calls fn(i) once for each particle whose cell is within one cell of box.
+// The grid is from the start of the substep, and one cell of margin also
+// covers how far a particle can move in a stable substep. Keys are sorted
+// and deduplicated first, so cells that share a key are visited once; the
+// particles of far cells that share a key are left to fn's own tests. Big
+// boxes scan every particle instead.
+template <typename Fn>
+void FluidSystem::forEachNear(const AABB& box, const KernelParams& params, Fn&& fn) {
+    size_t count = size();
+    int low[3] = {cellCoordinate(box.min.x, params.inverseCellSize) - 1,
+                  cellCoordinate(box.min.y, params.inverseCellSize) - 1,
+                  cellCoordinate(box.min.z, params.inverseCellSize) - 1};
+    int high[3] = {cellCoordinate(box.max.x, params.inverseCellSize) + 1,
+                   cellCoordinate(box.max.y, params.inverseCellSize) + 1,
+                   cellCoordinate(box.max.z, params.inverseCellSize) + 1};
+    double cells = 1.0;
+    for (int axis = 0; axis < 3; axis++) {
+        cells *= static_cast<double>(high[axis] - low[axis] + 1);
+    }
+    if (cells > static_cast<double>(count)) {
+        for (size_t i = 0; i < count; i++) {
+            fn(i);
+        }
+        return;
+    }
+    bodyKeys.clear();
+    for (int z = low[2]; z <= high[2]; z++) {
+        for (int y = low[1]; y <= high[1]; y++) {
+            for (int x = low[0]; x <= high[0]; x++) {
+                bodyKeys.push_back(hashCell(x, y, z, params.tableMask));
+            }
+        }
+    }
+    std::sort(bodyKeys.begin(), bodyKeys.end());
+    bodyKeys.erase(std::unique(bodyKeys.begin(), bodyKeys.end()), bodyKeys.end());
+    for (uint32_t key : bodyKeys) {
+        for (uint32_t i = cellStarts[key]; i < cellStarts[key + 1]; i++) {
+            fn(i);
+        }
+    }
+}
+
+// The body passes are serial, body by body, so a particle near two bodies
+// is handled in coupling order.
+void FluidSystem::bodyDensity(const KernelParams& params) {
+    for (RigidBody* body : coupled) {
+        AABB box = body->getAABB();
+        forEachNear(box, params, [&](size_t i) {
+            int axis;
+            float sign, distance;
+            if (!faceDistance(positionX[i], positionY[i], positionZ[i], box, axis, sign, distance)) return;
+            distance += params.wallOffset;
+            if (distance >= params.radius) return;
+            setDensity(i, density[i] + wallDensity(distance, params.radius, params.restDensity), params);
+        });
+    }
+}
+
+// The body's faces push particles away, and the body takes the opposite
+// impulse: this is what floats and pushes it.
+void FluidSystem::bodyForces(const KernelParams& params, float deltaTime) {
+    for (RigidBody* body : coupled) {
+        AABB box = body->getAABB();
+        Vec3 impulse;
+        forEachNear(box, params, [&](size_t i) {
+            int axis;
+            float sign, distance;
+            if (!faceDistance(positionX[i], positionY[i], positionZ[i], box, axis, sign, distance)) return;
+            distance += params.wallOffset;
+            if (distance >= params.radius) return;
+            float acceleration = sign * pressure[i] * inverseDensity[i] * wallGradient(distance, params.radius);
+            float* accelerations[3] = {&accelerationX[i], &accelerationY[i], &accelerationZ[i]};
+            *accelerations[axis] += acceleration;
+            float momentum = acceleration * settings.particleMass * deltaTime;
+            impulse += Vec3(axis == 0 ? momentum : 0.0f, axis == 1 ? momentum : 0.0f, axis == 2 ? momentum : 0.0f);
+        });
+        body->applyImpulse(impulse * -1.0f);
+    }
+}
+
+void FluidSystem::pushOutOfBodies(const KernelParams& params) {
+    for (RigidBody* body : coupled) {
+        AABB box = body->getAABB();
+        Vec3 impulse;
+        forEachNear(box, params, [&](size_t i) { pushOut(i, *body, box, impulse); });
+        body->applyImpulse(impulse * -1.0f);
+    }
+}
+
+// Leaves through the nearest face, like ParticleSystem colliders, but
+// against the body's velocity; impulse collects the momentum the particle
+// gained.
+void FluidSystem::pushOut(size_t index, RigidBody& body, const AABB& box, Vec3& impulse) {
+    float x = positionX[index], y = positionY[index], z = positionZ[index];
+    if (!(x > box.min.x && x < box.max.x && y > box.min.y && y < box.max.y && z > box.min.z && z < box.max.z)) {
+        return;
+    }
+    float distances[6] = {x - box.min.x, box.max.x - x, y - box.min.y, box.max.y - y, z - box.min.z, box.max.z - z};
+    int face = 0;
+    for (int f = 1; f < 6; f++) {
+        if (distances[f] < distances[face]) face = f;
+    }
+    int axis = face / 2;
+    bool upper = (face & 1) != 0;
+    float* position[3] = {&positionX[index], &positionY[index], &positionZ[index]};
+    float* velocity[3] = {&velocityX[index], &velocityY[index], &velocityZ[index]};
+    const float bound[6] = {box.min.x, box.max.x, box.min.y, box.max.y, box.min.z, box.max.z};
+    const float bodyVelocity[3] = {body.velocity.x, body.velocity.y, body.velocity.z};
+    const float before[3] = {*velocity[0], *velocity[1], *velocity[2]};
+    *position[axis] = bound[face];
+    float normalVelocity = before[axis] - bodyVelocity[axis];
+    if (upper ? normalVelocity < 0.0f : normalVelocity > 0.0f) {
+        *velocity[axis] = bodyVelocity[axis] - normalVelocity * settings.restitution;
+    }
+    for (int other = 0; other < 3; other++) {
+        if (other == axis) continue;
+        *velocity[other] = bodyVelocity[other] + (before[other] - bodyVelocity[other]) * (1.0f - settings.friction);
+    }
+    impulse += Vec3(*velocity[0] - before[0], *velocity[1] - before[1], *velocity[2] - before[2]) *
+               settings.particleMass;
+}
+
+size_t FluidSystem::size() const {
+    return positionX.size();
+}
+
+Vec3 FluidSystem::getPosition(size_t index) const {
+    return Vec3(positionX[index], positionY[index], positionZ[index]);
+}
+
+Vec3 FluidSystem::getVelocity(size_t index) const {
+    return Vec3(velocityX[index], velocityY[index], velocityZ[index]);
+}
+
+float FluidSystem::getDensity(size_t index) const {
+    return index < density.size() ? density[index] : 0.0f;
+}
+
+std::span<const float> FluidSystem::getPositionsX() const {
+    return std::span<const float>(positionX.data(), positionX.size());
+}
+
+std::span<const float> FluidSystem::getPositionsY() const {
+    return std::span<const float>(positionY.data(), positionY.size());
+}
+
+std::span<const float> FluidSystem::getPositionsZ() const {
+    return std::span<const float>(positionZ.data(), positionZ.size());
+}
+
+bool FluidSystem::hasAvx2Kernel() {
+    return physics::collision::BatchNarrowphase::hasAvx2();
+}
+
+}
@@ -0,0 +1,553 @@
+#include "physics/world/Joints.h"
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+
+namespace physics::world {
+
+using Vec3 = physics::math::Vec3;
+using RigidBody = physics::dynamics::RigidBody;
+
+namespace {
+// Joints per prepare or solve work item.
+const uint32_t kJointChunkSize = 512;
+// Colors 0..kMaxColors-2 hold independent joints; the last one collects the
+// rest and is solved serially.
+const uint32_t kMaxColors = 64;
+const float kMinLength = 1e-6f;
+const float kPi = 3.14159265358979f;
+
+const uint32_t kRowsPerJoint[kJointTypeCount] = {1, 1, 2, 3};
+
+struct SoftCoefficients {
+    float biasRate;
+    float massScale;
+    float impulseScale;
+};
+
+// Implicit spring-damper step (see "Solver2D: Soft Step"). Zero hertz is a
+// hard constraint without position feedback. Joints stiffer than half the
+// step rate do not converge across chains in a few iterations, so the
+// frequency is clamped there.
+SoftCoefficients makeSoft(float hertz, float dampingRatio, float deltaTime) {
+    if (hertz <= 0.0f) {
+        return {0.0f, 1.0f, 0.0f};
+    }
+    hertz = std::min(hertz, 0.5f / deltaTime);
+    float omega = 2.0f * kPi * hertz;
+    float a1 = 2.0f * dampingRatio + deltaTime * omega;
+    float a2 = deltaTime * omega * a1;
+    float a3 = 1.0f / (1.0f + a2);
+    return {omega / a1, a2 * a3, a3};
+}
+
+template <typename T>
+void moveLast(std::vector<T>& values, size_t to) {
+    values[to] = values.back();
+    values.pop_back();
+}
+
+template <typename T>
+void moveLastRows(std::vector<T>& values, size_t to, size_t rows) {
+    size_t last = values.size() - rows;
+    for (size_t r = 0; r < rows; r++) {
+        values[to * rows + r] = values[last + r];
+    }
+    values.resize(last);
+}
+
+Vec3 anyPerpendicular(const Vec3& axis) {
+    Vec3 other = std::fabs(axis.x) < 0.9f ? Vec3(1, 0, 0) : Vec3(0, 1, 0);
+    return axis.cross(other).normalized();
+}
+}
+
+size_t JointSystem::JointBatch::size() const {
+    return ids.size();
+}
+
+JointSystem::JointSystem()
+    : jointCount(0), solveBodies(nullptr), solveIdToIndex(nullptr), solveIdCount(0), solveDeltaTime(0.0f),
+      rigidBiasRate(0.0f), rigidMassScale(1.0f), rigidImpulseScale(0.0f), rigidRelaxScale(1.0f) {
+    for (size_t t = 0; t < kJointTypeCount; t++) {
+        batches[t].rowsPerJoint = kRowsPerJoint[t];
+        batches[t].colorsDirty = true;
+    }
+}
+
+JointId JointSystem::addJoint(JointType type, BodyId a, BodyId b) {
+    assert(a != InvalidBodyId && b != InvalidBodyId);
+    JointId id;
+    if (!freeIds.empty()) {
+        id = freeIds.back();
+        freeIds.pop_back();
+    } else {
+        id = static_cast<JointId>(idToJoint.size());
+        idToJoint.push_back({type, UINT32_MAX});
+    }
+    JointBatch& batch = batches[static_cast<size_t>(type)];
+    idToJoint[id] = {type, static_cast<uint32_t>(batch.size())};
+    batch.ids.push_back(id);
+    batch.bodyA.push_back(a);
+    batch.bodyB.push_back(b);
+    batch.impulse.insert(batch.impulse.end(), batch.rowsPerJoint, 0.0f);
+    batch.colorsDirty = true;
+    jointCount++;
+    return id;
+}
+
+JointId JointSystem::addDistance(BodyId a, BodyId b, float length) {
+    distance.length.push_back(length);
+    return addJoint(JointType::Distance, a, b);
+}
+
+JointId JointSystem::addSpring(BodyId a, BodyId b, float restLength, const JointSoftness& softness) {
+    assert(softness.hertz > 0.0f);
+    spring.restLength.push_back(restLength);
+    spring.hertz.push_back(softness.hertz);
+    spring.dampingRatio.push_back(softness.dampingRatio);
+    return addJoint(JointType::Spring, a, b);
+}
+
+JointId JointSystem::addHinge(BodyId a, BodyId b, const Vec3& axis, float axialOffset, float radius) {
+    hinge.axisX.push_back(axis.x);
+    hinge.axisY.push_back(axis.y);
+    hinge.axisZ.push_back(axis.z);
+    hinge.axialOffset.push_back(axialOffset);
+    hinge.radius.push_back(radius);
+    return addJoint(JointType::Hinge, a, b);
+}
+
+JointId JointSystem::addFixed(BodyId a, BodyId b, const Vec3& offset) {
+    fixed.offsetX.push_back(offset.x);
+    fixed.offsetY.push_back(offset.y);
+    fixed.offsetZ.push_back(offset.z);
+    return addJoint(JointType::Fixed, a, b);
+}
+
+void JointSystem::remove(JointId id) {
+    if (!isValid(id)) return;
+    removeAt(idToJoint[id].type, idToJoint[id].index);
+}
+
+// Swap-removes the joint at index, moving the batch's last joint into it.
+void JointSystem::removeAt(JointType type, uint32_t index) {
+    JointBatch& batch = batches[static_cast<size_t>(type)];
+    JointId removed = batch.ids[index];
+    moveLast(batch.ids, index);
+    moveLast(batch.bodyA, index);
+    moveLast(batch.bodyB, index);
+    moveLastRows(batch.impulse, index, batch.rowsPerJoint);
+    switch (type) {
+    case JointType::Distance:
+        moveLast(distance.length, index);
+        break;
+    case JointType::Spring:
+        moveLast(spring.restLength, index);
+        moveLast(spring.hertz, index);
+        moveLast(spring.dampingRatio, index);
+        break;
+    case JointType::Hinge:
+        moveLast(hinge.axisX, index);
+        moveLast(hinge.axisY, index);
+        moveLast(hinge.axisZ, index);
+        moveLast(hinge.axialOffset, index);
+        moveLast(hinge.radius, index);
+        break;
+    case JointType::Fixed:
+        moveLast(fixed.offsetX, index);
+        moveLast(fixed.offsetY, index);
+        moveLast(fixed.offsetZ, index);
+        break;
+    }
+    if (index < batch.size()) {
+        idToJoint[batch.ids[index]].index = index;
+    }
+    idToJoint[removed].index = UINT32_MAX;
+    freeIds.push_back(removed);
+    batch.colorsDirty = true;
+    jointCount--;
+}
+
+void JointSystem::clear() {
+    for (size_t t = 0; t < kJointTypeCount; t++) {
+        JointBatch& batch = batches[t];
+        batch.ids.clear();
+        batch.bodyA.clear();
+        batch.bodyB.clear();
+        batch.impulse.clear();
+        batch.colorsDirty = true;
+    }
+    distance = DistanceJoints();
+    spring = SpringJoints();
+    hinge = HingeJoints();
+    fixed = FixedJoints();
+    idToJoint.clear();
+    freeIds.clear();
+    jointCount = 0;
+}
+
+bool JointSystem::isValid(JointId id) const {
+    return id < idToJoint.size() && idToJoint[id].index != UINT32_MAX;
+}
+
+size_t JointSystem::getCount() const {
+    return jointCount;
+}
+
+size_t JointSystem::getCount(JointType type) const {
+    return batches[static_cast<size_t>(type)].size();
+}
+
+JointType JointSystem::getType(JointId id) const {
+    return idToJoint[id].type;
+}
+
+BodyId JointSystem::getBodyA(JointId id) const {
+    return batches[static_cast<size_t>(idToJoint[id].type)].bodyA[idToJoint[id].index];
+}
+
+BodyId JointSystem::getBodyB(JointId id) const {
+    return batches[static_cast<size_t>(idToJoint[id].type)].bodyB[idToJoint[id].index];
+}
+
+float JointSystem::getImpulse(JointId id) const {
+    const JointBatch& batch = batches[static_cast<size_t>(idToJoint[id].type)];
+    size_t first = idToJoint[id].index * batch.rowsPerJoint;
+    float sum = 0.0f;
+    for (size_t r = 0; r < batch.rowsPerJoint; r++) {
+        sum += batch.impulse[first + r] * batch.impulse[first + r];
+    }
+    return std::sqrt(sum);
+}
+
+// Greedy coloring by body: each joint takes the lowest color neither of its
+// bodies has used yet.
+void JointSystem::updateColors(JointBatch& batch) {
+    size_t count = batch.size();
+    BodyId maxBody = 0;
+    for (size_t j = 0; j < count; j++) {
+        maxBody = std::max({maxBody, batch.bodyA[j], batch.bodyB[j]});
+    }
+    bodyColors.assign(count > 0 ? static_cast<size_t>(maxBody) + 1 : 0, 0);
+    jointColors.resize(count);
+    uint32_t colorCount = 0;
+    for (size_t j = 0; j < count; j++) {
+        uint64_t used = bodyColors[batch.bodyA[j]] | bodyColors[batch.bodyB[j]];
+        uint32_t color = static_cast<uint32_t>(std::countr_zero(~used));
+        if (color >= kMaxColors - 1) {
+            color = kMaxColors - 1;
+        } else {
+            bodyColors[batch.bodyA[j]] |= uint64_t(1) << color;
+            bodyColors[batch.bodyB[j]] |= uint64_t(1) << color;
+        }
+        jointColors[j] = static_cast<uint8_t>(color);
+        colorCount = std::max(colorCount, color + 1);
+    }
+
+    batch.colorOffsets.assign(colorCount + 1, 0);
+    for (size_t j = 0; j < count; j++) {
+        batch.colorOffsets[jointColors[j] + 1]++;
+    }
+    for (uint32_t c = 0; c < colorCount; c++) {
+        batch.colorOffsets[c + 1] += batch.colorOffsets[c];
+    }
+    batch.colorOrder.resize(count);
+    std::vector<uint32_t> cursor(batch.colorOffsets.begin(), batch.colorOffsets.end() - 1);
+    for (size_t j = 0; j < count; j++) {
+        batch.colorOrder[cursor[jointColors[j]]++] = static_cast<uint32_t>(j);
+    }
+    batch.colorsDirty = false;
+}
+
+void JointSystem::buildWorkItems() {
+    items.clear();
+    passOffsets.assign(1, 0);
+    auto closePass = [this]() {
+        if (items.size() > passOffsets.back()) {
+            passOffsets.push_back(static_cast<uint32_t>(items.size()));
+        }
+    };
+
+    for (size_t t = 0; t < kJointTypeCount; t++) {
+        uint32_t count = static_cast<uint32_t>(batches[t].size());
+        for (uint32_t begin = 0; begin < count; begin += kJointChunkSize) {
+            items.push_back({static_cast<JointType>(t), Stage::Prepare, begin, std::min(begin + kJointChunkSize, count)});
+        }
+    }
+    closePass();
+
+    uint32_t warmPasses = settings.warmStarting ? 1 : 0;
+    uint32_t passes = warmPasses + settings.iterations + settings.relaxIterations;
+    for (uint32_t p = 0; p < passes; p++) {
+        Stage stage = p < warmPasses ? Stage::WarmStart
+                      : p < warmPasses + settings.iterations ? Stage::Iterate
+                                                              : Stage::Relax;
+        for (size_t t = 0; t < kJointTypeCount; t++) {
+            if (stage == Stage::Relax && static_cast<JointType>(t) == JointType::Spring) continue;
+            const JointBatch& batch = batches[t];
+            for (size_t c = 0; c + 1 < batch.colorOffsets.size(); c++) {
+                uint32_t begin = batch.colorOffsets[c];
+                uint32_t end = batch.colorOffsets[c + 1];
+                if (begin == end) continue;
+                uint32_t chunk = c == kMaxColors - 1 ? end - begin : kJointChunkSize;
+                for (uint32_t b = begin; b < end; b += chunk) {
+                    items.push_back({static_cast<JointType>(t), stage, b, std::min(b + chunk, end)});
+                }
+                closePass();
+            }
+        }
+    }
+}
+
+void JointSystem::beginSolve(const std::unique_ptr<RigidBody>* bodies, const uint32_t* idToIndex, size_t idCount,
+                             float deltaTime) {
+    solveBodies = bodies;
+    solveIdToIndex = idToIndex;
+    solveIdCount = idCount;
+    solveDeltaTime = deltaTime;
+    SoftCoefficients rigid = makeSoft(settings.rigidSoftness.hertz, settings.rigidSoftness.dampingRatio, deltaTime);
+    rigidBiasRate = rigid.biasRate;
+    rigidMassScale = rigid.massScale;
+    rigidImpulseScale = rigid.impulseScale;
+    rigidRelaxScale = 1.0f / rigid.massScale;
+
+    for (JointBatch& batch : batches) {
+        if (batch.colorsDirty) {
+            updateColors(batch);
+        }
+        size_t rows = batch.size() * batch.rowsPerJoint;
+        batch.slotA.resize(batch.size());
+        batch.slotB.resize(batch.size());
+        batch.normalX.resize(rows);
+        batch.normalY.resize(rows);
+        batch.normalZ.resize(rows);
+        batch.bias.resize(rows);
+        batch.mass.resize(rows);
+        batch.impulseScale.resize(rows);
+        if (!settings.warmStarting) {
+            std::fill(batch.impulse.begin(), batch.impulse.end(), 0.0f);
+        }
+    }
+    buildWorkItems();
+}
+
+size_t JointSystem::getPassCount() const {
+    return passOffsets.size() - 1;
+}
+
+size_t JointSystem::getPassBegin(size_t pass) const {
+    return passOffsets[pass];
+}
+
+size_t JointSystem::getPassEnd(size_t pass) const {
+    return passOffsets[pass + 1];
+}
+
+void JointSystem::runItem(size_t index) {
+    const WorkItem& item = items[index];
+    JointBatch& batch = batches[static_cast<size_t>(item.type)];
+    switch (item.stage) {
+    case Stage::Prepare:
+        prepare(item.type, item.begin, item.end);
+        break;
+    case Stage::WarmStart:
+        warmStart(batch, item.begin, item.end);
+        break;
+    case Stage::Iterate:
+        iterate(batch, item.begin, item.end);
+        break;
+    case Stage::Relax:
+        relax(batch, item.begin, item.end);
+        break;
+    }
+}
+
+void JointSystem::solve(const std::unique_ptr<RigidBody>* bodies, const uint32_t* idToIndex, size_t idCount,
+                        float deltaTime) {
+    beginSolve(bodies, idToIndex, idCount, deltaTime);
+    for (size_t i = 0; i < items.size(); i++) {
+        runItem(i);
+    }
+}
+
+// Positions are taken at the start of the step, before integration moved
+// them by deltaTime * velocity.
+bool JointSystem::bindBodies(JointBatch& batch, uint32_t joint, Vec3& delta, float& inverseMassSum) const {
+    BodyId a = batch.bodyA[joint];
+    BodyId b = batch.bodyB[joint];
+    uint32_t slotA = a < solveIdCount ? solveIdToIndex[a] : UINT32_MAX;
+    uint32_t slotB = b < solveIdCount ? solveIdToIndex[b] : UINT32_MAX;
+    if (slotA == UINT32_MAX || slotB == UINT32_MAX) {
+        batch.slotA[joint] = UINT32_MAX;
+        batch.slotB[joint] = UINT32_MAX;
+        for (size_t r = 0; r < batch.rowsPerJoint; r++) {
+            batch.impulse[joint * batch.rowsPerJoint + r] = 0.0f;
+        }
+        return false;
+    }
+    batch.slotA[joint] = slotA;
+    batch.slotB[joint] = slotB;
+    const RigidBody& bodyA = *solveBodies[slotA];
+    const RigidBody& bodyB = *solveBodies[slotB];
+    Vec3 startA = bodyA.position - bodyA.velocity * solveDeltaTime;
+    Vec3 startB = bodyB.position - bodyB.velocity * solveDeltaTime;
+    delta = startB - startA;
+    inverseMassSum = bodyA.inverseMass + bodyB.inverseMass;
+    return true;
+}
+
+void JointSystem::setRow(JointBatch& batch, size_t row, const Vec3& normal, float error, float inverseMassSum,
+                         float biasRate, float massScale, float impulseScale) {
+    batch.normalX[row] = normal.x;
+    batch.normalY[row] = normal.y;
+    batch.normalZ[row] = normal.z;
+    batch.bias[row] = biasRate * error;
+    batch.mass[row] = inverseMassSum > 0.0f ? massScale / inverseMassSum : 0.0f;
+    batch.impulseScale[row] = impulseScale;
+}
+
+void JointSystem::prepare(JointType type, uint32_t begin, uint32_t end) {
+    switch (type) {
+    case JointType::Distance:
+        prepareDistance(begin, end);
+        break;
+    case JointType::Spring:
+        prepareSpring(begin, end);
+        break;
+    case JointType::Hinge:
+        prepareHinge(begin, end);
+        break;
+    case JointType::Fixed:
+        prepareFixed(begin, end);
+        break;
+    }
+}
+
+void JointSystem::prepareDistance(uint32_t begin, uint32_t end) {
+    JointBatch& batch = batches[static_cast<size_t>(JointType::Distance)];
+    for (uint32_t j = begin; j < end; j++) {
+        Vec3 delta;
+        float inverseMassSum;
+        if (!bindBodies(batch, j, delta, inverseMassSum)) continue;
+        float length = delta.length();
+        Vec3 normal = length > kMinLength ? delta * (1.0f / length) : Vec3(0, 1, 0);
+        setRow(batch, j, normal, length - distance.length[j], inverseMassSum, rigidBiasRate, rigidMassScale,
+               rigidImpulseScale);
+    }
+}
+
+void JointSystem::prepareSpring(uint32_t begin, uint32_t end) {
+    JointBatch& batch = batches[static_cast<size_t>(JointType::Spring)];
+    for (uint32_t j = begin; j < end; j++) {
+        Vec3 delta;
+        float inverseMassSum;
+        if (!bindBodies(batch, j, delta, inverseMassSum)) continue;
+        float length = delta.length();
+        Vec3 normal = length > kMinLength ? delta * (1.0f / length) : Vec3(0, 1, 0);
+        SoftCoefficients soft = makeSoft(spring.hertz[j], spring.dampingRatio[j], solveDeltaTime);
+        setRow(batch, j, normal, length - spring.restLength[j], inverseMassSum, soft.biasRate, soft.massScale,
+               soft.impulseScale);
+    }
+}
+
+// Row 0 holds the offset along the axis, row 1 the distance from it.
+void JointSystem::prepareHinge(uint32_t begin, uint32_t end) {
+    JointBatch& batch = batches[static_cast<size_t>(JointType::Hinge)];
+    for (uint32_t j = begin; j < end; j++) {
+        Vec3 delta;
+        float inverseMassSum;
+        if (!bindBodies(batch, j, delta, inverseMassSum)) continue;
+        Vec3 axis(hinge.axisX[j], hinge.axisY[j], hinge.axisZ[j]);
+        float axial = delta.dot(axis);
+        Vec3 radial = delta - axis * axial;
+        float radius = radial.length();
+        Vec3 radialNormal = radius > kMinLength ? radial * (1.0f / radius) : anyPerpendicular(axis);
+        setRow(batch, 2 * j, axis, axial - hinge.axialOffset[j], inverseMassSum, rigidBiasRate, rigidMassScale,
+               rigidImpulseScale);
+        setRow(batch, 2 * j + 1, radialNormal, radius - hinge.radius[j], inverseMassSum, rigidBiasRate,
+               rigidMassScale, rigidImpulseScale);
+    }
+}
+
+void JointSystem::prepareFixed(uint32_t begin, uint32_t end) {
+    JointBatch& batch = batches[static_cast<size_t>(JointType::Fixed)];
+    for (uint32_t j = begin; j < end; j++) {
+        Vec3 delta;
+        float inverseMassSum;
+        if (!bindBodies(batch, j, delta, inverseMassSum)) continue;
+        setRow(batch, 3 * j, Vec3(1, 0, 0), delta.x - fixed.offsetX[j], inverseMassSum, rigidBiasRate,
+               rigidMassScale, rigidImpulseScale);
+        setRow(batch, 3 * j + 1, Vec3(0, 1, 0), delta.y - fixed.offsetY[j], inverseMassSum, rigidBiasRate,
+               rigidMassScale, rigidImpulseScale);
+        setRow(batch, 3 * j + 2, Vec3(0, 0, 1), delta.z - fixed.offsetZ[j], inverseMassSum, rigidBiasRate,
+               rigidMassScale, rigidImpulseScale);
+    }
+}
+
+void JointSystem::warmStart(JointBatch& batch, uint32_t begin, uint32_t end) {
+    uint32_t rows = batch.rowsPerJoint;
+    float deltaTime = solveDeltaTime;
+    for (uint32_t k = begin; k < end; k++) {
+        uint32_t j = batch.colorOrder[k];
+        if (batch.slotA[j] == UINT32_MAX) continue;
+        RigidBody& bodyA = *solveBodies[batch.slotA[j]];
+        RigidBody& bodyB = *solveBodies[batch.slotB[j]];
+        for (uint32_t r = j * rows; r < (j + 1) * rows; r++) {
+            Vec3 impulse = Vec3(batch.normalX[r], batch.normalY[r], batch.normalZ[r]) * batch.impulse[r];
+            Vec3 changeA = impulse * bodyA.inverseMass;
+            Vec3 changeB = impulse * bodyB.inverseMass;
+            bodyA.velocity = bodyA.velocity - changeA;
+            bodyB.velocity += changeB;
+            bodyA.position = bodyA.position - changeA * deltaTime;
+            bodyB.position += changeB * deltaTime;
+        }
+    }
+}
+
+void JointSystem::iterate(JointBatch& batch, uint32_t begin, uint32_t end) {
+    uint32_t rows = batch.rowsPerJoint;
+    float deltaTime = solveDeltaTime;
+    for (uint32_t k = begin; k < end; k++) {
+        uint32_t j = batch.colorOrder[k];
+        if (batch.slotA[j] == UINT32_MAX) continue;
+        RigidBody& bodyA = *solveBodies[batch.slotA[j]];
+        RigidBody& bodyB = *solveBodies[batch.slotB[j]];
+        for (uint32_t r = j * rows; r < (j + 1) * rows; r++) {
+            Vec3 normal(batch.normalX[r], batch.normalY[r], batch.normalZ[r]);
+            float speed = (bodyB.velocity - bodyA.velocity).dot(normal);
+            float lambda = -batch.mass[r] * (speed + batch.bias[r]) - batch.impulseScale[r] * batch.impulse[r];
+            batch.impulse[r] += lambda;
+            Vec3 impulse = normal * lambda;
+            Vec3 changeA = impulse * bodyA.inverseMass;
+            Vec3 changeB = impulse * bodyB.inverseMass;
+            bodyA.velocity = bodyA.velocity - changeA;
+            bodyB.velocity += changeB;
+            bodyA.position = bodyA.position - changeA * deltaTime;
+            bodyB.position += changeB * deltaTime;
+        }
+    }
+}
+
+// Unbiased, unsoftened pass on velocities alone (rigid joints only).
+void JointSystem::relax(JointBatch& batch, uint32_t begin, uint32_t end) {
+    uint32_t rows = batch.rowsPerJoint;
+    for (uint32_t k = begin; k < end; k++) {
+        uint32_t j = batch.colorOrder[k];
+        if (batch.slotA[j] == UINT32_MAX) continue;
+        RigidBody& bodyA = *solveBodies[batch.slotA[j]];
+        RigidBody& bodyB = *solveBodies[batch.slotB[j]];
+        for (uint32_t r = j * rows; r < (j + 1) * rows; r++) {
+            Vec3 normal(batch.normalX[r], batch.normalY[r], batch.normalZ[r]);
+            float speed = (bodyB.velocity - bodyA.velocity).dot(normal);
+            float lambda = -batch.mass[r] * rigidRelaxScale * speed;
+            batch.impulse[r] += lambda;
+            Vec3 impulse = normal * lambda;
+            bodyA.velocity = bodyA.velocity - impulse * bodyA.inverseMass;
+            bodyB.velocity += impulse * bodyB.inverseMass;
+        }
+    }
+}
+
+}
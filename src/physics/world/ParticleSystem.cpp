@@ -0,0 +1,329 @@
+#include "physics/world/ParticleSystem.h"
+#include "physics/collision/BatchNarrowphase.h"
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PHYSICS_HAS_AVX2_KERNEL 1
+#endif
+
+namespace physics::world {
+
+using Vec3 = physics::math::Vec3;
+using AABB = physics::collision::AABB;
+
+namespace {
+// Particles per integrate task; a multiple of the SIMD width so only the
+// last chunk has a scalar tail.
+const size_t kParticleChunkSize = 16384;
+
+struct ParticleArrays {
+    float* x;
+    float* y;
+    float* z;
+    float* vx;
+    float* vy;
+    float* vz;
+    float* life;
+};
+
+// Scalar reference kernel. The AVX2 kernel performs the same operations in
+// the same order, so both produce identical results.
+template <typename Params>
+void integrateScalar(const ParticleArrays& p, size_t begin, size_t end, const Params& params,
+                     std::vector<uint32_t>& expired) {
+    for (size_t i = begin; i < end; i++) {
+        float vx = (p.vx[i] + params.gravityStep[0]) * params.dragFactor;
+        float vy = (p.vy[i] + params.gravityStep[1]) * params.dragFactor;
+        float vz = (p.vz[i] + params.gravityStep[2]) * params.dragFactor;
+        float x = p.x[i] + vx * params.deltaTime;
+        float y = p.y[i] + vy * params.deltaTime;
+        float z = p.z[i] + vz * params.deltaTime;
+
+        if (y < params.groundY) {
+            y = params.groundY;
+            if (vy < 0.0f) vy = -vy * params.restitution;
+            vx = vx * params.tangentKeep;
+            vz = vz * params.tangentKeep;
+        }
+
+        for (size_t c = 0; c < params.colliderCount; c++) {
+            const AABB& box = params.colliders[c];
+            if (!(x > box.min.x && x < box.max.x && y > box.min.y && y < box.max.y && z > box.min.z && z < box.max.z)) {
+                continue;
+            }
+            // Leave through the nearest face; ties go to the earlier face.
+            float distances[6] = {x - box.min.x, box.max.x - x, y - box.min.y, box.max.y - y, z - box.min.z, box.max.z - z};
+            int face = 0;
+            float best = distances[0];
+            for (int f = 1; f < 6; f++) {
+                if (distances[f] < best) {
+                    best = distances[f];
+                    face = f;
+                }
+            }
+            int axis = face / 2;
+            bool upper = (face & 1) != 0;
+            float* position[3] = {&x, &y, &z};
+            float* velocity[3] = {&vx, &vy, &vz};
+            const float bound[6] = {box.min.x, box.max.x, box.min.y, box.max.y, box.min.z, box.max.z};
+            *position[axis] = bound[face];
+            float& normalVelocity = *velocity[axis];
+            if (upper ? normalVelocity < 0.0f : normalVelocity > 0.0f) {
+                normalVelocity = -normalVelocity * params.restitution;
+            }
+            for (int other = 0; other < 3; other++) {
+                if (other != axis) *velocity[other] = *velocity[other] * params.tangentKeep;
+            }
+        }
+
+        float life = p.life[i] - params.deltaTime;
+        if (life <= 0.0f) expired.push_back(static_cast<uint32_t>(i));
+        p.x[i] = x;
+        p.y[i] = y;
+        p.z[i] = z;
+        p.vx[i] = vx;
+        p.vy[i] = vy;
+        p.vz[i] = vz;
+        p.life[i] = life;
+    }
+}
+
+#ifdef PHYSICS_HAS_AVX2_KERNEL
+template <typename Params>
+__attribute__((target("avx2"))) void integrateAvx2(const ParticleArrays& p, size_t begin, size_t end,
+                                                   const Params& params, std::vector<uint32_t>& expired) {
+    const __m256 dt = _mm256_set1_ps(params.deltaTime);
+    const __m256 gravity[3] = {_mm256_set1_ps(params.gravityStep[0]), _mm256_set1_ps(params.gravityStep[1]),
+                               _mm256_set1_ps(params.gravityStep[2])};
+    const __m256 drag = _mm256_set1_ps(params.dragFactor);
+    const __m256 ground = _mm256_set1_ps(params.groundY);
+    const __m256 restitution = _mm256_set1_ps(params.restitution);
+    const __m256 keep = _mm256_set1_ps(params.tangentKeep);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 signBit = _mm256_set1_ps(-0.0f);
+
+    size_t batchEnd = begin + ((end - begin) & ~size_t(7));
+    for (size_t i = begin; i < batchEnd; i += 8) {
+        __m256 v[3] = {
+            _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(p.vx + i), gravity[0]), drag),
+            _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(p.vy + i), gravity[1]), drag),
+            _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(p.vz + i), gravity[2]), drag),
+        };
+        __m256 x[3] = {
+            _mm256_add_ps(_mm256_loadu_ps(p.x + i), _mm256_mul_ps(v[0], dt)),
+            _mm256_add_ps(_mm256_loadu_ps(p.y + i), _mm256_mul_ps(v[1], dt)),
+            _mm256_add_ps(_mm256_loadu_ps(p.z + i), _mm256_mul_ps(v[2], dt)),
+        };
+
+        __m256 below = _mm256_cmp_ps(x[1], ground, _CMP_LT_OQ);
+        if (_mm256_movemask_ps(below)) {
+            x[1] = _mm256_blendv_ps(x[1], ground, below);
+            __m256 falling = _mm256_and_ps(below, _mm256_cmp_ps(v[1], zero, _CMP_LT_OQ));
+            __m256 bounced = _mm256_mul_ps(_mm256_xor_ps(v[1], signBit), restitution);
+            v[1] = _mm256_blendv_ps(v[1], bounced, falling);
+            v[0] = _mm256_blendv_ps(v[0], _mm256_mul_ps(v[0], keep), below);
+            v[2] = _mm256_blendv_ps(v[2], _mm256_mul_ps(v[2], keep), below);
+        }
+
+        for (size_t c = 0; c < params.colliderCount; c++) {
+            const AABB& box = params.colliders[c];
+            __m256 low[3] = {_mm256_set1_ps(box.min.x), _mm256_set1_ps(box.min.y), _mm256_set1_ps(box.min.z)};
+            __m256 high[3] = {_mm256_set1_ps(box.max.x), _mm256_set1_ps(box.max.y), _mm256_set1_ps(box.max.z)};
+            __m256 inside = _mm256_and_ps(_mm256_cmp_ps(x[0], low[0], _CMP_GT_OQ), _mm256_cmp_ps(x[0], high[0], _CMP_LT_OQ));
+            for (int axis = 1; axis < 3; axis++) {
+                inside = _mm256_and_ps(inside, _mm256_and_ps(_mm256_cmp_ps(x[axis], low[axis], _CMP_GT_OQ),
+                                                             _mm256_cmp_ps(x[axis], high[axis], _CMP_LT_OQ)));
+            }
+            if (_mm256_movemask_ps(inside) == 0) continue;
+
+            __m256 best = _mm256_sub_ps(x[0], low[0]);
+            __m256 face = zero;
+            for (int f = 1; f < 6; f++) {
+                int axis = f / 2;
+                __m256 distance = (f & 1) ? _mm256_sub_ps(high[axis], x[axis]) : _mm256_sub_ps(x[axis], low[axis]);
+                __m256 closer = _mm256_cmp_ps(distance, best, _CMP_LT_OQ);
+                best = _mm256_blendv_ps(best, distance, closer);
+                face = _mm256_blendv_ps(face, _mm256_set1_ps(static_cast<float>(f)), closer);
+            }
+
+            __m256 onAxis[3];
+            for (int axis = 0; axis < 3; axis++) {
+                __m256 lowerFace = _mm256_and_ps(inside, _mm256_cmp_ps(face, _mm256_set1_ps(static_cast<float>(2 * axis)), _CMP_EQ_OQ));
+                __m256 upperFace = _mm256_and_ps(inside, _mm256_cmp_ps(face, _mm256_set1_ps(static_cast<float>(2 * axis + 1)), _CMP_EQ_OQ));
+                onAxis[axis] = _mm256_or_ps(lowerFace, upperFace);
+                x[axis] = _mm256_blendv_ps(x[axis], low[axis], lowerFace);
+                x[axis] = _mm256_blendv_ps(x[axis], high[axis], upperFace);
+                __m256 reflect = _mm256_or_ps(_mm256_and_ps(lowerFace, _mm256_cmp_ps(v[axis], zero, _CMP_GT_OQ)),
+                                              _mm256_and_ps(upperFace, _mm256_cmp_ps(v[axis], zero, _CMP_LT_OQ)));
+                v[axis] = _mm256_blendv_ps(v[axis], _mm256_mul_ps(_mm256_xor_ps(v[axis], signBit), restitution), reflect);
+            }
+            for (int axis = 0; axis < 3; axis++) {
+                __m256 tangent = _mm256_andnot_ps(onAxis[axis], inside);
+                v[axis] = _mm256_blendv_ps(v[axis], _mm256_mul_ps(v[axis], keep), tangent);
+            }
+        }
+
+        __m256 life = _mm256_sub_ps(_mm256_loadu_ps(p.life + i), dt);
+        int expiredMask = _mm256_movemask_ps(_mm256_cmp_ps(life, zero, _CMP_LE_OQ));
+        while (expiredMask) {
+            int lane = __builtin_ctz(static_cast<unsigned>(expiredMask));
+            expiredMask &= expiredMask - 1;
+            expired.push_back(static_cast<uint32_t>(i + lane));
+        }
+        _mm256_storeu_ps(p.x + i, x[0]);
+        _mm256_storeu_ps(p.y + i, x[1]);
+        _mm256_storeu_ps(p.z + i, x[2]);
+        _mm256_storeu_ps(p.vx + i, v[0]);
+        _mm256_storeu_ps(p.vy + i, v[1]);
+        _mm256_storeu_ps(p.vz + i, v[2]);
+        _mm256_storeu_ps(p.life + i, life);
+    }
+    integrateScalar(p, batchEnd, end, params, expired);
+}
+#endif
+}
+
+ParticleSystem::ParticleSystem() : threadPool(nullptr), chunkCount(0) {}
+
+size_t ParticleSystem::spawn(const Vec3& position, const Vec3& velocity, float life) {
+    positionX.push_back(position.x);
+    positionY.push_back(position.y);
+    positionZ.push_back(position.z);
+    velocityX.push_back(velocity.x);
+    velocityY.push_back(velocity.y);
+    velocityZ.push_back(velocity.z);
+    lifetime.push_back(life);
+    return lifetime.size() - 1;
+}
+
+void ParticleSystem::kill(size_t index) {
+    if (index < lifetime.size()) lifetime[index] = 0.0f;
+}
+
+void ParticleSystem::reserve(size_t capacity) {
+    for (std::vector<float>* values : {&positionX, &positionY, &positionZ, &velocityX, &velocityY, &velocityZ, &lifetime}) {
+        values->reserve(capacity);
+    }
+}
+
+void ParticleSystem::clear() {
+    for (std::vector<float>* values : {&positionX, &positionY, &positionZ, &velocityX, &velocityY, &velocityZ, &lifetime}) {
+        values->clear();
+    }
+}
+
+void ParticleSystem::addCollider(const AABB& bounds) {
+    colliders.push_back(bounds);
+}
+
+void ParticleSystem::clearColliders() {
+    colliders.clear();
+}
+
+void ParticleSystem::step(float deltaTime) {
+    run(deltaTime, true);
+}
+
+void ParticleSystem::stepScalar(float deltaTime) {
+    run(deltaTime, false);
+}
+
+void ParticleSystem::run(float deltaTime, bool allowSimd) {
+    KernelParams params;
+    params.deltaTime = deltaTime;
+    params.gravityStep[0] = settings.gravity.x * deltaTime;
+    params.gravityStep[1] = settings.gravity.y * deltaTime;
+    params.gravityStep[2] = settings.gravity.z * deltaTime;
+    params.dragFactor = 1.0f / (1.0f + settings.drag * deltaTime);
+    params.groundY = settings.groundY;
+    params.restitution = settings.restitution;
+    params.tangentKeep = 1.0f - settings.friction;
+    params.colliders = colliders.data();
+    params.colliderCount = colliders.size();
+
+    chunkCount = (lifetime.size() + kParticleChunkSize - 1) / kParticleChunkSize;
+    if (chunks.size() < chunkCount) {
+        chunks.resize(chunkCount);
+    }
+    auto integrateChunks = [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; c++) {
+            integrateChunk(c, params, allowSimd);
+        }
+    };
+    if (threadPool) {
+        threadPool->parallelFor(chunkCount, 1, integrateChunks);
+    } else {
+        integrateChunks(0, chunkCount);
+    }
+    removeExpired();
+}
+
+void ParticleSystem::integrateChunk(size_t chunk, const KernelParams& params, bool allowSimd) {
+    size_t begin = chunk * kParticleChunkSize;
+    size_t end = std::min(begin + kParticleChunkSize, lifetime.size());
+    ParticleArrays arrays{positionX.data(), positionY.data(), positionZ.data(), velocityX.data(), velocityY.data(),
+                          velocityZ.data(), lifetime.data()};
+    std::vector<uint32_t>& expired = chunks[chunk].expired;
+    expired.clear();
+#ifdef PHYSICS_HAS_AVX2_KERNEL
+    if (allowSimd && hasAvx2Kernel()) {
+        integrateAvx2(arrays, begin, end, params, expired);
+        return;
+    }
+#endif
+    (void)allowSimd;
+    integrateScalar(arrays, begin, end, params, expired);
+}
+
+// Expired indices are ascending within and across chunks. Removing them
+// from the back means every particle swapped in from the end is still alive.
+void ParticleSystem::removeExpired() {
+    for (size_t c = chunkCount; c-- > 0;) {
+        const std::vector<uint32_t>& expired = chunks[c].expired;
+        for (size_t k = expired.size(); k-- > 0;) {
+            swapRemove(expired[k]);
+        }
+    }
+}
+
+void ParticleSystem::swapRemove(size_t index) {
+    for (std::vector<float>* values : {&positionX, &positionY, &positionZ, &velocityX, &velocityY, &velocityZ, &lifetime}) {
+        (*values)[index] = values->back();
+        values->pop_back();
+    }
+}
+
+size_t ParticleSystem::size() const {
+    return lifetime.size();
+}
+
+Vec3 ParticleSystem::getPosition(size_t index) const {
+    return Vec3(positionX[index], positionY[index], positionZ[index]);
+}
+
+Vec3 ParticleSystem::getVelocity(size_t index) const {
+    return Vec3(velocityX[index], velocityY[index], velocityZ[index]);
+}
+
+float ParticleSystem::getLifetime(size_t index) const {
+    return lifetime[index];
+}
+
+std::span<const float> ParticleSystem::getPositionsX() const {
+    return std::span<const float>(positionX.data(), positionX.size());
+}
+
+std::span<const float> ParticleSystem::getPositionsY() const {
+    return std::span<const float>(positionY.data(), positionY.size());
+}
+
+std::span<const float> ParticleSystem::getPositionsZ() const {
+    return std::span<const float>(positionZ.data(), positionZ.size());
+}
+
+bool ParticleSystem::hasAvx2Kernel() {
+    return physics::collision::BatchNarrowphase::hasAvx2();
+}
+
+}
@@ -0,0 +1,478 @@
+#include "physics/world/RegionStreamer.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+namespace physics::world {
+
+using Vec3 = physics::math::Vec3;
+using RigidBody = physics::dynamics::RigidBody;
+using ConvexHull = physics::collision::ConvexHull;
+using Shape = physics::collision::Shape;
+using ShapeType = physics::collision::ShapeType;
+
+namespace {
+
+// File layout: magic, version, then fixed-size records appended in
+// write order. Records use the host byte order. A record holds position,
+// velocity, size, mass, friction, restitution and flags, then the shape
+// (type, hull index, radius, half height, half extents, axes) and the
+// collision filter (category, mask, group).
+const char kRegionMagic[4] = {'V', 'R', 'G', 'N'};
+const uint32_t kRegionVersion = 3;
+const size_t kHeaderSize = sizeof(kRegionMagic) + sizeof(uint32_t);
+// writeShape's floats: radius, half height, half extents, then the axes.
+const size_t kShapeFloats = 2 + 3 + 3 * (sizeof(Shape::axes) / sizeof(Vec3));
+const size_t kShapeSize = 1 + sizeof(uint32_t) + sizeof(float) * kShapeFloats;
+const size_t kFilterSize = sizeof(uint32_t) * 3;
+const size_t kRecordSize = sizeof(float) * 12 + 1 + kShapeSize + kFilterSize;
+const uint32_t kNoHull = 0xFFFFFFFFu;
+
+const uint8_t kFlagStatic = 1 << 0;
+const uint8_t kFlagOnGround = 1 << 1;
+
+void writeFloats(char*& cursor, std::initializer_list<float> values) {
+    for (float value : values) {
+        std::memcpy(cursor, &value, sizeof(float));
+        cursor += sizeof(float);
+    }
+}
+
+float readFloat(const char*& cursor) {
+    float value;
+    std::memcpy(&value, cursor, sizeof(float));
+    cursor += sizeof(float);
+    return value;
+}
+
+Vec3 readVec3(const char*& cursor) {
+    float x = readFloat(cursor);
+    float y = readFloat(cursor);
+    float z = readFloat(cursor);
+    return Vec3(x, y, z);
+}
+
+template <typename T>
+void writeValue(char*& cursor, T value) {
+    std::memcpy(cursor, &value, sizeof(T));
+    cursor += sizeof(T);
+}
+
+template <typename T>
+T readValue(const char*& cursor) {
+    T value;
+    std::memcpy(&value, cursor, sizeof(T));
+    cursor += sizeof(T);
+    return value;
+}
+
+// Hulls without an index fall back to the box in the size field, which
+// setShape made cover the hull.
+void writeShape(char*& cursor, const Shape& shape, std::span<const ConvexHull* const> hulls) {
+    ShapeType type = shape.type;
+    uint32_t hullIndex = kNoHull;
+    if (type == ShapeType::ConvexHull) {
+        auto found = std::find(hulls.begin(), hulls.end(), shape.hull);
+        if (found == hulls.end()) {
+            type = ShapeType::Box;
+        } else {
+            hullIndex = static_cast<uint32_t>(found - hulls.begin());
+        }
+    }
+    *cursor++ = static_cast<char>(type);
+    writeValue(cursor, hullIndex);
+    writeFloats(cursor, {shape.radius, shape.halfHeight,
+                         shape.halfExtents.x, shape.halfExtents.y, shape.halfExtents.z});
+    for (const Vec3& axis : shape.axes) {
+        writeFloats(cursor, {axis.x, axis.y, axis.z});
+    }
+}
+
+Shape readShape(const char*& cursor, std::span<const ConvexHull* const> hulls) {
+    Shape shape;
+    uint8_t type = static_cast<uint8_t>(*cursor++);
+    uint32_t hullIndex = readValue<uint32_t>(cursor);
+    shape.radius = readFloat(cursor);
+    shape.halfHeight = readFloat(cursor);
+    shape.halfExtents = readVec3(cursor);
+    for (Vec3& axis : shape.axes) {
+        axis = readVec3(cursor);
+    }
+    shape.type = type < physics::collision::ShapeTypeCount ? static_cast<ShapeType>(type) : ShapeType::Box;
+    if (shape.type == ShapeType::ConvexHull) {
+        if (hullIndex < hulls.size()) {
+            shape.hull = hulls[hullIndex];
+        } else {
+            shape.type = ShapeType::Box;
+        }
+    }
+    return shape;
+}
+
+}
+
+size_t RegionKeyHash::operator()(const RegionKey& key) const {
+    uint64_t h = static_cast<uint32_t>(key.x) * 73856093ull;
+    h ^= static_cast<uint32_t>(key.y) * 19349663ull;
+    h ^= static_cast<uint32_t>(key.z) * 83492791ull;
+    return static_cast<size_t>(h);
+}
+
+RegionStreamer::RegionStreamer(World& world, float cellSize, const std::filesystem::path& directory)
+    : world(world), cellSize(cellSize), directory(directory), failedWrites(0), ioBusy(false), stopping(false) {
+    std::filesystem::create_directories(directory);
+    ioThread = std::thread([this]() { ioLoop(); });
+}
+
+RegionStreamer::~RegionStreamer() {
+    {
+        std::lock_guard<std::mutex> lock(ioMutex);
+        stopping = true;
+    }
+    ioWake.notify_all();
+    ioThread.join();
+    // Loads that landed and writes that failed after the last update().
+    integrateLoadedRegions();
+}
+
+ObserverId RegionStreamer::addObserver(const Vec3& position, float radius) {
+    for (size_t i = 0; i < observers.size(); i++) {
+        if (!observers[i].active) {
+            observers[i] = {position, radius, true};
+            return static_cast<ObserverId>(i);
+        }
+    }
+    observers.push_back({position, radius, true});
+    return static_cast<ObserverId>(observers.size() - 1);
+}
+
+void RegionStreamer::setObserverPosition(ObserverId id, const Vec3& position) {
+    if (id < observers.size()) {
+        observers[id].position = position;
+    }
+}
+
+void RegionStreamer::removeObserver(ObserverId id) {
+    if (id < observers.size()) {
+        observers[id].active = false;
+    }
+}
+
+RegionKey RegionStreamer::getRegionKey(const Vec3& position) const {
+    return {static_cast<int32_t>(std::floor(position.x / cellSize)),
+            static_cast<int32_t>(std::floor(position.y / cellSize)),
+            static_cast<int32_t>(std::floor(position.z / cellSize))};
+}
+
+bool RegionStreamer::isRegionActive(const RegionKey& key) const {
+    Vec3 cellMin(key.x * cellSize, key.y * cellSize, key.z * cellSize);
+    Vec3 cellMax = cellMin + Vec3(cellSize, cellSize, cellSize);
+    for (const Observer& observer : observers) {
+        if (!observer.active) continue;
+        Vec3 closest(std::clamp(observer.position.x, cellMin.x, cellMax.x),
+                     std::clamp(observer.position.y, cellMin.y, cellMax.y),
+                     std::clamp(observer.position.z, cellMin.z, cellMax.z));
+        if ((closest - observer.position).lengthSq() <= observer.radius * observer.radius) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool RegionStreamer::isRegionOnDisk(const RegionKey& key) const {
+    auto it = regions.find(key);
+    return it != regions.end() && it->second == RegionState::OnDisk;
+}
+
+size_t RegionStreamer::getPagedOutRegionCount() const {
+    return static_cast<size_t>(std::count_if(regions.begin(), regions.end(),
+        [](const auto& entry) { return entry.second == RegionState::OnDisk; }));
+}
+
+size_t RegionStreamer::getPendingLoadCount() const {
+    return static_cast<size_t>(std::count_if(regions.begin(), regions.end(),
+        [](const auto& entry) { return entry.second == RegionState::Loading; }));
+}
+
+const std::vector<RegionKey>& RegionStreamer::getFailedLoads() const {
+    return failedLoads;
+}
+
+size_t RegionStreamer::getFailedWriteCount() const {
+    return failedWrites;
+}
+
+void RegionStreamer::retryFailedLoads() {
+    failedLoads.clear();
+}
+
+std::filesystem::path RegionStreamer::getRegionPath(const RegionKey& key) const {
+    return directory / ("region_" + std::to_string(key.x) + "_" + std::to_string(key.y) + "_" +
+                        std::to_string(key.z) + ".bin");
+}
+
+void RegionStreamer::registerHull(const ConvexHull& hull) {
+    hulls.push_back(&hull);
+}
+
+void RegionStreamer::update() {
+    integrateLoadedRegions();
+    pageOutInactiveRegions();
+    requestActiveRegions();
+}
+
+void RegionStreamer::pageOutInactiveRegions() {
+    std::unordered_map<RegionKey, bool, RegionKeyHash> activeCache;
+    std::unordered_map<RegionKey, std::vector<size_t>, RegionKeyHash> outgoing;
+
+    for (size_t i = 0; i < world.getBodyCount(); i++) {
+        RegionKey key = getRegionKey(world.getBody(i)->position);
+        auto cached = activeCache.find(key);
+        if (cached == activeCache.end()) {
+            // Regions with a load in flight stay resident until it lands
+            auto region = regions.find(key);
+            bool keep = isRegionActive(key) || (region != regions.end() && region->second == RegionState::Loading);
+            cached = activeCache.emplace(key, keep).first;
+        }
+        if (!cached->second) {
+            outgoing[key].push_back(i);
+        }
+    }
+    if (outgoing.empty()) return;
+
+    std::vector<BodyId> removedIds;
+    {
+        std::lock_guard<std::mutex> lock(ioMutex);
+        for (auto& [key, indices] : outgoing) {
+            std::vector<const RigidBody*> regionBodies;
+            regionBodies.reserve(indices.size());
+            for (size_t index : indices) {
+                regionBodies.push_back(world.getBody(index));
+                removedIds.push_back(world.getBodyId(index));
+            }
+            ioRequests.push_back({key, true, serializeBodies(regionBodies, hulls)});
+            regions[key] = RegionState::OnDisk;
+        }
+    }
+    ioWake.notify_one();
+    world.removeBodies(removedIds);
+}
+
+void RegionStreamer::requestActiveRegions() {
+    bool queued = false;
+    std::lock_guard<std::mutex> lock(ioMutex);
+    for (const Observer& observer : observers) {
+        if (!observer.active) continue;
+        Vec3 extent(observer.radius, observer.radius, observer.radius);
+        RegionKey low = getRegionKey(observer.position - extent);
+        RegionKey high = getRegionKey(observer.position + extent);
+        for (int32_t z = low.z; z <= high.z; z++) {
+            for (int32_t y = low.y; y <= high.y; y++) {
+                for (int32_t x = low.x; x <= high.x; x++) {
+                    RegionKey key{x, y, z};
+                    auto region = regions.find(key);
+                    if (region == regions.end() || region->second != RegionState::OnDisk) continue;
+                    if (!isRegionActive(key)) continue;
+                    if (std::find(failedLoads.begin(), failedLoads.end(), key) != failedLoads.end()) continue;
+                    region->second = RegionState::Loading;
+                    ioRequests.push_back({key, false, {}});
+                    queued = true;
+                }
+            }
+        }
+    }
+    if (queued) ioWake.notify_one();
+}
+
+void RegionStreamer::integrateLoadedRegions() {
+    std::vector<IOResult> results;
+    {
+        std::lock_guard<std::mutex> lock(ioMutex);
+        results.swap(completedIO);
+    }
+    for (IOResult& result : results) {
+        switch (result.status) {
+            case IOStatus::Written:
+                break;
+            case IOStatus::Loaded:
+                for (const RigidBody& body : deserializeBodies(result.records, hulls)) {
+                    world.addBody(std::make_unique<RigidBody>(body));
+                }
+                regions.erase(result.key);
+                break;
+            case IOStatus::LoadFailed:
+                regions[result.key] = RegionState::OnDisk;
+                if (std::find(failedLoads.begin(), failedLoads.end(), result.key) == failedLoads.end()) {
+                    failedLoads.push_back(result.key);
+                }
+                break;
+            case IOStatus::WriteFailed: {
+                failedWrites++;
+                for (const RigidBody& body : deserializeBodies(result.records, hulls)) {
+                    world.addBody(std::make_unique<RigidBody>(body));
+                }
+                // With nothing left on disk the region is simply resident
+                // again. A load queued meanwhile finds no file and loads
+                // nothing.
+                auto region = regions.find(result.key);
+                if (!result.fileKept && region != regions.end() && region->second == RegionState::OnDisk) {
+                    regions.erase(region);
+                }
+                break;
+            }
+        }
+    }
+}
+
+void RegionStreamer::waitForPendingIO() {
+    std::unique_lock<std::mutex> lock(ioMutex);
+    ioIdle.wait(lock, [this]() { return ioRequests.empty() && !ioBusy; });
+}
+
+void RegionStreamer::ioLoop() {
+    for (;;) {
+        IORequest request;
+        {
+            std::unique_lock<std::mutex> lock(ioMutex);
+            ioWake.wait(lock, [this]() { return stopping || !ioRequests.empty(); });
+            if (ioRequests.empty()) return;
+            request = std::move(ioRequests.front());
+            ioRequests.pop_front();
+            ioBusy = true;
+        }
+
+        IOResult result = request.write ? writeRegion(request) : readRegion(request);
+
+        {
+            std::lock_guard<std::mutex> lock(ioMutex);
+            if (result.status != IOStatus::Written) {
+                completedIO.push_back(std::move(result));
+            }
+            ioBusy = false;
+        }
+        ioIdle.notify_all();
+    }
+}
+
+// Appends the records. On failure the file is cut back to its old size
+// (or removed if it was new) and the bodies go back to the world.
+RegionStreamer::IOResult RegionStreamer::writeRegion(const IORequest& request) {
+    std::filesystem::path path = getRegionPath(request.key);
+    std::error_code error;
+    std::filesystem::file_status status = std::filesystem::status(path, error);
+    bool fresh = status.type() == std::filesystem::file_type::not_found;
+    bool regular = std::filesystem::is_regular_file(status);
+    error.clear();
+    uintmax_t previousSize = regular ? std::filesystem::file_size(path, error) : 0;
+    bool written = false;
+    if ((fresh || regular) && !error) {
+        std::ofstream file(path, std::ios::binary | std::ios::app);
+        if (file && fresh) {
+            file.write(kRegionMagic, sizeof(kRegionMagic));
+            file.write(reinterpret_cast<const char*>(&kRegionVersion), sizeof(kRegionVersion));
+        }
+        if (file) {
+            file.write(request.data.data(), static_cast<std::streamsize>(request.data.size()));
+        }
+        file.close();
+        written = file.good();
+    }
+    if (written) {
+        return IOResult{request.key, IOStatus::Written, {}, true};
+    }
+    if (fresh) {
+        if (std::filesystem::is_regular_file(path, error)) std::filesystem::remove(path, error);
+    } else if (regular) {
+        std::filesystem::resize_file(path, previousSize, error);
+    }
+    return IOResult{request.key, IOStatus::WriteFailed, request.data, regular && !fresh};
+}
+
+// The file is only removed once it has been read and parsed completely. A
+// missing file holds no bodies, so it loads as empty.
+RegionStreamer::IOResult RegionStreamer::readRegion(const IORequest& request) {
+    std::filesystem::path path = getRegionPath(request.key);
+    std::error_code error;
+    std::filesystem::file_status status = std::filesystem::status(path, error);
+    if (status.type() == std::filesystem::file_type::not_found) {
+        return IOResult{request.key, IOStatus::Loaded, {}, false};
+    }
+    IOResult failed{request.key, IOStatus::LoadFailed, {}, true};
+    if (!std::filesystem::is_regular_file(status)) return failed;
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return failed;
+    std::vector<char> contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (file.bad()) return failed;
+    file.close();
+
+    uint32_t version = 0;
+    if (contents.size() < kHeaderSize || std::memcmp(contents.data(), kRegionMagic, sizeof(kRegionMagic)) != 0) {
+        return failed;
+    }
+    std::memcpy(&version, contents.data() + sizeof(kRegionMagic), sizeof(version));
+    if (version != kRegionVersion || (contents.size() - kHeaderSize) % kRecordSize != 0) return failed;
+
+    // A file that stays behind would be loaded again later.
+    if (!std::filesystem::remove(path, error) || error) return failed;
+    contents.erase(contents.begin(), contents.begin() + kHeaderSize);
+    return IOResult{request.key, IOStatus::Loaded, std::move(contents), false};
+}
+
+std::vector<char> RegionStreamer::serializeBodies(const std::vector<const RigidBody*>& bodies,
+                                                  std::span<const ConvexHull* const> hulls) {
+    std::vector<char> data(bodies.size() * kRecordSize);
+    char* cursor = data.data();
+    for (const RigidBody* body : bodies) {
+        writeFloats(cursor, {body->position.x, body->position.y, body->position.z,
+                             body->velocity.x, body->velocity.y, body->velocity.z,
+                             body->size.x, body->size.y, body->size.z,
+                             body->mass, body->friction, body->restitution});
+        uint8_t flags = (body->isStatic ? kFlagStatic : 0) | (body->onGround ? kFlagOnGround : 0);
+        *cursor++ = static_cast<char>(flags);
+        writeShape(cursor, body->shape, hulls);
+        writeValue(cursor, body->filter.category);
+        writeValue(cursor, body->filter.mask);
+        writeValue(cursor, body->filter.group);
+    }
+    assert(cursor == data.data() + data.size() && "region record size does not match its fields");
+    return data;
+}
+
+std::vector<RigidBody> RegionStreamer::deserializeBodies(const std::vector<char>& data,
+                                                        std::span<const ConvexHull* const> hulls) {
+    std::vector<RigidBody> bodies;
+    size_t count = data.size() / kRecordSize;
+    bodies.reserve(count);
+    const char* cursor = data.data();
+    for (size_t i = 0; i < count; i++) {
+        Vec3 position = readVec3(cursor);
+        Vec3 velocity = readVec3(cursor);
+        Vec3 size = readVec3(cursor);
+        float mass = readFloat(cursor);
+        float friction = readFloat(cursor);
+        float restitution = readFloat(cursor);
+        uint8_t flags = static_cast<uint8_t>(*cursor++);
+        Shape shape = readShape(cursor, hulls);
+        physics::collision::CollisionFilter filter;
+        filter.category = readValue<uint32_t>(cursor);
+        filter.mask = readValue<uint32_t>(cursor);
+        filter.group = readValue<int32_t>(cursor);
+
+        RigidBody body(position, size, (flags & kFlagStatic) ? 0.0f : mass);
+        body.velocity = velocity;
+        body.friction = friction;
+        body.restitution = restitution;
+        body.onGround = (flags & kFlagOnGround) != 0;
+        // size was saved after setShape, so assigning keeps it as it was.
+        body.shape = shape;
+        body.filter = filter;
+        bodies.push_back(body);
+    }
+    assert(cursor == data.data() + count * kRecordSize && "region record size does not match its fields");
+    return bodies;
+}
+
+}
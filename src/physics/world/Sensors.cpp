@@ -0,0 +1,271 @@
+#include "physics/world/Sensors.h"
+#include <algorithm>
+#include <cmath>
+
+namespace physics::world {
+
+using AABB = physics::collision::AABB;
+
+namespace {
+int32_t cellCoordinate(float value, float inverseCellSize) {
+    float cell = std::floor(value * inverseCellSize);
+    return static_cast<int32_t>(std::clamp(cell, -1048576.0f, 1048575.0f));
+}
+}
+
+SensorSystem::SensorSystem(float cellSize)
+    : cellSize(cellSize), inverseCellSize(1.0f / cellSize), sensorCount(0), overlapCount(0), queryStamp(0) {}
+
+SensorId SensorSystem::add(const AABB& bounds) {
+    SensorId id;
+    if (!freeSensorIds.empty()) {
+        id = freeSensorIds.back();
+        freeSensorIds.pop_back();
+        sensorBounds[id] = bounds;
+    } else {
+        id = static_cast<SensorId>(sensorBounds.size());
+        sensorBounds.push_back(bounds);
+        sensorAlive.push_back(0);
+        sensorEdited.push_back(0);
+        queryStamps.push_back(0);
+    }
+    sensorAlive[id] = 1;
+    sensorCount++;
+    insertIntoGrid(id);
+    if (!sensorEdited[id]) {
+        sensorEdited[id] = 1;
+        editedSensors.push_back(id);
+    }
+    return id;
+}
+
+void SensorSystem::remove(SensorId id) {
+    if (!isValid(id)) return;
+    removeFromGrid(id);
+    sensorAlive[id] = 0;
+    sensorCount--;
+    if (!sensorEdited[id]) {
+        sensorEdited[id] = 1;
+        editedSensors.push_back(id);
+    }
+}
+
+void SensorSystem::move(SensorId id, const AABB& bounds) {
+    if (!isValid(id)) return;
+    removeFromGrid(id);
+    sensorBounds[id] = bounds;
+    insertIntoGrid(id);
+    if (!sensorEdited[id]) {
+        sensorEdited[id] = 1;
+        editedSensors.push_back(id);
+    }
+}
+
+// Drops every sensor and overlap without reporting exits.
+void SensorSystem::clear() {
+    sensorBounds.clear();
+    sensorAlive.clear();
+    sensorEdited.clear();
+    freeSensorIds.clear();
+    editedSensors.clear();
+    queryStamps.clear();
+    grid.clear();
+    for (std::vector<SensorId>& overlaps : bodyOverlaps) {
+        overlaps.clear();
+    }
+    sensorCount = 0;
+    overlapCount = 0;
+    pendingEvents.clear();
+    events.clear();
+}
+
+bool SensorSystem::isValid(SensorId id) const {
+    return id < sensorAlive.size() && sensorAlive[id];
+}
+
+size_t SensorSystem::getCount() const {
+    return sensorCount;
+}
+
+const AABB& SensorSystem::getBounds(SensorId id) const {
+    return sensorBounds[id];
+}
+
+std::span<const SensorId> SensorSystem::getOverlaps(BodyId body) const {
+    if (body >= bodyOverlaps.size()) return {};
+    return std::span<const SensorId>(bodyOverlaps[body].data(), bodyOverlaps[body].size());
+}
+
+size_t SensorSystem::getOverlapCount() const {
+    return overlapCount;
+}
+
+bool SensorSystem::hasPendingWork() const {
+    return sensorCount > 0 || !editedSensors.empty() || !pendingEvents.empty() || !events.empty();
+}
+
+std::span<const SensorEvent> SensorSystem::getEvents() const {
+    return std::span<const SensorEvent>(events.data(), events.size());
+}
+
+SensorSystem::CellRange SensorSystem::cellRange(const AABB& bounds) const {
+    return CellRange{{cellCoordinate(bounds.min.x, inverseCellSize), cellCoordinate(bounds.min.y, inverseCellSize),
+                      cellCoordinate(bounds.min.z, inverseCellSize)},
+                     {cellCoordinate(bounds.max.x, inverseCellSize), cellCoordinate(bounds.max.y, inverseCellSize),
+                      cellCoordinate(bounds.max.z, inverseCellSize)}};
+}
+
+uint64_t SensorSystem::cellKey(int32_t x, int32_t y, int32_t z) {
+    const uint64_t mask = (1u << 21) - 1;
+    return ((static_cast<uint64_t>(x) & mask) << 42) | ((static_cast<uint64_t>(y) & mask) << 21) |
+           (static_cast<uint64_t>(z) & mask);
+}
+
+void SensorSystem::insertIntoGrid(SensorId id) {
+    CellRange range = cellRange(sensorBounds[id]);
+    for (int32_t x = range.min[0]; x <= range.max[0]; x++) {
+        for (int32_t y = range.min[1]; y <= range.max[1]; y++) {
+            for (int32_t z = range.min[2]; z <= range.max[2]; z++) {
+                grid[cellKey(x, y, z)].push_back(id);
+            }
+        }
+    }
+}
+
+void SensorSystem::removeFromGrid(SensorId id) {
+    CellRange range = cellRange(sensorBounds[id]);
+    for (int32_t x = range.min[0]; x <= range.max[0]; x++) {
+        for (int32_t y = range.min[1]; y <= range.max[1]; y++) {
+            for (int32_t z = range.min[2]; z <= range.max[2]; z++) {
+                auto cell = grid.find(cellKey(x, y, z));
+                if (cell == grid.end()) continue;
+                std::vector<SensorId>& sensors = cell->second;
+                auto it = std::find(sensors.begin(), sensors.end(), id);
+                if (it != sensors.end()) {
+                    *it = sensors.back();
+                    sensors.pop_back();
+                }
+                if (sensors.empty()) grid.erase(cell);
+            }
+        }
+    }
+}
+
+std::vector<SensorId>& SensorSystem::overlapsOf(BodyId body) {
+    if (body >= bodyOverlaps.size()) {
+        bodyOverlaps.resize(body + 1);
+    }
+    return bodyOverlaps[body];
+}
+
+void SensorSystem::update(std::span<const AABB> bounds, const BodyId* ids, std::span<const uint32_t> changed) {
+    events.clear();
+    events.insert(events.end(), pendingEvents.begin(), pendingEvents.end());
+    pendingEvents.clear();
+
+    for (SensorId id : editedSensors) {
+        refreshEditedSensor(id, bounds, ids);
+        sensorEdited[id] = 0;
+        if (!sensorAlive[id]) {
+            freeSensorIds.push_back(id);
+        }
+    }
+    editedSensors.clear();
+
+    if (sensorCount == 0 && overlapCount == 0) return;
+    for (uint32_t slot : changed) {
+        refreshBody(ids[slot], bounds[slot]);
+    }
+}
+
+// Brute-force pass for a sensor that was added, moved or removed: checks it
+// against every body and fixes up their overlap lists.
+void SensorSystem::refreshEditedSensor(SensorId id, std::span<const AABB> bounds, const BodyId* ids) {
+    bool alive = sensorAlive[id] != 0;
+    for (size_t slot = 0; slot < bounds.size(); slot++) {
+        BodyId body = ids[slot];
+        bool overlapping = alive && sensorBounds[id].intersects(bounds[slot]);
+        if (!overlapping && body >= bodyOverlaps.size()) continue;
+        std::vector<SensorId>& overlaps = overlapsOf(body);
+        auto it = std::lower_bound(overlaps.begin(), overlaps.end(), id);
+        bool wasOverlapping = it != overlaps.end() && *it == id;
+        if (overlapping == wasOverlapping) continue;
+        if (overlapping) {
+            overlaps.insert(it, id);
+            overlapCount++;
+            events.push_back({SensorEventType::Enter, id, body});
+        } else {
+            overlaps.erase(it);
+            overlapCount--;
+            events.push_back({SensorEventType::Exit, id, body});
+        }
+    }
+}
+
+void SensorSystem::refreshBody(BodyId body, const AABB& bounds) {
+    if (++queryStamp == 0) {
+        std::fill(queryStamps.begin(), queryStamps.end(), 0);
+        queryStamp = 1;
+    }
+
+    scratch.clear();
+    CellRange range = cellRange(bounds);
+    uint64_t cellCount = static_cast<uint64_t>(range.max[0] - range.min[0] + 1) *
+                         static_cast<uint64_t>(range.max[1] - range.min[1] + 1) *
+                         static_cast<uint64_t>(range.max[2] - range.min[2] + 1);
+    if (cellCount > sensorCount) {
+        // Bodies spanning more cells than there are sensors test them all.
+        for (SensorId id = 0; id < sensorBounds.size(); id++) {
+            if (sensorAlive[id] && sensorBounds[id].intersects(bounds)) scratch.push_back(id);
+        }
+    } else {
+        for (int32_t x = range.min[0]; x <= range.max[0]; x++) {
+            for (int32_t y = range.min[1]; y <= range.max[1]; y++) {
+                for (int32_t z = range.min[2]; z <= range.max[2]; z++) {
+                    auto cell = grid.find(cellKey(x, y, z));
+                    if (cell == grid.end()) continue;
+                    for (SensorId id : cell->second) {
+                        if (queryStamps[id] == queryStamp) continue;
+                        queryStamps[id] = queryStamp;
+                        if (sensorBounds[id].intersects(bounds)) scratch.push_back(id);
+                    }
+                }
+            }
+        }
+        std::sort(scratch.begin(), scratch.end());
+    }
+
+    if (scratch.empty() && (body >= bodyOverlaps.size() || bodyOverlaps[body].empty())) return;
+    std::vector<SensorId>& overlaps = overlapsOf(body);
+    size_t i = 0;
+    size_t j = 0;
+    while (i < overlaps.size() || j < scratch.size()) {
+        if (j == scratch.size() || (i < overlaps.size() && overlaps[i] < scratch[j])) {
+            events.push_back({SensorEventType::Exit, overlaps[i++], body});
+        } else if (i == overlaps.size() || scratch[j] < overlaps[i]) {
+            events.push_back({SensorEventType::Enter, scratch[j++], body});
+        } else {
+            i++;
+            j++;
+        }
+    }
+    overlapCount = overlapCount - overlaps.size() + scratch.size();
+    overlaps.assign(scratch.begin(), scratch.end());
+}
+
+void SensorSystem::bodyRemoved(BodyId body) {
+    if (body >= bodyOverlaps.size()) return;
+    for (SensorId id : bodyOverlaps[body]) {
+        pendingEvents.push_back({SensorEventType::Exit, id, body});
+    }
+    overlapCount -= bodyOverlaps[body].size();
+    bodyOverlaps[body].clear();
+}
+
+void SensorSystem::allBodiesRemoved() {
+    for (BodyId body = 0; body < bodyOverlaps.size(); body++) {
+        bodyRemoved(body);
+    }
+}
+
+}
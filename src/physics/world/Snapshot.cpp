@@ -0,0 +1,44 @@
+#include "physics/world/Snapshot.h"
+#include <algorithm>
+#include <cmath>
+
+namespace physics::world {
+
+using Vec3 = physics::math::Vec3;
+using AABB = physics::collision::AABB;
+
+namespace {
+const float kQuantizedMax = 65535.0f;
+
+uint16_t quantizeAxis(float value, float min, float max) {
+    float extent = max - min;
+    if (!(extent > 0.0f)) return 0;
+    float t = std::clamp((value - min) / extent, 0.0f, 1.0f);
+    return static_cast<uint16_t>(std::lround(t * kQuantizedMax));
+}
+
+float dequantizeAxis(uint16_t value, float min, float max) {
+    return min + (max - min) * (static_cast<float>(value) / kQuantizedMax);
+}
+}
+
+QuantizedPosition quantizePosition(const Vec3& position, const AABB& range) {
+    return QuantizedPosition{quantizeAxis(position.x, range.min.x, range.max.x),
+                             quantizeAxis(position.y, range.min.y, range.max.y),
+                             quantizeAxis(position.z, range.min.z, range.max.z)};
+}
+
+Vec3 dequantizePosition(const QuantizedPosition& position, const AABB& range) {
+    return Vec3(dequantizeAxis(position.x, range.min.x, range.max.x),
+                dequantizeAxis(position.y, range.min.y, range.max.y),
+                dequantizeAxis(position.z, range.min.z, range.max.z));
+}
+
+void quantizePositions(std::span<const Vec3> positions, std::span<const uint32_t> slots, const AABB& range,
+                       QuantizedPosition* out) {
+    for (size_t i = 0; i < slots.size(); i++) {
+        out[i] = quantizePosition(positions[slots[i]], range);
+    }
+}
+
+}
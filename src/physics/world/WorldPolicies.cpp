@@ -0,0 +1,81 @@
+#include "physics/world/WorldPolicies.h"
+#include <algorithm>
+#include <cmath>
+
+namespace physics::world {
+
+using AABB = physics::collision::AABB;
+using SweepAndPrune = physics::collision::SweepAndPrune;
+using SweepEntry = physics::collision::SweepEntry;
+
+SweepAndPruneBroadphase::SweepAndPruneBroadphase(std::pmr::memory_resource* scratch)
+    : scratch(scratch), entries(scratch) {}
+
+void SweepAndPruneBroadphase::prepare(const AABB* bounds, size_t first, size_t count) {
+    SweepAndPrune::sortEntries(bounds, count, entries, first);
+}
+
+void SweepAndPruneBroadphase::release() {
+    std::pmr::vector<SweepEntry>(scratch).swap(entries);
+}
+
+UniformGridBroadphase::UniformGridBroadphase(std::pmr::memory_resource* scratch)
+    : scratch(scratch), entries(scratch), first(0) {}
+
+int32_t UniformGridBroadphase::cellOf(float coordinate) const {
+    return static_cast<int32_t>(std::floor(coordinate / cellSize));
+}
+
+uint32_t UniformGridBroadphase::hashCell(int32_t x, int32_t y, int32_t z) {
+    return (static_cast<uint32_t>(x) * 73856093u) ^ (static_cast<uint32_t>(y) * 19349663u) ^
+           (static_cast<uint32_t>(z) * 83492791u);
+}
+
+void UniformGridBroadphase::prepare(const AABB* bounds, size_t first, size_t count) {
+    this->first = first;
+    entries.clear();
+    for (size_t i = first; i < count; i++) {
+        const AABB& box = bounds[i];
+        for (int32_t x = cellOf(box.min.x); x <= cellOf(box.max.x); x++) {
+            for (int32_t y = cellOf(box.min.y); y <= cellOf(box.max.y); y++) {
+                for (int32_t z = cellOf(box.min.z); z <= cellOf(box.max.z); z++) {
+                    entries.push_back({hashCell(x, y, z), static_cast<uint32_t>(i)});
+                }
+            }
+        }
+    }
+    std::sort(entries.begin(), entries.end(), [](const CellEntry& lhs, const CellEntry& rhs) {
+        return lhs.hash < rhs.hash || (lhs.hash == rhs.hash && lhs.index < rhs.index);
+    });
+    // A body covering two cells whose hashes collide would appear twice in
+    // that hash's run and be paired twice.
+    entries.erase(std::unique(entries.begin(), entries.end(),
+                              [](const CellEntry& lhs, const CellEntry& rhs) {
+                                  return lhs.hash == rhs.hash && lhs.index == rhs.index;
+                              }),
+                  entries.end());
+}
+
+void UniformGridBroadphase::release() {
+    std::pmr::vector<CellEntry>(scratch).swap(entries);
+}
+
+DefaultStorage::DefaultStorage(std::pmr::memory_resource* resource)
+    : storageResource(resource ? resource : std::pmr::get_default_resource()) {}
+
+std::pmr::memory_resource* DefaultStorage::resource() const {
+    return storageResource;
+}
+
+HugePageStorage::HugePageStorage(std::pmr::memory_resource* upstream)
+    : hugePages(physics::memory::HugePageSettings(), upstream ? upstream : std::pmr::new_delete_resource()) {}
+
+std::pmr::memory_resource* HugePageStorage::resource() {
+    return &hugePages;
+}
+
+physics::memory::HugePageResource& HugePageStorage::pages() {
+    return hugePages;
+}
+
+}
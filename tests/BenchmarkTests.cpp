@@ -0,0 +1,61 @@
+#include "physics/bench/Benchmark.h"
+#include "physics/bench/PerfCounters.h"
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+using namespace physics::bench;
+
+void testSummarizeRejectsOutliers() {
+    std::vector<double> samples = {10.0, 10.2, 9.9, 10.1, 10.0, 9.8, 10.3, 50.0, 10.1, 0.5};
+    std::vector<bool> kept;
+    SampleStats stats = Benchmark::summarize(samples, 3.5, &kept);
+    std::cout << "Summary: median=" << stats.median << " mean=" << stats.mean << " rejected=" << stats.rejected << "\n";
+    assert(stats.rejected == 2 && stats.kept == 8);
+    assert(!kept[7] && !kept[9] && kept[0]);
+    assert(stats.min == 9.8 && stats.max == 10.3);
+    assert(std::abs(stats.mean - 10.05) < 1e-9);
+    assert(stats.stddev > 0.0 && stats.stddev < 0.2);
+
+    // Identical samples have no spread and nothing to reject.
+    SampleStats flat = Benchmark::summarize({4.0, 4.0, 4.0, 4.0}, 3.5);
+    assert(flat.kept == 4 && flat.rejected == 0 && flat.stddev == 0.0 && flat.median == 4.0);
+}
+
+void testBenchmarkRun() {
+    BenchmarkOptions options;
+    options.samples = 5;
+    options.warmupRuns = 1;
+    options.minSampleNanos = 20000;
+
+    std::vector<float> values(256, 1.5f);
+    size_t totalCalls = 0;
+    BenchmarkResult result = Benchmark::run("sum", [&](size_t n) {
+        float sum = 0.0f;
+        for (size_t i = 0; i < n; i++) {
+            sum += values[i & 255];
+        }
+        doNotOptimize(sum);
+        totalCalls++;
+    }, options);
+
+    PerfCounters counters;
+    std::cout << "Benchmark sum: " << result.iterations << " iterations/sample, " << result.nanos.median
+              << " ns/op, hardware counters " << (counters.isAvailable() ? "available" : "unavailable") << "\n";
+    assert(result.name == "sum");
+    assert(result.iterations >= 1);
+    assert(result.nanos.kept + result.nanos.rejected == options.samples);
+    assert(result.nanos.median > 0.0);
+    assert(totalCalls >= options.samples + options.warmupRuns);
+    for (uint32_t c = 0; c < PerfCounters::CounterCount; c++) {
+        PerfCounters::Counter counter = static_cast<PerfCounters::Counter>(c);
+        assert(result.hasCounter[c] == counters.hasCounter(counter));
+        if (!result.hasCounter[c]) assert(result.counters[c] == 0.0);
+    }
+}
+
+void runBenchmarkTests() {
+    testSummarizeRejectsOutliers();
+    testBenchmarkRun();
+}
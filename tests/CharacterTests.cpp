@@ -0,0 +1,229 @@
+#include "physics/world/World.h"
+#include "physics/parallel/ThreadPool.h"
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+using namespace physics::world;
+using physics::math::Vec3;
+using physics::dynamics::RigidBody;
+
+namespace {
+const Vec3 kHalfExtents(0.3f, 0.9f, 0.3f);
+
+void addStatic(World& world, const Vec3& center, const Vec3& size) {
+    world.addBody(std::make_unique<RigidBody>(center, size, 0.0f));
+}
+
+// A 200 m floor whose top is at y = 0.
+void addFloor(World& world) {
+    addStatic(world, Vec3(0, -0.5f, 0), Vec3(200, 1, 200));
+}
+
+CharacterId addStanding(World& world, float x, float z) {
+    CharacterId id = world.getCharacters().add(Vec3(x, kHalfExtents.y + 0.05f, z), kHalfExtents);
+    for (int i = 0; i < 10; i++) {
+        world.step();
+    }
+    return id;
+}
+
+void walk(World& world, CharacterId id, const Vec3& direction, int steps) {
+    world.getCharacters().setInput(id, direction, 6.0f);
+    for (int i = 0; i < steps; i++) {
+        world.step();
+    }
+}
+}
+
+void testCharacterWalksOnFloor() {
+    World world;
+    addFloor(world);
+    world.bakeStaticGeometry();
+    CharacterId id = addStanding(world, 0, 0);
+    CharacterSystem& characters = world.getCharacters();
+    assert(characters.isGrounded(id));
+    walk(world, id, Vec3(1, 0, 0), 60);
+    Vec3 position = characters.getPosition(id);
+    assert(characters.isGrounded(id));
+    assert(position.x > 4.0f);
+    assert(std::fabs(position.y - kHalfExtents.y) < 0.02f);
+    assert(std::fabs(characters.getVelocity(id).x - 6.0f) < 0.1f);
+
+    // Friction stops it once the input is released.
+    walk(world, id, Vec3(), 60);
+    assert(characters.getVelocity(id).length() < 1e-3f);
+}
+
+// Walking diagonally into a wall keeps the motion along it.
+void testCharacterSlidesAlongWall() {
+    World world;
+    addFloor(world);
+    addStatic(world, Vec3(3, 1, 0), Vec3(1, 2, 40));
+    world.bakeStaticGeometry();
+    CharacterId id = addStanding(world, 0, 0);
+    walk(world, id, Vec3(1, 0, 1), 120);
+    Vec3 position = world.getCharacters().getPosition(id);
+    assert(position.x < 2.5f - kHalfExtents.x + 1e-3f);
+    assert(position.x > 2.1f);
+    assert(position.z > 4.0f);
+    assert(world.getCharacters().isGrounded(id));
+}
+
+// A stair step is climbed without jumping; a waist-high ledge is not.
+void testCharacterStepsUp() {
+    World world;
+    addFloor(world);
+    addStatic(world, Vec3(5, 0.15f, -5), Vec3(4, 0.3f, 4));
+    addStatic(world, Vec3(5, 0.5f, 5), Vec3(4, 1.0f, 4));
+    world.bakeStaticGeometry();
+    CharacterId low = addStanding(world, 0, -5);
+    CharacterId high = addStanding(world, 0, 5);
+    CharacterSystem& characters = world.getCharacters();
+    characters.setInput(low, Vec3(1, 0, 0), 6.0f);
+    walk(world, high, Vec3(1, 0, 0), 60);
+    assert(characters.getPosition(low).x > 4.0f);
+    assert(std::fabs(characters.getPosition(low).y - (0.3f + kHalfExtents.y)) < 0.02f);
+    assert(characters.isGrounded(low));
+    assert(characters.getPosition(high).x < 3.0f - kHalfExtents.x + 1e-3f);
+    assert(std::fabs(characters.getPosition(high).y - kHalfExtents.y) < 0.02f);
+
+    // Walking back off the step snaps down instead of flying off it.
+    walk(world, low, Vec3(-1, 0, 0), 60);
+    assert(characters.isGrounded(low));
+    assert(std::fabs(characters.getPosition(low).y - kHalfExtents.y) < 0.02f);
+}
+
+void testCharacterJumpsAndLands() {
+    World world;
+    addFloor(world);
+    addStatic(world, Vec3(0, 3.0f, 0), Vec3(4, 0.2f, 4));
+    world.bakeStaticGeometry();
+    CharacterId open = addStanding(world, 10, 0);
+    CharacterId capped = addStanding(world, 0, 0);
+    CharacterSystem& characters = world.getCharacters();
+    characters.setInput(open, Vec3(), 0.0f, true);
+    characters.setInput(capped, Vec3(), 0.0f, true);
+    float apex = 0.0f;
+    bool left = false;
+    for (int i = 0; i < 120; i++) {
+        world.step();
+        apex = std::max(apex, characters.getPosition(open).y);
+        left = left || !characters.isGrounded(open);
+        assert(characters.getPosition(capped).y + kHalfExtents.y < 2.9f + 1e-3f);
+    }
+    float expected = kHalfExtents.y + 5.1f * 5.1f / (2.0f * 9.81f);
+    assert(left);
+    assert(std::fabs(apex - expected) < 0.1f);
+    assert(characters.isGrounded(open) && characters.isGrounded(capped));
+    assert(std::fabs(characters.getPosition(open).y - kHalfExtents.y) < 0.02f);
+}
+
+// Holding a wish direction just under 90 degrees from the velocity, as a
+// player turning while strafing does, adds speed beyond the ground speed.
+void testCharacterAirStrafeGainsSpeed() {
+    World world(Vec3(0, 0, 0));
+    CharacterSystem& characters = world.getCharacters();
+    CharacterId id = characters.add(Vec3(0, 10, 0), kHalfExtents);
+    characters.setVelocity(id, Vec3(6, 0, 0));
+    const CharacterSettings& settings = characters.settings;
+    float gain = settings.airSpeedCap * settings.airAcceleration * world.timeStep;
+    for (int i = 0; i < 120; i++) {
+        Vec3 velocity = characters.getVelocity(id);
+        float angle = std::atan2(velocity.z, velocity.x) + std::acos((settings.airSpeedCap - gain) / velocity.length());
+        characters.setInput(id, Vec3(std::cos(angle), 0, std::sin(angle)), 6.0f);
+        world.step();
+    }
+    float speed = characters.getVelocity(id).length();
+    assert(speed > 6.8f);
+    std::cout << "Air strafe: 6 m/s to " << speed << " m/s in 2 s\n";
+}
+
+// Character chunks run in parallel with integration and give the serial
+// result.
+void testParallelCharactersMatchSerial() {
+    physics::parallel::ThreadPool pool(3);
+    World serial;
+    World parallel;
+    parallel.threadPool = &pool;
+    for (World* world : {&serial, &parallel}) {
+        addFloor(*world);
+        for (int i = 0; i < 40; i++) {
+            float x = -80.0f + static_cast<float>(i) * 4.0f;
+            addStatic(*world, Vec3(x, 0.15f + static_cast<float>(i % 3) * 0.5f, 0), Vec3(1.5f, 0.3f + (i % 3), 60));
+        }
+        world->bakeStaticGeometry();
+        for (int i = 0; i < 5000; i++) {
+            float x = -90.0f + static_cast<float>(i % 100) * 1.8f;
+            float z = -45.0f + static_cast<float>(i / 100) * 1.8f;
+            CharacterId id = world->getCharacters().add(Vec3(x, 3.0f, z), kHalfExtents);
+            world->getCharacters().setInput(id, Vec3(std::cos(static_cast<float>(i)), 0, std::sin(static_cast<float>(i))),
+                                            6.0f, i % 7 == 0);
+        }
+    }
+    for (int i = 0; i < 90; i++) {
+        serial.step();
+        parallel.step();
+    }
+    const CharacterSystem& a = serial.getCharacters();
+    const CharacterSystem& b = parallel.getCharacters();
+    size_t grounded = 0;
+    for (CharacterId id = 0; id < 5000; id++) {
+        Vec3 pa = a.getPosition(id);
+        Vec3 pb = b.getPosition(id);
+        assert(std::memcmp(&pa, &pb, sizeof(Vec3)) == 0);
+        assert(pa.y > kHalfExtents.y - 0.02f);
+        grounded += a.isGrounded(id) ? 1 : 0;
+    }
+    std::cout << "Characters: " << grounded << " of 5000 grounded after 90 steps\n";
+    assert(grounded > 3500);
+}
+
+// Removing a wall drops the bake; the floor is baked again on the next step,
+// so the character keeps standing and walks on through the gap.
+void testCharacterAfterLevelEdit() {
+    World world;
+    addFloor(world);
+    BodyId wall = world.addBody(std::make_unique<RigidBody>(Vec3(3, 1, 0), Vec3(1, 2, 40), 0.0f));
+    world.bakeStaticGeometry();
+    CharacterId id = addStanding(world, 0, 0);
+    walk(world, id, Vec3(1, 0, 0), 60);
+    assert(world.getCharacters().getPosition(id).x < 2.5f);
+
+    std::vector<BodyId> removed = {wall};
+    world.removeBodies(removed);
+    walk(world, id, Vec3(1, 0, 0), 60);
+    Vec3 position = world.getCharacters().getPosition(id);
+    assert(world.getBakedBodyCount() == 1);
+    assert(world.getCharacters().isGrounded(id));
+    assert(std::fabs(position.y - kHalfExtents.y) < 0.02f);
+    assert(position.x > 4.0f);
+}
+
+void testRemovingCharacters() {
+    World world;
+    CharacterSystem& characters = world.getCharacters();
+    CharacterId a = characters.add(Vec3(0, 0, 0), kHalfExtents);
+    CharacterId b = characters.add(Vec3(5, 0, 0), kHalfExtents);
+    characters.remove(a);
+    assert(!characters.isValid(a) && characters.isValid(b));
+    assert(characters.getPosition(b).x == 5.0f);
+    CharacterId c = characters.add(Vec3(7, 0, 0), kHalfExtents);
+    assert(c == a && characters.getCount() == 2);
+    world.clearBodies();
+    assert(characters.getCount() == 2);
+}
+
+void runCharacterTests() {
+    testCharacterWalksOnFloor();
+    testCharacterSlidesAlongWall();
+    testCharacterStepsUp();
+    testCharacterJumpsAndLands();
+    testCharacterAirStrafeGainsSpeed();
+    testParallelCharactersMatchSerial();
+    testCharacterAfterLevelEdit();
+    testRemovingCharacters();
+}
@@ -1,8 +1,12 @@
 #include "physics/collision/CollisionDetection.h"
+#include "physics/collision/BatchNarrowphase.h"
 #include <iostream>
 #include <cassert>
 #include <iomanip>
 #include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
 
 using namespace physics::collision;
 using namespace physics::dynamics;
@@ -167,6 +171,71 @@ void testNoCollisionResponse() {
     assert(bodyB.velocity.x == originalVelB.x && bodyB.velocity.y == originalVelB.y && bodyB.velocity.z == originalVelB.z);
 }
 
+static bool sameBits(float a, float b) {
+    return std::memcmp(&a, &b, sizeof(float)) == 0;
+}
+
+static bool sameContact(const Contact& lhs, const Contact& rhs) {
+    return lhs.indexA == rhs.indexA && lhs.indexB == rhs.indexB && lhs.info.hasCollision == rhs.info.hasCollision &&
+           sameBits(lhs.info.penetrationDepth, rhs.info.penetrationDepth) &&
+           sameBits(lhs.info.normal.x, rhs.info.normal.x) && sameBits(lhs.info.normal.y, rhs.info.normal.y) &&
+           sameBits(lhs.info.normal.z, rhs.info.normal.z) && sameBits(lhs.info.contactPoint.x, rhs.info.contactPoint.x) &&
+           sameBits(lhs.info.contactPoint.y, rhs.info.contactPoint.y) && sameBits(lhs.info.contactPoint.z, rhs.info.contactPoint.z);
+}
+
+void testBatchNarrowphase() {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> coordinate(-4.0f, 4.0f);
+    std::uniform_real_distribution<float> extent(0.25f, 3.0f);
+
+    std::vector<RigidBody> bodies;
+    for (int i = 0; i < 200; i++) {
+        bodies.emplace_back(Vec3(coordinate(rng), coordinate(rng), coordinate(rng)), Vec3(extent(rng), extent(rng), extent(rng)), 1.0f);
+    }
+    // Exactly touching and coincident boxes exercise the tie-breaking paths
+    bodies.emplace_back(Vec3(0, 0, 0), Vec3(1, 1, 1), 1.0f);
+    bodies.emplace_back(Vec3(1, 0, 0), Vec3(1, 1, 1), 1.0f);
+    bodies.emplace_back(Vec3(0, 0, 0), Vec3(1, 1, 1), 1.0f);
+
+    std::vector<AABB> bounds;
+    std::vector<Vec3> positions;
+    for (const RigidBody& body : bodies) {
+        bounds.push_back(body.getAABB());
+        positions.push_back(body.position);
+    }
+
+    std::vector<BodyPair> pairs;
+    for (uint32_t a = 0; a < bodies.size(); a++) {
+        for (uint32_t b = a + 1; b < bodies.size(); b += 3) {
+            pairs.push_back({a, b});
+        }
+    }
+    pairs.push_back({200, 201});
+    pairs.push_back({200, 202});
+
+    std::vector<Contact> expected;
+    for (const BodyPair& pair : pairs) {
+        CollisionInfo info = CollisionDetection::getAABBCollisionInfo(bodies[pair.a], bodies[pair.b]);
+        if (info.hasCollision && info.penetrationDepth > 0.0f) {
+            expected.push_back({pair.a, pair.b, info});
+        }
+    }
+
+    std::vector<Contact> batched(pairs.size());
+    std::vector<Contact> scalar(pairs.size());
+    size_t batchedCount = BatchNarrowphase::findContacts(bounds.data(), positions.data(), pairs, batched.data());
+    size_t scalarCount = BatchNarrowphase::findContactsScalar(bounds.data(), positions.data(), pairs, scalar.data());
+
+    bool matches = batchedCount == expected.size() && scalarCount == expected.size();
+    for (size_t i = 0; matches && i < expected.size(); i++) {
+        matches = sameContact(batched[i], expected[i]) && sameContact(scalar[i], expected[i]);
+    }
+    std::cout << "Batch narrowphase (avx2=" << (BatchNarrowphase::hasAvx2() ? "true" : "false") << "): " << pairs.size()
+              << " pairs, " << batchedCount << " contacts, bit-identical to scalar: " << (matches ? "true" : "false") << "\n";
+    assert(matches);
+    assert(batchedCount > 0);
+}
+
 void runCollisionDetectionTests() {
     testGroundCollisionDetection();
     testGroundCollisionResponse();
@@ -175,4 +244,5 @@ void runCollisionDetectionTests() {
     testStaticBodyCollisions();
     testMultiAxisCollisions();
     testNoCollisionResponse();
+    testBatchNarrowphase();
 }
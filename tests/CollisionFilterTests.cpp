@@ -0,0 +1,165 @@
+#include "physics/world/World.h"
+#include "physics/collision/Broadphase.h"
+#include "physics/parallel/ThreadPool.h"
+#include <iostream>
+#include <cassert>
+#include <algorithm>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+using namespace physics::world;
+using physics::math::Vec3;
+using physics::dynamics::RigidBody;
+using physics::collision::AABB;
+using physics::collision::BodyPair;
+using physics::collision::CollisionFilter;
+using physics::collision::SweepAndPrune;
+
+namespace {
+const uint32_t kStatic = 1 << 0;
+const uint32_t kDebris = 1 << 1;
+const uint32_t kCharacter = 1 << 2;
+
+bool hasPair(std::span<const BodyPair> pairs, size_t a, size_t b) {
+    for (const BodyPair& pair : pairs) {
+        if ((pair.a == a && pair.b == b) || (pair.a == b && pair.b == a)) return true;
+    }
+    return false;
+}
+}
+
+void testShouldCollideRules() {
+    CollisionFilter any;
+    CollisionFilter debris{kDebris, kStatic | kCharacter, 0};
+    CollisionFilter character{kCharacter, kStatic | kDebris | kCharacter, 0};
+    assert(CollisionFilter::shouldCollide(any, any));
+    assert(!CollisionFilter::shouldCollide(debris, debris));
+    assert(CollisionFilter::shouldCollide(debris, character));
+    assert(CollisionFilter::shouldCollide(character, debris));
+
+    // Masks must agree both ways.
+    CollisionFilter deaf{kCharacter, kStatic, 0};
+    assert(!CollisionFilter::shouldCollide(deaf, character));
+    assert(!CollisionFilter::shouldCollide(character, deaf));
+
+    // A shared group overrides the masks.
+    CollisionFilter owner{kCharacter, kStatic | kDebris | kCharacter, -3};
+    CollisionFilter projectile{kCharacter, kStatic | kDebris | kCharacter, -3};
+    assert(!CollisionFilter::shouldCollide(owner, projectile));
+    CollisionFilter ragdollA{kDebris, 0, 5};
+    CollisionFilter ragdollB{kDebris, 0, 5};
+    assert(CollisionFilter::shouldCollide(ragdollA, ragdollB));
+    // Different groups fall back to the masks.
+    projectile.group = -4;
+    assert(CollisionFilter::shouldCollide(owner, projectile));
+    std::cout << "Collision filter rules: masks both ways, groups override\n";
+}
+
+void testBroadphaseSkipsFilteredPairs() {
+    std::vector<AABB> bounds = {
+        AABB(Vec3(0, 0, 0), Vec3(2, 2, 2)),
+        AABB(Vec3(1, 1, 1), Vec3(3, 3, 3)),
+        AABB(Vec3(1.5f, 0, 0), Vec3(2.5f, 1, 1)),
+    };
+    std::vector<CollisionFilter> filters = {
+        {kDebris, kStatic, 0},
+        {kDebris, kStatic, 0},
+        {kStatic, ~0u, 0},
+    };
+    std::pmr::vector<BodyPair> unfiltered;
+    SweepAndPrune::findPairs(bounds.data(), bounds.size(), unfiltered, std::pmr::get_default_resource());
+    assert(unfiltered.size() == 3);
+
+    std::pmr::vector<BodyPair> filtered;
+    SweepAndPrune::findPairs(bounds.data(), bounds.size(), filtered, std::pmr::get_default_resource(), filters.data());
+    std::span<const BodyPair> view(filtered.data(), filtered.size());
+    assert(filtered.size() == 2);
+    assert(!hasPair(view, 0, 1));
+    assert(hasPair(view, 0, 2));
+    assert(hasPair(view, 1, 2));
+}
+
+// Debris lands on the floor but falls through other debris; the projectile
+// passes through its owner and still hits the wall.
+void testWorldCollisionFiltering(physics::parallel::ThreadPool* pool) {
+    World world;
+    world.threadPool = pool;
+    auto floor = std::make_unique<RigidBody>(Vec3(0, -0.5f, 0), Vec3(40, 1, 40), 0.0f);
+    floor->filter = {kStatic, ~0u, 0};
+    world.addBody(std::move(floor));
+
+    std::vector<BodyId> debris;
+    for (int i = 0; i < 4; i++) {
+        auto piece = std::make_unique<RigidBody>(Vec3(0, 0.5f + 1.2f * i, 0), Vec3(1, 1, 1), 1.0f);
+        piece->restitution = 0.0f;
+        piece->filter = {kDebris, kStatic | kCharacter, 0};
+        debris.push_back(world.addBody(std::move(piece)));
+    }
+
+    auto owner = std::make_unique<RigidBody>(Vec3(10, 1, 0), Vec3(1, 2, 1), 0.0f);
+    owner->filter = {kCharacter, ~0u, -1};
+    BodyId ownerId = world.addBody(std::move(owner));
+    auto wall = std::make_unique<RigidBody>(Vec3(14, 1.5f, 0), Vec3(1, 3, 3), 0.0f);
+    BodyId wallId = world.addBody(std::move(wall));
+    auto bullet = std::make_unique<RigidBody>(Vec3(10, 1, 0), Vec3(0.2f, 0.2f, 0.2f), 0.1f);
+    bullet->velocity = Vec3(6, 0, 0);
+    bullet->acceleration = Vec3(0, 9.81f, 0);
+    bullet->restitution = 0.0f;
+    bullet->filter = {kCharacter, ~0u, -1};
+    BodyId bulletId = world.addBody(std::move(bullet));
+
+    for (int i = 0; i < 90; i++) {
+        world.step();
+        for (const Contact& contact : world.getContacts()) {
+            BodyId a = world.getBodyId(contact.indexA);
+            BodyId b = world.getBodyId(contact.indexB);
+            bool debrisA = std::find(debris.begin(), debris.end(), a) != debris.end();
+            bool debrisB = std::find(debris.begin(), debris.end(), b) != debris.end();
+            assert(!(debrisA && debrisB));
+            assert(!((a == ownerId && b == bulletId) || (a == bulletId && b == ownerId)));
+        }
+        for (const BodyPair& pair : world.getCandidatePairs()) {
+            assert(CollisionFilter::shouldCollide(world.getBody(pair.a)->filter, world.getBody(pair.b)->filter));
+        }
+    }
+
+    // With no debris-debris contacts every piece sinks to the floor.
+    for (BodyId id : debris) {
+        assert(world.getBodyById(id)->position.y < 0.6f);
+    }
+    const RigidBody& shot = *world.getBodyById(bulletId);
+    const RigidBody& target = *world.getBodyById(wallId);
+    assert(shot.position.x < target.position.x - 0.5f);
+    std::cout << "Collision filtering (" << (pool ? "pool" : "serial") << "): bullet x=" << shot.position.x
+              << ", debris heights " << world.getBodyById(debris[0])->position.y << ".."
+              << world.getBodyById(debris.back())->position.y << "\n";
+}
+
+// Changing a body's filter takes effect on the next step.
+void testFilterChangeTakesEffect() {
+    World world;
+    world.gravity = Vec3(0, 0, 0);
+    world.addBody(std::make_unique<RigidBody>(Vec3(0, 0, 0), Vec3(1, 1, 1), 1.0f));
+    BodyId other = world.addBody(std::make_unique<RigidBody>(Vec3(0.5f, 0, 0), Vec3(1, 1, 1), 1.0f));
+    world.step();
+    assert(world.getCandidatePairs().size() == 1);
+
+    world.getBodyById(other)->filter.mask = 0;
+    world.step();
+    assert(world.getCandidatePairs().empty());
+    assert(world.getContacts().empty());
+
+    world.getBodyById(other)->filter.mask = ~0u;
+    world.step();
+    assert(world.getCandidatePairs().size() == 1);
+}
+
+void runCollisionFilterTests() {
+    testShouldCollideRules();
+    testBroadphaseSkipsFilteredPairs();
+    testWorldCollisionFiltering(nullptr);
+    physics::parallel::ThreadPool pool(3);
+    testWorldCollisionFiltering(&pool);
+    testFilterChangeTakesEffect();
+}
@@ -0,0 +1,138 @@
+#include "physics/world/World.h"
+#include "physics/memory/AllocationCounter.h"
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace physics::world;
+using physics::math::Vec3;
+using physics::dynamics::RigidBody;
+
+namespace {
+const int kProducers = 4;
+const int kSpawnsPerProducer = 1000;
+
+// Every producer spawns its bodies from its own thread; the ids they get
+// must not depend on how the threads interleave.
+void spawnFromThreads(World& world, std::vector<BodyId>& ids) {
+    ids.assign(kProducers * kSpawnsPerProducer, InvalidBodyId);
+    std::vector<std::thread> threads;
+    for (int p = 0; p < kProducers; p++) {
+        threads.emplace_back([&world, &ids, p]() {
+            CommandWriter writer = world.getCommands().writer(static_cast<uint32_t>(p));
+            for (int i = 0; i < kSpawnsPerProducer; i++) {
+                Vec3 position(static_cast<float>(p) * 10.0f, 0, static_cast<float>(i) * 2.0f);
+                writer.spawn(std::make_unique<RigidBody>(position, Vec3(1, 1, 1), 1.0f), &ids[p * kSpawnsPerProducer + i]);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+}
+
+void testSpawnsAreDeterministic() {
+    World first(Vec3(0, 0, 0));
+    World second(Vec3(0, 0, 0));
+    std::vector<BodyId> firstIds;
+    std::vector<BodyId> secondIds;
+    spawnFromThreads(first, firstIds);
+    spawnFromThreads(second, secondIds);
+    first.step();
+    second.step();
+    assert(first.getBodyCount() == kProducers * kSpawnsPerProducer);
+    assert(firstIds == secondIds);
+    for (size_t i = 0; i < first.getBodyCount(); i++) {
+        assert(first.getBody(i)->position.x == second.getBody(i)->position.x);
+        assert(first.getBody(i)->position.z == second.getBody(i)->position.z);
+    }
+    // Producer 0 sorts first, in recording order.
+    assert(firstIds[0] == 0 && firstIds[1] == 1);
+    assert(first.getBodyById(firstIds[kSpawnsPerProducer + 3])->position.x == 10.0f);
+}
+
+// Recording goes on while the main thread steps; every impulse lands once.
+void testRecordingDuringSteps() {
+    World world(Vec3(0, 0, 0));
+    world.collisionsEnabled = false;
+    std::vector<BodyId> ids;
+    for (int i = 0; i < 64; i++) {
+        ids.push_back(world.addBody(std::make_unique<RigidBody>(Vec3(static_cast<float>(i) * 3.0f, 0, 0), Vec3(1, 1, 1), 1.0f)));
+    }
+    const int impulsesPerProducer = 5000;
+    std::vector<std::thread> threads;
+    for (int p = 0; p < kProducers; p++) {
+        threads.emplace_back([&world, &ids, p]() {
+            CommandWriter writer = world.getCommands().writer(static_cast<uint32_t>(p));
+            for (int i = 0; i < impulsesPerProducer; i++) {
+                writer.applyImpulse(ids[static_cast<size_t>(i + p) % ids.size()], Vec3(0.001f, 0, 0));
+            }
+        });
+    }
+    for (int i = 0; i < 50; i++) {
+        world.step();
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    world.step();
+    float momentum = 0.0f;
+    for (size_t i = 0; i < world.getBodyCount(); i++) {
+        momentum += world.getBody(i)->velocity.x;
+    }
+    assert(std::fabs(momentum - 0.001f * kProducers * impulsesPerProducer) < 1e-3f);
+    assert(world.getCommands().empty());
+}
+
+void testTeleportMassAndDespawn() {
+    World world(Vec3(0, 0, 0));
+    world.collisionsEnabled = false;
+    BodyId a = world.addBody(std::make_unique<RigidBody>(Vec3(0, 0, 0), Vec3(1, 1, 1), 1.0f));
+    BodyId b = world.addBody(std::make_unique<RigidBody>(Vec3(5, 0, 0), Vec3(1, 1, 1), 1.0f));
+    BodyId c = world.addBody(std::make_unique<RigidBody>(Vec3(9, 0, 0), Vec3(1, 1, 1), 1.0f));
+    {
+        CommandWriter writer = world.getCommands().writer(0);
+        writer.teleport(a, Vec3(0, 20, 0));
+        writer.setMass(b, 4.0f);
+        writer.applyImpulse(b, Vec3(8, 0, 0));
+        writer.applyForce(c, Vec3(0, 60, 0));
+        writer.despawn(c);
+        writer.despawn(12345);
+        writer.applyImpulse(777, Vec3(1, 1, 1));
+    }
+    world.step();
+    assert(world.getBodyById(a)->position.y == 20.0f);
+    assert(world.getBodyById(b)->mass == 4.0f);
+    assert(std::fabs(world.getBodyById(b)->velocity.x - 2.0f) < 1e-6f);
+    assert(world.getBodyIndex(c) == InvalidBodyIndex);
+    assert(world.getBodyCount() == 2);
+}
+
+// A frame's spawns grow the body arrays once, not once per body.
+void testBulkSpawnGrowsStorageOnce() {
+    if (!physics::memory::allocationCountingEnabled()) return;
+    World world(Vec3(0, 0, 0));
+    {
+        CommandWriter writer = world.getCommands().writer(0);
+        for (int i = 0; i < 10000; i++) {
+            writer.spawn(std::make_unique<RigidBody>(Vec3(static_cast<float>(i), 0, 0), Vec3(1, 1, 1), 1.0f));
+        }
+    }
+    uint64_t before = physics::memory::threadAllocationCount();
+    world.applyCommands();
+    uint64_t allocations = physics::memory::threadAllocationCount() - before;
+    assert(world.getBodyCount() == 10000);
+    assert(allocations < 16);
+    std::cout << "Commands: 10000 spawns applied with " << allocations << " allocations\n";
+}
+
+void runCommandTests() {
+    testSpawnsAreDeterministic();
+    testRecordingDuringSteps();
+    testTeleportMassAndDespawn();
+    testBulkSpawnGrowsStorageOnce();
+}
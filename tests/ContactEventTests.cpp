@@ -0,0 +1,140 @@
+#include "physics/world/World.h"
+#include "physics/memory/AllocationCounter.h"
+#include <iostream>
+#include <cassert>
+#include <memory>
+#include <vector>
+
+using namespace physics::world;
+using physics::math::Vec3;
+using physics::dynamics::RigidBody;
+
+namespace {
+struct EventCounts {
+    size_t began = 0;
+    size_t persisted = 0;
+    size_t ended = 0;
+};
+
+EventCounts countEvents(const World& world, BodyId body) {
+    EventCounts counts;
+    for (const ContactEvent& event : world.getContactEvents()) {
+        if (event.bodyA != body && event.bodyB != body) continue;
+        if (event.type == ContactEventType::Began) counts.began++;
+        if (event.type == ContactEventType::Persisted) counts.persisted++;
+        if (event.type == ContactEventType::Ended) counts.ended++;
+    }
+    return counts;
+}
+}
+
+void testContactEventLifecycle() {
+    World world;
+    world.contactEvents.enabled = true;
+    BodyId floor = world.addBody(std::make_unique<RigidBody>(Vec3(0, -0.5f, 0), Vec3(20, 1, 20), 0.0f));
+    auto falling = std::make_unique<RigidBody>(Vec3(0, 1.5f, 0), Vec3(1, 1, 1), 1.0f);
+    falling->restitution = 0.0f;
+    BodyId box = world.addBody(std::move(falling));
+
+    size_t began = 0;
+    size_t persisted = 0;
+    float firstImpulse = 0.0f;
+    for (int i = 0; i < 120; i++) {
+        world.step();
+        EventCounts counts = countEvents(world, box);
+        assert(counts.ended == 0);
+        if (counts.began > 0) {
+            const ContactEvent& event = world.getContactEvents()[0];
+            assert((event.bodyA == floor && event.bodyB == box) || (event.bodyA == box && event.bodyB == floor));
+            assert(event.info.hasCollision);
+            firstImpulse = event.impulse;
+        }
+        began += counts.began;
+        persisted += counts.persisted;
+    }
+    std::cout << "Contact events: began=" << began << " persisted=" << persisted << " landing impulse=" << firstImpulse << "\n";
+    assert(began == 1);
+    assert(persisted > 60);
+    assert(firstImpulse > 0.0f);
+
+    RigidBody* body = world.getBodyById(box);
+    body->position = Vec3(0, 5, 0);
+    body->velocity = Vec3(0, 0, 0);
+    world.step();
+    EventCounts lifted = countEvents(world, box);
+    assert(lifted.ended == 1 && lifted.began == 0 && lifted.persisted == 0);
+    world.step();
+    assert(world.getContactEvents().empty());
+
+    // Switching events off drops the stream.
+    world.contactEvents.enabled = false;
+    world.step();
+    assert(world.getContactEvents().empty());
+}
+
+void testContactEventSubscriptions() {
+    World world;
+    world.contactEvents.enabled = true;
+    world.contactEvents.subscribedOnly = true;
+    world.addBody(std::make_unique<RigidBody>(Vec3(0, -0.5f, 0), Vec3(20, 1, 20), 0.0f));
+    BodyId watched = world.addBody(std::make_unique<RigidBody>(Vec3(-3, 0.49f, 0), Vec3(1, 1, 1), 1.0f));
+    BodyId ignored = world.addBody(std::make_unique<RigidBody>(Vec3(3, 0.49f, 0), Vec3(1, 1, 1), 1.0f));
+    world.subscribeContactEvents(watched);
+
+    for (int i = 0; i < 10; i++) {
+        world.step();
+        for (const ContactEvent& event : world.getContactEvents()) {
+            assert(event.bodyA != ignored && event.bodyB != ignored);
+        }
+    }
+    assert(countEvents(world, watched).persisted == 1);
+
+    // Removing a body in contact ends its pairs on the next step.
+    world.removeBodies(std::span<const BodyId>(&watched, 1));
+    world.step();
+    EventCounts removed = countEvents(world, watched);
+    std::cout << "Subscribed events after removal: ended=" << removed.ended << "\n";
+    assert(removed.ended == 1);
+    world.step();
+    assert(world.getContactEvents().empty());
+}
+
+void testContactEventsMatchAcrossThreads() {
+    std::vector<ContactEvent> results[2];
+    for (int withPool = 0; withPool < 2; withPool++) {
+        physics::parallel::ThreadPool pool(3);
+        World world;
+        world.contactEvents.enabled = true;
+        world.threadPool = withPool ? &pool : nullptr;
+        world.addBody(std::make_unique<RigidBody>(Vec3(0, -1, 0), Vec3(200, 1, 200), 0.0f));
+        for (int i = 0; i < 1200; i++) {
+            float x = static_cast<float>(i % 40) * 1.5f - 30.0f;
+            float z = static_cast<float>(i / 40) * 1.5f - 30.0f;
+            float y = 0.6f + static_cast<float>(i % 3) * 0.9f;
+            auto box = std::make_unique<RigidBody>(Vec3(x, y, z), Vec3(1, 1, 1), 1.0f);
+            box->restitution = 0.0f;
+            world.addBody(std::move(box));
+        }
+        for (int i = 0; i < 60; i++) {
+            world.step();
+        }
+        // Once warmed up the stream reuses its buffers.
+        world.step();
+        assert(!physics::memory::allocationCountingEnabled() || world.getLastStepAllocationCount() == 0);
+        std::span<const ContactEvent> events = world.getContactEvents();
+        results[withPool].assign(events.begin(), events.end());
+    }
+    std::cout << "Contact events per step in pile: " << results[0].size() << "\n";
+    assert(!results[0].empty() && results[0].size() == results[1].size());
+    for (size_t i = 0; i < results[0].size(); i++) {
+        assert(results[0][i].type == results[1][i].type);
+        assert(results[0][i].bodyA == results[1][i].bodyA && results[0][i].bodyB == results[1][i].bodyB);
+        assert(results[0][i].impulse == results[1][i].impulse);
+    }
+}
+
+void runContactEventTests() {
+    testContactEventLifecycle();
+    testContactEventSubscriptions();
+    testContactEventsMatchAcrossThreads();
+}
@@ -0,0 +1,186 @@
+#include "physics/world/DomainDecomposition.h"
+#include "physics/collision/ConvexHull.h"
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace physics::world;
+using namespace physics::dynamics;
+using namespace physics::math;
+using namespace physics::parallel;
+
+namespace {
+// Upper neighbour (1) only, which accepts everything and answers with an
+// EndOfFrame tagged with a fixed frame.
+class FixedFrameTransport : public DomainTransport {
+public:
+    explicit FixedFrameTransport(uint32_t frame) : frame(frame) {}
+
+    bool hasNeighbor(uint32_t neighbor) const override { return neighbor == 1; }
+    bool trySend(uint32_t, const DomainMessage&) override { return true; }
+    bool tryReceive(uint32_t, DomainMessage& message) override {
+        message = DomainMessage{};
+        message.kind = DomainMessage::EndOfFrame;
+        message.frame = frame;
+        return true;
+    }
+
+private:
+    uint32_t frame;
+};
+}
+
+void testSlabLayout() {
+    SlabLayout layout{0, -10.0f, 10.0f, 2, 2.0f};
+    assert(layout.domainOf(Vec3(-5, 0, 0)) == 0);
+    assert(layout.domainOf(Vec3(0.5f, 0, 0)) == 1);
+    assert(layout.domainOf(Vec3(-100, 0, 0)) == 0);
+    assert(layout.domainOf(Vec3(100, 0, 0)) == 1);
+    assert(layout.lowerBound(1) == 0.0f && layout.upperBound(0) == 0.0f);
+
+    RigidBody body(Vec3(1, 2, 3), Vec3(1, 2, 1), 3.0f);
+    body.velocity = Vec3(-1, 0, 4);
+    RigidBody copy = DomainNode::unpackBody(DomainNode::packBody(body, DomainMessage::Migrate, 7));
+    assert(copy.position.z == 3.0f && copy.velocity.z == 4.0f && copy.mass == 3.0f && copy.size.y == 2.0f);
+
+    physics::collision::ConvexHull wedge({Vec3(-1, 0, -1), Vec3(1, 0, -1), Vec3(0, 2, 1)});
+    std::vector<const physics::collision::ConvexHull*> hulls = {&wedge};
+    body.setShape(physics::collision::Shape::convexHull(wedge));
+    body.filter.category = 2;
+    body.filter.group = 5;
+    copy = DomainNode::unpackBody(DomainNode::packBody(body, DomainMessage::Ghost, 7, hulls), hulls);
+    assert(copy.shape.type == physics::collision::ShapeType::ConvexHull && copy.shape.hull == &wedge);
+    assert(copy.filter == body.filter && copy.size.y == body.size.y);
+    copy = DomainNode::unpackBody(DomainNode::packBody(body, DomainMessage::Ghost, 7));
+    assert(copy.shape.type == physics::collision::ShapeType::Box && copy.size.x == body.size.x);
+    std::cout << "DomainMessage size: " << sizeof(DomainMessage) << " bytes\n";
+}
+
+void testSharedRingBuffer() {
+    std::string name = "/valerie_ring_test_" + std::to_string(getpid());
+    SharedRingBuffer producer = SharedRingBuffer::create(name, sizeof(int), 4);
+    SharedRingBuffer consumer = SharedRingBuffer::open(name);
+
+    for (int i = 0; i < 4; i++) {
+        assert(producer.push(&i));
+    }
+    int overflow = 99;
+    assert(!producer.push(&overflow));
+    assert(consumer.size() == 4);
+
+    int value = -1;
+    for (int i = 0; i < 4; i++) {
+        assert(consumer.pop(&value) && value == i);
+    }
+    assert(!consumer.pop(&value));
+    SharedRingBuffer::unlink(name);
+}
+
+// Two processes own the slabs [-10, 0) and [0, 10). A body launched from the
+// lower slab crosses the border and must end up owned by the upper process,
+// while a body parked inside the halo shows up there as a ghost every step.
+void testMultiProcessDomains() {
+    std::string prefix = "/valerie_dd_" + std::to_string(getpid());
+    SlabLayout layout{0, -10.0f, 10.0f, 2, 2.0f};
+    SharedMemoryTransport::createRings(prefix, 2, 64);
+
+    const int steps = 60;
+    std::cout << std::flush;
+    pid_t child = fork();
+    if (child == 0) {
+        World world(Vec3(0, 0, 0));
+        SharedMemoryTransport transport(prefix, 1, 2);
+        DomainNode node(world, layout, 1, transport);
+        size_t minGhosts = SIZE_MAX;
+        size_t migratedIn = 0;
+        for (int i = 0; i < steps; i++) {
+            node.step(1.0f / 60.0f);
+            minGhosts = std::min(minGhosts, node.getLastGhostCount());
+            migratedIn += node.getLastMigratedInCount();
+        }
+        bool ok = node.getOwnedBodyCount() == 1 && migratedIn == 1 && minGhosts >= 1 &&
+                  std::abs(world.getBody(0)->position.x - 2.0f) < 0.05f &&
+                  std::abs(world.getBody(0)->velocity.x - 5.0f) < 0.001f;
+        std::cout << "Domain 1: owned=" << node.getOwnedBodyCount() << " migrated in=" << migratedIn << " min ghosts per step=" << minGhosts
+                  << " body x=" << (world.getBodyCount() ? world.getBody(0)->position.x : 0.0f) << std::endl;
+        _exit(ok ? 0 : 1);
+    }
+
+    World world(Vec3(0, 0, 0));
+    auto runner = std::make_unique<RigidBody>(Vec3(-3, 0, 0), Vec3(1, 1, 1), 1.0f);
+    runner->velocity = Vec3(5, 0, 0);
+    world.addBody(std::move(runner));
+    world.addBody(std::make_unique<RigidBody>(Vec3(-0.5f, 5, 0), Vec3(1, 1, 1), 0.0f));
+
+    SharedMemoryTransport transport(prefix, 0, 2);
+    DomainNode node(world, layout, 0, transport);
+    size_t migratedOut = 0;
+    for (int i = 0; i < steps; i++) {
+        node.step(1.0f / 60.0f);
+        migratedOut += node.getLastMigratedOutCount();
+    }
+
+    int status = 0;
+    waitpid(child, &status, 0);
+    SharedMemoryTransport::unlinkRings(prefix, 2);
+
+    std::cout << "Domain 0: owned=" << node.getOwnedBodyCount() << " migrated out=" << migratedOut << " frame=" << node.getFrame() << "\n";
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    assert(node.getOwnedBodyCount() == 1 && migratedOut == 1);
+    assert(world.getBody(0)->isStatic);
+}
+
+// A neighbour that never steps makes step() give up after exchangeTimeout
+// instead of spinning forever.
+void testDomainExchangeTimeout() {
+    std::string prefix = "/valerie_dd_timeout_" + std::to_string(getpid());
+    SlabLayout layout{0, -10.0f, 10.0f, 2, 2.0f};
+    SharedMemoryTransport::createRings(prefix, 2, 64);
+    World world(Vec3(0, 0, 0));
+    SharedMemoryTransport transport(prefix, 0, 2);
+    DomainNode node(world, layout, 0, transport);
+    node.exchangeTimeout = std::chrono::milliseconds(50);
+    bool timedOut = false;
+    try {
+        node.step(1.0f / 60.0f);
+    } catch (const std::runtime_error& error) {
+        std::cout << "Domain exchange: " << error.what() << "\n";
+        timedOut = true;
+    }
+    SharedMemoryTransport::unlinkRings(prefix, 2);
+    assert(timedOut);
+}
+
+// A message from another frame is an error in every build, not a silent
+// mix of two frames.
+void testDomainExchangeWrongFrame() {
+    SlabLayout layout{0, -10.0f, 10.0f, 2, 2.0f};
+    World world(Vec3(0, 0, 0));
+    FixedFrameTransport stale(0);
+    DomainNode node(world, layout, 0, stale);
+    node.step(1.0f / 60.0f);
+    assert(node.getFrame() == 1);
+    bool threw = false;
+    try {
+        node.step(1.0f / 60.0f);
+    } catch (const std::runtime_error& error) {
+        std::cout << "Domain exchange: " << error.what() << "\n";
+        assert(std::string(error.what()).find("frame 0 during frame 1") != std::string::npos);
+        threw = true;
+    }
+    assert(threw);
+}
+
+void runDomainDecompositionTests() {
+    testSlabLayout();
+    testSharedRingBuffer();
+    testMultiProcessDomains();
+    testDomainExchangeTimeout();
+    testDomainExchangeWrongFrame();
+}
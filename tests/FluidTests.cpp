@@ -0,0 +1,137 @@
+#include "physics/world/Fluid.h"
+#include "physics/world/World.h"
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <memory>
+
+using namespace physics::world;
+using physics::collision::AABB;
+using physics::dynamics::RigidBody;
+using physics::math::Vec3;
+
+namespace {
+// A 0.5 m wide, 0.8 m tall column at the left of a 1 x 2 x 0.5 m tank,
+// at the spacing the default particle mass expects.
+void fillDamBreak(FluidSystem& fluid) {
+    fluid.settings.bounds = AABB(Vec3(0, 0, 0), Vec3(1, 2, 0.5f));
+    fluid.spawnBlock(AABB(Vec3(0, 0, 0), Vec3(0.5f, 0.8f, 0.5f)), 0.05f);
+}
+
+bool sameState(const FluidSystem& a, const FluidSystem& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        Vec3 pa = a.getPosition(i), pb = b.getPosition(i);
+        Vec3 va = a.getVelocity(i), vb = b.getVelocity(i);
+        if (std::memcmp(&pa, &pb, sizeof(Vec3)) != 0 || std::memcmp(&va, &vb, sizeof(Vec3)) != 0) return false;
+    }
+    return true;
+}
+
+// A 30 cm box of the given density dropped into a 40 cm deep pool; returns
+// its final height.
+float dropBox(float density) {
+    World world;
+    world.addBody(std::make_unique<RigidBody>(Vec3(0, -0.5f, 0), Vec3(10, 1, 10), 0.0f));
+    BodyId box = world.addBody(std::make_unique<RigidBody>(Vec3(0.5f, 0.8f, 0.5f), Vec3(0.3f, 0.3f, 0.3f),
+                                                          0.027f * density));
+    FluidSystem fluid;
+    fluid.settings.bounds = AABB(Vec3(0, 0, 0), Vec3(1, 2, 1));
+    fluid.spawnBlock(AABB(Vec3(0, 0, 0), Vec3(1, 0.4f, 1)), 0.05f);
+    fluid.couple(world.getBodyById(box));
+    for (int i = 0; i < 120; i++) {
+        world.step();
+        fluid.step(1.0f / 60.0f);
+    }
+    return world.getBodyById(box)->position.y;
+}
+}
+
+void testFluidSettlesNearRestDensity() {
+    FluidSystem fluid;
+    fillDamBreak(fluid);
+    assert(fluid.size() == 10 * 16 * 10);
+    for (int i = 0; i < 240; i++) {
+        fluid.step(1.0f / 60.0f);
+    }
+    float densitySum = 0.0f;
+    float speedSum = 0.0f;
+    for (size_t i = 0; i < fluid.size(); i++) {
+        Vec3 position = fluid.getPosition(i);
+        assert(position.x >= 0.0f && position.x <= 1.0f && position.y >= 0.0f && position.z >= 0.0f &&
+               position.z <= 0.5f);
+        densitySum += fluid.getDensity(i);
+        speedSum += fluid.getVelocity(i).length();
+    }
+    float meanDensity = densitySum / static_cast<float>(fluid.size());
+    float meanSpeed = speedSum / static_cast<float>(fluid.size());
+    std::cout << "Fluid: dam break of " << fluid.size() << " particles settles at mean density " << meanDensity
+              << ", mean speed " << meanSpeed << "\n";
+    assert(std::fabs(meanDensity - 1000.0f) < 50.0f);
+    assert(meanSpeed < 0.25f);
+}
+
+// The kernels keep per-lane partial sums, so SIMD and scalar agree bit for
+// bit, and every particle is computed on its own, so the pool does not
+// change the result either.
+void testFluidSimdMatchesScalar() {
+    FluidSystem simd;
+    FluidSystem scalar;
+    physics::parallel::ThreadPool pool(3);
+    simd.threadPool = &pool;
+    for (FluidSystem* fluid : {&simd, &scalar}) {
+        fillDamBreak(*fluid);
+    }
+    for (int i = 0; i < 30; i++) {
+        simd.step(1.0f / 60.0f);
+        scalar.stepScalar(1.0f / 60.0f);
+    }
+    bool identical = sameState(simd, scalar);
+    std::cout << "Fluid (avx2=" << (FluidSystem::hasAvx2Kernel() ? "true" : "false")
+              << "): pooled SIMD identical to serial scalar: " << (identical ? "true" : "false") << "\n";
+    assert(identical);
+}
+
+void testFluidFloatsLightBodies() {
+    float light = dropBox(300.0f);
+    float heavy = dropBox(3000.0f);
+    std::cout << "Fluid: 30 cm box rests at y=" << light << " at 300 kg/m^3, y=" << heavy << " at 3000 kg/m^3\n";
+    assert(light > 0.25f);
+    assert(heavy < 0.16f);
+}
+
+// A jet of fluid hits a free box in zero gravity; the momentum the box gains
+// is lost by the fluid.
+void testFluidPushesBodies() {
+    RigidBody box(Vec3(1.2f, 0.5f, 0.5f), Vec3(0.3f, 0.6f, 0.6f), 20.0f);
+    FluidSystem fluid;
+    fluid.settings.gravity = Vec3(0, 0, 0);
+    fluid.settings.friction = 0.0f;
+    fluid.settings.bounds = AABB(Vec3(0, 0, 0), Vec3(6, 1, 1));
+    fluid.spawnBlock(AABB(Vec3(0, 0.3f, 0.3f), Vec3(0.6f, 0.7f, 0.7f)), 0.05f, Vec3(3, 0, 0));
+    fluid.couple(&box);
+    auto fluidMomentum = [&]() {
+        float momentum = 0.0f;
+        for (size_t i = 0; i < fluid.size(); i++) {
+            momentum += fluid.getVelocity(i).x * fluid.settings.particleMass;
+        }
+        return momentum;
+    };
+    float before = fluidMomentum();
+    for (int i = 0; i < 30; i++) {
+        fluid.step(1.0f / 60.0f);
+    }
+    float gained = box.velocity.x * box.mass;
+    float lost = before - fluidMomentum();
+    std::cout << "Fluid: jet gave the box " << gained << " kg m/s, fluid lost " << lost << "\n";
+    assert(box.velocity.x > 0.1f);
+    assert(std::fabs(gained - lost) < 0.05f * before);
+}
+
+void runFluidTests() {
+    testFluidSettlesNearRestDensity();
+    testFluidSimdMatchesScalar();
+    testFluidFloatsLightBodies();
+    testFluidPushesBodies();
+}
@@ -0,0 +1,205 @@
+#include "physics/collision/ConvexHull.h"
+#include "physics/collision/Gjk.h"
+#include "physics/collision/ShapeCollision.h"
+#include "physics/world/World.h"
+#include <algorithm>
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+using namespace physics::collision;
+using namespace physics::dynamics;
+using namespace physics::math;
+
+namespace {
+// Hull placed at a world position, as a support mapping.
+struct PlacedHull {
+    const ConvexHull* hull;
+    Vec3 position;
+
+    static Vec3 support(const void* context, const Vec3& direction) {
+        const PlacedHull& placed = *static_cast<const PlacedHull*>(context);
+        return placed.position + placed.hull->support(direction);
+    }
+
+    SupportMapping mapping() const {
+        return SupportMapping{&PlacedHull::support, this};
+    }
+};
+
+ConvexHull cubeHull(float half) {
+    std::vector<Vec3> points;
+    for (int i = 0; i < 8; i++) {
+        points.push_back(Vec3(i & 1 ? half : -half, i & 2 ? half : -half, i & 4 ? half : -half));
+    }
+    return ConvexHull(points);
+}
+
+// Points on a sphere of the given radius; enough of them that the hull is
+// within a few percent of the sphere.
+ConvexHull ballHull(float radius) {
+    std::vector<Vec3> points;
+    const int rings = 12;
+    const int segments = 24;
+    const float pi = 3.14159265f;
+    points.push_back(Vec3(0, radius, 0));
+    points.push_back(Vec3(0, -radius, 0));
+    for (int r = 1; r < rings; r++) {
+        float polar = pi * static_cast<float>(r) / rings;
+        for (int s = 0; s < segments; s++) {
+            float azimuth = 2.0f * pi * static_cast<float>(s) / segments;
+            points.push_back(Vec3(radius * std::sin(polar) * std::cos(azimuth), radius * std::cos(polar),
+                                  radius * std::sin(polar) * std::sin(azimuth)));
+        }
+    }
+    return ConvexHull(points);
+}
+
+bool near(float a, float b, float tolerance = 1e-3f) {
+    return std::abs(a - b) <= tolerance;
+}
+}
+
+void testGjkDistance() {
+    ConvexHull cube = cubeHull(0.5f);
+    PlacedHull a{&cube, Vec3(2.0f, 0.2f, 0.1f)};
+    PlacedHull b{&cube, Vec3(0, 0, 0)};
+    GjkResult result = Gjk::query(a.mapping(), b.mapping());
+    std::cout << "Cube hull distance: " << result.distance << " in " << result.iterations << " iterations\n";
+    assert(!result.overlapping);
+    assert(near(result.distance, 1.0f));
+    assert(near(result.axis.x, 1.0f));
+    assert(near(result.pointA.x, 1.5f) && near(result.pointB.x, 0.5f));
+
+    ConvexHull ball = ballHull(1.0f);
+    PlacedHull left{&ball, Vec3(0, 0, 0)};
+    PlacedHull right{&ball, Vec3(1.6f, 1.6f, 1.6f)};
+    result = Gjk::query(right.mapping(), left.mapping());
+    float expected = std::sqrt(3.0f) * 1.6f - 2.0f;
+    std::cout << "Ball hull distance: " << result.distance << " (sphere " << expected << ")\n";
+    assert(!result.overlapping);
+    assert(std::abs(result.distance - expected) < 0.05f);
+}
+
+void testEpaPenetration() {
+    ConvexHull cube = cubeHull(0.5f);
+    PlacedHull a{&cube, Vec3(0.8f, 0.1f, 0.0f)};
+    PlacedHull b{&cube, Vec3(0, 0, 0)};
+    CollisionInfo info = Gjk::collide(a.mapping(), b.mapping());
+    std::cout << "Cube hull penetration: " << info.penetrationDepth << " normal.x=" << info.normal.x << "\n";
+    assert(info.hasCollision);
+    assert(near(info.penetrationDepth, 0.2f));
+    assert(near(info.normal.x, 1.0f));
+
+    // Swapping the order flips the normal.
+    info = Gjk::collide(b.mapping(), a.mapping());
+    assert(info.hasCollision && near(info.normal.x, -1.0f));
+
+    PlacedHull far{&cube, Vec3(3, 0, 0)};
+    assert(!Gjk::collide(far.mapping(), b.mapping()).hasCollision);
+}
+
+void testGjkWarmStart() {
+    ConvexHull ball = ballHull(0.5f);
+    ConvexHull cube = cubeHull(0.5f);
+    PlacedHull a{&ball, Vec3(0.3f, 1.4f, 0.2f)};
+    PlacedHull b{&cube, Vec3(0, 0, 0)};
+
+    GjkCache cache;
+    uint32_t coldIterations = Gjk::query(a.mapping(), b.mapping(), &cache).iterations;
+    uint32_t maxWarm = 0;
+    for (int frame = 0; frame < 30; frame++) {
+        a.position = a.position - Vec3(0, 0.01f, 0);
+        GjkResult result = Gjk::query(a.mapping(), b.mapping(), &cache);
+        GjkResult cold = Gjk::query(a.mapping(), b.mapping());
+        assert(result.overlapping == cold.overlapping);
+        assert(near(result.distance, cold.distance));
+        maxWarm = std::max(maxWarm, result.iterations);
+    }
+    std::cout << "GJK iterations cold: " << coldIterations << ", warm max: " << maxWarm << "\n";
+    assert(maxWarm <= 2);
+
+    // Overlapping pairs reuse the enclosing simplex too.
+    a.position = Vec3(0.3f, 0.8f, 0.2f);
+    uint32_t iterations = 0;
+    Gjk::collide(a.mapping(), b.mapping(), &cache, &iterations);
+    Gjk::collide(a.mapping(), b.mapping(), &cache, &iterations);
+    assert(iterations <= 1);
+
+    GjkPairCache pairCache(4);
+    GjkCache stored;
+    stored.count = 1;
+    stored.directions[0] = Vec3(0, 1, 0);
+    pairCache.store(7, 9, stored);
+    GjkCache loaded;
+    pairCache.load(7, 9, loaded);
+    assert(loaded.count == 1 && loaded.directions[0].y == 1.0f);
+    pairCache.load(9, 7, loaded);
+    assert(loaded.count == 0);
+    for (int i = 0; i < 8; i++) {
+        pairCache.beginFrame();
+    }
+    assert(pairCache.size() == 0);
+}
+
+void testHullAgainstPrimitives() {
+    ConvexHull cube = cubeHull(0.5f);
+    std::vector<AABB> bounds;
+    std::vector<Vec3> positions;
+    std::vector<Shape> shapes;
+    auto add = [&](const Vec3& position, const Shape& shape) {
+        RigidBody body(position, Vec3(1, 1, 1), 1.0f);
+        body.setShape(shape);
+        bounds.push_back(body.getAABB());
+        positions.push_back(body.position);
+        shapes.push_back(body.shape);
+        return static_cast<uint32_t>(positions.size() - 1);
+    };
+    uint32_t hull = add(Vec3(0, 0.9f, 0), Shape::convexHull(cube));
+    uint32_t box = add(Vec3(0, 0, 0), Shape::box());
+    uint32_t ball = add(Vec3(0.0f, 1.7f, 0), Shape::sphere(0.5f));
+    uint32_t pill = add(Vec3(0.65f, 0.9f, 0), Shape::capsule(0.25f, 0.5f));
+
+    std::vector<uint32_t> ids = {10, 11, 12, 13};
+    GjkPairCache cache;
+    ShapeView view{bounds.data(), positions.data(), shapes.data(), ids.data(), &cache};
+
+    CollisionInfo hullBox = ShapeCollision::collide(view, hull, box);
+    std::cout << "Hull-box depth=" << hullBox.penetrationDepth << " normal.y=" << hullBox.normal.y << "\n";
+    assert(hullBox.hasCollision && near(hullBox.penetrationDepth, 0.1f) && near(hullBox.normal.y, 1.0f));
+
+    CollisionInfo ballHullInfo = ShapeCollision::collide(view, ball, hull);
+    assert(ballHullInfo.hasCollision && near(ballHullInfo.penetrationDepth, 0.2f, 0.01f) && ballHullInfo.normal.y > 0.99f);
+
+    CollisionInfo pillHull = ShapeCollision::collide(view, pill, hull);
+    assert(pillHull.hasCollision && near(pillHull.penetrationDepth, 0.1f, 0.01f) && pillHull.normal.x > 0.99f);
+    assert(cache.size() == 3);
+}
+
+void testHullRestsOnFloor() {
+    ConvexHull wedge({Vec3(-0.5f, -0.5f, -0.5f), Vec3(0.5f, -0.5f, -0.5f), Vec3(-0.5f, -0.5f, 0.5f),
+                      Vec3(0.5f, -0.5f, 0.5f), Vec3(0.0f, 0.5f, 0.0f)});
+    physics::world::World world;
+    world.addBody(std::make_unique<RigidBody>(Vec3(0, -0.5f, 0), Vec3(20, 1, 20), 0.0f));
+    auto pyramid = std::make_unique<RigidBody>(Vec3(0, 3, 0), Vec3(1, 1, 1), 1.0f);
+    pyramid->setShape(Shape::convexHull(wedge));
+    pyramid->restitution = 0.0f;
+    physics::world::BodyId pyramidId = world.addBody(std::move(pyramid));
+
+    for (int i = 0; i < 240; i++) {
+        world.step();
+    }
+    float height = world.getBodyById(pyramidId)->position.y;
+    std::cout << "Hull resting height: " << height << "\n";
+    assert(height > 0.45f && height < 0.55f);
+}
+
+void runGjkTests() {
+    testGjkDistance();
+    testEpaPenetration();
+    testGjkWarmStart();
+    testHullAgainstPrimitives();
+    testHullRestsOnFloor();
+}
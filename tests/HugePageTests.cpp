@@ -0,0 +1,102 @@
+#include "physics/memory/HugePageResource.h"
+#include "physics/world/World.h"
+#include <iostream>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+using namespace physics::memory;
+using physics::world::World;
+using physics::dynamics::RigidBody;
+using physics::math::Vec3;
+
+void testHugePageMappings() {
+    HugePageResource resource;
+    {
+        std::pmr::vector<float> small(1000, 1.0f, &resource);
+        assert(resource.getMappingCount() == 0);
+
+        std::pmr::vector<float> large(3 * 1024 * 1024 / sizeof(float), 2.0f, &resource);
+        assert(resource.getMappingCount() == 1);
+        assert(resource.getMappedBytes() == 2 * HugePageResource::kHugePageSize);
+        assert(reinterpret_cast<uintptr_t>(large.data()) % HugePageResource::kHugePageSize == 0);
+        assert(large.back() == 2.0f && small.back() == 1.0f);
+
+        // Geometric growth maps once per reallocation and releases the old
+        // mapping.
+        for (int i = 0; i < 4 * 1024 * 1024; i++) {
+            large.push_back(static_cast<float>(i));
+        }
+        assert(resource.getMappingCount() == 1);
+        assert(large[large.size() - 1] == static_cast<float>(4 * 1024 * 1024 - 1));
+    }
+    assert(resource.getMappingCount() == 0);
+    assert(resource.getMappedBytes() == 0);
+}
+
+// Explicit pages and NUMA placement are hints: whatever the kernel allows,
+// the memory must be usable.
+void testHugePageFallbacks() {
+    HugePageSettings settings;
+    settings.mode = HugePageMode::Explicit;
+    settings.numaPolicy = NumaPolicy::Preferred;
+    settings.numaNode = 0;
+    HugePageResource preferred(settings);
+    std::pmr::vector<uint64_t> values(1 << 20, 7, &preferred);
+    assert(values[12345] == 7);
+
+    settings.mode = HugePageMode::None;
+    settings.numaPolicy = NumaPolicy::Interleave;
+    HugePageResource interleaved(settings);
+    std::pmr::vector<uint64_t> more(1 << 20, 9, &interleaved);
+    assert(more[54321] == 9);
+
+    assert(numaNodeCount() >= 1);
+    std::vector<unsigned> cpus = numaNodeCpus(0);
+    assert(!cpus.empty());
+    physics::parallel::ThreadPool pool(2);
+    bool pinned = pool.pinWorkers(cpus);
+    size_t sum = 0;
+    std::vector<size_t> parts(4, 0);
+    pool.parallelFor(4000, 1000, [&](size_t begin, size_t end) { parts[begin / 1000] = end - begin; });
+    for (size_t part : parts) sum += part;
+    assert(sum == 4000);
+    std::cout << "Huge pages: " << numaNodeCount() << " NUMA node(s), explicit fallbacks="
+              << preferred.getExplicitFallbackCount() << ", placement failures="
+              << preferred.getPlacementFailureCount() + interleaved.getPlacementFailureCount()
+              << ", workers pinned=" << (pinned ? "yes" : "no") << "\n";
+}
+
+// A world on huge-page storage steps exactly like one on the heap.
+void testWorldOnHugePageStorage() {
+    HugePageSettings settings;
+    settings.minMappingBytes = 64 * 1024;
+    HugePageResource resource(settings);
+    World heap;
+    World mapped(Vec3(0, -9.81f, 0), 1.0f / 60.0f, &resource);
+    assert(mapped.getStorageResource() == &resource);
+    for (World* world : {&heap, &mapped}) {
+        world->addBody(std::make_unique<RigidBody>(Vec3(0, -0.5f, 0), Vec3(200, 1, 200), 0.0f));
+        for (int i = 0; i < 5000; i++) {
+            Vec3 position(static_cast<float>(i % 70) * 1.5f - 50.0f, 1.0f + static_cast<float>(i / 4900), static_cast<float>(i / 70) * 1.5f - 50.0f);
+            world->addBody(std::make_unique<RigidBody>(position, Vec3(1, 1, 1), 1.0f));
+        }
+    }
+    for (int i = 0; i < 30; i++) {
+        heap.step();
+        mapped.step();
+    }
+    assert(resource.getMappingCount() > 0);
+    for (size_t i = 0; i < heap.getBodyCount(); i++) {
+        assert(std::memcmp(&heap.getBody(i)->position, &mapped.getBody(i)->position, sizeof(Vec3)) == 0);
+    }
+}
+
+void runHugePageTests() {
+    testHugePageMappings();
+    testHugePageFallbacks();
+    testWorldOnHugePageStorage();
+}
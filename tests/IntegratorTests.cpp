@@ -0,0 +1,143 @@
+#include "physics/dynamics/Integrators.h"
+#include "physics/world/World.h"
+#include <iostream>
+#include <cassert>
+#include <iomanip>
+#include <cmath>
+#include <algorithm>
+
+using namespace physics::dynamics;
+using namespace physics::world;
+using namespace physics::math;
+
+namespace {
+
+const float kPi = 3.14159265f;
+
+// Unit mass on a spring anchored at the origin with a period of one second.
+struct AnchoredSpring {
+    float omegaSq = 4.0f * kPi * kPi;
+
+    Vec3 operator()(const RigidBody&, const Vec3& position, const Vec3&) const {
+        return position * -omegaSq;
+    }
+};
+
+template <typename Integrator>
+float springEnergyDrift(float hz, float seconds) {
+    AnchoredSpring spring;
+    RigidBody body(Vec3(1, 0, 0), Vec3(1, 1, 1), 1.0f);
+    float dt = 1.0f / hz;
+    int steps = static_cast<int>(seconds * hz + 0.5f);
+
+    float initialEnergy = 0.5f * spring.omegaSq;
+    float worstDrift = 0.0f;
+    for (int i = 0; i < steps; i++) {
+        integrateBody<Integrator>(body, dt, spring);
+        float energy = 0.5f * body.velocity.lengthSq() + 0.5f * spring.omegaSq * body.position.lengthSq();
+        worstDrift = std::max(worstDrift, std::abs(energy - initialEnergy) / initialEnergy);
+    }
+    return worstDrift;
+}
+
+template <typename Integrator>
+Vec3 fallFor(float seconds, int steps) {
+    RigidBody body(Vec3(0, 0, 0), Vec3(1, 1, 1), 1.0f);
+    body.velocity = Vec3(1, 0, 0);
+    float dt = seconds / steps;
+    for (int i = 0; i < steps; i++) {
+        body.applyForce(Vec3(0, -10, 0));
+        integrateBody<Integrator>(body, dt);
+    }
+    return body.position;
+}
+
+}
+
+void testIntegratorMatchesRigidBody() {
+    RigidBody a(Vec3(0, 0, 0), Vec3(1, 1, 1), 1.0f);
+    RigidBody b = a;
+    a.velocity = b.velocity = Vec3(2, 3, 4);
+    a.acceleration = b.acceleration = Vec3(1, -2, 0.5f);
+
+    a.integrate(0.1f);
+    integrateBody<SemiImplicitEuler>(b, 0.1f);
+
+    std::cout << std::fixed << std::setprecision(5);
+    std::cout << "RigidBody::integrate pos(" << a.position.x << ", " << a.position.y << ", " << a.position.z << ") SemiImplicitEuler pos(" << b.position.x << ", " << b.position.y << ", " << b.position.z << ")\n";
+    assert(a.position.x == b.position.x && a.position.y == b.position.y && a.position.z == b.position.z);
+    assert(a.velocity.x == b.velocity.x && a.velocity.y == b.velocity.y && a.velocity.z == b.velocity.z);
+    assert(b.acceleration.x == 0.0f && b.acceleration.y == 0.0f && b.acceleration.z == 0.0f);
+
+    RigidBody staticBody;
+    staticBody.makeStatic();
+    integrateBody<RK4>(staticBody, 1.0f, AnchoredSpring());
+    assert(staticBody.position.x == 0.0f && staticBody.position.y == 0.0f && staticBody.position.z == 0.0f);
+}
+
+void testConstantAccelerationExactness() {
+    // x(1) = (1, -5, 0) exactly for constant gravity
+    Vec3 euler = fallFor<SemiImplicitEuler>(1.0f, 10);
+    Vec3 positionVerlet = fallFor<PositionVerlet>(1.0f, 10);
+    Vec3 velocityVerlet = fallFor<VelocityVerlet>(1.0f, 10);
+    Vec3 rk4 = fallFor<RK4>(1.0f, 10);
+
+    std::cout << "Free fall y after 1s at 10Hz: euler=" << euler.y << " posVerlet=" << positionVerlet.y << " velVerlet=" << velocityVerlet.y << " rk4=" << rk4.y << "\n";
+    assert(std::abs(euler.y - (-5.5f)) < 0.001f);
+    assert(std::abs(positionVerlet.y - (-5.0f)) < 0.001f);
+    assert(std::abs(velocityVerlet.y - (-5.0f)) < 0.001f);
+    assert(std::abs(rk4.y - (-5.0f)) < 0.001f);
+    assert(std::abs(rk4.x - 1.0f) < 0.001f);
+}
+
+void testSpringStabilityTradeoff() {
+    float euler240 = springEnergyDrift<SemiImplicitEuler>(240.0f, 10.0f);
+    float euler30 = springEnergyDrift<SemiImplicitEuler>(30.0f, 10.0f);
+    float positionVerlet30 = springEnergyDrift<PositionVerlet>(30.0f, 10.0f);
+    float velocityVerlet30 = springEnergyDrift<VelocityVerlet>(30.0f, 10.0f);
+    float rk430 = springEnergyDrift<RK4>(30.0f, 10.0f);
+
+    std::cout << "Spring energy drift over 10s: euler@240Hz=" << euler240 << " euler@30Hz=" << euler30
+              << " posVerlet@30Hz=" << positionVerlet30 << " velVerlet@30Hz=" << velocityVerlet30
+              << " rk4@30Hz=" << rk430 << "\n";
+
+    assert(rk430 < euler240);
+    assert(positionVerlet30 < euler30);
+    assert(velocityVerlet30 < euler30);
+    assert(positionVerlet30 < 0.05f && velocityVerlet30 < 0.05f && rk430 < 0.01f);
+}
+
+void testWorldIntegratorPolicy() {
+    World eulerWorld(Vec3(0, -10, 0), 0.1f);
+    World verletWorld(Vec3(0, -10, 0), 0.1f);
+    eulerWorld.addBody(std::make_unique<RigidBody>(Vec3(0, 10, 0), Vec3(1, 1, 1), 1.0f));
+    verletWorld.addBody(std::make_unique<RigidBody>(Vec3(0, 10, 0), Vec3(1, 1, 1), 1.0f));
+    eulerWorld.addBody(std::make_unique<RigidBody>(Vec3(0, 0, 0), Vec3(1, 1, 1), 0.0f));
+
+    eulerWorld.step<SemiImplicitEuler>(0.1f);
+    verletWorld.step<VelocityVerlet>(0.1f);
+
+    const RigidBody* euler = eulerWorld.getBody(0);
+    const RigidBody* verlet = verletWorld.getBody(0);
+    std::cout << "World step<SemiImplicitEuler> y=" << euler->position.y << " step<VelocityVerlet> y=" << verlet->position.y << "\n";
+    assert(std::abs(euler->position.y - 9.9f) < 0.001f);
+    assert(std::abs(verlet->position.y - 9.95f) < 0.001f);
+    assert(std::abs(verlet->velocity.y - (-1.0f)) < 0.001f);
+    assert(eulerWorld.getBody(1)->position.y == 0.0f);
+
+    World springWorld(Vec3(0, 0, 0), 1.0f / 30.0f);
+    springWorld.addBody(std::make_unique<RigidBody>(Vec3(1, 0, 0), Vec3(1, 1, 1), 1.0f));
+    for (int i = 0; i < 30; i++) {
+        springWorld.step<RK4>(springWorld.timeStep, AnchoredSpring());
+    }
+    const RigidBody* oscillator = springWorld.getBody(0);
+    std::cout << "RK4 spring after one period: x=" << oscillator->position.x << "\n";
+    assert(std::abs(oscillator->position.x - 1.0f) < 0.01f);
+}
+
+void runIntegratorTests() {
+    testIntegratorMatchesRigidBody();
+    testConstantAccelerationExactness();
+    testSpringStabilityTradeoff();
+    testWorldIntegratorPolicy();
+}
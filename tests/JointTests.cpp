@@ -0,0 +1,157 @@
+#include "physics/world/World.h"
+#include "physics/parallel/ThreadPool.h"
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+using namespace physics::world;
+using physics::math::Vec3;
+using physics::dynamics::RigidBody;
+
+namespace {
+BodyId addBox(World& world, const Vec3& position, float mass) {
+    return world.addBody(std::make_unique<RigidBody>(position, Vec3(0.2f, 0.2f, 0.2f), mass));
+}
+
+// Chains hanging straight down from static anchors.
+std::vector<JointId> addChains(World& world, int chains, int links, float spacing) {
+    std::vector<JointId> ids;
+    for (int c = 0; c < chains; c++) {
+        float z = static_cast<float>(c) * 2.0f;
+        BodyId previous = addBox(world, Vec3(0, 30, z), 0.0f);
+        for (int l = 1; l <= links; l++) {
+            BodyId link = addBox(world, Vec3(0, 30 - static_cast<float>(l) * spacing, z), 1.0f);
+            ids.push_back(world.getJoints().addDistance(previous, link, spacing));
+            previous = link;
+        }
+    }
+    return ids;
+}
+
+float distanceBetween(World& world, BodyId a, BodyId b) {
+    return (world.getBodyById(b)->position - world.getBodyById(a)->position).length();
+}
+
+// Stretch of a 1 Hz spring holding a body against gravity once it settles.
+float springStretch(float deltaTime) {
+    World world(Vec3(0, -9.81f, 0), deltaTime);
+    BodyId anchor = addBox(world, Vec3(0, 0, 0), 0.0f);
+    BodyId bob = addBox(world, Vec3(0, -2, 0), 1.0f);
+    world.getJoints().addSpring(anchor, bob, 2.0f, JointSoftness{1.0f, 1.0f});
+    int steps = static_cast<int>(std::lround(4.0f / deltaTime));
+    for (int i = 0; i < steps; i++) {
+        world.step();
+    }
+    return -2.0f - world.getBodyById(bob)->position.y;
+}
+}
+
+// A hanging chain keeps its links within a few percent of their length
+// while it swings after a kick.
+void testDistanceChainHolds() {
+    World world;
+    world.collisionsEnabled = false;
+    std::vector<JointId> ids = addChains(world, 1, 20, 0.5f);
+    JointSystem& joints = world.getJoints();
+    world.getBodyById(joints.getBodyB(ids.back()))->velocity = Vec3(8, 0, 3);
+    float worst = 0.0f;
+    for (int i = 0; i < 300; i++) {
+        world.step();
+        for (JointId id : ids) {
+            float error = std::fabs(distanceBetween(world, joints.getBodyA(id), joints.getBodyB(id)) - 0.5f);
+            worst = std::max(worst, error);
+        }
+    }
+    assert(worst < 0.05f);
+    assert(joints.getImpulse(ids.front()) > joints.getImpulse(ids.back()));
+    std::cout << "Joint chain: worst link error " << worst << " over 300 steps\n";
+}
+
+// Spring stiffness follows its frequency, not the step rate: the settled
+// stretch is g / (2 pi f)^2 at any step.
+void testSpringIsTimestepIndependent() {
+    float expected = 9.81f / (4.0f * 3.14159265f * 3.14159265f);
+    float coarse = springStretch(1.0f / 60.0f);
+    float fine = springStretch(1.0f / 240.0f);
+    assert(std::fabs(coarse - expected) < 0.005f);
+    assert(std::fabs(fine - expected) < 0.005f);
+}
+
+// A hinged body orbits the axis: its height along the axis and its radius
+// hold while it swings.
+void testHingeAndFixed() {
+    World world(Vec3(0, 0, 0));
+    world.collisionsEnabled = false;
+    BodyId pivot = addBox(world, Vec3(0, 0, 0), 0.0f);
+    BodyId door = addBox(world, Vec3(2, 1, 0), 1.0f);
+    world.getBodyById(door)->velocity = Vec3(0, 1, 3);
+    world.getJoints().addHinge(pivot, door, Vec3(0, 1, 0), 1.0f, 2.0f);
+
+    BodyId leader = addBox(world, Vec3(0, 0, 5), 1.0f);
+    BodyId follower = addBox(world, Vec3(1, 0.5f, 5), 1.0f);
+    world.getJoints().addFixed(leader, follower, Vec3(1, 0.5f, 0));
+    world.getBodyById(leader)->applyImpulse(Vec3(2, 0, -1));
+
+    for (int i = 0; i < 120; i++) {
+        world.step();
+    }
+    Vec3 offset = world.getBodyById(door)->position;
+    assert(std::fabs(offset.y - 1.0f) < 0.02f);
+    assert(std::fabs(std::sqrt(offset.x * offset.x + offset.z * offset.z) - 2.0f) < 0.02f);
+    assert(offset.z > 0.5f || offset.x < 1.5f);
+
+    Vec3 held = world.getBodyById(follower)->position - world.getBodyById(leader)->position;
+    assert(std::fabs(held.x - 1.0f) < 0.01f && std::fabs(held.y - 0.5f) < 0.01f && std::fabs(held.z) < 0.01f);
+    assert(world.getBodyById(follower)->velocity.x > 0.5f);
+}
+
+// The colored passes give the serial result on any number of threads.
+void testParallelJointsMatchSerial() {
+    physics::parallel::ThreadPool pool(3);
+    World serial;
+    World parallel;
+    parallel.threadPool = &pool;
+    for (World* world : {&serial, &parallel}) {
+        world->collisionsEnabled = false;
+        addChains(*world, 500, 40, 0.5f);
+    }
+    for (int i = 0; i < 20; i++) {
+        serial.step();
+        parallel.step();
+    }
+    assert(serial.getJoints().getCount() == 20000);
+    for (size_t i = 0; i < serial.getBodyCount(); i++) {
+        assert(std::memcmp(&serial.getBody(i)->position, &parallel.getBody(i)->position, sizeof(Vec3)) == 0);
+    }
+}
+
+void testRemovingBodiesRemovesJoints() {
+    World world;
+    world.collisionsEnabled = false;
+    std::vector<JointId> ids = addChains(world, 2, 5, 0.5f);
+    JointSystem& joints = world.getJoints();
+    BodyId middle = joints.getBodyB(ids[2]);
+    world.removeBody(world.getBodyIndex(middle));
+    assert(joints.getCount() == 8);
+    assert(!joints.isValid(ids[2]) && !joints.isValid(ids[3]));
+
+    BodyId ids2[] = {joints.getBodyB(ids[5]), joints.getBodyB(ids[9])};
+    world.removeBodies(ids2);
+    assert(joints.getCount() == 5);
+    for (int i = 0; i < 10; i++) {
+        world.step();
+    }
+    world.clearBodies();
+    assert(joints.getCount() == 0);
+}
+
+void runJointTests() {
+    testDistanceChainHolds();
+    testSpringIsTimestepIndependent();
+    testHingeAndFixed();
+    testParallelJointsMatchSerial();
+    testRemovingBodiesRemovesJoints();
+}
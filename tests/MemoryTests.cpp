@@ -0,0 +1,175 @@
+#include "physics/memory/FrameArena.h"
+#include "physics/memory/AllocationCounter.h"
+#include "physics/world/World.h"
+#include "physics/collision/ConvexHull.h"
+#include "physics/parallel/ThreadPool.h"
+#include <iostream>
+#include <thread>
+#include <cassert>
+#include <vector>
+#include <memory_resource>
+
+using namespace physics::memory;
+using namespace physics::world;
+using namespace physics::dynamics;
+using namespace physics::math;
+
+void testFrameArenaAllocation() {
+    FrameArena arena(256);
+    assert(arena.getUpstreamAllocationCount() == 1);
+
+    void* a = arena.allocate(10, 1);
+    void* b = arena.allocate(16, 16);
+    assert(reinterpret_cast<uintptr_t>(b) % 16 == 0);
+    assert(a != b);
+
+    // Overflow chains a second block, reset merges them into one
+    void* large = arena.allocate(1000, 8);
+    assert(large != nullptr);
+    std::cout << "Arena after overflow: capacity=" << arena.getCapacity() << " upstream allocations=" << arena.getUpstreamAllocationCount() << "\n";
+    assert(arena.getUpstreamAllocationCount() == 2);
+    arena.reset();
+    assert(arena.getUpstreamAllocationCount() == 3);
+    assert(arena.getBytesUsed() == 0);
+
+    size_t capacity = arena.getCapacity();
+    for (int frame = 0; frame < 10; frame++) {
+        std::pmr::vector<int> scratch(&arena);
+        scratch.resize(200);
+        void* extra = arena.allocate(16, 8);
+        assert(extra != nullptr);
+        scratch = std::pmr::vector<int>(&arena);
+        arena.reset();
+    }
+    std::cout << "Arena steady state: capacity=" << arena.getCapacity() << " upstream allocations=" << arena.getUpstreamAllocationCount() << "\n";
+    assert(arena.getCapacity() == capacity);
+    assert(arena.getUpstreamAllocationCount() == 3);
+}
+
+void testAllocationCounter() {
+    uint64_t before = threadAllocationCount();
+    auto value = std::make_unique<int>(5);
+    uint64_t after = threadAllocationCount();
+    std::cout << "Allocation counting enabled: " << (allocationCountingEnabled() ? "true" : "false") << " counted " << (after - before) << " allocation(s)\n";
+    assert(!allocationCountingEnabled() || after - before == 1);
+}
+
+void testZeroAllocationStep() {
+    World world(Vec3(0, -9.81f, 0));
+    world.addBody(std::make_unique<RigidBody>(Vec3(0, -0.5f, 0), Vec3(100, 1, 100), 0.0f));
+    for (int i = 0; i < 200; i++) {
+        float x = static_cast<float>(i % 20) * 1.5f - 15.0f;
+        float z = static_cast<float>(i / 20) * 1.5f - 7.5f;
+        world.addBody(std::make_unique<RigidBody>(Vec3(x, 0.4f + static_cast<float>(i % 3) * 0.1f, z), Vec3(1, 1, 1), 1.0f));
+    }
+    world.reorderSettings.enabled = true;
+    world.reorderSettings.frameInterval = 7;
+
+    for (int i = 0; i < 30; i++) {
+        world.step();
+    }
+
+    world.debugAssertNoStepAllocations = true;
+    uint64_t before = threadAllocationCount();
+    uint64_t arenaBefore = world.getFrameArena().getUpstreamAllocationCount();
+    size_t contactSteps = 0;
+    for (int i = 0; i < 120; i++) {
+        world.step();
+        assert(world.getLastStepAllocationCount() == 0);
+        if (!world.getContacts().empty()) contactSteps++;
+    }
+    uint64_t allocations = threadAllocationCount() - before;
+
+    std::cout << "Steady-state steps: heap allocations=" << allocations << " arena upstream allocations=" << (world.getFrameArena().getUpstreamAllocationCount() - arenaBefore)
+              << " steps with contacts=" << contactSteps << " arena peak=" << world.getFrameArena().getPeakBytesUsed() << " bytes\n";
+    assert(allocations == 0);
+    assert(contactSteps > 0);
+}
+
+// Same with the step on a pool and convex hulls resting on each other, so
+// narrowphase workers allocate if anything does, and the GJK pair cache is
+// in use.
+void testZeroAllocationPooledHullStep() {
+    std::vector<Vec3> corners;
+    for (int i = 0; i < 8; i++) {
+        corners.push_back(Vec3(i & 1 ? 0.5f : -0.5f, i & 2 ? 0.5f : -0.5f, i & 4 ? 0.5f : -0.5f));
+    }
+    physics::collision::ConvexHull cube(corners);
+    physics::parallel::ThreadPool pool(3);
+    World world(Vec3(0, -9.81f, 0));
+    world.threadPool = &pool;
+    world.addBody(std::make_unique<RigidBody>(Vec3(0, -0.5f, 0), Vec3(100, 1, 100), 0.0f));
+    for (int i = 0; i < 200; i++) {
+        float x = static_cast<float>(i % 10) * 1.05f - 5.0f;
+        float z = static_cast<float>(i / 10 % 10) * 1.05f - 5.0f;
+        float y = i < 100 ? 0.5f : 1.55f;
+        auto body = std::make_unique<RigidBody>(Vec3(x, y, z), Vec3(1, 1, 1), 1.0f);
+        body->setShape(physics::collision::Shape::convexHull(cube));
+        world.addBody(std::move(body));
+    }
+    for (int i = 0; i < 60; i++) {
+        world.step();
+    }
+
+    world.debugAssertNoStepAllocations = true;
+    uint64_t allocations = 0;
+    size_t contactSteps = 0;
+    for (int i = 0; i < 120; i++) {
+        world.step();
+        allocations += world.getLastStepAllocationCount();
+        if (!world.getContacts().empty()) contactSteps++;
+    }
+    std::cout << "Steady-state pooled hull steps: heap allocations=" << allocations << " steps with contacts="
+              << contactSteps << "\n";
+    assert(allocations == 0);
+    assert(contactSteps > 0);
+}
+
+// Two worlds stepped at the same time on two threads, sharing one pool. The
+// one that keeps spawning bodies allocates; the settled one still sees none
+// of its own.
+void testConcurrentWorldAllocationCounts() {
+    physics::parallel::ThreadPool pool(3);
+    World settled(Vec3(0, -9.81f, 0));
+    World growing(Vec3(0, -9.81f, 0));
+    for (World* world : {&settled, &growing}) {
+        world->threadPool = &pool;
+        world->addBody(std::make_unique<RigidBody>(Vec3(0, -0.5f, 0), Vec3(100, 1, 100), 0.0f));
+        for (int i = 0; i < 200; i++) {
+            float x = static_cast<float>(i % 20) * 1.5f - 15.0f;
+            float z = static_cast<float>(i / 20) * 1.5f - 7.5f;
+            world->addBody(std::make_unique<RigidBody>(Vec3(x, 0.5f, z), Vec3(1, 1, 1), 1.0f));
+        }
+    }
+    for (int i = 0; i < 30; i++) {
+        settled.step();
+    }
+    settled.debugAssertNoStepAllocations = true;
+
+    uint64_t settledAllocations = 0;
+    uint64_t growingAllocations = 0;
+    std::thread other([&]() {
+        for (int i = 0; i < 120; i++) {
+            growing.addBody(std::make_unique<RigidBody>(Vec3(0, 5.0f + static_cast<float>(i), 0), Vec3(1, 1, 1), 1.0f));
+            growing.step();
+            growingAllocations += growing.getLastStepAllocationCount();
+        }
+    });
+    for (int i = 0; i < 120; i++) {
+        settled.step();
+        settledAllocations += settled.getLastStepAllocationCount();
+    }
+    other.join();
+    std::cout << "Concurrent worlds: settled step allocations=" << settledAllocations
+              << " growing step allocations=" << growingAllocations << "\n";
+    assert(settledAllocations == 0);
+    assert(!allocationCountingEnabled() || growingAllocations > 0);
+}
+
+void runMemoryTests() {
+    testFrameArenaAllocation();
+    testAllocationCounter();
+    testZeroAllocationStep();
+    testZeroAllocationPooledHullStep();
+    testConcurrentWorldAllocationCounts();
+}
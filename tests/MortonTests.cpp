@@ -0,0 +1,39 @@
+#include "physics/math/Morton.h"
+#include <iostream>
+#include <cassert>
+
+using namespace physics::math;
+
+void testMortonEncoding() {
+    std::cout << "expandBits10(0b111) = " << expandBits10(0b111) << "\n";
+    assert(expandBits10(0b111) == 0b001001001);
+    assert(expandBits10(0x3ff) == 0x09249249);
+
+    assert(mortonEncode(1, 0, 0) == 0b100);
+    assert(mortonEncode(0, 1, 0) == 0b010);
+    assert(mortonEncode(0, 0, 1) == 0b001);
+    assert(mortonEncode(1023, 1023, 1023) == 0x3fffffff);
+}
+
+void testMortonLocality() {
+    Vec3 boundsMin(0, 0, 0);
+    Vec3 boundsMax(100, 100, 100);
+
+    uint32_t origin = mortonEncode(Vec3(0, 0, 0), boundsMin, boundsMax);
+    uint32_t near = mortonEncode(Vec3(1, 1, 1), boundsMin, boundsMax);
+    uint32_t far = mortonEncode(Vec3(90, 90, 90), boundsMin, boundsMax);
+    uint32_t clamped = mortonEncode(Vec3(500, -20, 100), boundsMin, boundsMax);
+
+    std::cout << "Morton codes: origin=" << origin << " near=" << near << " far=" << far << " clamped=" << clamped << "\n";
+    assert(origin == 0);
+    assert(near < far);
+    assert(clamped == mortonEncode(1023, 0, 1023));
+
+    uint32_t flat = mortonEncode(Vec3(5, 5, 5), Vec3(5, 5, 5), Vec3(5, 5, 5));
+    assert(flat == 0);
+}
+
+void runMortonTests() {
+    testMortonEncoding();
+    testMortonLocality();
+}
@@ -0,0 +1,77 @@
+#include "physics/parallel/ThreadPool.h"
+#include "physics/parallel/RadixSort.h"
+#include <iostream>
+#include <cassert>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <cstdint>
+
+using namespace physics::parallel;
+
+void testParallelForCoverage() {
+    ThreadPool pool(3);
+    std::vector<int> hits(10000, 0);
+
+    pool.parallelFor(hits.size(), 64, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) hits[i]++;
+    });
+
+    bool allOnce = std::all_of(hits.begin(), hits.end(), [](int h) { return h == 1; });
+    std::cout << "ThreadPool(3) concurrency=" << pool.getConcurrency() << " every index visited once: " << (allOnce ? "true" : "false") << "\n";
+    assert(pool.getConcurrency() == 4);
+    assert(allOnce);
+
+    std::atomic<int> nestedTotal(0);
+    pool.parallelFor(8, 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            pool.parallelFor(4, 1, [&](size_t b, size_t e) { nestedTotal += static_cast<int>(e - b); });
+        }
+    });
+    std::cout << "Nested parallelFor total: " << nestedTotal.load() << "\n";
+    assert(nestedTotal.load() == 32);
+
+    ThreadPool serial(0);
+    size_t calls = 0;
+    serial.parallelFor(100, 10, [&](size_t begin, size_t end) { calls++; assert(begin == 0 && end == 100); });
+    assert(calls == 1);
+}
+
+void testRadixSortPairs() {
+    ThreadPool pool(2);
+    std::vector<uint32_t> keys(50000);
+    std::vector<uint32_t> values(keys.size());
+    uint32_t state = 12345;
+    for (size_t i = 0; i < keys.size(); i++) {
+        state = state * 1664525u + 1013904223u;
+        keys[i] = (state >> 2) & 0x3fffffff;
+        values[i] = static_cast<uint32_t>(i);
+    }
+    std::vector<uint32_t> expected = keys;
+    std::stable_sort(expected.begin(), expected.end());
+    std::vector<uint32_t> originalKeys = keys;
+
+    RadixSortScratch scratch;
+    radixSortPairs(keys, values, scratch, 30, &pool);
+
+    bool sorted = keys == expected;
+    bool valuesFollow = true;
+    bool stable = true;
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (originalKeys[values[i]] != keys[i]) valuesFollow = false;
+        if (i > 0 && keys[i] == keys[i - 1] && values[i] < values[i - 1]) stable = false;
+    }
+    std::cout << "Radix sort 50000 pairs: sorted=" << (sorted ? "true" : "false") << " values follow keys=" << (valuesFollow ? "true" : "false") << " stable=" << (stable ? "true" : "false") << "\n";
+    assert(sorted && valuesFollow && stable);
+
+    std::vector<uint32_t> smallKeys = {3, 1, 2, 1};
+    std::vector<uint32_t> smallValues = {0, 1, 2, 3};
+    radixSortPairs(smallKeys, smallValues, scratch);
+    assert((smallKeys == std::vector<uint32_t>{1, 1, 2, 3}));
+    assert((smallValues == std::vector<uint32_t>{1, 3, 2, 0}));
+}
+
+void runParallelTests() {
+    testParallelForCoverage();
+    testRadixSortPairs();
+}
@@ -0,0 +1,105 @@
+#include "physics/world/ParticleSystem.h"
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace physics::world;
+using physics::collision::AABB;
+using physics::math::Vec3;
+
+namespace {
+void sprayParticles(ParticleSystem& particles, size_t count, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> spread(-5.0f, 5.0f);
+    std::uniform_real_distribution<float> life(0.2f, 3.0f);
+    for (size_t i = 0; i < count; i++) {
+        particles.spawn(Vec3(spread(rng), 2.0f + spread(rng) * 0.3f, spread(rng)),
+                        Vec3(spread(rng), spread(rng) + 5.0f, spread(rng)), life(rng));
+    }
+}
+
+bool sameState(const ParticleSystem& a, const ParticleSystem& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        Vec3 pa = a.getPosition(i), pb = b.getPosition(i);
+        Vec3 va = a.getVelocity(i), vb = b.getVelocity(i);
+        if (std::memcmp(&pa, &pb, sizeof(Vec3)) != 0 || std::memcmp(&va, &vb, sizeof(Vec3)) != 0) return false;
+        if (a.getLifetime(i) != b.getLifetime(i)) return false;
+    }
+    return true;
+}
+}
+
+void testParticleSimdMatchesScalar() {
+    ParticleSystem simd;
+    ParticleSystem scalar;
+    physics::parallel::ThreadPool pool(3);
+    simd.threadPool = &pool;
+    for (ParticleSystem* particles : {&simd, &scalar}) {
+        sprayParticles(*particles, 50003, 7);
+        particles->addCollider(AABB(Vec3(-1, 0, -1), Vec3(1, 1.5f, 1)));
+        particles->addCollider(AABB(Vec3(2, 0, -4), Vec3(3, 3, 4)));
+    }
+    for (int i = 0; i < 120; i++) {
+        simd.step(1.0f / 60.0f);
+        scalar.stepScalar(1.0f / 60.0f);
+    }
+    bool identical = sameState(simd, scalar);
+    std::cout << "Particles (avx2=" << (ParticleSystem::hasAvx2Kernel() ? "true" : "false") << "): " << simd.size()
+              << " alive of 50003, pooled SIMD identical to serial scalar: " << (identical ? "true" : "false") << "\n";
+    assert(identical);
+    assert(simd.size() > 0 && simd.size() < 50003);
+}
+
+void testParticleGroundAndColliders() {
+    ParticleSystem particles;
+    particles.settings.restitution = 0.0f;
+    size_t dropped = particles.spawn(Vec3(5, 3, 0), Vec3(0, 0, 0), 100.0f);
+    size_t landed = particles.spawn(Vec3(0, 3, 0), Vec3(0, 0, 0), 100.0f);
+    particles.addCollider(AABB(Vec3(-1, 0, -1), Vec3(1, 1, 1)));
+    for (int i = 0; i < 180; i++) {
+        particles.step(1.0f / 60.0f);
+    }
+    std::cout << "Particle heights: ground=" << particles.getPosition(dropped).y << " box top=" << particles.getPosition(landed).y << "\n";
+    assert(particles.getPosition(dropped).y == 0.0f);
+    assert(particles.getPosition(landed).y == 1.0f);
+    assert(std::abs(particles.getVelocity(landed).y) < 0.2f);
+
+    // A particle flying sideways into a box leaves through the face it hit.
+    ParticleSystem sideways;
+    sideways.settings.gravity = Vec3(0, 0, 0);
+    sideways.settings.drag = 0.0f;
+    sideways.settings.restitution = 1.0f;
+    sideways.addCollider(AABB(Vec3(1, -1, -1), Vec3(3, 1, 1)));
+    sideways.spawn(Vec3(0.95f, 0, 0), Vec3(6, 0, 0), 100.0f);
+    sideways.step(1.0f / 60.0f);
+    assert(sideways.getPosition(0).x == 1.0f && sideways.getVelocity(0).x == -6.0f);
+}
+
+void testParticleLifetimeCompaction() {
+    ParticleSystem particles;
+    for (int i = 0; i < 1000; i++) {
+        particles.spawn(Vec3(static_cast<float>(i), 1, 0), Vec3(0, 0, 0), i % 2 == 0 ? 0.05f : 10.0f);
+    }
+    particles.kill(1);
+    particles.step(1.0f / 60.0f);
+    assert(particles.size() == 999);
+    particles.step(1.0f / 60.0f);
+    particles.step(1.0f / 60.0f);
+    particles.step(1.0f / 60.0f);
+    std::cout << "Particles after expiry: " << particles.size() << "\n";
+    assert(particles.size() == 499);
+    for (size_t i = 0; i < particles.size(); i++) {
+        int original = static_cast<int>(particles.getPosition(i).x);
+        assert(original % 2 == 1 && original != 1);
+    }
+}
+
+void runParticleTests() {
+    testParticleSimdMatchesScalar();
+    testParticleGroundAndColliders();
+    testParticleLifetimeCompaction();
+}
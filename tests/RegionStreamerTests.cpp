@@ -0,0 +1,238 @@
+#include "physics/world/RegionStreamer.h"
+#include "physics/collision/ConvexHull.h"
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <filesystem>
+
+using namespace physics::world;
+using namespace physics::dynamics;
+using namespace physics::math;
+
+namespace {
+std::filesystem::path streamingTestDirectory() {
+    return std::filesystem::temp_directory_path() / "valerie_region_streamer_test";
+}
+}
+
+void testRegionSerialization() {
+    RigidBody dynamicBody(Vec3(1.5f, -2.0f, 3.25f), Vec3(1, 2, 3), 4.0f);
+    dynamicBody.velocity = Vec3(0.5f, 0, -1);
+    dynamicBody.restitution = 0.9f;
+    RigidBody staticBody(Vec3(10, 0, 0), Vec3(5, 1, 5), 0.0f);
+
+    std::vector<char> data = RegionStreamer::serializeBodies({&dynamicBody, &staticBody});
+    std::vector<RigidBody> restored = RegionStreamer::deserializeBodies(data);
+
+    std::cout << "Serialized 2 bodies into " << data.size() << " bytes\n";
+    assert(restored.size() == 2);
+    assert(restored[0].position.x == 1.5f && restored[0].position.y == -2.0f && restored[0].position.z == 3.25f);
+    assert(restored[0].velocity.z == -1.0f && restored[0].mass == 4.0f && restored[0].restitution == 0.9f);
+    assert(restored[0].size.y == 2.0f && !restored[0].isStatic);
+    assert(restored[1].isStatic && restored[1].inverseMass == 0.0f);
+}
+
+// Shapes and filters survive a page-out; hulls come back through the hull
+// table, and one that is not in it comes back as its covering box.
+void testRegionSerializationKeepsShapeAndFilter() {
+    using physics::collision::ConvexHull;
+    using physics::collision::Shape;
+    using physics::collision::ShapeType;
+    ConvexHull wedge({Vec3(-1, 0, -1), Vec3(1, 0, -1), Vec3(0, 2, 1)});
+    ConvexHull unknown({Vec3(-0.5f, -0.5f, -0.5f), Vec3(0.5f, 0.5f, 0.5f)});
+    RigidBody capsule(Vec3(0, 0, 0), Vec3(1, 1, 1), 1.0f);
+    capsule.setShape(Shape::capsule(0.25f, 0.5f, Vec3(1, 0, 0)));
+    capsule.filter.category = 4;
+    capsule.filter.mask = 0xF0u;
+    capsule.filter.group = -3;
+    RigidBody hull(Vec3(5, 0, 0), Vec3(1, 1, 1), 1.0f);
+    hull.setShape(Shape::convexHull(wedge));
+    RigidBody unregistered(Vec3(9, 0, 0), Vec3(1, 1, 1), 1.0f);
+    unregistered.setShape(Shape::convexHull(unknown));
+
+    std::vector<const ConvexHull*> hulls = {&wedge};
+    std::vector<RigidBody> restored = RegionStreamer::deserializeBodies(
+        RegionStreamer::serializeBodies({&capsule, &hull, &unregistered}, hulls), hulls);
+    assert(restored.size() == 3);
+    assert(restored[0].shape.type == ShapeType::Capsule && restored[0].shape.radius == 0.25f);
+    assert(restored[0].shape.halfHeight == 0.5f && restored[0].shape.axes[1].x == 1.0f);
+    assert(restored[0].filter == capsule.filter && restored[0].size.y == capsule.size.y);
+    assert(restored[1].shape.type == ShapeType::ConvexHull && restored[1].shape.hull == &wedge);
+    assert(restored[1].filter == physics::collision::CollisionFilter{});
+    assert(restored[2].shape.type == ShapeType::Box && restored[2].size.x == 1.0f);
+}
+
+// Bodies paged out to a region that is already on disk are appended to its
+// file; every record of both batches must come back intact.
+void testRegionAppendedPageOut() {
+    std::filesystem::remove_all(streamingTestDirectory());
+    World world(Vec3(0, 0, 0));
+    world.collisionsEnabled = false;
+    RegionStreamer streamer(world, 50.0f, streamingTestDirectory());
+    ObserverId player = streamer.addObserver(Vec3(0, 5, 5), 30.0f);
+    auto addBatch = [&](float y, float mass) {
+        for (int i = 0; i < 3; i++) {
+            auto body = std::make_unique<RigidBody>(Vec3(200.0f + static_cast<float>(i), y, 5), Vec3(1, 1, 1), mass);
+            body->setShape(physics::collision::Shape::sphere(0.25f * mass));
+            body->filter.category = static_cast<uint32_t>(mass);
+            world.addBody(std::move(body));
+        }
+    };
+    addBatch(5.0f, 1.0f);
+    streamer.update();
+    streamer.waitForPendingIO();
+    addBatch(6.0f, 3.0f);
+    streamer.update();
+    streamer.waitForPendingIO();
+    assert(world.getBodyCount() == 0);
+
+    streamer.setObserverPosition(player, Vec3(210, 5, 5));
+    streamer.update();
+    streamer.waitForPendingIO();
+    streamer.update();
+    assert(world.getBodyCount() == 6 && streamer.getFailedLoads().empty());
+    size_t heavy = 0;
+    for (size_t i = 0; i < world.getBodyCount(); i++) {
+        const RigidBody* body = world.getBody(i);
+        float mass = body->position.y == 6.0f ? 3.0f : 1.0f;
+        assert(body->position.x >= 200.0f && body->position.x <= 202.0f && body->position.z == 5.0f);
+        assert(body->mass == mass && body->filter.category == static_cast<uint32_t>(mass));
+        assert(body->shape.type == physics::collision::ShapeType::Sphere && body->shape.radius == 0.25f * mass);
+        if (mass == 3.0f) heavy++;
+    }
+    assert(heavy == 3);
+}
+
+void testRegionPageOutAndIn() {
+    std::filesystem::remove_all(streamingTestDirectory());
+
+    World world(Vec3(0, 0, 0));
+    world.collisionsEnabled = false;
+    for (int i = 0; i < 10; i++) {
+        world.addBody(std::make_unique<RigidBody>(Vec3(static_cast<float>(i), 5, 5), Vec3(1, 1, 1), 1.0f));
+    }
+    for (int i = 0; i < 20; i++) {
+        auto body = std::make_unique<RigidBody>(Vec3(200.0f + static_cast<float>(i), 5, 5), Vec3(1, 1, 1), 1.0f);
+        body->velocity = Vec3(0, 0, static_cast<float>(i));
+        world.addBody(std::move(body));
+    }
+
+    {
+        RegionStreamer streamer(world, 50.0f, streamingTestDirectory());
+        ObserverId player = streamer.addObserver(Vec3(0, 5, 5), 30.0f);
+
+        streamer.update();
+        streamer.waitForPendingIO();
+
+        RegionKey farRegion = streamer.getRegionKey(Vec3(200, 5, 5));
+        std::cout << "After paging out far region: resident bodies=" << world.getBodyCount() << " paged regions=" << streamer.getPagedOutRegionCount() << "\n";
+        assert(world.getBodyCount() == 10);
+        assert(streamer.isRegionOnDisk(farRegion));
+        assert(std::filesystem::exists(streamer.getRegionPath(farRegion)));
+
+        world.step();
+        assert(world.getBodyCount() == 10);
+
+        streamer.setObserverPosition(player, Vec3(210, 5, 5));
+        streamer.update();
+        assert(streamer.getPendingLoadCount() == 1);
+        streamer.waitForPendingIO();
+        streamer.update();
+        streamer.waitForPendingIO();
+
+        std::cout << "After observer moved: resident bodies=" << world.getBodyCount() << " paged regions=" << streamer.getPagedOutRegionCount() << "\n";
+        assert(world.getBodyCount() == 20);
+        assert(!std::filesystem::exists(streamer.getRegionPath(farRegion)));
+        assert(streamer.isRegionOnDisk(streamer.getRegionKey(Vec3(0, 5, 5))));
+
+        bool restoredAll = true;
+        for (size_t i = 0; i < world.getBodyCount(); i++) {
+            const RigidBody* body = world.getBody(i);
+            float offset = body->position.x - 200.0f;
+            if (offset < 0.0f || offset > 19.0f || std::abs(body->velocity.z - offset) > 0.001f || body->position.y != 5.0f) {
+                restoredAll = false;
+            }
+        }
+        assert(restoredAll);
+
+        streamer.setObserverPosition(player, Vec3(0, 5, 5));
+        streamer.update();
+    }
+
+    // Destroying the streamer flushes queued writes and adds the bodies of
+    // loads that finished meanwhile, here the region around the origin.
+    std::cout << "Region files after shutdown: " << std::distance(std::filesystem::directory_iterator(streamingTestDirectory()), std::filesystem::directory_iterator()) << "\n";
+    assert(world.getBodyCount() == 10);
+    std::filesystem::remove_all(streamingTestDirectory());
+}
+
+// A malformed region file is neither deleted nor reported as an empty load.
+void testRegionLoadFailureKeepsFile() {
+    std::filesystem::remove_all(streamingTestDirectory());
+    World world(Vec3(0, 0, 0));
+    world.collisionsEnabled = false;
+    for (int i = 0; i < 5; i++) {
+        world.addBody(std::make_unique<RigidBody>(Vec3(200.0f + static_cast<float>(i), 5, 5), Vec3(1, 1, 1), 1.0f));
+    }
+    {
+        RegionStreamer streamer(world, 50.0f, streamingTestDirectory());
+        ObserverId player = streamer.addObserver(Vec3(0, 5, 5), 30.0f);
+        streamer.update();
+        streamer.waitForPendingIO();
+        RegionKey farRegion = streamer.getRegionKey(Vec3(200, 5, 5));
+        std::filesystem::path path = streamer.getRegionPath(farRegion);
+        std::filesystem::resize_file(path, std::filesystem::file_size(path) - 3);
+
+        streamer.setObserverPosition(player, Vec3(210, 5, 5));
+        streamer.update();
+        streamer.waitForPendingIO();
+        streamer.update();
+        streamer.waitForPendingIO();
+        assert(world.getBodyCount() == 0);
+        assert(streamer.getFailedLoads().size() == 1 && streamer.getFailedLoads()[0] == farRegion);
+        assert(streamer.isRegionOnDisk(farRegion));
+        assert(std::filesystem::exists(path));
+        // Not retried every update.
+        streamer.update();
+        assert(streamer.getPendingLoadCount() == 0);
+    }
+    std::filesystem::remove_all(streamingTestDirectory());
+}
+
+// A region whose file cannot be written keeps its bodies in the world.
+void testRegionWriteFailureKeepsBodies() {
+    std::filesystem::remove_all(streamingTestDirectory());
+    World world(Vec3(0, 0, 0));
+    world.collisionsEnabled = false;
+    for (int i = 0; i < 5; i++) {
+        world.addBody(std::make_unique<RigidBody>(Vec3(200.0f + static_cast<float>(i), 5, 5), Vec3(1, 1, 1), 1.0f));
+    }
+    {
+        RegionStreamer streamer(world, 50.0f, streamingTestDirectory());
+        RegionKey farRegion = streamer.getRegionKey(Vec3(200, 5, 5));
+        // A directory where the file should go makes the open fail.
+        std::filesystem::create_directories(streamer.getRegionPath(farRegion));
+        ObserverId player = streamer.addObserver(Vec3(0, 5, 5), 30.0f);
+        streamer.update();
+        assert(world.getBodyCount() == 0);
+        streamer.waitForPendingIO();
+        streamer.setObserverPosition(player, Vec3(210, 5, 5));
+        streamer.update();
+        std::cout << "Region write failure: failed writes=" << streamer.getFailedWriteCount()
+                  << " bodies back=" << world.getBodyCount() << "\n";
+        assert(streamer.getFailedWriteCount() == 1);
+        assert(world.getBodyCount() == 5);
+        assert(!streamer.isRegionOnDisk(farRegion));
+    }
+    assert(world.getBodyCount() == 5);
+    std::filesystem::remove_all(streamingTestDirectory());
+}
+
+void runRegionStreamerTests() {
+    testRegionSerialization();
+    testRegionSerializationKeepsShapeAndFilter();
+    testRegionAppendedPageOut();
+    testRegionPageOutAndIn();
+    testRegionLoadFailureKeepsFile();
+    testRegionWriteFailureKeepsBodies();
+}
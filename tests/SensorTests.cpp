@@ -0,0 +1,129 @@
+#include "physics/world/World.h"
+#include "physics/memory/AllocationCounter.h"
+#include <iostream>
+#include <cassert>
+#include <memory>
+#include <vector>
+
+using namespace physics::world;
+using physics::collision::AABB;
+using physics::math::Vec3;
+using physics::dynamics::RigidBody;
+
+namespace {
+size_t countEvents(const World& world, SensorEventType type, SensorId sensor, BodyId body) {
+    size_t count = 0;
+    for (const SensorEvent& event : world.getSensors().getEvents()) {
+        if (event.type == type && event.sensor == sensor && event.body == body) count++;
+    }
+    return count;
+}
+}
+
+void testSensorEnterExit() {
+    World world(Vec3(0, 0, 0));
+    SensorId zone = world.getSensors().add(AABB(Vec3(4, -1, -1), Vec3(6, 1, 1)));
+    auto moving = std::make_unique<RigidBody>(Vec3(0, 0, 0), Vec3(1, 1, 1), 1.0f);
+    moving->velocity = Vec3(6, 0, 0);
+    BodyId body = world.addBody(std::move(moving));
+
+    int enteredAt = -1;
+    int exitedAt = -1;
+    for (int i = 0; i < 120; i++) {
+        world.step();
+        if (countEvents(world, SensorEventType::Enter, zone, body)) {
+            assert(enteredAt < 0);
+            enteredAt = i;
+        }
+        if (countEvents(world, SensorEventType::Exit, zone, body)) {
+            assert(exitedAt < 0);
+            exitedAt = i;
+        }
+    }
+    std::cout << "Sensor entered at step " << enteredAt << ", exited at step " << exitedAt << "\n";
+    assert(enteredAt > 0 && exitedAt > enteredAt);
+    // Sensors never touch the body.
+    assert(world.getBodyById(body)->velocity.x == 6.0f);
+    assert(world.getContacts().empty());
+    assert(world.getSensors().getOverlapCount() == 0);
+}
+
+void testSensorEdits() {
+    World world(Vec3(0, 0, 0));
+    SensorSystem& sensors = world.getSensors();
+    BodyId resting = world.addBody(std::make_unique<RigidBody>(Vec3(0, 0, 0), Vec3(1, 1, 1), 1.0f));
+    world.step();
+
+    SensorId zone = sensors.add(AABB(Vec3(-1, -1, -1), Vec3(1, 1, 1)));
+    world.step();
+    assert(countEvents(world, SensorEventType::Enter, zone, resting) == 1);
+    assert(sensors.getOverlaps(resting).size() == 1);
+    world.step();
+    assert(sensors.getEvents().empty());
+
+    sensors.move(zone, AABB(Vec3(10, 10, 10), Vec3(12, 12, 12)));
+    world.step();
+    assert(countEvents(world, SensorEventType::Exit, zone, resting) == 1);
+
+    sensors.move(zone, AABB(Vec3(-2, -2, -2), Vec3(2, 2, 2)));
+    world.step();
+    assert(countEvents(world, SensorEventType::Enter, zone, resting) == 1);
+    sensors.remove(zone);
+    world.step();
+    assert(countEvents(world, SensorEventType::Exit, zone, resting) == 1);
+    assert(!sensors.isValid(zone) && sensors.getCount() == 0);
+
+    SensorId other = sensors.add(AABB(Vec3(-2, -2, -2), Vec3(2, 2, 2)));
+    world.step();
+    assert(countEvents(world, SensorEventType::Enter, other, resting) == 1);
+    world.removeBodies(std::span<const BodyId>(&resting, 1));
+    world.step();
+    std::cout << "Sensor exit after body removal: " << countEvents(world, SensorEventType::Exit, other, resting) << "\n";
+    assert(countEvents(world, SensorEventType::Exit, other, resting) == 1);
+    assert(sensors.getOverlapCount() == 0);
+}
+
+void testManySensorsRestingBodies() {
+    World world(Vec3(0, 0, 0));
+    SensorSystem& sensors = world.getSensors();
+    // 100k small zones on a 2 m grid, y in {0}
+    for (int x = 0; x < 400; x++) {
+        for (int z = 0; z < 250; z++) {
+            Vec3 center(static_cast<float>(x) * 2.0f, 0.0f, static_cast<float>(z) * 2.0f);
+            sensors.add(AABB(center - Vec3(0.5f, 0.5f, 0.5f), center + Vec3(0.5f, 0.5f, 0.5f)));
+        }
+    }
+    // Resting bodies, each inside exactly one zone, plus one that moves.
+    for (int i = 0; i < 500; i++) {
+        Vec3 center(static_cast<float>(i % 50) * 4.0f, 0.0f, static_cast<float>(i / 50) * 4.0f);
+        world.addBody(std::make_unique<RigidBody>(center, Vec3(0.4f, 0.4f, 0.4f), 1.0f));
+    }
+    auto runner = std::make_unique<RigidBody>(Vec3(1, 0, 2), Vec3(0.4f, 0.4f, 0.4f), 1.0f);
+    runner->velocity = Vec3(12, 0, 0);
+    BodyId runnerId = world.addBody(std::move(runner));
+
+    world.step();
+    assert(sensors.getEvents().size() == 500);
+    assert(sensors.getOverlapCount() == 500);
+
+    size_t enters = 0;
+    size_t exits = 0;
+    for (int i = 0; i < 60; i++) {
+        world.step();
+        for (const SensorEvent& event : sensors.getEvents()) {
+            assert(event.body == runnerId);
+            (event.type == SensorEventType::Enter ? enters : exits)++;
+        }
+    }
+    world.step();
+    assert(!physics::memory::allocationCountingEnabled() || world.getLastStepAllocationCount() == 0);
+    std::cout << "100000 sensors, 501 bodies: steady-state events only from the mover (enters=" << enters
+              << " exits=" << exits << ")\n";
+    assert(enters > 0 && (exits == enters || exits + 1 == enters));
+}
+
+void runSensorTests() {
+    testSensorEnterExit();
+    testSensorEdits();
+    testManySensorsRestingBodies();
+}
@@ -0,0 +1,204 @@
+#include "physics/collision/ShapeCollision.h"
+#include "physics/collision/BatchNarrowphase.h"
+#include "physics/world/World.h"
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace physics::collision;
+using namespace physics::dynamics;
+using namespace physics::math;
+
+namespace {
+// Collision inputs for a handful of bodies, as the world caches them.
+struct ShapeScene {
+    std::vector<AABB> bounds;
+    std::vector<Vec3> positions;
+    std::vector<Shape> shapes;
+
+    uint32_t add(const Vec3& position, const Vec3& size, const Shape& shape) {
+        RigidBody body(position, size, 1.0f);
+        body.setShape(shape);
+        bounds.push_back(body.getAABB());
+        positions.push_back(body.position);
+        shapes.push_back(body.shape);
+        return static_cast<uint32_t>(bounds.size() - 1);
+    }
+
+    ShapeView view() const {
+        return ShapeView{bounds.data(), positions.data(), shapes.data(), nullptr, nullptr};
+    }
+};
+
+bool near(float a, float b, float tolerance = 1e-4f) {
+    return std::abs(a - b) <= tolerance;
+}
+}
+
+void testShapeBounds() {
+    RigidBody ball(Vec3(1, 2, 3), Vec3(1, 1, 1), 1.0f);
+    ball.setShape(Shape::sphere(0.5f));
+    AABB ballBounds = ball.getAABB();
+    assert(ballBounds.min.x == 0.5f && ballBounds.max.z == 3.5f);
+    assert(ball.size.y == 1.0f);
+
+    RigidBody pill(Vec3(0, 0, 0), Vec3(1, 1, 1), 1.0f);
+    pill.setShape(Shape::capsule(0.5f, 1.0f));
+    AABB pillBounds = pill.getAABB();
+    std::cout << "Capsule bounds y: " << pillBounds.min.y << " to " << pillBounds.max.y << "\n";
+    assert(near(pillBounds.max.y, 1.5f) && near(pillBounds.max.x, 0.5f));
+    assert(near(pill.size.y, 3.0f));
+
+    float c = std::sqrt(0.5f);
+    RigidBody crate(Vec3(0, 0, 0), Vec3(1, 1, 1), 1.0f);
+    crate.setShape(Shape::orientedBox(Vec3(1, 1, 1), Vec3(c, c, 0), Vec3(-c, c, 0)));
+    AABB crateBounds = crate.getAABB();
+    std::cout << "Rotated box bounds x: " << crateBounds.min.x << " to " << crateBounds.max.x << "\n";
+    assert(near(crateBounds.max.x, 2.0f * c) && near(crateBounds.max.z, 1.0f));
+}
+
+void testPrimitivePairs() {
+    ShapeScene scene;
+    uint32_t floor = scene.add(Vec3(0, -0.5f, 0), Vec3(10, 1, 10), Shape::box());
+    uint32_t ball = scene.add(Vec3(0, 0.4f, 0), Vec3(1, 1, 1), Shape::sphere(0.5f));
+    uint32_t otherBall = scene.add(Vec3(0.8f, 0.4f, 0), Vec3(1, 1, 1), Shape::sphere(0.5f));
+    uint32_t pill = scene.add(Vec3(0, 1.1f, 0), Vec3(1, 1, 1), Shape::capsule(0.25f, 0.5f, Vec3(1, 0, 0)));
+    uint32_t standing = scene.add(Vec3(0.3f, 1.9f, 0), Vec3(1, 1, 1), Shape::capsule(0.25f, 0.5f));
+    ShapeView view = scene.view();
+
+    // Box A under sphere B: the normal points from the sphere down into the box
+    CollisionInfo boxBall = ShapeCollision::collide(view, floor, ball);
+    std::cout << "Box-sphere depth=" << boxBall.penetrationDepth << " normal.y=" << boxBall.normal.y << "\n";
+    assert(boxBall.hasCollision && near(boxBall.penetrationDepth, 0.1f) && near(boxBall.normal.y, -1.0f));
+    CollisionInfo ballBox = ShapeCollision::collide(view, ball, floor);
+    assert(ballBox.hasCollision && near(ballBox.normal.y, 1.0f));
+
+    CollisionInfo balls = ShapeCollision::collide(view, ball, otherBall);
+    assert(balls.hasCollision && near(balls.penetrationDepth, 0.2f) && near(balls.normal.x, -1.0f));
+
+    CollisionInfo ballPill = ShapeCollision::collide(view, ball, pill);
+    std::cout << "Sphere-capsule depth=" << ballPill.penetrationDepth << "\n";
+    assert(ballPill.hasCollision && near(ballPill.penetrationDepth, 0.05f) && near(ballPill.normal.y, -1.0f));
+
+    CollisionInfo pills = ShapeCollision::collide(view, pill, standing);
+    std::cout << "Capsule-capsule depth=" << pills.penetrationDepth << "\n";
+    assert(pills.hasCollision && near(pills.penetrationDepth, 0.2f) && near(pills.normal.y, -1.0f));
+
+    assert(!ShapeCollision::collide(view, floor, standing).hasCollision);
+}
+
+void testOrientedBoxes() {
+    float c = std::sqrt(0.5f);
+    ShapeScene scene;
+    uint32_t box = scene.add(Vec3(0, 0, 0), Vec3(2, 2, 2), Shape::box());
+    // Diamond whose bounds overlap the box corner region but whose faces do not
+    uint32_t diamond = scene.add(Vec3(2.3f, 2.3f, 0), Vec3(1, 1, 1), Shape::orientedBox(Vec3(1, 1, 1), Vec3(c, c, 0), Vec3(-c, c, 0)));
+    uint32_t touching = scene.add(Vec3(2.0f, 0, 0), Vec3(1, 1, 1), Shape::orientedBox(Vec3(1, 1, 1), Vec3(c, c, 0), Vec3(-c, c, 0)));
+    ShapeView view = scene.view();
+
+    assert(scene.bounds[box].intersects(scene.bounds[diamond]));
+    assert(!ShapeCollision::collide(view, box, diamond).hasCollision);
+
+    CollisionInfo hit = ShapeCollision::collide(view, box, touching);
+    std::cout << "Box vs rotated box depth=" << hit.penetrationDepth << " normal.x=" << hit.normal.x << "\n";
+    assert(hit.hasCollision && near(hit.penetrationDepth, 2.0f * c - 1.0f) && near(hit.normal.x, -1.0f));
+}
+
+void testSphereBatchMatchesScalar() {
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> coordinate(-3.0f, 3.0f);
+    std::uniform_real_distribution<float> radius(0.1f, 1.0f);
+    ShapeScene scene;
+    for (int i = 0; i < 300; i++) {
+        scene.add(Vec3(coordinate(rng), coordinate(rng), coordinate(rng)), Vec3(1, 1, 1), Shape::sphere(radius(rng)));
+    }
+    scene.add(Vec3(0, 0, 0), Vec3(1, 1, 1), Shape::sphere(0.5f));
+    scene.add(Vec3(0, 0, 0), Vec3(1, 1, 1), Shape::sphere(0.5f));
+
+    std::vector<BodyPair> pairs;
+    for (uint32_t a = 0; a < scene.shapes.size(); a++) {
+        for (uint32_t b = a + 1; b < scene.shapes.size(); b += 2) {
+            pairs.push_back({a, b});
+        }
+    }
+    std::vector<Contact> batched(pairs.size());
+    std::vector<Contact> scalar(pairs.size());
+    size_t batchedCount = BatchNarrowphase::findSphereContacts(scene.positions.data(), scene.shapes.data(), pairs, batched.data());
+    size_t scalarCount = BatchNarrowphase::findSphereContactsScalar(scene.positions.data(), scene.shapes.data(), pairs, scalar.data());
+
+    bool matches = batchedCount == scalarCount;
+    for (size_t i = 0; matches && i < scalarCount; i++) {
+        const CollisionInfo& lhs = batched[i].info;
+        const CollisionInfo& rhs = scalar[i].info;
+        matches = batched[i].indexA == scalar[i].indexA && batched[i].indexB == scalar[i].indexB &&
+                  std::memcmp(&lhs.normal, &rhs.normal, sizeof(Vec3)) == 0 &&
+                  std::memcmp(&lhs.contactPoint, &rhs.contactPoint, sizeof(Vec3)) == 0 &&
+                  std::memcmp(&lhs.penetrationDepth, &rhs.penetrationDepth, sizeof(float)) == 0;
+    }
+    std::cout << "Sphere batch: " << pairs.size() << " pairs, " << batchedCount << " contacts, bit-identical to scalar: " << (matches ? "true" : "false") << "\n";
+    assert(matches && batchedCount > 0);
+}
+
+void testMixedBatchDispatch() {
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> coordinate(-2.0f, 2.0f);
+    float c = std::sqrt(0.5f);
+    const Shape shapes[4] = {Shape::box(), Shape::sphere(0.6f), Shape::capsule(0.3f, 0.5f),
+                             Shape::orientedBox(Vec3(0.5f, 0.5f, 0.5f), Vec3(c, 0, c), Vec3(0, 1, 0))};
+    ShapeScene scene;
+    for (int i = 0; i < 120; i++) {
+        scene.add(Vec3(coordinate(rng), coordinate(rng), coordinate(rng)), Vec3(1, 1, 1), shapes[i % 4]);
+    }
+    std::vector<BodyPair> pairs;
+    for (uint32_t a = 0; a < scene.shapes.size(); a++) {
+        for (uint32_t b = a + 1; b < scene.shapes.size(); b++) {
+            pairs.push_back({a, b});
+        }
+    }
+
+    ShapeView view = scene.view();
+    std::vector<BodyPair> scratch;
+    std::vector<Contact> contacts(pairs.size());
+    size_t count = ShapeCollision::findContacts(view, pairs, scratch, contacts.data());
+
+    size_t expected = 0;
+    for (const BodyPair& pair : pairs) {
+        if (ShapeCollision::collide(view, pair.a, pair.b).hasCollision) expected++;
+    }
+    bool consistent = count == expected;
+    for (size_t i = 0; consistent && i < count; i++) {
+        CollisionInfo single = ShapeCollision::collide(view, contacts[i].indexA, contacts[i].indexB);
+        consistent = single.penetrationDepth == contacts[i].info.penetrationDepth && single.normal.x == contacts[i].info.normal.x;
+    }
+    std::cout << "Mixed shape batch: " << pairs.size() << " pairs, " << count << " contacts, matches per-pair dispatch: " << (consistent ? "true" : "false") << "\n";
+    assert(consistent && count > 0);
+}
+
+void testSphereRestsOnFloor() {
+    physics::world::World world;
+    world.addBody(std::make_unique<RigidBody>(Vec3(0, -0.5f, 0), Vec3(20, 1, 20), 0.0f));
+    auto ball = std::make_unique<RigidBody>(Vec3(0, 3, 0), Vec3(1, 1, 1), 1.0f);
+    ball->setShape(Shape::sphere(0.5f));
+    ball->restitution = 0.0f;
+    physics::world::BodyId ballId = world.addBody(std::move(ball));
+
+    for (int i = 0; i < 240; i++) {
+        world.step();
+    }
+    float height = world.getBodyById(ballId)->position.y;
+    std::cout << "Sphere resting height: " << height << "\n";
+    assert(height > 0.45f && height < 0.55f);
+}
+
+void runShapeTests() {
+    testShapeBounds();
+    testPrimitivePairs();
+    testOrientedBoxes();
+    testSphereBatchMatchesScalar();
+    testMixedBatchDispatch();
+    testSphereRestsOnFloor();
+}
@@ -0,0 +1,136 @@
+#include "physics/world/World.h"
+#include "physics/parallel/ThreadPool.h"
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+using namespace physics::world;
+using physics::math::Vec3;
+using physics::collision::AABB;
+using physics::dynamics::RigidBody;
+
+namespace {
+// Falling boxes over a floor, with every tenth body asleep in the air.
+void addScene(World& world, int count) {
+    world.addBody(std::make_unique<RigidBody>(Vec3(0, -0.5f, 0), Vec3(200, 1, 200), 0.0f));
+    for (int i = 0; i < count; i++) {
+        float x = -50.0f + static_cast<float>(i % 50) * 2.0f;
+        float z = -50.0f + static_cast<float>(i / 50) * 2.0f;
+        world.addBody(std::make_unique<RigidBody>(Vec3(x, 1.0f + static_cast<float>(i % 3), z), Vec3(0.5f, 0.5f, 0.5f),
+                                                  i % 10 == 0 ? 0.0f : 1.0f));
+    }
+}
+}
+
+// The snapshot holds each body's state after the solve, by storage index,
+// and is the same on any number of threads.
+void testSnapshotMatchesBodies() {
+    physics::parallel::ThreadPool pool(3);
+    World serial;
+    World parallel;
+    parallel.threadPool = &pool;
+    for (World* world : {&serial, &parallel}) {
+        world->snapshots.enabled = true;
+        addScene(*world, 2000);
+    }
+    for (int i = 0; i < 20; i++) {
+        serial.step();
+        parallel.step();
+    }
+    assert(serial.getSnapshotPositions().size() == serial.getBodyCount());
+    for (size_t i = 0; i < serial.getBodyCount(); i++) {
+        const RigidBody& body = *serial.getBody(i);
+        assert(serial.getSnapshotIds()[i] == serial.getBodyId(i));
+        assert(std::memcmp(&serial.getSnapshotPositions()[i], &body.position, sizeof(Vec3)) == 0);
+        assert(std::memcmp(&serial.getSnapshotVelocities()[i], &body.velocity, sizeof(Vec3)) == 0);
+        AABB bounds = body.getAABB();
+        assert(std::memcmp(&serial.getSnapshotBounds()[i], &bounds, sizeof(AABB)) == 0);
+    }
+    size_t bytes = serial.getBodyCount() * sizeof(Vec3);
+    assert(std::memcmp(serial.getSnapshotPositions().data(), parallel.getSnapshotPositions().data(), bytes) == 0);
+}
+
+// Only bodies whose state changed after a frame are listed for it.
+void testChangedSinceFrame() {
+    World world(Vec3(0, 0, 0));
+    world.snapshots.enabled = true;
+    world.collisionsEnabled = false;
+    for (int i = 0; i < 100; i++) {
+        world.addBody(std::make_unique<RigidBody>(Vec3(static_cast<float>(i) * 2.0f, 0, 0), Vec3(1, 1, 1), 1.0f));
+    }
+    world.step();
+    uint32_t first = world.getFrame();
+    std::vector<uint32_t> changed;
+    world.getChangedSince(0, changed);
+    assert(changed.size() == 100);
+
+    world.getBody(10)->velocity = Vec3(1, 0, 0);
+    world.getBody(40)->position = Vec3(0, 5, 0);
+    world.step();
+    world.step();
+    changed.clear();
+    world.getChangedSince(first, changed);
+    assert(changed.size() == 2 && changed[0] == 10 && changed[1] == 40);
+    changed.clear();
+    world.getChangedSince(world.getFrame() - 1, changed);
+    assert(changed.size() == 1 && changed[0] == 10);
+    changed.clear();
+    world.getChangedSince(world.getFrame(), changed);
+    assert(changed.empty());
+
+    BodyId added = world.addBody(std::make_unique<RigidBody>(Vec3(0, -5, 0), Vec3(1, 1, 1), 1.0f));
+    uint32_t before = world.getFrame();
+    world.step();
+    changed.clear();
+    world.getChangedSince(before, changed);
+    assert(changed.size() == 2 && world.getSnapshotIds()[changed[1]] == added);
+
+    // A new shape or size changes the bounds of a body that stays put.
+    world.getBody(20)->setShape(physics::collision::Shape::sphere(0.75f));
+    world.getBody(30)->size = Vec3(1, 3, 1);
+    before = world.getFrame();
+    world.step();
+    changed.clear();
+    world.getChangedSince(before, changed);
+    assert(changed.size() == 3 && changed[0] == 10 && changed[1] == 20 && changed[2] == 30);
+    AABB bounds = world.getBody(30)->getAABB();
+    assert(std::memcmp(&world.getSnapshotBounds()[30], &bounds, sizeof(AABB)) == 0);
+}
+
+// 16-bit positions round-trip to within half a quantization step.
+void testQuantizedPositions() {
+    AABB range(Vec3(-512, -64, -512), Vec3(512, 64, 512));
+    World world(Vec3(0, -9.81f, 0));
+    world.snapshots.enabled = true;
+    for (int i = 0; i < 500; i++) {
+        float t = static_cast<float>(i);
+        world.addBody(std::make_unique<RigidBody>(Vec3(std::sin(t) * 500, std::cos(t * 3) * 60, std::cos(t) * 500),
+                                                  Vec3(1, 1, 1), 1.0f));
+    }
+    world.collisionsEnabled = false;
+    world.step();
+
+    std::vector<uint32_t> changed;
+    world.getChangedSince(0, changed);
+    std::vector<QuantizedPosition> packed(changed.size());
+    quantizePositions(world.getSnapshotPositions(), changed, range, packed.data());
+    float worst = 0.0f;
+    for (size_t k = 0; k < changed.size(); k++) {
+        Vec3 error = dequantizePosition(packed[k], range) - world.getSnapshotPositions()[changed[k]];
+        worst = std::max(worst, std::max(std::fabs(error.x), std::fabs(error.z)));
+        assert(std::fabs(error.y) <= 128.0f / 65535.0f);
+    }
+    assert(worst <= 1024.0f / 65535.0f);
+
+    QuantizedPosition clamped = quantizePosition(Vec3(1000, -1000, 0), range);
+    assert(clamped.x == 65535 && clamped.y == 0 && clamped.z == 32768);
+}
+
+void runSnapshotTests() {
+    testSnapshotMatchesBodies();
+    testChangedSinceFrame();
+    testQuantizedPositions();
+}
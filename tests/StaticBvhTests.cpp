@@ -0,0 +1,219 @@
+#include "physics/collision/StaticBvh.h"
+#include "physics/world/World.h"
+#include <iostream>
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace physics::world;
+using physics::collision::AABB;
+using physics::collision::BvhNode;
+using physics::collision::StaticBvh;
+using physics::dynamics::RigidBody;
+using physics::math::Vec3;
+
+namespace {
+std::vector<AABB> randomBoxes(size_t count, unsigned seed, float spread, float maxSize) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> position(-spread, spread);
+    std::uniform_real_distribution<float> size(0.05f, maxSize);
+    std::vector<AABB> boxes;
+    for (size_t i = 0; i < count; i++) {
+        Vec3 center(position(rng), position(rng) * 0.2f, position(rng));
+        boxes.push_back(AABB(center, size(rng), size(rng), size(rng)));
+    }
+    return boxes;
+}
+
+// Level of floor tiles and pillars plus dynamic boxes dropped above it.
+void buildLevel(World& world) {
+    for (int x = -20; x < 20; x++) {
+        for (int z = -20; z < 20; z++) {
+            world.addBody(std::make_unique<RigidBody>(Vec3(x + 0.5f, -0.5f, z + 0.5f), Vec3(1, 1, 1), 0.0f));
+            if ((x * 7 + z * 3) % 11 == 0) {
+                world.addBody(std::make_unique<RigidBody>(Vec3(x + 0.5f, 1.0f, z + 0.5f), Vec3(1, 2, 1), 0.0f));
+            }
+        }
+    }
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> spread(-15.0f, 15.0f);
+    for (int i = 0; i < 300; i++) {
+        auto body = std::make_unique<RigidBody>(Vec3(spread(rng), 0.6f + (i % 5) * 1.5f, spread(rng)), Vec3(0.8f, 0.8f, 0.8f), 1.0f);
+        body->restitution = 0.0f;
+        world.addBody(std::move(body));
+    }
+}
+
+bool sameNode(const BvhNode& a, const BvhNode& b) {
+    return std::memcmp(a.childMin, b.childMin, sizeof(a.childMin)) == 0 &&
+           std::memcmp(a.childMax, b.childMax, sizeof(a.childMax)) == 0 &&
+           std::memcmp(a.child, b.child, sizeof(a.child)) == 0 && std::memcmp(a.count, b.count, sizeof(a.count)) == 0;
+}
+
+std::vector<std::pair<BodyId, BodyId>> contactIds(const World& world) {
+    std::vector<std::pair<BodyId, BodyId>> ids;
+    for (const Contact& contact : world.getContacts()) {
+        BodyId a = world.getBodyId(contact.indexA);
+        BodyId b = world.getBodyId(contact.indexB);
+        ids.push_back({std::min(a, b), std::max(a, b)});
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+}
+
+void testStaticBvhMatchesBruteForce() {
+    std::vector<AABB> boxes = randomBoxes(5000, 11, 100.0f, 3.0f);
+    StaticBvh tree;
+    tree.build(boxes);
+    assert(tree.getPrimitiveCount() == boxes.size());
+    assert(tree.getDepth() < 64);
+    assert(reinterpret_cast<uintptr_t>(tree.getNodes().data()) % 64 == 0);
+
+    std::span<const uint32_t> order = tree.getPrimitiveOrder();
+    std::vector<AABB> queries = randomBoxes(500, 12, 110.0f, 12.0f);
+    size_t hits = 0;
+    for (const AABB& query : queries) {
+        std::vector<uint32_t> found;
+        tree.query(query, [&](uint32_t k) { found.push_back(order[k]); });
+        std::vector<uint32_t> expected;
+        for (uint32_t i = 0; i < boxes.size(); i++) {
+            if (boxes[i].intersects(query)) expected.push_back(i);
+        }
+        std::sort(found.begin(), found.end());
+        assert(found == expected);
+        hits += found.size();
+    }
+
+    // Subtrees built on a pool splice into the same tree.
+    physics::parallel::ThreadPool pool(3);
+    StaticBvh pooled;
+    pooled.build(boxes, &pool);
+    assert(pooled.getNodeCount() == tree.getNodeCount());
+    for (size_t i = 0; i < tree.getNodeCount(); i++) {
+        assert(sameNode(pooled.getNodes()[i], tree.getNodes()[i]));
+    }
+    assert(std::equal(order.begin(), order.end(), pooled.getPrimitiveOrder().begin()));
+    std::cout << "Static BVH: 5000 boxes, " << tree.getNodeCount() << " nodes, depth " << tree.getDepth() << ", "
+              << hits << " query hits match brute force\n";
+}
+
+void testStaticBvhSmallInputs() {
+    StaticBvh tree;
+    tree.build({});
+    size_t visits = 0;
+    tree.query(AABB(Vec3(-1, -1, -1), Vec3(1, 1, 1)), [&](uint32_t) { visits++; });
+    assert(visits == 0);
+
+    std::vector<AABB> one = {AABB(Vec3(0, 0, 0), Vec3(1, 1, 1))};
+    tree.build(one);
+    tree.query(AABB(Vec3(-10, -10, -10), Vec3(10, 10, 10)), [&](uint32_t k) { visits += k == 0; });
+    tree.query(AABB(Vec3(2, 2, 2), Vec3(3, 3, 3)), [&](uint32_t) { visits += 10; });
+    assert(visits == 1);
+
+    // Identical boxes cannot be split by the heuristic.
+    std::vector<AABB> stacked(100, AABB(Vec3(0, 0, 0), Vec3(1, 1, 1)));
+    tree.build(stacked);
+    visits = 0;
+    tree.query(AABB(Vec3(0.5f, 0.5f, 0.5f), Vec3(0.6f, 0.6f, 0.6f)), [&](uint32_t) { visits++; });
+    assert(visits == 100);
+    assert(tree.getDepth() < 64);
+}
+
+// Baking must find exactly the contacts the sweep finds without it.
+void testBakedWorldMatchesUnbaked() {
+    World plain;
+    World baked;
+    buildLevel(plain);
+    buildLevel(baked);
+    size_t staticCount = baked.bakeStaticGeometry();
+    assert(staticCount == baked.getBakedBodyCount());
+    assert(staticCount == baked.getBodyCount() - 300);
+    for (size_t i = 0; i < baked.getBodyCount(); i++) {
+        assert(baked.getBody(i)->isStatic == (i < staticCount));
+        assert(baked.getBodyById(plain.getBodyId(i))->position.x == plain.getBody(i)->position.x);
+    }
+
+    for (int i = 0; i < 120; i++) {
+        plain.step();
+        baked.step();
+        if (i == 0) {
+            assert(contactIds(plain) == contactIds(baked));
+            assert(baked.getChangedBodies().size() == baked.getBodyCount());
+        }
+        for (const auto& pair : baked.getCandidatePairs()) {
+            assert(pair.a < pair.b);
+            assert(pair.b >= staticCount);
+        }
+    }
+    // Integration and the bounds refresh skip the baked block.
+    for (uint32_t slot : baked.getChangedBodies()) {
+        assert(slot >= staticCount);
+    }
+
+    size_t resting = 0;
+    for (size_t i = staticCount; i < baked.getBodyCount(); i++) {
+        float y = baked.getBody(i)->position.y;
+        assert(y > 0.0f);
+        if (y < 2.6f) resting++;
+    }
+    std::cout << "Baked " << staticCount << " static bodies, BVH depth " << baked.getStaticBvh().getDepth() << ", "
+              << contactIds(baked).size() << " contacts, " << resting << "/300 boxes down\n";
+    assert(resting > 200);
+}
+
+void testBakedWorldEdits() {
+    World world;
+    buildLevel(world);
+    physics::parallel::ThreadPool pool(3);
+    world.threadPool = &pool;
+    size_t staticCount = world.bakeStaticGeometry();
+    for (int i = 0; i < 10; i++) world.step();
+
+    BodyId late = world.addBody(std::make_unique<RigidBody>(Vec3(0.5f, 0.5f, 0.5f), Vec3(0.5f, 0.5f, 0.5f), 1.0f));
+    world.reorderBodies();
+    assert(world.getBakedBodyCount() == staticCount);
+    for (int i = 0; i < 30; i++) world.step();
+    assert(world.getBodyById(late)->position.y > 0.0f);
+
+    // Removing baked geometry drops the bake; the next step bakes the rest
+    // again and keeps simulating.
+    BodyId tile = world.getBodyId(0);
+    std::vector<BodyId> removed = {tile};
+    world.removeBodies(removed);
+    assert(world.getBakedBodyCount() == 0);
+    assert(world.getStaticBvh().getPrimitiveCount() == 0);
+    world.step();
+    assert(world.getBakedBodyCount() == staticCount - 1);
+    assert(world.getStaticBvh().getPrimitiveCount() == staticCount - 1);
+    assert(world.getBodyById(late)->position.y > 0.0f);
+
+    // So do commands that touch baked bodies.
+    {
+        CommandWriter writer = world.getCommands().writer(0);
+        writer.despawn(world.getBodyId(0));
+        writer.teleport(world.getBodyId(1), world.getBody(1)->position + Vec3(0, -0.5f, 0));
+    }
+    world.step();
+    assert(world.getBakedBodyCount() == staticCount - 2);
+    for (int i = 0; i < 10; i++) world.step();
+    assert(world.getBodyById(late)->position.y > 0.0f);
+
+    assert(world.bakeStaticGeometry() == staticCount - 2);
+    world.clearBodies();
+    assert(world.getBakedBodyCount() == 0);
+    world.addBody(std::make_unique<RigidBody>(Vec3(0, -1, 0), Vec3(10, 1, 10), 0.0f));
+    world.step();
+    assert(world.getBakedBodyCount() == 0);
+}
+
+void runStaticBvhTests() {
+    testStaticBvhMatchesBruteForce();
+    testStaticBvhSmallInputs();
+    testBakedWorldMatchesUnbaked();
+    testBakedWorldEdits();
+}
@@ -0,0 +1,120 @@
+#include "physics/world/World.h"
+#include "physics/parallel/ThreadPool.h"
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <memory>
+
+using namespace physics::world;
+using physics::math::Vec3;
+using physics::dynamics::RigidBody;
+
+namespace {
+// A 10 cm thick baked wall at x = 5, and a 20 cm box flying at it at
+// 60 m/s, a metre per 60 Hz step.
+float shootAtWall(uint32_t maxSubsteps, size_t& substepped) {
+    World world(Vec3(0, 0, 0));
+    world.substeps.maxSubsteps = maxSubsteps;
+    world.addBody(std::make_unique<RigidBody>(Vec3(5, 0, 0), Vec3(0.1f, 4, 4), 0.0f));
+    world.bakeStaticGeometry();
+    BodyId bullet = world.addBody(std::make_unique<RigidBody>(Vec3(0.5f, 0, 0), Vec3(0.2f, 0.2f, 0.2f), 1.0f));
+    world.getBodyById(bullet)->velocity = Vec3(60, 0, 0);
+    world.step();
+    substepped = world.getLastSubstepBodyCount();
+    for (int i = 0; i < 20; i++) {
+        world.step();
+    }
+    return world.getBodyById(bullet)->position.x;
+}
+}
+
+void testSubstepsStopTunneling() {
+    size_t substepped = 0;
+    assert(shootAtWall(1, substepped) > 5.0f);
+    assert(substepped == 0);
+    float x = shootAtWall(16, substepped);
+    assert(x < 5.0f);
+    assert(substepped == 1);
+    std::cout << "Substeps: bullet stopped at x=" << x << " by a 10 cm wall\n";
+}
+
+// Only fast bodies take substeps; everything else steps exactly as without
+// them.
+void testSubstepsOnlyCostFastBodies() {
+    World plain;
+    World multiRate;
+    multiRate.substeps.maxSubsteps = 8;
+    for (World* world : {&plain, &multiRate}) {
+        world->collisionsEnabled = false;
+        for (int i = 0; i < 5000; i++) {
+            float x = static_cast<float>(i % 100) * 2.0f;
+            float z = static_cast<float>(i / 100) * 2.0f;
+            auto body = std::make_unique<RigidBody>(Vec3(x, 10, z), Vec3(0.5f, 0.5f, 0.5f), 1.0f);
+            body->velocity = i % 500 == 0 ? Vec3(0, 0, 40) : Vec3(1, 0, 0);
+            world->addBody(std::move(body));
+        }
+    }
+    for (int i = 0; i < 10; i++) {
+        plain.step();
+        multiRate.step();
+        assert(multiRate.getLastSubstepBodyCount() == 10);
+    }
+    for (size_t i = 0; i < plain.getBodyCount(); i++) {
+        if (i % 500 == 0) continue;
+        assert(std::memcmp(&plain.getBody(i)->position, &multiRate.getBody(i)->position, sizeof(Vec3)) == 0);
+    }
+}
+
+// A contact deeper than maxPenetration of the body substeps it next step.
+void testDeepContactsTriggerSubsteps() {
+    World world(Vec3(0, 0, 0));
+    world.substeps.maxSubsteps = 4;
+    world.addBody(std::make_unique<RigidBody>(Vec3(0, -0.5f, 0), Vec3(10, 1, 10), 0.0f));
+    world.addBody(std::make_unique<RigidBody>(Vec3(0, 0.1f, 0), Vec3(1, 1, 1), 1.0f));
+    world.step();
+    assert(world.getLastSubstepBodyCount() == 0);
+    world.step();
+    assert(world.getLastSubstepBodyCount() == 1);
+    world.step();
+    assert(world.getLastSubstepBodyCount() == 0);
+}
+
+// Substep groups are per chunk, so pooled steps match serial ones.
+void testParallelSubstepsMatchSerial() {
+    physics::parallel::ThreadPool pool(3);
+    World serial;
+    World parallel;
+    parallel.threadPool = &pool;
+    for (World* world : {&serial, &parallel}) {
+        world->substeps.maxSubsteps = 16;
+        world->addBody(std::make_unique<RigidBody>(Vec3(0, -0.5f, 0), Vec3(200, 1, 200), 0.0f));
+        for (int i = 0; i < 20; i++) {
+            float z = -50.0f + static_cast<float>(i) * 5.0f;
+            world->addBody(std::make_unique<RigidBody>(Vec3(0, 1, z), Vec3(0.2f, 2, 4), 0.0f));
+        }
+        world->bakeStaticGeometry();
+        for (int i = 0; i < 3000; i++) {
+            float x = -60.0f + static_cast<float>(i % 60) * 2.0f;
+            float z = -50.0f + static_cast<float>(i / 60) * 2.0f;
+            auto body = std::make_unique<RigidBody>(Vec3(x, 0.5f + static_cast<float>(i % 4), z), Vec3(0.3f, 0.3f, 0.3f), 1.0f);
+            body->velocity = Vec3(x < 0 ? 30.0f : -30.0f, 0, static_cast<float>(i % 7) - 3.0f);
+            world->addBody(std::move(body));
+        }
+    }
+    for (int i = 0; i < 30; i++) {
+        serial.step();
+        parallel.step();
+        assert(serial.getLastSubstepBodyCount() == parallel.getLastSubstepBodyCount());
+    }
+    for (size_t i = 0; i < serial.getBodyCount(); i++) {
+        assert(std::memcmp(&serial.getBody(i)->position, &parallel.getBody(i)->position, sizeof(Vec3)) == 0);
+    }
+}
+
+void runSubstepTests() {
+    testSubstepsStopTunneling();
+    testSubstepsOnlyCostFastBodies();
+    testDeepContactsTriggerSubsteps();
+    testParallelSubstepsMatchSerial();
+}
@@ -0,0 +1,176 @@
+#include "physics/parallel/TaskGraph.h"
+#include "physics/world/World.h"
+#include <iostream>
+#include <cassert>
+#include <atomic>
+#include <stdexcept>
+#include <memory>
+#include <vector>
+
+using namespace physics::parallel;
+using namespace physics::world;
+using physics::math::Vec3;
+using physics::dynamics::RigidBody;
+
+namespace {
+struct OrderLog {
+    std::atomic<int> clock{0};
+    int finishedAt[6] = {};
+};
+
+void recordTask(void* context, size_t arg) {
+    OrderLog& log = *static_cast<OrderLog*>(context);
+    log.finishedAt[arg] = ++log.clock;
+}
+
+void fillPile(World& world) {
+    world.addBody(std::make_unique<RigidBody>(Vec3(0, -1, 0), Vec3(200, 1, 200), 0.0f));
+    for (int i = 0; i < 1500; i++) {
+        float x = static_cast<float>(i % 40) * 1.5f - 30.0f;
+        float z = static_cast<float>(i / 40) * 1.5f - 30.0f;
+        float y = 0.6f + static_cast<float>(i % 3) * 0.9f;
+        world.addBody(std::make_unique<RigidBody>(Vec3(x, y, z), Vec3(1, 1, 1), 1.0f));
+    }
+}
+
+struct ContactProbe {
+    World* world;
+    size_t contactsSeen;
+};
+
+void probeContacts(void* context, size_t) {
+    ContactProbe& probe = *static_cast<ContactProbe*>(context);
+    probe.contactsSeen += probe.world->getContacts().size();
+}
+}
+
+void testTaskGraphOrdering() {
+    // 0 -> {1, 2} -> 3, and 4 -> 5 independent of the rest
+    for (int withPool = 0; withPool < 2; withPool++) {
+        ThreadPool pool(3);
+        TaskGraph graph;
+        OrderLog log;
+        TaskId ids[6];
+        for (size_t i = 0; i < 6; i++) {
+            ids[i] = graph.addTask(&recordTask, &log, i);
+        }
+        graph.addDependency(ids[0], ids[1]);
+        graph.addDependency(ids[0], ids[2]);
+        graph.addDependency(ids[1], ids[3]);
+        graph.addDependency(ids[2], ids[3]);
+        graph.addDependency(ids[4], ids[5]);
+        graph.run(withPool ? &pool : nullptr);
+
+        std::cout << "TaskGraph " << (withPool ? "pooled" : "serial") << " finish order:";
+        for (int i = 0; i < 6; i++) std::cout << " " << log.finishedAt[i];
+        std::cout << "\n";
+        assert(graph.getLastRunOrder().size() == 6);
+        assert(log.finishedAt[0] < log.finishedAt[1] && log.finishedAt[0] < log.finishedAt[2]);
+        assert(log.finishedAt[1] < log.finishedAt[3] && log.finishedAt[2] < log.finishedAt[3]);
+        assert(log.finishedAt[4] < log.finishedAt[5]);
+    }
+
+    // clear() keeps capacity, so rebuilding the same graph does not allocate
+    TaskGraph graph;
+    OrderLog log;
+    graph.addTask(&recordTask, &log, 0);
+    graph.run();
+    graph.clear();
+    assert(graph.getTaskCount() == 0);
+}
+
+// A cycle is refused before any task runs, with or without a pool, and
+// the graph can be rebuilt afterwards.
+void testTaskGraphCycleThrows() {
+    for (int withPool = 0; withPool < 2; withPool++) {
+        ThreadPool pool(3);
+        TaskGraph graph;
+        OrderLog log;
+        TaskId ids[3];
+        for (size_t i = 0; i < 3; i++) {
+            ids[i] = graph.addTask(&recordTask, &log, i);
+        }
+        graph.addDependency(ids[0], ids[1]);
+        graph.addDependency(ids[1], ids[2]);
+        graph.addDependency(ids[2], ids[1]);
+        bool threw = false;
+        try {
+            graph.run(withPool ? &pool : nullptr);
+        } catch (const std::logic_error&) {
+            threw = true;
+        }
+        assert(threw);
+        assert(log.clock == 0);
+
+        graph.clear();
+        graph.addTask(&recordTask, &log, 0);
+        graph.run(withPool ? &pool : nullptr);
+        assert(log.clock == 1);
+    }
+}
+
+void testParallelStepMatchesSerial() {
+    World serial;
+    World pooled;
+    World staged;
+    ThreadPool pool(3);
+    pooled.threadPool = &pool;
+    fillPile(serial);
+    fillPile(pooled);
+    fillPile(staged);
+
+    for (int i = 0; i < 60; i++) {
+        serial.step();
+        pooled.step();
+
+        staged.applyGravity();
+        staged.integrateBodies(staged.timeStep);
+        staged.detectCollisions();
+        staged.resolveCollisions();
+    }
+
+    bool identical = true;
+    for (size_t i = 0; i < serial.getBodyCount(); i++) {
+        const RigidBody& a = *serial.getBody(i);
+        const RigidBody& b = *pooled.getBody(i);
+        const RigidBody& c = *staged.getBody(i);
+        identical = identical && a.position.x == b.position.x && a.position.y == b.position.y && a.position.z == b.position.z;
+        identical = identical && a.position.x == c.position.x && a.position.y == c.position.y && a.position.z == c.position.z;
+        identical = identical && a.velocity.y == b.velocity.y && a.velocity.y == c.velocity.y;
+    }
+    std::cout << "Task graph step: tasks=" << pooled.getStepGraph().getTaskCount() << " contacts=" << pooled.getContacts().size()
+              << " identical to serial and staged: " << (identical ? "true" : "false") << "\n";
+    assert(serial.getContacts().size() == pooled.getContacts().size());
+    assert(pooled.getContacts().size() > 0);
+    assert(identical);
+}
+
+void testUserStepTask() {
+    World world;
+    ThreadPool pool(2);
+    world.threadPool = &pool;
+    fillPile(world);
+
+    ContactProbe probe{&world, 0};
+    world.addStepTask(&probeContacts, &probe, StepStage::Narrowphase, "contact probe");
+    size_t contactTotal = 0;
+    for (int i = 0; i < 60; i++) {
+        world.step();
+        contactTotal += world.getContacts().size();
+    }
+    std::cout << "User task after narrowphase saw " << probe.contactsSeen << " contacts over 60 steps\n";
+    assert(probe.contactsSeen == contactTotal);
+    assert(probe.contactsSeen > 0);
+
+    world.clearStepTasks();
+    probe.contactsSeen = 0;
+    world.step();
+    assert(probe.contactsSeen == 0);
+}
+
+void runTaskGraphTests() {
+    testTaskGraphOrdering();
+    testTaskGraphCycleThrows();
+    testParallelStepMatchesSerial();
+    testUserStepTask();
+}
@@ -0,0 +1,166 @@
+#include "physics/world/World.h"
+#include "physics/parallel/ThreadPool.h"
+#include <iostream>
+#include <cassert>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace physics::world;
+using physics::math::Vec3;
+using physics::dynamics::RigidBody;
+using physics::dynamics::SemiImplicitEuler;
+using physics::collision::BodyPair;
+
+namespace {
+using GridWorld = BasicWorld<SemiImplicitEuler, UniformGridBroadphase, ImpulseSolver, DefaultStorage>;
+using BallisticWorld = BasicWorld<SemiImplicitEuler, NoBroadphase, ImpulseSolver, DefaultStorage>;
+using HugePageWorld = BasicWorld<SemiImplicitEuler, SweepAndPruneBroadphase, ImpulseSolver, HugePageStorage>;
+using BareWorld =
+    BasicWorld<SemiImplicitEuler, SweepAndPruneBroadphase, ImpulseSolver, DefaultStorage, NoOptionalStages>;
+
+// Loosely packed boxes of mixed sizes, so some overlap across grid cells.
+template <typename WorldT>
+void addScatteredBoxes(WorldT& world, int count) {
+    uint32_t seed = 12345;
+    auto next = [&seed]() {
+        seed = seed * 1664525u + 1013904223u;
+        return static_cast<float>(seed >> 8) / static_cast<float>(1u << 24);
+    };
+    for (int i = 0; i < count; i++) {
+        Vec3 position(next() * 40.0f, next() * 10.0f, next() * 40.0f);
+        float size = 0.5f + next() * 2.0f;
+        world.addBody(std::make_unique<RigidBody>(position, Vec3(size, size, size), 1.0f));
+    }
+}
+
+template <typename WorldT>
+std::vector<std::pair<BodyId, BodyId>> sortedPairIds(const WorldT& world) {
+    std::vector<std::pair<BodyId, BodyId>> ids;
+    for (const BodyPair& pair : world.getCandidatePairs()) {
+        BodyId a = world.getBodyId(pair.a);
+        BodyId b = world.getBodyId(pair.b);
+        ids.push_back({std::min(a, b), std::max(a, b)});
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+}
+
+// The grid broadphase reports the same pairs as sweep and prune, and its
+// parallel step matches the serial one.
+void testUniformGridMatchesSweep() {
+    World sweep;
+    GridWorld grid;
+    addScatteredBoxes(sweep, 3000);
+    addScatteredBoxes(grid, 3000);
+    sweep.detectCollisions();
+    grid.detectCollisions();
+    std::vector<std::pair<BodyId, BodyId>> expected = sortedPairIds(sweep);
+    assert(!expected.empty());
+    assert(sortedPairIds(grid) == expected);
+    assert(std::adjacent_find(expected.begin(), expected.end()) == expected.end());
+
+    physics::parallel::ThreadPool pool(3);
+    GridWorld serial;
+    GridWorld parallel;
+    parallel.threadPool = &pool;
+    addScatteredBoxes(serial, 3000);
+    addScatteredBoxes(parallel, 3000);
+    for (int i = 0; i < 10; i++) {
+        serial.step();
+        parallel.step();
+    }
+    assert(sortedPairIds(parallel) == sortedPairIds(serial));
+    for (size_t i = 0; i < serial.getBodyCount(); i++) {
+        assert(std::memcmp(&serial.getBody(i)->position, &parallel.getBody(i)->position, sizeof(Vec3)) == 0);
+    }
+    std::cout << "Uniform grid: " << expected.size() << " pairs match sweep and prune\n";
+}
+
+// Cells (x, -1, -1) and (x, 1, 1) share a hash. A large body covering both is
+// found once in that hash's run, so its pair with a small body in one of
+// them is reported once.
+void testUniformGridHashCollision() {
+    GridWorld world;
+    world.getBroadphase().cellSize = 2.0f;
+    world.addBody(std::make_unique<RigidBody>(Vec3(1, -1, -1), Vec3(1, 1, 1), 1.0f));
+    world.addBody(std::make_unique<RigidBody>(Vec3(1, 0, 0), Vec3(1, 5, 5), 1.0f));
+    world.detectCollisions();
+    std::vector<std::pair<BodyId, BodyId>> pairs = sortedPairIds(world);
+    assert(pairs.size() == 1);
+}
+
+// Without a broadphase the step graph has no collision stages and bodies
+// fall through each other.
+void testNoBroadphaseOnlyIntegrates() {
+    BallisticWorld world;
+    world.addBody(std::make_unique<RigidBody>(Vec3(0, 0, 0), Vec3(10, 1, 10), 0.0f));
+    world.addBody(std::make_unique<RigidBody>(Vec3(0, 1, 0), Vec3(1, 1, 1), 1.0f));
+    for (int i = 0; i < 60; i++) {
+        world.step();
+    }
+    assert(world.getContacts().empty());
+    assert(world.getBody(1)->position.y < -2.0f);
+    const physics::parallel::TaskGraph& graph = world.getStepGraph();
+    for (physics::parallel::TaskId id = 0; id < graph.getTaskCount(); id++) {
+        assert(std::string(graph.getTaskName(id)).find("broadphase") == std::string::npos);
+        assert(std::string(graph.getTaskName(id)) != "narrowphase");
+    }
+}
+
+// Stages compiled out by the stage policy ignore their runtime settings: the
+// step graph has only integration and collisions, and the result matches a
+// full world with those stages switched off.
+void testNoOptionalStagesCompilesOut() {
+    World full;
+    BareWorld bare;
+    bare.contactEvents.enabled = true;
+    bare.snapshots.enabled = true;
+    bare.substeps.maxSubsteps = 8;
+    addScatteredBoxes(full, 500);
+    addScatteredBoxes(bare, 500);
+    for (int i = 0; i < 10; i++) {
+        full.step();
+        bare.step();
+    }
+    assert(!bare.getContacts().empty());
+    assert(bare.getContactEvents().empty());
+    assert(bare.getSnapshotIds().empty());
+    assert(bare.getLastSubstepBodyCount() == 0);
+    const physics::parallel::TaskGraph& graph = bare.getStepGraph();
+    for (physics::parallel::TaskId id = 0; id < graph.getTaskCount(); id++) {
+        std::string name = graph.getTaskName(id);
+        assert(name != "contact events" && name != "write snapshot" && name != "snapshot");
+    }
+    for (size_t i = 0; i < full.getBodyCount(); i++) {
+        assert(std::memcmp(&full.getBody(i)->position, &bare.getBody(i)->position, sizeof(Vec3)) == 0);
+    }
+}
+
+// A storage policy changes where the arrays live, not the result.
+void testHugePageStoragePolicy() {
+    World heap;
+    HugePageWorld mapped;
+    addScatteredBoxes(heap, 4000);
+    addScatteredBoxes(mapped, 4000);
+    for (int i = 0; i < 10; i++) {
+        heap.step();
+        mapped.step();
+    }
+    assert(mapped.getStorage().pages().getMappingCount() > 0);
+    for (size_t i = 0; i < heap.getBodyCount(); i++) {
+        assert(std::memcmp(&heap.getBody(i)->position, &mapped.getBody(i)->position, sizeof(Vec3)) == 0);
+    }
+}
+
+void runWorldPolicyTests() {
+    testUniformGridMatchesSweep();
+    testUniformGridHashCollision();
+    testNoBroadphaseOnlyIntegrates();
+    testNoOptionalStagesCompilesOut();
+    testHugePageStoragePolicy();
+}
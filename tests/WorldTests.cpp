@@ -157,6 +157,119 @@ void testCustomTimeStep() {
     assert(std::abs(testBody->velocity.y - (-2.0f)) < 0.001f);
 }
 
+void testBodyIds() {
+    World world;
+    BodyId a = world.addBody(std::make_unique<RigidBody>(Vec3(0, 0, 0), Vec3(1, 1, 1), 1.0f));
+    BodyId b = world.addBody(std::make_unique<RigidBody>(Vec3(1, 0, 0), Vec3(1, 1, 1), 1.0f));
+    BodyId c = world.addBody(std::make_unique<RigidBody>(Vec3(2, 0, 0), Vec3(1, 1, 1), 1.0f));
+
+    std::cout << "Body ids: " << a << ", " << b << ", " << c << "\n";
+    assert(a != b && b != c && a != c);
+    assert(world.getBodyId(1) == b && world.getBodyIndex(c) == 2);
+
+    world.removeBody(0);
+    assert(world.getBodyById(a) == nullptr);
+    assert(world.getBodyIndex(a) == InvalidBodyIndex);
+    assert(world.getBodyIndex(c) == 1);
+    assert(world.getBodyById(c)->position.x == 2.0f);
+    assert(world.getBodyId(5) == InvalidBodyId);
+}
+
+void testMortonReorder() {
+    World world(Vec3(0, 0, 0));
+    const int gridSize = 8;
+    std::vector<BodyId> ids;
+    std::vector<Vec3> positions;
+
+    // Insert in a scrambled spawn order
+    for (int i = 0; i < gridSize * gridSize * gridSize; i++) {
+        int cell = (i * 97) % (gridSize * gridSize * gridSize);
+        Vec3 position(static_cast<float>(cell % gridSize), static_cast<float>((cell / gridSize) % gridSize), static_cast<float>(cell / (gridSize * gridSize)));
+        ids.push_back(world.addBody(std::make_unique<RigidBody>(position, Vec3(1, 1, 1), 1.0f)));
+        positions.push_back(position);
+    }
+
+    float before = world.measureDisorder();
+    world.reorderBodies();
+    float after = world.measureDisorder();
+    std::cout << "Morton disorder before=" << before << " after=" << after << "\n";
+    assert(before > 0.2f);
+    assert(after == 0.0f);
+
+    for (size_t i = 0; i < ids.size(); i++) {
+        const RigidBody* body = world.getBodyById(ids[i]);
+        assert(body->position.x == positions[i].x && body->position.y == positions[i].y && body->position.z == positions[i].z);
+        assert(world.getBodyId(world.getBodyIndex(ids[i])) == ids[i]);
+    }
+
+    // Neighbours in storage should be close in space after the reorder
+    float totalGap = 0.0f;
+    for (size_t i = 1; i < world.getBodyCount(); i++) {
+        totalGap += (world.getBody(i)->position - world.getBody(i - 1)->position).length();
+    }
+    float meanGap = totalGap / static_cast<float>(world.getBodyCount() - 1);
+    std::cout << "Mean storage neighbour distance after reorder: " << meanGap << "\n";
+    assert(meanGap < 2.0f);
+}
+
+void testAutomaticReorder() {
+    World world(Vec3(0, 0, 0));
+    world.reorderSettings.enabled = true;
+    world.reorderSettings.frameInterval = 3;
+    world.reorderSettings.disorderThreshold = 1.0f;
+
+    for (int i = 0; i < 64; i++) {
+        world.addBody(std::make_unique<RigidBody>(Vec3(static_cast<float>(63 - i), 0, 0), Vec3(1, 1, 1), 1.0f));
+    }
+
+    world.step();
+    world.step();
+    assert(world.getBody(0)->position.x == 63.0f);
+    world.step();
+    std::cout << "After 3 steps with frameInterval=3, first body x=" << world.getBody(0)->position.x << "\n";
+    assert(world.getBody(0)->position.x == 0.0f);
+
+    World metricWorld(Vec3(0, 0, 0));
+    metricWorld.reorderSettings.enabled = true;
+    metricWorld.reorderSettings.frameInterval = 0;
+    metricWorld.reorderSettings.disorderThreshold = 0.5f;
+    for (int i = 0; i < 64; i++) {
+        metricWorld.addBody(std::make_unique<RigidBody>(Vec3(static_cast<float>(63 - i), 0, 0), Vec3(1, 1, 1), 1.0f));
+    }
+    metricWorld.step();
+    std::cout << "Metric-triggered reorder, first body x=" << metricWorld.getBody(0)->position.x << "\n";
+    assert(metricWorld.getBody(0)->position.x == 0.0f);
+}
+
+void testBoundsCache() {
+    World world;
+    BodyId ground = world.addBody(std::make_unique<RigidBody>(Vec3(0, -10, 0), Vec3(10, 1, 10), 0.0f));
+    BodyId falling = world.addBody(std::make_unique<RigidBody>(Vec3(0, 5, 0), Vec3(1, 1, 1), 1.0f));
+    BodyId resting = world.addBody(std::make_unique<RigidBody>(Vec3(20, 5, 0), Vec3(1, 1, 1), 0.0f));
+
+    world.step();
+    std::cout << "Changed bodies after first step: " << world.getChangedBodies().size() << "\n";
+    assert(world.getChangedBodies().size() == 3);
+
+    world.step();
+    std::cout << "Changed bodies after second step: " << world.getChangedBodies().size() << "\n";
+    assert(world.getChangedBodies().size() == 1);
+    assert(world.getChangedBodies()[0] == world.getBodyIndex(falling));
+
+    physics::collision::AABB cached = world.getBodyBounds(world.getBodyIndex(falling));
+    physics::collision::AABB current = world.getBodyById(falling)->getAABB();
+    assert(cached.min.y == current.min.y && cached.max.y == current.max.y);
+
+    // Moving a static body by hand is picked up by the next refresh
+    world.getBodyById(resting)->position.x = 25.0f;
+    world.removeBodies(std::span<const BodyId>(&ground, 1));
+    assert(world.getChangedBodies().empty());
+    assert(world.getBodyBounds().size() == 2);
+    world.step();
+    assert(world.getChangedBodies().size() == 2);
+    assert(world.getBodyBounds(world.getBodyIndex(resting)).min.x == 24.5f);
+}
+
 void runWorldTests() {
     testWorldConstruction();
     testBodyManagement();
@@ -164,4 +277,8 @@ void runWorldTests() {
     testWorldStep();
     testMultiBodySimulation();
     testCustomTimeStep();
+    testBodyIds();
+    testMortonReorder();
+    testAutomaticReorder();
+    testBoundsCache();
 }
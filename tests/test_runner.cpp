@@ -3,12 +3,36 @@
 #include "physics/dynamics/RigidBody.h"
 #include "physics/world/World.h"
 #include "physics/collision/CollisionDetection.h"
+#include "physics/dynamics/Integrators.h"
 
 void run_vec3_tests();
 void runAABBTests();
 void runRigidBodyTests();
 void runWorldTests();
 void runCollisionDetectionTests();
+void runIntegratorTests();
+void runParallelTests();
+void runMortonTests();
+void runMemoryTests();
+void runRegionStreamerTests();
+void runDomainDecompositionTests();
+void runTaskGraphTests();
+void runShapeTests();
+void runGjkTests();
+void runBenchmarkTests();
+void runContactEventTests();
+void runSensorTests();
+void runParticleTests();
+void runCollisionFilterTests();
+void runStaticBvhTests();
+void runHugePageTests();
+void runWorldPolicyTests();
+void runJointTests();
+void runCharacterTests();
+void runSubstepTests();
+void runSnapshotTests();
+void runCommandTests();
+void runFluidTests();
 
 
 int main() {
@@ -17,5 +41,28 @@ int main() {
   runRigidBodyTests();
   runWorldTests();
   runCollisionDetectionTests();
+  runIntegratorTests();
+  runParallelTests();
+  runMortonTests();
+  runMemoryTests();
+  runRegionStreamerTests();
+  runDomainDecompositionTests();
+  runTaskGraphTests();
+  runShapeTests();
+  runGjkTests();
+  runBenchmarkTests();
+  runContactEventTests();
+  runSensorTests();
+  runParticleTests();
+  runCollisionFilterTests();
+  runStaticBvhTests();
+  runHugePageTests();
+  runWorldPolicyTests();
+  runJointTests();
+  runCharacterTests();
+  runSubstepTests();
+  runSnapshotTests();
+  runCommandTests();
+  runFluidTests();
   return 0;
 }